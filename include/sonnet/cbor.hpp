@@ -0,0 +1,130 @@
+#pragma once
+
+
+/*
+    ---------------------------------------
+    Sonnet CBOR - RFC 8949 binary encoding
+    ---------------------------------------
+    This header converts `Sonnet::value` trees to and from CBOR, a compact
+    binary encoding of the JSON data model
+
+    --------
+    Encoding
+    --------
+    - `to_cbor(v)` returns the encoding as bytes; overloads append to an
+      existing byte vector or write to a `std::ostream`
+    - Numbers with an integral value that fits in 64 bits are written as
+      CBOR integers; other numbers use the shortest IEEE 754 float
+      (half, single or double) that represents them exactly
+    - Arrays, objects and strings are always written with definite lengths
+    - `CborOptions::canonical` selects the core deterministic encoding of
+      RFC 8949 section 4.2.1: in addition to the rules above, map keys are
+      ordered by their encoded bytes (shorter keys first, then bytewise),
+      so equal values always produce identical bytes
+
+    --------
+    Decoding
+    --------
+    - `from_cbor(bytes, res)` decodes one CBOR data item into a `value`
+      allocated from `res`
+    - `from_cbor(bytes, handler)` reports the item to a `SaxHandler`
+      instead of building a tree (see `sax.hpp`); definite-length strings
+      are passed to the handler as views into `bytes`
+    - Items are mapped to JSON following RFC 8949 section 6.1:
+        * Integers and floats become numbers (beyond 2^53 precision is lost)
+        * Byte strings become base64url strings without padding
+        * Tags are skipped, except bignums (tags 2 and 3) which become numbers
+        * `undefined` and unassigned simple values become `null`
+    - Indefinite-length items are accepted
+    - Map keys must be text strings; anything else fails with
+      `ParseError::code::unsupported_type`
+    - `ParseOptions::max_depth` limits nesting; the other parse options do
+      not apply to binary input
+    - Errors report the byte offset of the offending item; `line` is always
+      1 and `column` is `offset + 1`
+
+    -----
+    Usage
+    -----
+        std::vector<std::byte> wire = Sonnet::to_cbor(doc);
+
+        auto back = Sonnet::from_cbor(wire);
+        if (!back) log(back.error().msg);
+*/
+
+#include <cstddef>
+#include <expected>
+#include <iosfwd>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/sax.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetCbor CBOR
+/// @ingroup Sonnet
+/// @brief Conversion between `Sonnet::value` and CBOR (RFC 8949)
+
+namespace Sonnet {
+
+    /// @ingroup SonnetCbor
+    /// @brief Configuration controlling CBOR encoding
+    ///
+    /// @details
+    /// Fields:
+    /// `canonical`
+    ///   - When `true`, produces the RFC 8949 core deterministic encoding:
+    ///     map keys are sorted by their encoded form, i.e. by length first
+    ///     and then bytewise.
+    ///   - When `false` (default), map keys are written in the object's
+    ///     own (bytewise) order.
+    struct CborOptions {
+        bool canonical = false; ///< Emit the core deterministic encoding if true.
+    };
+
+    /// @ingroup SonnetCbor
+    /// @brief Encodes @p v as CBOR
+    /// @param v    Value to encode
+    /// @param opts Encoding options
+    /// @return The encoded bytes
+    [[nodiscard]] SONNET_API std::vector<std::byte> to_cbor(const value& v, const CborOptions& opts = {});
+
+    /// @ingroup SonnetCbor
+    /// @brief Appends the CBOR encoding of @p v to @p out
+    SONNET_API void to_cbor(const value& v, std::vector<std::byte>& out, const CborOptions& opts = {});
+
+    /// @ingroup SonnetCbor
+    /// @brief Writes the CBOR encoding of @p v to @p os
+    SONNET_API void to_cbor(const value& v, std::ostream& os, const CborOptions& opts = {});
+
+    /// @ingroup SonnetCbor
+    /// @brief Decodes a single CBOR data item into a `value`
+    ///
+    /// @details
+    /// The whole input must be consumed by the item; extra bytes fail with
+    /// `trailing_characters`.
+    ///
+    /// @param bytes CBOR input
+    /// @param res   Memory resource for the resulting tree
+    /// @param opts  Parse options; only `max_depth` is used
+    /// @return The decoded value, or a `ParseError` describing the failure
+    [[nodiscard]] SONNET_API std::expected<value, ParseError> from_cbor(std::span<const std::byte> bytes,
+                                                                       std::pmr::memory_resource* res = std::pmr::get_default_resource(),
+                                                                       const ParseOptions& opts = {});
+
+    /// @ingroup SonnetCbor
+    /// @brief Decodes a single CBOR data item, reporting it to @p handler
+    ///
+    /// @param bytes   CBOR input
+    /// @param handler Receives one event per decoded item
+    /// @param opts    Parse options; only `max_depth` is used
+    /// @return Nothing on success, or a `ParseError` describing the failure
+    ///         (`aborted` if the handler stopped decoding)
+    [[nodiscard]] SONNET_API std::expected<void, ParseError> from_cbor(std::span<const std::byte> bytes, SaxHandler& handler,
+                                                                      const ParseOptions& opts = {});
+
+} // namespace Sonnet
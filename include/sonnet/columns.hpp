@@ -0,0 +1,146 @@
+#pragma once
+
+
+/*
+    ---------------------------------------------
+    Sonnet columns - struct-of-arrays export
+    ---------------------------------------------
+    This header converts an array of objects (rows) into one typed column
+    per key, the layout analytics code and columnar formats expect
+
+    ------
+    Layout
+    ------
+    - Buffers follow the Apache Arrow memory layout, so they can be handed
+      to Arrow-based code without conversion:
+        * `validity`: one bit per row, least significant bit first, 1 for
+          a present non-null value
+        * boolean columns: values bit-packed the same way in `bits`
+        * int64 / float64 columns: one slot per row in `ints` / `doubles`
+        * utf8 columns: `length + 1` 32-bit `offsets` into `data`
+    - Null rows still occupy a (zeroed or empty) value slot
+    - Columns appear in the order their key is first seen
+
+    -----------
+    Type Rules
+    -----------
+    - The first non-null value of a key decides the column type. Integral
+      numbers that fit in 64 bits give int64, other numbers float64
+    - An int64 column becomes float64 when a non-integral number appears
+    - Any other mix of types turns the column into utf8: strings keep
+      their contents, every other value is stored as its compact JSON text.
+      Nested arrays and objects are always stored as JSON text
+    - A key missing from a row, or a column of only nulls, is null
+    - If a row repeats a key, the last occurrence wins, as in `parse`
+
+    -----------------
+    Building Columns
+    -----------------
+    - `to_columns(v)` converts an existing document
+    - `parse_columns(json)` fills the columns straight from the parser via
+      `parse_sax` without building the document first, so only the
+      columns are held in memory
+
+    -----
+    Usage
+    -----
+        auto table = Sonnet::parse_columns(R"([{"id":1,"px":9.5},{"id":2}])");
+        const Sonnet::Column* px = table->find("px");
+        if (px && px->is_valid(1)) use(px->doubles[1]);
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetColumns Columnar Export
+/// @ingroup Sonnet
+/// @brief Struct-of-arrays conversion of arrays of objects
+
+namespace Sonnet {
+
+    /// @ingroup SonnetColumns
+    /// @brief Physical type of a column
+    enum class column_type : std::uint8_t {
+        null,    ///< Every row is null; no value buffer
+        boolean, ///< Bit-packed booleans in `bits`
+        int64,   ///< 64-bit integers in `ints`
+        float64, ///< Doubles in `doubles`
+        utf8,    ///< Strings in `offsets` / `data`
+    };
+
+    /// @ingroup SonnetColumns
+    /// @brief One typed column of a `ColumnTable`
+    ///
+    /// @details
+    /// Only the buffers of the column's `type` are populated; the others are
+    /// empty.
+    struct Column {
+        std::string name;                     ///< Object key the column was built from
+        column_type type = column_type::null; ///< Physical type
+        std::size_t length = 0;               ///< Number of rows
+        std::size_t null_count = 0;           ///< Number of null rows
+
+        std::vector<std::uint8_t> validity;   ///< Validity bitmap, LSB first
+        std::vector<std::uint8_t> bits;       ///< Boolean values, LSB first
+        std::vector<std::int64_t> ints;       ///< int64 values
+        std::vector<double> doubles;          ///< float64 values
+        std::vector<std::int32_t> offsets;    ///< utf8 offsets, `length + 1` entries
+        std::string data;                     ///< utf8 bytes
+
+        /// @ingroup SonnetColumns
+        /// @brief Returns whether @p row holds a non-null value
+        [[nodiscard]] bool is_valid(std::size_t row) const noexcept {
+            return (validity[row >> 3] >> (row & 7)) & 1;
+        }
+
+        /// @ingroup SonnetColumns
+        /// @brief Value of @p row in a boolean column
+        [[nodiscard]] bool bool_at(std::size_t row) const noexcept {
+            return (bits[row >> 3] >> (row & 7)) & 1;
+        }
+
+        /// @ingroup SonnetColumns
+        /// @brief Value of @p row in a utf8 column, pointing into `data`
+        [[nodiscard]] std::string_view string_at(std::size_t row) const noexcept {
+            auto begin = static_cast<std::size_t>(offsets[row]);
+            return { data.data() + begin, static_cast<std::size_t>(offsets[row + 1]) - begin };
+        }
+    };
+
+    /// @ingroup SonnetColumns
+    /// @brief Columns built from an array of objects
+    struct ColumnTable {
+        std::size_t rows = 0;        ///< Number of rows (array elements)
+        std::vector<Column> columns; ///< One column per distinct key
+
+        /// @ingroup SonnetColumns
+        /// @brief Returns the column for @p name, or `nullptr`
+        [[nodiscard]] SONNET_API const Column* find(std::string_view name) const noexcept;
+    };
+
+    /// @ingroup SonnetColumns
+    /// @brief Converts an array of objects into columns
+    /// @throws std::invalid_argument if @p v is not an array of objects
+    /// @throws std::length_error if a utf8 column exceeds 2 GiB of text
+    [[nodiscard]] SONNET_API ColumnTable to_columns(const value& v);
+
+    /// @ingroup SonnetColumns
+    /// @brief Parses JSON text directly into columns
+    ///
+    /// @details
+    /// Equivalent to `to_columns(*parse(json, opts))` without materializing
+    /// the document. A top-level value that is not an array of objects fails
+    /// with `ParseError::code::unsupported_type`.
+    /// @throws std::length_error if a utf8 column exceeds 2 GiB of text
+    [[nodiscard]] SONNET_API std::expected<ColumnTable, ParseError> parse_columns(std::string_view json, const ParseOptions& opts = {});
+
+} // namespace Sonnet
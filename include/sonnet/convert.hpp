@@ -29,6 +29,13 @@
     
       in either the same namespace as `T` or in the `Sonnet` namespace,
       subject to argument-dependent lookup (ADL)
+    - A third form reports failures instead of throwing them:
+
+        // Deserialize T, or describe why not and return false
+        bool from_json(const Sonnet::value& src, T& out, Sonnet::ConvertError& err);
+
+    - Either form may be overloaded for `Sonnet::value&&` as well (see
+      "Moving Out of a Document" below)
     - Sonnet provides generic helpers that use these functions:
 
         template<typename T>
@@ -37,30 +44,68 @@
         template<typename T>
         std::expected<T, Sonnet::ConvertError> from_json_value(const Sonnet::value& v);
 
-      (Exact names and error types may vary depending on the library's design.)
-
     -------------------
     Builtin Conversions
     -------------------
-    - Sonnet may provide builtin `to_json`/`from_json` support for:
-        * `bool`, `double`, `string`, `string_view`, etc.
-        * STL containers like `vector<T>`, where `T` is itself
-          convertible via `to_json`/`from_json`
-        * Associative containers mapping string-like keys to values
+    - Sonnet provides `to_json` and checked `from_json` for:
+        * `bool`, arithmetic types and enumerations (as their underlying
+          integer). Integral targets accept only integers they can hold
+        * `std::basic_string<char>` with any allocator; anything
+          convertible to `std::string_view` can be written
+        * `std::chrono::duration`, as its tick count
+        * `std::vector<T>` and `std::array<T, N>` as arrays, and
+          `std::tuple` / `std::pair` as arrays of fixed length
+        * `std::map` and `std::unordered_map` with string keys as objects
+        * `std::optional<T>` (`null` when empty), `std::variant` (the
+          first alternative that converts wins; `std::monostate` is
+          `null`) and `Sonnet::value` itself
+      where the element types are convertible in turn
+    - Containers are cleared and `reserve()`d from `value::size()` before
+      they are filled, and elements are converted in place
+    - A `from_json` of your own for an enumeration replaces the builtin
+      one, so enums can be mapped to names instead
+
+    ------------------------
+    Moving Out of a Document
+    ------------------------
+    - `deserialize<T>(value&&)` and `from_json_value<T>(value&&)` take a
+      document that is about to be discarded and move its contents into
+      the result instead of copying them
+    - They call `from_json` with a `Sonnet::value&&`, so a converter may
+      add an rvalue overload beside the `const Sonnet::value&` one and
+      move out of `src`; types without one are read from it as usual.
+      Converters forward members with `std::move(src[key])` or similar
+    - The builtin rvalue overloads hand on every element and member as
+      an rvalue, and adopt the storage outright where the types match:
+        * `Sonnet::string` takes over the string buffer
+        * `std::vector<Sonnet::value, ...>` (`Sonnet::array`) and
+          `Sonnet::object` take over the whole container
+        * `Sonnet::value` takes over the node
+      A buffer is only adopted when the destination uses the same memory
+      resource as the document; otherwise it is copied, as a
+      `std::pmr` move assignment does. `std::string` always copies
+    - `std::variant` reads from the document without moving, since an
+      alternative that fails must leave it intact for the next one
+    - The document is left valid but unspecified, as after any move
 
     --------------
     Error Handling
     --------------
-    - Deserialization (`from_json`) will be able to report failures,
-      e.g. via:
-        * `std::expected<T, ConvertError>`
-        * throwing exceptions (if enabled)
-      depending on library configuration
-    - Typical errors might include:
-        * Type mismatch (e.g. expected object, got array)
-        * Missing require fields
-        * Invalid or out-of-range values
-    
+    - `from_json_value` never throws on bad input. It returns a
+      `ConvertError` holding a category, the JSON Pointer of the failing
+      value (e.g. `/items/3/qty`) and a message:
+        * `type_mismatch`: the value has the wrong kind (e.g. expected an
+          object, got an array)
+        * `missing_member`: a required member is absent
+        * `out_of_range`: a number does not fit the target type
+        * `invalid_value`: a converter rejected the value
+    - Types with the checked `from_json` overload convert without any
+      exception. Types with only the two-argument `from_json` are still
+      accepted: whatever they throw is caught and reported as
+      `invalid_value` with the exception's message, at the cost of the
+      unwinding the checked overload avoids
+    - `deserialize` keeps throwing on failure
+
     ----------------
     Conceptual Usage
     ----------------
@@ -87,8 +132,26 @@
 */
 
 
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <exception>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <concepts>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
 #include "sonnet/value.hpp"
 #include "sonnet/config.hpp"
@@ -157,7 +220,80 @@ namespace Sonnet {
     /// @tparam T Type to check.
     template<typename T>
     concept JsonDeserializable = requires(const value& v, T& t) { { from_json(v, t) } -> std::same_as<void>; };
+
+    /// @ingroup SonnetConvert
+    /// @brief Why a value could not be converted to a C++ type
+    struct ConvertError {
+        /// @ingroup SonnetConvert
+        /// @brief Failure categories
+        enum class code : std::uint8_t {
+            type_mismatch,  ///< The value has the wrong kind
+            missing_member, ///< A required object member is absent
+            out_of_range,   ///< A number does not fit the target type
+            invalid_value,  ///< A converter rejected the value
+        };
+
+        code errc{};        ///< The classification of the failure.
+        std::string path{}; ///< JSON Pointer to the failing value, relative to the converted one.
+        std::string msg{};  ///< Human-readable diagnostic message.
+    };
+
+    /// @ingroup SonnetConvert
+    /// @brief Concept representing types that can be deserialized without
+    ///        throwing on bad input.
+    ///
+    /// @details
+    /// A type `T` satisfies `JsonCheckedDeserializable` if an overload of:
+    ///
+    ///     bool from_json(const Sonnet::value& src, T& out, Sonnet::ConvertError& err);
+    ///
+    /// is available. It returns `true` on success; otherwise it fills in
+    /// `err` and returns `false`. Implementations that convert members
+    /// call `from_json_into` for each of them and prefix `err.path` with
+    /// the member's key when it fails.
+    ///
+    /// @tparam T Type to check.
+    template<typename T>
+    concept JsonCheckedDeserializable = requires(const value& v, T& t, ConvertError& e) { { from_json(v, t, e) } -> std::same_as<bool>; };
     
+    namespace detail {
+        // `V` is `const value&` or `value`, so `std::forward<V>` passes the
+        // document on as it was given
+        template<typename V, typename T>
+        bool convert_into(V&& v, T& t, ConvertError& err) {
+            if constexpr (JsonCheckedDeserializable<T>) {
+                return from_json(std::forward<V>(v), t, err);
+            } else {
+                try {
+                    from_json(std::forward<V>(v), t);
+                    return true;
+                } catch (const std::exception& e) {
+                    err.errc = ConvertError::code::invalid_value;
+                    err.msg = e.what();
+                    return false;
+                }
+            }
+        }
+
+        template<typename T, typename V>
+        T deserialize(V&& v) {
+            T t{};
+            if constexpr (JsonDeserializable<T>) {
+                from_json(std::forward<V>(v), t);
+            } else {
+                ConvertError err;
+                if (!from_json(std::forward<V>(v), t, err)) throw std::invalid_argument{ "Sonnet::deserialize: " + (err.path.empty() ? err.msg : err.path + ": " + err.msg) };
+            }
+            return t;
+        }
+
+        // Passes on `e`, a part of a document given as `V`, the same way
+        template<typename V>
+        constexpr V&& forward_part(auto& e) noexcept {
+            return static_cast<V&&>(e);
+        }
+    } // namespace detail
+
     /// @ingroup SonnetConvert
     /// @brief Serializes a user-defined type into a JSON value.
     ///
@@ -201,16 +337,544 @@ namespace Sonnet {
     ///
     /// @note
     /// Implementations of `from_json` may perform validation, throw exceptions,
-    /// or assume well-formed input, depending on application needs.
+    /// or assume well-formed input, depending on application needs. Types
+    /// with only the checked `from_json` (such as the builtin conversions)
+    /// throw `std::invalid_argument` describing the `ConvertError`.
     ///
-    /// @tparam T A type that satisfies `JsonDeserializable`.
+    /// @tparam T A type that satisfies `JsonDeserializable` or
+    ///           `JsonCheckedDeserializable`.
     /// @param v  The JSON value to deserialize from.
     /// @return A new instance of `T` populated from the JSON data.
-    template<JsonDeserializable T>
+    template<typename T>
+        requires JsonDeserializable<T> || JsonCheckedDeserializable<T>
     [[nodiscard]] inline T deserialize(const value& v) {
+        return detail::deserialize<T>(v);
+    }
+
+    /// @ingroup SonnetConvert
+    /// @brief Deserializes a user-defined type from a JSON value that is
+    ///        about to be discarded.
+    ///
+    /// @details
+    /// Same as the overload above, but strings and containers are moved
+    /// out of @p v rather than copied where the converters allow it (see
+    /// "Moving Out of a Document" above).
+    ///
+    /// Example:
+    /// @code
+    /// auto msg = Sonnet::deserialize<Message>(std::move(*Sonnet::parse(body)));
+    /// @endcode
+    ///
+    /// @param v The JSON value to deserialize from; left valid but
+    ///          unspecified.
+    /// @return A new instance of `T` populated from the JSON data.
+    template<typename T>
+        requires JsonDeserializable<T> || JsonCheckedDeserializable<T>
+    [[nodiscard]] inline T deserialize(value&& v) {
+        return detail::deserialize<T>(std::move(v));
+    }
+
+    /// @ingroup SonnetConvert
+    /// @brief Serializes a user-defined type into a JSON value.
+    ///
+    /// @details
+    /// Same as `serialize`; provided as the counterpart of
+    /// `from_json_value`.
+    template<JsonSerializable T>
+    [[nodiscard]] inline value to_json_value(const T& t, std::pmr::memory_resource* res = std::pmr::get_default_resource()) {
+        return serialize(t, res);
+    }
+
+    /// @ingroup SonnetConvert
+    /// @brief Deserializes @p v into an existing object without throwing on
+    ///        bad input.
+    ///
+    /// @details
+    /// Uses the checked `from_json` overload when there is one; otherwise
+    /// the two-argument `from_json`, with any exception it throws caught
+    /// and reported as `ConvertError::code::invalid_value`.
+    /// @return `true` on success; otherwise `false` with @p err filled in
+    template<typename T>
+        requires JsonCheckedDeserializable<T> || JsonDeserializable<T>
+    [[nodiscard]] bool from_json_into(const value& v, T& t, ConvertError& err) {
+        return detail::convert_into(v, t, err);
+    }
+
+    /// @ingroup SonnetConvert
+    /// @brief Deserializes @p v into an existing object without throwing on
+    ///        bad input, moving out of @p v
+    ///
+    /// @details
+    /// Calls `from_json` with an rvalue, so rvalue overloads are preferred
+    /// (see "Moving Out of a Document" above).
+    /// @return `true` on success; otherwise `false` with @p err filled in
+    template<typename T>
+        requires JsonCheckedDeserializable<T> || JsonDeserializable<T>
+    [[nodiscard]] bool from_json_into(value&& v, T& t, ConvertError& err) {
+        return detail::convert_into(std::move(v), t, err);
+    }
+
+    /// @ingroup SonnetConvert
+    /// @brief Deserializes a user-defined type from a JSON value without
+    ///        throwing on bad input.
+    ///
+    /// @details
+    /// Example:
+    /// @code
+    /// auto p = Sonnet::from_json_value<Point>(*parsed);
+    /// if (!p) log("{}: {}", p.error().path, p.error().msg);
+    /// @endcode
+    ///
+    /// @tparam T A default-constructible type with a `from_json` overload.
+    /// @param v  The JSON value to deserialize from.
+    /// @return The converted object, or where and why conversion failed
+    template<typename T>
+        requires std::default_initializable<T> && (JsonCheckedDeserializable<T> || JsonDeserializable<T>)
+    [[nodiscard]] std::expected<T, ConvertError> from_json_value(const value& v) {
+        T t{};
+        ConvertError err;
+        if (!from_json_into(v, t, err)) return std::unexpected(std::move(err));
+        return t;
+    }
+
+    /// @ingroup SonnetConvert
+    /// @brief Deserializes a user-defined type from a JSON value that is
+    ///        about to be discarded, without throwing on bad input.
+    ///
+    /// @details
+    /// Moves out of @p v like `deserialize(value&&)`.
+    template<typename T>
+        requires std::default_initializable<T> && (JsonCheckedDeserializable<T> || JsonDeserializable<T>)
+    [[nodiscard]] std::expected<T, ConvertError> from_json_value(value&& v) {
         T t{};
-        from_json(v, t);
+        ConvertError err;
+        if (!from_json_into(std::move(v), t, err)) return std::unexpected(std::move(err));
         return t;
     }
 
+    namespace detail {
+        template<typename T>
+        struct is_string : std::false_type {};
+
+        template<typename Alloc>
+        struct is_string<std::basic_string<char, std::char_traits<char>, Alloc>> : std::true_type {};
+
+        template<typename T>
+        struct is_duration : std::false_type {};
+
+        template<typename Rep, typename Period>
+        struct is_duration<std::chrono::duration<Rep, Period>> : std::true_type {};
+
+        template<typename T>
+        struct is_optional : std::false_type {};
+
+        template<typename T>
+        struct is_optional<std::optional<T>> : std::true_type {};
+
+        /// @brief Types converted from a single JSON scalar
+        template<typename T>
+        concept JsonScalar = std::is_arithmetic_v<T> || std::is_enum_v<T> || is_string<T>::value || is_duration<T>::value;
+
+        /// @brief A JSON scalar as seen by the converters
+        struct Scalar {
+            kind type = kind::null;
+            bool b = false;
+            double d = 0.0;
+            std::string_view s{};
+        };
+
+        inline Scalar scalar_of(const value& v) {
+            Scalar s;
+            s.type = v.type();
+            switch (v.type()) {
+            case kind::boolean: s.b = v.as_bool(); break;
+            case kind::number: s.d = v.as_number(); break;
+            case kind::string: s.s = v.as_string(); break;
+            default: break;
+            }
+            return s;
+        }
+
+        template<typename T>
+        constexpr std::string_view expects() noexcept {
+            if constexpr (std::same_as<T, bool>) return "a boolean";
+            else if constexpr (std::integral<T> || std::is_enum_v<T>) return "an integer";
+            else if constexpr (std::floating_point<T> || is_duration<T>::value) return "a number";
+            else if constexpr (is_string<T>::value) return "a string";
+            else return "an object";
+        }
+
+        inline bool fail(ConvertError& err, ConvertError::code c, std::string_view msg) {
+            err.errc = c;
+            err.msg.assign(msg);
+            return false;
+        }
+
+        inline bool mismatch(ConvertError& err, std::string_view expected) {
+            fail(err, ConvertError::code::type_mismatch, "expected ");
+            err.msg.append(expected);
+            return false;
+        }
+
+        // Appends `token` to a JSON Pointer, escaping '~' and '/'
+        inline void append_token(std::string& path, std::string_view token) {
+            path.push_back('/');
+            for (char c : token) {
+                if (c == '~') path.append("~0");
+                else if (c == '/') path.append("~1");
+                else path.push_back(c);
+            }
+        }
+
+        // Prefixes the path of a failure with the member or element it
+        // happened in, as the converters unwind
+        inline bool within(ConvertError& err, std::string_view token) {
+            std::string prefix;
+            append_token(prefix, token);
+            err.path.insert(0, prefix);
+            return false;
+        }
+
+        inline bool within(ConvertError& err, std::size_t index) {
+            return within(err, std::to_string(index));
+        }
+
+        template<JsonScalar T>
+        bool assign(T& t, const Scalar& s, ConvertError& err) {
+            if constexpr (std::same_as<T, bool>) {
+                if (s.type != kind::boolean) return mismatch(err, expects<T>());
+                t = s.b;
+            } else if constexpr (std::integral<T>) {
+                // [low, high) holds exactly the doubles that convert to T
+                constexpr double high = [] { double x = 1.0; for (int i = 0; i < std::numeric_limits<T>::digits; i++) x *= 2.0; return x; }();
+                constexpr double low = std::is_signed_v<T> ? -high : 0.0;
+                if (s.type != kind::number) return mismatch(err, expects<T>());
+                if (!(s.d >= low && s.d < high) || std::trunc(s.d) != s.d) return fail(err, ConvertError::code::out_of_range, "expected an integer in range");
+                t = static_cast<T>(s.d);
+            } else if constexpr (std::floating_point<T>) {
+                if (s.type != kind::number) return mismatch(err, expects<T>());
+                t = static_cast<T>(s.d);
+            } else if constexpr (std::is_enum_v<T>) {
+                std::underlying_type_t<T> u{};
+                if (!assign(u, s, err)) return false;
+                t = static_cast<T>(u);
+            } else if constexpr (is_duration<T>::value) {
+                typename T::rep r{};
+                if (!assign(r, s, err)) return false;
+                t = T{ r };
+            } else {
+                if (s.type != kind::string) return mismatch(err, expects<T>());
+                t.assign(s.s.data(), s.s.size());
+            }
+            return true;
+        }
+
+        // Converts every element of the array `v` with `f(element, index)`;
+        // packed numbers are passed as temporary values, and the elements
+        // of an rvalue `v` as rvalues
+        template<typename V, typename F>
+        bool each_element(V&& v, F&& f) {
+            if (v.is_packed()) {
+                auto nums = std::as_const(v).numbers();
+                for (std::size_t i = 0; i < nums.size(); i++) {
+                    if (!f(value{ nums[i] }, i)) return false;
+                }
+                return true;
+            }
+            auto& arr = v.as_array();
+            for (std::size_t i = 0; i < arr.size(); i++) {
+                if (!f(forward_part<V>(arr[i]), i)) return false;
+            }
+            return true;
+        }
+
+        template<typename V, typename T>
+        bool element_from_json(V&& v, std::size_t i, T& t, ConvertError& err) {
+            return from_json_into(std::forward<V>(v), t, err) || within(err, i);
+        }
+
+        template<typename V, typename... Ts, std::size_t... I>
+        bool tuple_from_json(V&& v, std::tuple<Ts&...> t, ConvertError& err, std::index_sequence<I...>) {
+            if (!v.is_array()) return mismatch(err, "an array");
+            if (v.size() != sizeof...(Ts)) return fail(err, ConvertError::code::invalid_value, "expected an array of " + std::to_string(sizeof...(Ts)) + " elements");
+            if (v.is_packed()) {
+                auto nums = std::as_const(v).numbers();
+                return (element_from_json(value{ nums[I] }, I, std::get<I>(t), err) && ...);
+            }
+            auto& arr = v.as_array();
+            return (element_from_json(forward_part<V>(arr[I]), I, std::get<I>(t), err) && ...);
+        }
+
+        template<typename V, typename T, typename A>
+        bool vector_from_json(V&& v, std::vector<T, A>& vec, ConvertError& err) {
+            if (!v.is_array()) return mismatch(err, "an array");
+            vec.clear();
+            vec.reserve(v.size());
+            return each_element(std::forward<V>(v), [&]<typename E>(E&& e, std::size_t i) {
+                // vector<bool> has no element references to convert into
+                if constexpr (std::same_as<T, bool>) {
+                    bool b = false;
+                    if (!element_from_json(std::forward<E>(e), i, b, err)) return false;
+                    vec.push_back(b);
+                    return true;
+                } else {
+                    return element_from_json(std::forward<E>(e), i, vec.emplace_back(), err);
+                }
+            });
+        }
+
+        template<typename V, typename T, std::size_t N>
+        bool std_array_from_json(V&& v, std::array<T, N>& a, ConvertError& err) {
+            if (!v.is_array()) return mismatch(err, "an array");
+            if (v.size() != N) return fail(err, ConvertError::code::invalid_value, "expected an array of " + std::to_string(N) + " elements");
+            return each_element(std::forward<V>(v), [&]<typename E>(E&& e, std::size_t i) { return element_from_json(std::forward<E>(e), i, a[i], err); });
+        }
+
+        template<typename... Ts>
+        void tuple_to_json(value& out, const Ts&... ts) {
+            std::pmr::memory_resource* res = out.resource();
+            array arr{ allocator_type{ res } };
+            arr.reserve(sizeof...(Ts));
+            ((arr.emplace_back(res), to_json(arr.back(), ts)), ...);
+            out = value{ std::move(arr), res };
+        }
+    } // namespace detail
+
+    // ----------------------------------------------------------------
+    // Builtin conversions
+    // ----------------------------------------------------------------
+
+    template<detail::JsonScalar T>
+    void to_json(value& out, const T& t) {
+        if constexpr (std::same_as<T, bool>) out = value{ t, out.resource() };
+        else if constexpr (std::is_arithmetic_v<T>) out = value{ static_cast<double>(t), out.resource() };
+        else if constexpr (std::is_enum_v<T>) out = value{ static_cast<double>(std::to_underlying(t)), out.resource() };
+        else if constexpr (detail::is_duration<T>::value) out = value{ static_cast<double>(t.count()), out.resource() };
+        else out = value{ std::string_view{ t }, out.resource() };
+    }
+
+    template<detail::JsonScalar T>
+        requires (!std::is_enum_v<T> || !JsonDeserializable<T>)
+    bool from_json(const value& v, T& t, ConvertError& err) {
+        return detail::assign(t, detail::scalar_of(v), err);
+    }
+
+    // Takes over the buffer when `t` uses the document's memory resource
+    inline bool from_json(value&& v, string& t, ConvertError& err) {
+        if (!v.is_string()) return detail::mismatch(err, "a string");
+        t = std::move(v.as_string());
+        return true;
+    }
+
+    template<typename T>
+        requires std::convertible_to<const T&, std::string_view> && (!detail::JsonScalar<T>) && (!std::same_as<T, value>)
+    void to_json(value& out, const T& t) {
+        out = value{ std::string_view{ t }, out.resource() };
+    }
+
+    inline void to_json(value& out, const value& v) { out = v; }
+
+    inline bool from_json(const value& v, value& t, ConvertError&) {
+        t = v;
+        return true;
+    }
+
+    inline bool from_json(value&& v, value& t, ConvertError&) {
+        t = std::move(v);
+        return true;
+    }
+
+    inline void to_json(value& out, std::monostate) { out = value{ nullptr, out.resource() }; }
+
+    inline bool from_json(const value& v, std::monostate&, ConvertError& err) {
+        return v.is_null() || detail::mismatch(err, "null");
+    }
+
+    template<typename T>
+    void to_json(value& out, const std::optional<T>& o) {
+        if (o) to_json(out, *o);
+        else out = value{ nullptr, out.resource() };
+    }
+
+    template<typename T>
+    bool from_json(const value& v, std::optional<T>& o, ConvertError& err) {
+        if (v.is_null()) {
+            o.reset();
+            return true;
+        }
+        return from_json_into(v, o.emplace(), err);
+    }
+
+    template<typename T>
+    bool from_json(value&& v, std::optional<T>& o, ConvertError& err) {
+        if (v.is_null()) {
+            o.reset();
+            return true;
+        }
+        return from_json_into(std::move(v), o.emplace(), err);
+    }
+
+    template<typename T, typename A>
+    void to_json(value& out, const std::vector<T, A>& vec) {
+        std::pmr::memory_resource* res = out.resource();
+        array arr{ allocator_type{ res } };
+        arr.reserve(vec.size());
+        for (const auto& e : vec) to_json(arr.emplace_back(res), e);
+        out = value{ std::move(arr), res };
+    }
+
+    template<typename T, typename A>
+    bool from_json(const value& v, std::vector<T, A>& vec, ConvertError& err) {
+        return detail::vector_from_json(v, vec, err);
+    }
+
+    template<typename T, typename A>
+    bool from_json(value&& v, std::vector<T, A>& vec, ConvertError& err) {
+        // A `Sonnet::array` takes over the document's array
+        if constexpr (std::same_as<std::vector<T, A>, array>) {
+            if (!v.is_array()) return detail::mismatch(err, "an array");
+            vec = std::move(v.as_array());
+            return true;
+        } else {
+            return detail::vector_from_json(std::move(v), vec, err);
+        }
+    }
+
+    template<typename T, std::size_t N>
+    void to_json(value& out, const std::array<T, N>& a) {
+        std::pmr::memory_resource* res = out.resource();
+        array arr{ allocator_type{ res } };
+        arr.reserve(N);
+        for (const auto& e : a) to_json(arr.emplace_back(res), e);
+        out = value{ std::move(arr), res };
+    }
+
+    template<typename T, std::size_t N>
+    bool from_json(const value& v, std::array<T, N>& a, ConvertError& err) {
+        return detail::std_array_from_json(v, a, err);
+    }
+
+    template<typename T, std::size_t N>
+    bool from_json(value&& v, std::array<T, N>& a, ConvertError& err) {
+        return detail::std_array_from_json(std::move(v), a, err);
+    }
+
+    template<typename... Ts>
+    void to_json(value& out, const std::tuple<Ts...>& t) {
+        std::apply([&](const Ts&... ts) { detail::tuple_to_json(out, ts...); }, t);
+    }
+
+    template<typename... Ts>
+    bool from_json(const value& v, std::tuple<Ts...>& t, ConvertError& err) {
+        return detail::tuple_from_json(v, std::apply([](Ts&... ts) { return std::tie(ts...); }, t), err, std::index_sequence_for<Ts...>{});
+    }
+
+    template<typename... Ts>
+    bool from_json(value&& v, std::tuple<Ts...>& t, ConvertError& err) {
+        return detail::tuple_from_json(std::move(v), std::apply([](Ts&... ts) { return std::tie(ts...); }, t), err, std::index_sequence_for<Ts...>{});
+    }
+
+    template<typename A, typename B>
+    void to_json(value& out, const std::pair<A, B>& p) {
+        detail::tuple_to_json(out, p.first, p.second);
+    }
+
+    template<typename A, typename B>
+    bool from_json(const value& v, std::pair<A, B>& p, ConvertError& err) {
+        return detail::tuple_from_json(v, std::tie(p.first, p.second), err, std::index_sequence_for<A, B>{});
+    }
+
+    template<typename A, typename B>
+    bool from_json(value&& v, std::pair<A, B>& p, ConvertError& err) {
+        return detail::tuple_from_json(std::move(v), std::tie(p.first, p.second), err, std::index_sequence_for<A, B>{});
+    }
+
+    template<typename... Ts>
+    void to_json(value& out, const std::variant<Ts...>& var) {
+        std::visit([&](const auto& alt) { to_json(out, alt); }, var);
+    }
+
+    template<typename... Ts>
+    bool from_json(const value& v, std::variant<Ts...>& var, ConvertError& err) {
+        // Alternatives are tried in order; the first that converts wins
+        bool done = false;
+        auto attempt = [&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+            std::variant_alternative_t<I, std::variant<Ts...>> alt{};
+            ConvertError ignored;
+            if (!from_json_into(v, alt, ignored)) return false;
+            var.template emplace<I>(std::move(alt));
+            return done = true;
+        };
+        [&]<std::size_t... I>(std::index_sequence<I...>) { (attempt(std::integral_constant<std::size_t, I>{}) || ...); }(std::index_sequence_for<Ts...>{});
+        return done || detail::mismatch(err, "a value matching an alternative");
+    }
+
+    namespace detail {
+        template<typename M>
+        void map_to_json(value& out, const M& m) {
+            std::pmr::memory_resource* res = out.resource();
+            object obj{ std::less<>{}, res };
+            for (const auto& [k, e] : m) {
+                value elem{ res };
+                to_json(elem, e);
+                obj.insert_or_assign(string{ std::string_view{ k }, res }, std::move(elem));
+            }
+            out = value{ std::move(obj), res };
+        }
+
+        template<typename V, typename M>
+        bool map_from_json(V&& v, M& m, ConvertError& err) {
+            if (!v.is_object()) return mismatch(err, "an object");
+            // A `Sonnet::object` takes over the document's object
+            if constexpr (std::same_as<M, object> && !std::is_reference_v<V>) {
+                m = std::move(v.as_object());
+                return true;
+            } else {
+                m.clear();
+                if constexpr (requires { m.reserve(v.size()); }) m.reserve(v.size());
+                for (auto& [k, e] : v.as_object()) {
+                    auto it = m.try_emplace(typename M::key_type(k.data(), k.size())).first;
+                    if (!from_json_into(forward_part<V>(e), it->second, err)) return within(err, k);
+                }
+                return true;
+            }
+        }
+    } // namespace detail
+
+    template<typename K, typename T, typename C, typename A>
+        requires detail::is_string<K>::value
+    void to_json(value& out, const std::map<K, T, C, A>& m) {
+        detail::map_to_json(out, m);
+    }
+
+    template<typename K, typename T, typename C, typename A>
+        requires detail::is_string<K>::value
+    bool from_json(const value& v, std::map<K, T, C, A>& m, ConvertError& err) {
+        return detail::map_from_json(v, m, err);
+    }
+
+    template<typename K, typename T, typename C, typename A>
+        requires detail::is_string<K>::value
+    bool from_json(value&& v, std::map<K, T, C, A>& m, ConvertError& err) {
+        return detail::map_from_json(std::move(v), m, err);
+    }
+
+    template<typename K, typename T, typename H, typename E, typename A>
+        requires detail::is_string<K>::value
+    void to_json(value& out, const std::unordered_map<K, T, H, E, A>& m) {
+        detail::map_to_json(out, m);
+    }
+
+    template<typename K, typename T, typename H, typename E, typename A>
+        requires detail::is_string<K>::value
+    bool from_json(const value& v, std::unordered_map<K, T, H, E, A>& m, ConvertError& err) {
+        return detail::map_from_json(v, m, err);
+    }
+
+    template<typename K, typename T, typename H, typename E, typename A>
+        requires detail::is_string<K>::value
+    bool from_json(value&& v, std::unordered_map<K, T, H, E, A>& m, ConvertError& err) {
+        return detail::map_from_json(std::move(v), m, err);
+    }
+
 } // namespace Sonnet
\ No newline at end of file
@@ -0,0 +1,708 @@
+#pragma once
+
+
+/*
+    ---------------------------------------------
+    Sonnet type descriptions - SONNET_DEFINE_TYPE
+    ---------------------------------------------
+    This header turns a list of data members into compile-time field
+    metadata, and generates from it the conversions of `convert.hpp`,
+    a typed parser and a typed writer for the type
+
+    -------------------------
+    Describing a type - macro
+    -------------------------
+    - `SONNET_DEFINE_TYPE(T, m1, m2, ...)` is written once, at namespace
+      scope in the namespace of `T`, and lists the members that make up
+      the JSON object. Each member is stored under its own name
+    - It defines, for argument-dependent lookup:
+        * `to_json(value&, const T&)`, `from_json(const value&, T&)` and
+          `from_json(const value&, T&, ConvertError&)`, so `T` satisfies
+          `JsonSerializable`, `JsonDeserializable` and
+          `JsonCheckedDeserializable`
+        * `from_json` overloads for `value&&` that move each member out
+          of the document (see "Moving Out of a Document" in
+          `convert.hpp`)
+        * `sonnet_describe(describe::tag<T>)`, the field metadata used by
+          the functions below
+    - Members may be any type with a builtin conversion (see "Builtin
+      Conversions" in `convert.hpp`), other described types, or any type
+      with its own `to_json` / `from_json`
+    - The members must be public, and reading needs `T{}` to compile:
+      give `Sonnet::value` members an initializer such as `{ nullptr }`,
+      since its default constructor is explicit
+
+    --------------
+    Field metadata
+    --------------
+    - For each member the description holds its name, a member pointer
+      and the key text `"name":` as it appears in JSON output. Member
+      names are identifiers, so the key text never needs escaping and is
+      spelled out by the macro rather than computed
+    - Keys are matched with a perfect hash built at compile time
+      (hash-and-displace over FNV-1a): one hash of the incoming key picks
+      the only field it can be, and one comparison confirms it. Unknown
+      keys cost the same and are ignored
+    - Members are also ordered by name at compile time, so `to_json`
+      appends them to the object in key order without searching it
+
+    ---------------------------------
+    Conversions - to_json / from_json
+    ---------------------------------
+    - `to_json` always produces an object with every member
+    - `from_json` requires an object holding every member except
+      `std::optional` ones, which are left empty when absent; other
+      members are ignored. A missing member, a value of the wrong kind, or a
+      number that does not fit an integral member throws
+      `std::invalid_argument` naming the JSON Pointer of the member
+    - The checked `from_json` overload is generated as well, so
+      `from_json_value<T>` reports the same failures as a `ConvertError`
+      without throwing, down through nested described members
+
+    -------------------------------------------
+    Typed parsing and writing - parse_as / dump
+    -------------------------------------------
+    - `parse_as<T>(json)` fills a `T` straight from JSON text through the
+      SAX interface (see `sax.hpp`), without building a document.
+      Vectors, `std::array`, string-keyed maps and optionals of readable
+      types are filled in place, vectors reserving the element count
+      when the parser knows it. Only `Sonnet::value`, tuples, variants
+      and types with hand-written `from_json` are materialized, one
+      member at a time, and then moved into the member through the
+      rvalue `from_json`. `T` may also be one of these containers
+    - Conversion failures are reported as a `ParseError` with code
+      `aborted`, the position in the text, and the JSON Pointer of the
+      member in the message
+    - `dump(t)` writes a described `t` straight to JSON text using the
+      pre-escaped keys. The output is byte-for-byte what
+      `dump(serialize(t))` produces, with the same `WriteOptions`
+
+    -----
+    Usage
+    -----
+        namespace shop {
+            struct item  { std::string sku; int qty; double price; };
+            struct order { std::uint64_t id; item line; Sonnet::value meta{ nullptr }; };
+
+            SONNET_DEFINE_TYPE(item, sku, qty, price);
+            SONNET_DEFINE_TYPE(order, id, line, meta);
+        }
+
+        auto o = Sonnet::parse_as<shop::order>(body);
+        if (!o) return bad_request(o.error().msg);
+
+        std::string text = Sonnet::dump(*o);
+*/
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/convert.hpp"
+#include "sonnet/sax.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetDescribe Type Descriptions
+/// @ingroup Sonnet
+/// @brief Compile-time field metadata for user-defined types
+
+namespace Sonnet::describe {
+
+    /// @ingroup SonnetDescribe
+    /// @brief Tag selecting the description of @p T through ADL
+    template<typename T>
+    struct tag {};
+
+    /// @ingroup SonnetDescribe
+    /// @brief One described data member of @p T
+    template<typename T, typename M>
+    struct field {
+        std::string_view name; ///< Member name, used as the JSON key.
+        std::string_view key;  ///< Key text as written: `"name":`.
+        M T::* member;         ///< Pointer to the member.
+    };
+
+    template<typename T, typename M>
+    field(std::string_view, std::string_view, M T::*) -> field<T, M>;
+
+} // namespace Sonnet::describe
+
+namespace Sonnet {
+
+    /// @ingroup SonnetDescribe
+    /// @brief Types described with `SONNET_DEFINE_TYPE`
+    template<typename T>
+    concept Described = requires { sonnet_describe(describe::tag<T>{}); };
+
+} // namespace Sonnet
+
+namespace Sonnet::describe {
+
+    /// @ingroup SonnetDescribe
+    /// @brief The fields of @p T, as a `std::tuple` of `field`
+    template<Described T>
+    inline constexpr auto fields_of = sonnet_describe(tag<T>{});
+
+    namespace detail {
+        inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        template<Described T>
+        inline constexpr std::size_t count = std::tuple_size_v<std::remove_cvref_t<decltype(fields_of<T>)>>;
+
+        template<Described T>
+        inline constexpr auto names = std::apply([](const auto&... f) { return std::array<std::string_view, sizeof...(f)>{ f.name... }; }, fields_of<T>);
+
+        // Field indexes ordered by name, which is the order of the members
+        // of a `Sonnet::object`
+        template<Described T>
+        inline constexpr auto order = [] {
+            std::array<std::size_t, count<T>> idx{};
+            for (std::size_t i = 0; i < idx.size(); i++) idx[i] = i;
+            std::sort(idx.begin(), idx.end(), [](std::size_t l, std::size_t r) { return names<T>[l] < names<T>[r]; });
+            for (std::size_t i = 1; i < idx.size(); i++) {
+                if (names<T>[idx[i - 1]] == names<T>[idx[i]]) throw "SONNET_DEFINE_TYPE: member listed twice";
+            }
+            return idx;
+        }();
+
+        constexpr std::uint64_t key_hash(std::string_view key) noexcept {
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            for (char c : key) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 0x100000001b3ull;
+            }
+            return h;
+        }
+
+        constexpr std::size_t displace(std::uint64_t h, std::uint32_t d, std::size_t mask) noexcept {
+            h ^= d * 0x9e3779b97f4a7c15ull;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            return static_cast<std::size_t>(h) & mask;
+        }
+
+        // Perfect hash over the names of N fields: the key hash picks a
+        // bucket, the bucket's displacement picks the slot
+        template<std::size_t N>
+        struct KeyTable {
+            static constexpr std::size_t buckets = std::bit_ceil(std::max<std::size_t>(N, 1));
+            static constexpr std::size_t slots = 2 * buckets;
+
+            std::array<std::uint32_t, buckets> disp{};
+            std::array<std::uint32_t, slots> field{}; // field index + 1, 0 when empty
+
+            constexpr std::size_t find(std::string_view key, const std::array<std::string_view, N>& names) const noexcept {
+                const std::uint64_t h = key_hash(key);
+                const std::uint32_t f = field[displace(h, disp[h & (buckets - 1)], slots - 1)];
+                return f != 0 && names[f - 1] == key ? f - 1 : npos;
+            }
+        };
+
+        template<std::size_t N>
+        constexpr KeyTable<N> make_key_table(const std::array<std::string_view, N>& names) {
+            using table = KeyTable<N>;
+            table t;
+            std::array<std::uint64_t, N> h{};
+            std::array<std::size_t, table::buckets> size{};
+            for (std::size_t i = 0; i < N; i++) {
+                h[i] = key_hash(names[i]);
+                size[h[i] & (table::buckets - 1)]++;
+            }
+
+            // Place the fullest buckets first, while most slots are free
+            std::array<std::size_t, table::buckets> by_size{};
+            for (std::size_t b = 0; b < by_size.size(); b++) by_size[b] = b;
+            std::sort(by_size.begin(), by_size.end(), [&](std::size_t l, std::size_t r) { return size[l] > size[r]; });
+
+            for (std::size_t b : by_size) {
+                if (size[b] == 0) break;
+                for (std::uint32_t d = 1;; d++) {
+                    if (d == 1u << 20) throw "SONNET_DEFINE_TYPE: no perfect hash for the member names";
+                    std::array<std::size_t, N> placed{};
+                    std::size_t n = 0;
+                    bool ok = true;
+                    for (std::size_t i = 0; i < N && ok; i++) {
+                        if ((h[i] & (table::buckets - 1)) != b) continue;
+                        const std::size_t s = displace(h[i], d, table::slots - 1);
+                        ok = t.field[s] == 0;
+                        for (std::size_t j = 0; j < n && ok; j++) ok = placed[j] != s;
+                        placed[n++] = s;
+                    }
+                    if (!ok) continue;
+
+                    t.disp[b] = d;
+                    for (std::size_t i = 0; i < N; i++) {
+                        if ((h[i] & (table::buckets - 1)) == b) t.field[displace(h[i], d, table::slots - 1)] = static_cast<std::uint32_t>(i + 1);
+                    }
+                    break;
+                }
+            }
+            return t;
+        }
+
+        template<Described T>
+        inline constexpr auto keys = make_key_table(names<T>);
+
+        using Sonnet::detail::Scalar;
+        using Sonnet::detail::scalar_of;
+        using Sonnet::detail::assign;
+        using Sonnet::detail::fail;
+        using Sonnet::detail::mismatch;
+        using Sonnet::detail::within;
+        using Sonnet::detail::is_optional;
+
+        template<typename M>
+        struct is_sequence : std::false_type {};
+
+        // vector<bool> has no element references to fill in; it goes
+        // through its `from_json` instead
+        template<typename T, typename A>
+            requires (!std::same_as<T, bool>)
+        struct is_sequence<std::vector<T, A>> : std::true_type {};
+
+        template<typename T, std::size_t N>
+        struct is_sequence<std::array<T, N>> : std::true_type {};
+
+        template<typename M>
+        struct is_bit_vector : std::false_type {};
+
+        template<typename A>
+        struct is_bit_vector<std::vector<bool, A>> : std::true_type {};
+
+        template<typename M>
+        struct is_tuple : std::false_type {};
+
+        template<typename... Ts>
+        struct is_tuple<std::tuple<Ts...>> : std::true_type {};
+
+        template<typename A, typename B>
+        struct is_tuple<std::pair<A, B>> : std::true_type {};
+
+        template<typename M>
+        struct is_variant : std::false_type {};
+
+        template<typename... Ts>
+        struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+        template<typename M>
+        struct is_string_map : std::false_type {};
+
+        template<typename K, typename T, typename C, typename A>
+        struct is_string_map<std::map<K, T, C, A>> : Sonnet::detail::is_string<K> {};
+
+        template<typename K, typename T, typename H, typename E, typename A>
+        struct is_string_map<std::unordered_map<K, T, H, E, A>> : Sonnet::detail::is_string<K> {};
+
+        // How a member type is read and written
+        enum class Shape : std::uint8_t {
+            none,     ///< Not convertible
+            scalar,   ///< bool, arithmetic, enum, duration or string
+            object,   ///< Described type
+            array,    ///< std::vector or std::array
+            map,      ///< std::map or std::unordered_map with string keys
+            optional, ///< std::optional
+            dom,      ///< Anything else with a `from_json`, read from a `Sonnet::value`
+        };
+
+        template<typename M>
+        consteval Shape shape_of() {
+            // Enums with a converter of their own go through it
+            if constexpr (Sonnet::detail::JsonScalar<M> && !(std::is_enum_v<M> && JsonDeserializable<M>)) return Shape::scalar;
+            else if constexpr (Described<M>) return Shape::object;
+            else if constexpr (is_optional<M>::value) return shape_of<typename M::value_type>() == Shape::none ? Shape::none : Shape::optional;
+            else if constexpr (is_sequence<M>::value) return shape_of<typename M::value_type>() == Shape::none ? Shape::none : Shape::array;
+            else if constexpr (is_string_map<M>::value) return shape_of<typename M::mapped_type>() == Shape::none ? Shape::none : Shape::map;
+            else if constexpr (JsonCheckedDeserializable<M> || JsonDeserializable<M>) return Shape::dom;
+            else return Shape::none;
+        }
+
+        template<typename M>
+        constexpr std::string_view expects() noexcept {
+            constexpr Shape shape = shape_of<M>();
+            if constexpr (shape == Shape::scalar) return Sonnet::detail::expects<M>();
+            else if constexpr (shape == Shape::array) return "an array";
+            else if constexpr (shape == Shape::optional) return expects<typename M::value_type>();
+            else return "an object";
+        }
+
+        // `V` is `const value&`, or `value` when reading moves out of
+        // the document
+        template<typename V, typename M>
+        bool read(V&& v, M& m, ConvertError& err);
+
+        // Whether every member must be present; optional ones may be absent
+        template<Described T>
+        inline constexpr auto required = std::apply([](const auto&... f) {
+            return std::array<bool, sizeof...(f)>{ !is_optional<std::remove_cvref_t<decltype(std::declval<T&>().*f.member)>>::value... };
+        }, fields_of<T>);
+
+        template<typename V, Described T>
+        bool read_object(V&& v, T& t, ConvertError& err) {
+            constexpr std::size_t n = count<T>;
+            if (!v.is_object()) return mismatch(err, "an object");
+
+            constexpr auto members = []<std::size_t... I>(std::index_sequence<I...>) {
+                return std::array<bool (*)(V&&, T&, ConvertError&), n>{
+                    +[](V&& src, T& dst, ConvertError& e) { return read(std::forward<V>(src), dst.*std::get<I>(fields_of<T>).member, e); }...
+                };
+            }(std::make_index_sequence<n>{});
+
+            std::array<bool, n> seen{};
+            for (auto& [k, m] : v.as_object()) {
+                const std::size_t i = keys<T>.find(k, names<T>);
+                if (i == npos) continue;
+                seen[i] = true;
+                if (!members[i](Sonnet::detail::forward_part<V>(m), t, err)) return within(err, names<T>[i]);
+            }
+            for (std::size_t i = 0; i < n; i++) {
+                if (seen[i] || !required<T>[i]) continue;
+                within(err, names<T>[i]);
+                return fail(err, ConvertError::code::missing_member, "missing member");
+            }
+            return true;
+        }
+
+        template<typename V, typename M>
+        bool read(V&& v, M& m, ConvertError& err) {
+            constexpr Shape shape = shape_of<M>();
+            static_assert(shape != Shape::none, "Sonnet: member type has no JSON conversion");
+            // `Sonnet::string` members may take over the document's buffer
+            if constexpr (shape == Shape::scalar && !std::same_as<M, string>) return assign(m, scalar_of(v), err);
+            else if constexpr (shape == Shape::object) return read_object(std::forward<V>(v), m, err);
+            else return from_json_into(std::forward<V>(v), m, err);
+        }
+
+        template<Described T>
+        void write_value(value& out, const T& t) {
+            std::pmr::memory_resource* res = out.resource();
+            object obj{ std::less<>{}, res };
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                ((to_json(obj.emplace_hint(obj.end(), std::piecewise_construct, std::forward_as_tuple(std::get<order<T>[I]>(fields_of<T>).name), std::forward_as_tuple(res))->second,
+                          t.*std::get<order<T>[I]>(fields_of<T>).member)), ...);
+            }(std::make_index_sequence<count<T>>{});
+            out = value{ std::move(obj), res };
+        }
+
+        template<typename V, Described T>
+        void read_value(V&& v, T& t) {
+            ConvertError err;
+            if (!read_object(std::forward<V>(v), t, err)) throw std::invalid_argument{ "Sonnet::from_json: " + (err.path.empty() ? err.msg : err.path + ": " + err.msg) };
+        }
+
+        /// @brief Appends JSON text for the typed writer; formatting
+        ///        matches `Sonnet::dump` with the same options
+        class Emitter {
+        public:
+            Emitter(std::string& out, const WriteOptions& opts) noexcept
+                : m_Out{ out }, m_Opts{ opts }, m_Pretty{ opts.pretty && !opts.canonical } {}
+
+            void null() { m_Out.append("null"); }
+            void boolean(bool b) { m_Out.append(b ? "true" : "false"); }
+            SONNET_API void number(double d);
+            SONNET_API void string(std::string_view s);
+            SONNET_API void dom(const value& v);
+
+            [[nodiscard]] bool canonical() const noexcept { return m_Opts.canonical; }
+
+            void begin_object() { open('{'); }
+            void end_object() { close('}'); }
+            void begin_array() { open('['); }
+            void end_array() { close(']'); }
+
+            // `key` is the pre-escaped text `"name":`
+            void member(std::string_view key) {
+                element();
+                m_Out.append(key);
+                if (m_Pretty) m_Out.push_back(' ');
+            }
+
+            // Writes a key that may need escaping
+            void member_name(std::string_view k) {
+                element();
+                string(k);
+                m_Out.append(m_Pretty ? ": " : ":");
+            }
+
+            void element() {
+                if (!m_First) m_Out.push_back(',');
+                m_First = false;
+                if (m_Pretty) newline(m_Depth);
+            }
+
+        private:
+            void open(char c) {
+                m_Out.push_back(c);
+                m_Depth++;
+                m_First = true;
+            }
+
+            void close(char c) {
+                m_Depth--;
+                if (m_Pretty && !m_First) newline(m_Depth);
+                m_First = false;
+                m_Out.push_back(c);
+            }
+
+            void newline(std::size_t depth) {
+                m_Out.push_back('\n');
+                m_Out.append(depth * m_Opts.indent, ' ');
+            }
+
+            std::string& m_Out;
+            const WriteOptions& m_Opts;
+            bool m_Pretty;
+            bool m_First = false;
+            std::size_t m_Depth = 0;
+        };
+
+        template<typename M>
+        void write(Emitter& e, const M& m);
+
+        template<typename... Ts>
+        void write_elements(Emitter& e, const Ts&... ts) {
+            e.begin_array();
+            ((e.element(), write(e, ts)), ...);
+            e.end_array();
+        }
+
+        template<typename M>
+        void write(Emitter& e, const M& m) {
+            if constexpr (std::same_as<M, bool>) e.boolean(m);
+            else if constexpr (std::is_arithmetic_v<M>) e.number(static_cast<double>(m));
+            else if constexpr (std::is_enum_v<M> && !JsonDeserializable<M>) e.number(static_cast<double>(std::to_underlying(m)));
+            else if constexpr (Sonnet::detail::is_duration<M>::value) e.number(static_cast<double>(m.count()));
+            else if constexpr (std::convertible_to<const M&, std::string_view> && !std::same_as<M, value>) e.string(std::string_view{ m });
+            else if constexpr (Described<M>) {
+                e.begin_object();
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    ((e.member(std::get<order<M>[I]>(fields_of<M>).key), write(e, m.*std::get<order<M>[I]>(fields_of<M>).member)), ...);
+                }(std::make_index_sequence<count<M>>{});
+                e.end_object();
+            } else if constexpr (is_optional<M>::value) {
+                if (m) write(e, *m);
+                else e.null();
+            } else if constexpr (is_sequence<M>::value || is_bit_vector<M>::value) {
+                e.begin_array();
+                for (const auto& x : m) {
+                    e.element();
+                    write(e, x);
+                }
+                e.end_array();
+            } else if constexpr (is_string_map<M>::value) {
+                // Members go out in byte order of their keys, as a
+                // `Sonnet::object` holds them; canonical output orders by
+                // UTF-16 code units instead and goes through the DOM
+                if (e.canonical()) return e.dom(serialize(m));
+                std::vector<const typename M::value_type*> members;
+                members.reserve(m.size());
+                for (const auto& kv : m) members.push_back(&kv);
+                if constexpr (!std::same_as<M, std::map<typename M::key_type, typename M::mapped_type, std::less<typename M::key_type>, typename M::allocator_type>> &&
+                              !std::same_as<M, std::map<typename M::key_type, typename M::mapped_type, std::less<>, typename M::allocator_type>>)
+                    std::sort(members.begin(), members.end(), [](auto* l, auto* r) { return std::string_view{ l->first } < std::string_view{ r->first }; });
+                e.begin_object();
+                for (const auto* kv : members) {
+                    e.member_name(kv->first);
+                    write(e, kv->second);
+                }
+                e.end_object();
+            } else if constexpr (is_tuple<M>::value) {
+                std::apply([&](const auto&... ts) { write_elements(e, ts...); }, m);
+            } else if constexpr (is_variant<M>::value) {
+                std::visit([&](const auto& alt) { write(e, alt); }, m);
+            } else if constexpr (std::same_as<M, std::monostate>) e.null();
+            else if constexpr (std::same_as<M, value>) e.dom(m);
+            else e.dom(serialize(m));
+        }
+
+        struct Reader;
+
+        /// @brief An object the typed parser is filling in
+        struct Slot {
+            void* obj = nullptr;
+            const Reader* reader = nullptr;
+        };
+
+        /// @brief How the typed parser fills in one C++ type
+        struct Reader {
+            Shape shape = Shape::none;
+            std::string_view expects{};
+            bool (*scalar)(void* obj, const Scalar& s, ConvertError& err) = nullptr;           ///< scalar: stores a scalar
+            bool (*adopt)(void* obj, value&& v, ConvertError& err) = nullptr;                 ///< dom: takes a materialized value
+            std::size_t (*find)(std::string_view key) = nullptr;                              ///< object: field index of a key, or npos
+            Slot (*member)(void* obj, std::size_t field) = nullptr;                           ///< object: the member to fill in
+            const std::string_view* names = nullptr;                                          ///< object: field names
+            const bool* required = nullptr;                                                   ///< object: whether each field must be present
+            std::size_t fields = 0;                                                           ///< object: field count
+            void (*begin)(void* obj, std::size_t size) = nullptr;                             ///< array, map: empties it, reserving `size` if known
+            Slot (*element)(void* obj, std::size_t index) = nullptr;                          ///< array: the element to fill in, empty past a fixed size
+            bool (*finish)(void* obj, std::size_t count, ConvertError& err) = nullptr;        ///< array: checks the element count
+            Slot (*entry)(void* obj, std::string_view key) = nullptr;                         ///< map: the entry to fill in
+            Slot (*engage)(void* obj) = nullptr;                                              ///< optional: the contained value to fill in
+            void (*disengage)(void* obj) = nullptr;                                           ///< optional: resets it
+        };
+
+        template<typename M>
+        consteval Reader make_reader();
+
+        template<typename M>
+        inline constexpr Reader reader_of = make_reader<M>();
+
+        template<typename M>
+        consteval Reader make_reader() {
+            constexpr Shape shape = shape_of<M>();
+            static_assert(shape != Shape::none, "Sonnet: member type has no JSON conversion");
+
+            Reader r;
+            r.shape = shape;
+            r.expects = expects<M>();
+            if constexpr (shape == Shape::scalar) {
+                r.scalar = +[](void* obj, const Scalar& s, ConvertError& err) { return assign(*static_cast<M*>(obj), s, err); };
+            } else if constexpr (shape == Shape::object) {
+                r.find = +[](std::string_view key) { return keys<M>.find(key, names<M>); };
+                r.member = +[](void* obj, std::size_t i) {
+                    constexpr auto slots = []<std::size_t... I>(std::index_sequence<I...>) {
+                        return std::array<Slot (*)(void*), count<M>>{ +[](void* o) {
+                            auto& m = static_cast<M*>(o)->*std::get<I>(fields_of<M>).member;
+                            return Slot{ &m, &reader_of<std::remove_cvref_t<decltype(m)>> };
+                        }... };
+                    }(std::make_index_sequence<count<M>>{});
+                    return slots[i](obj);
+                };
+                r.names = names<M>.data();
+                r.required = required<M>.data();
+                r.fields = count<M>;
+            } else if constexpr (shape == Shape::array) {
+                using T = typename M::value_type;
+                if constexpr (requires(M& m) { m.emplace_back(); }) {
+                    r.begin = +[](void* obj, std::size_t size) {
+                        auto& vec = *static_cast<M*>(obj);
+                        vec.clear();
+                        if (size != SaxHandler::unknown_size) vec.reserve(size);
+                    };
+                    r.element = +[](void* obj, std::size_t) { return Slot{ &static_cast<M*>(obj)->emplace_back(), &reader_of<T> }; };
+                    r.finish = +[](void*, std::size_t, ConvertError&) { return true; };
+                } else {
+                    constexpr std::size_t n = std::tuple_size_v<M>;
+                    r.begin = +[](void*, std::size_t) {};
+                    r.element = +[](void* obj, std::size_t i) { return i < n ? Slot{ &(*static_cast<M*>(obj))[i], &reader_of<T> } : Slot{}; };
+                    r.finish = +[](void*, std::size_t count, ConvertError& err) {
+                        return count == n || fail(err, ConvertError::code::invalid_value, "expected an array of " + std::to_string(n) + " elements");
+                    };
+                }
+            } else if constexpr (shape == Shape::map) {
+                using K = typename M::key_type;
+                r.begin = +[](void* obj, std::size_t size) {
+                    auto& m = *static_cast<M*>(obj);
+                    m.clear();
+                    if constexpr (requires { m.reserve(size); }) {
+                        if (size != SaxHandler::unknown_size) m.reserve(size);
+                    }
+                };
+                r.entry = +[](void* obj, std::string_view key) {
+                    auto it = static_cast<M*>(obj)->try_emplace(K(key.data(), key.size())).first;
+                    return Slot{ &it->second, &reader_of<typename M::mapped_type> };
+                };
+            } else if constexpr (shape == Shape::optional) {
+                r.engage = +[](void* obj) { return Slot{ &static_cast<M*>(obj)->emplace(), &reader_of<typename M::value_type> }; };
+                r.disengage = +[](void* obj) { static_cast<M*>(obj)->reset(); };
+            } else {
+                r.adopt = +[](void* obj, value&& v, ConvertError& err) { return read(std::move(v), *static_cast<M*>(obj), err); };
+            }
+            return r;
+        }
+
+        /// @brief Parses @p json into the object of @p root
+        [[nodiscard]] SONNET_API std::expected<void, ParseError> parse_into(std::string_view json, Slot root, const ParseOptions& opts);
+
+    } // namespace detail
+
+} // namespace Sonnet::describe
+
+namespace Sonnet {
+
+    /// @ingroup SonnetDescribe
+    /// @brief Parses JSON text straight into a @p T
+    ///
+    /// @details
+    /// No document is built; see "Typed parsing and writing" above.
+    /// @return The parsed value, or the parse error or conversion failure
+    template<typename T>
+        requires std::default_initializable<T> && (describe::detail::shape_of<T>() != describe::detail::Shape::none)
+    [[nodiscard]] std::expected<T, ParseError> parse_as(std::string_view json, const ParseOptions& opts = {}) {
+        T t{};
+        if (auto r = describe::detail::parse_into(json, { &t, &describe::detail::reader_of<T> }, opts); !r) return std::unexpected(std::move(r.error()));
+        return t;
+    }
+
+    /// @ingroup SonnetDescribe
+    /// @brief Writes a described type straight to JSON text
+    /// @return The same text as `dump(serialize(t), opts)`
+    template<Described T>
+    [[nodiscard]] std::string dump(const T& t, const WriteOptions& opts = {}) {
+        std::string out;
+        describe::detail::Emitter e{ out, opts };
+        describe::detail::write(e, t);
+        return out;
+    }
+
+} // namespace Sonnet
+
+#define SONNET_DETAIL_PARENS ()
+#define SONNET_DETAIL_EXPAND(...) SONNET_DETAIL_EXPAND4(SONNET_DETAIL_EXPAND4(SONNET_DETAIL_EXPAND4(SONNET_DETAIL_EXPAND4(__VA_ARGS__))))
+#define SONNET_DETAIL_EXPAND4(...) SONNET_DETAIL_EXPAND3(SONNET_DETAIL_EXPAND3(SONNET_DETAIL_EXPAND3(SONNET_DETAIL_EXPAND3(__VA_ARGS__))))
+#define SONNET_DETAIL_EXPAND3(...) SONNET_DETAIL_EXPAND2(SONNET_DETAIL_EXPAND2(SONNET_DETAIL_EXPAND2(SONNET_DETAIL_EXPAND2(__VA_ARGS__))))
+#define SONNET_DETAIL_EXPAND2(...) SONNET_DETAIL_EXPAND1(SONNET_DETAIL_EXPAND1(SONNET_DETAIL_EXPAND1(SONNET_DETAIL_EXPAND1(__VA_ARGS__))))
+#define SONNET_DETAIL_EXPAND1(...) __VA_ARGS__
+
+#define SONNET_DETAIL_FIELD(T, m) ::Sonnet::describe::field{ std::string_view{ #m }, std::string_view{ "\"" #m "\":" }, &T::m }
+#define SONNET_DETAIL_FIELDS(T, ...) __VA_OPT__(SONNET_DETAIL_EXPAND(SONNET_DETAIL_FIELDS_STEP(T, __VA_ARGS__)))
+#define SONNET_DETAIL_FIELDS_STEP(T, m, ...) SONNET_DETAIL_FIELD(T, m) __VA_OPT__(, SONNET_DETAIL_FIELDS_AGAIN SONNET_DETAIL_PARENS (T, __VA_ARGS__))
+#define SONNET_DETAIL_FIELDS_AGAIN() SONNET_DETAIL_FIELDS_STEP
+
+/// @ingroup SonnetDescribe
+/// @brief Describes the data members of @p T that form its JSON object
+///
+/// @details
+/// Write it at namespace scope in the namespace of @p T, followed by a
+/// semicolon. Up to 256 members can be listed.
+#define SONNET_DEFINE_TYPE(T, ...)                                                           \
+    [[maybe_unused]] constexpr auto sonnet_describe(::Sonnet::describe::tag<T>) noexcept {   \
+        return std::tuple{ SONNET_DETAIL_FIELDS(T, __VA_ARGS__) };                           \
+    }                                                                                        \
+    inline void to_json(::Sonnet::value& out, const T& src) {                                \
+        ::Sonnet::describe::detail::write_value(out, src);                                   \
+    }                                                                                        \
+    inline void from_json(const ::Sonnet::value& src, T& out) {                              \
+        ::Sonnet::describe::detail::read_value(src, out);                                    \
+    }                                                                                        \
+    inline bool from_json(const ::Sonnet::value& src, T& out, ::Sonnet::ConvertError& err) { \
+        return ::Sonnet::describe::detail::read_object(src, out, err);                       \
+    }                                                                                        \
+    inline void from_json(::Sonnet::value&& src, T& out) {                                   \
+        ::Sonnet::describe::detail::read_value(::std::move(src), out);                       \
+    }                                                                                        \
+    inline bool from_json(::Sonnet::value&& src, T& out, ::Sonnet::ConvertError& err) {      \
+        return ::Sonnet::describe::detail::read_object(::std::move(src), out, err);          \
+    }                                                                                        \
+    static_assert(true)
@@ -0,0 +1,97 @@
+#pragma once
+
+
+/*
+    ----------------------------------------
+    Sonnet diff - structural differences
+    ----------------------------------------
+    This header computes the differences between two `Sonnet::value`
+    trees, as a list of changes or as an RFC 6902 JSON Patch
+
+    ---------
+    Functions
+    ---------
+    - `diff_changes(a, b)` returns `Change` records (`add`, `remove` or
+      `replace` at a JSON Pointer path). New values are not copied: each
+      record points at the node in `b`
+    - `diff(a, b)` returns the same changes as a JSON Patch document;
+      `apply_patch(a, diff(a, b))` turns `a` into `b`
+
+    ---------
+    Algorithm
+    ---------
+    - Every container of both trees is hashed once (a 64-bit structural
+      hash); subtrees whose hashes match are skipped without being walked
+      again. A hash collision between different subtrees, which has a
+      probability of about 2^-64 per comparison, would hide a change
+    - Objects are merged key by key in sorted order: missing keys become
+      `remove`, new keys `add`, common keys are compared recursively
+    - Arrays are aligned with Myers' O((N+M)D) algorithm on element hashes
+      after trimming the common prefix and suffix. A removed element
+      followed by an added one is treated as a modification and compared
+      recursively, so a changed field in one row does not replace the row
+    - `DiffOptions::array_edit_limit` bounds D; past it the remaining
+      elements are compared index by index, which is always correct but
+      may produce more operations
+    - Packed arrays (see `value::pack`) that differ are replaced whole
+
+    -----
+    Usage
+    -----
+        Sonnet::value patch = Sonnet::diff(previous, current);
+        send(Sonnet::dump(patch));
+
+        for (const auto& c : Sonnet::diff_changes(previous, current)) log(c.path);
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetDiff Diff
+/// @ingroup Sonnet
+/// @brief Structural differences between values
+
+namespace Sonnet {
+
+    /// @ingroup SonnetDiff
+    /// @brief Kind of a `Change`
+    enum class change_kind : std::uint8_t {
+        add,     ///< A member or element was inserted
+        remove,  ///< A member or element was removed
+        replace, ///< A value was replaced
+    };
+
+    /// @ingroup SonnetDiff
+    /// @brief One difference between two values
+    struct Change {
+        change_kind kind = change_kind::replace;
+        std::string path;              ///< JSON Pointer, valid after the preceding changes are applied
+        const value* target = nullptr; ///< New value inside the second document; `nullptr` for `remove`
+    };
+
+    /// @ingroup SonnetDiff
+    /// @brief Settings for `diff` and `diff_changes`
+    struct DiffOptions {
+        /// @brief Maximum number of insertions plus deletions searched for
+        ///        when aligning two arrays
+        std::size_t array_edit_limit = 512;
+    };
+
+    /// @ingroup SonnetDiff
+    /// @brief Lists the changes that turn @p a into @p b
+    ///
+    /// @details
+    /// The changes are ordered so that applying them one after another is
+    /// valid. The returned records point into @p b, which must outlive them.
+    [[nodiscard]] SONNET_API std::vector<Change> diff_changes(const value& a, const value& b, const DiffOptions& opts = {});
+
+    /// @ingroup SonnetDiff
+    /// @brief Returns an RFC 6902 JSON Patch that turns @p a into @p b
+    [[nodiscard]] SONNET_API value diff(const value& a, const value& b, const DiffOptions& opts = {});
+
+} // namespace Sonnet
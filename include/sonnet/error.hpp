@@ -22,6 +22,8 @@
             - `trailing_comma_not_allowed`
             - `io_error`
             - `depth_limit_exceeded`
+            - `unsupported_type`
+            - `aborted`
         * The exact set of codes is documented alongside enum definition
     - `size_t offset`:
         * Byte offset from the start of the input where the error was detected
@@ -127,6 +129,11 @@ namespace Sonnet {
         /// - `depth_limit_exceeded`
         ///     Successfully parse a complete JSON value, but maximum nesting depth
         ///     was reached. Off by default.
+        /// - `unsupported_type`
+        ///     A binary encoding (CBOR, MessagePack) contains an item that has no
+        ///     JSON equivalent, e.g. a map key that is not a string.
+        /// - `aborted`
+        ///     A `SaxHandler` callback returned `false` and decoding was stopped.
         enum class code : uint8_t {
             unexpected_character,   ///< Invalid or unexpected character.
             invalid_number,         ///< Malformed numeric literal.
@@ -136,6 +143,8 @@ namespace Sonnet {
             unexpected_end_of_input,///< Input ended prematurely.
             trailing_characters,    ///< Extra characters after valid JSON.
             depth_limit_exceeded,   ///< Maximum depth limit exceeded.
+            unsupported_type,       ///< Binary item with no JSON equivalent.
+            aborted,                ///< Stopped by a SAX handler.
         };
 
         code errc{};       ///< The classification of the parsing error.
@@ -0,0 +1,216 @@
+#pragma once
+
+
+/*
+    -------------------------------------------------
+    Sonnet frozen documents - zero-copy binary format
+    -------------------------------------------------
+    This header defines a read-only binary representation of a JSON
+    document that can be used in place, straight from a memory-mapped file,
+    without parsing and without allocating
+
+    ------
+    Layout
+    ------
+    - A document is a 16-byte header (`SNFZ` magic, format version, total
+      size) followed by the root node. All integers are little-endian
+    - Every node starts with a one-byte kind:
+        * null, false, true: the kind byte only
+        * number: the kind byte and an IEEE 754 double
+        * string: the kind byte, a 32-bit byte length and the UTF-8 bytes
+        * array: the kind byte, a 32-bit count and one 32-bit offset per
+          element
+        * object: the kind byte, a 32-bit count and one (key, value) pair of
+          32-bit offsets per member, sorted by key bytes
+    - Offsets are relative to the position of the offset field itself, so
+      a document has no absolute addresses and can be mapped anywhere
+    - Children follow their container in order; a single document is
+      limited to 4 GiB
+
+    --------------------------------
+    Writing - freeze(const value&)
+    --------------------------------
+    - `freeze(v)` returns the frozen bytes; `freeze(v, os)` writes them to
+      a stream (e.g. a file that is later mapped)
+
+    ------------------------
+    Reading - frozen_view
+    ------------------------
+    - `open_frozen(bytes)` checks the header and returns a `frozen_view` of
+      the root. Views are a single pointer and are copied freely
+    - Object lookups (`find`, `at`) binary-search the sorted key table;
+      array indexing is a single offset load. Pages of a mapped file are
+      only touched when the nodes on them are visited
+    - `open_frozen` trusts the body of the document. Input from untrusted
+      sources should be checked once with `verify_frozen`, which walks the
+      whole document and rejects truncated, out-of-order or non-canonical
+      layouts
+    - `view.to_value(res)` materializes a regular `value`
+
+    -------------------------
+    Mapping - MappedFile
+    -------------------------
+    - `MappedFile::open(path)` maps a file read-only; the mapping is
+      released when the `MappedFile` is destroyed. Views into it must not
+      outlive it
+    - On platforms without `mmap` the file is read into memory instead
+
+    -----
+    Usage
+    -----
+        std::ofstream out{ "ref.snfz", std::ios::binary };
+        Sonnet::freeze(dataset, out);
+
+        auto file = Sonnet::MappedFile::open("ref.snfz");
+        auto root = Sonnet::open_frozen(file->bytes());
+        double rate = root->at("rates").at("EUR").as_number();
+*/
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <iosfwd>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetFrozen Frozen Documents
+/// @ingroup Sonnet
+/// @brief Zero-copy binary documents readable in place
+
+namespace Sonnet {
+
+    /// @ingroup SonnetFrozen
+    /// @brief Read-only view of a node inside a frozen document
+    ///
+    /// @details
+    /// A view is a pointer into the document bytes; it performs no
+    /// allocation and stays valid as long as those bytes do. Accessors on
+    /// the wrong kind throw `std::invalid_argument`.
+    class frozen_view {
+    public:
+        /// @ingroup SonnetFrozen
+        /// @brief Constructs a view of `null`
+        SONNET_API frozen_view() noexcept;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Returns the kind of the viewed node
+        [[nodiscard]] SONNET_API kind type() const noexcept;
+
+        [[nodiscard]] bool is_null()   const noexcept { return type() == kind::null;    }
+        [[nodiscard]] bool is_bool()   const noexcept { return type() == kind::boolean; }
+        [[nodiscard]] bool is_number() const noexcept { return type() == kind::number;  }
+        [[nodiscard]] bool is_string() const noexcept { return type() == kind::string;  }
+        [[nodiscard]] bool is_array()  const noexcept { return type() == kind::array;   }
+        [[nodiscard]] bool is_object() const noexcept { return type() == kind::object;  }
+
+        [[nodiscard]] SONNET_API bool as_bool() const;
+        [[nodiscard]] SONNET_API double as_number() const;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Returns the string bytes, pointing into the document
+        [[nodiscard]] SONNET_API std::string_view as_string() const;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Number of elements or members; 0 for scalars
+        [[nodiscard]] SONNET_API std::size_t size() const noexcept;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Returns the element at @p idx, or a view of `null` when
+        ///        this is not an array or @p idx is out of range
+        [[nodiscard]] SONNET_API frozen_view operator[](std::size_t idx) const noexcept;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Looks up @p key by binary search
+        /// @return The member value, or `std::nullopt` if absent or not an object
+        [[nodiscard]] SONNET_API std::optional<frozen_view> find(std::string_view key) const noexcept;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Like `find`, but throws `std::out_of_range` if @p key is absent
+        [[nodiscard]] SONNET_API frozen_view at(std::string_view key) const;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Key of the @p idx-th member in key order
+        [[nodiscard]] SONNET_API std::string_view key(std::size_t idx) const;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Value of the @p idx-th member in key order
+        [[nodiscard]] SONNET_API frozen_view member(std::size_t idx) const;
+
+        /// @ingroup SonnetFrozen
+        /// @brief Copies the viewed subtree into a `value` allocated from @p res
+        [[nodiscard]] SONNET_API value to_value(std::pmr::memory_resource* res = std::pmr::get_default_resource()) const;
+
+    private:
+        explicit frozen_view(const std::byte* node) noexcept : m_Node{ node } {}
+
+        friend SONNET_API std::expected<frozen_view, ParseError> open_frozen(std::span<const std::byte> bytes);
+
+        const std::byte* m_Node;
+    };
+
+    /// @ingroup SonnetFrozen
+    /// @brief Encodes @p v as a frozen document
+    /// @throws std::length_error if the document would exceed 4 GiB
+    [[nodiscard]] SONNET_API std::vector<std::byte> freeze(const value& v);
+
+    /// @ingroup SonnetFrozen
+    /// @brief Writes the frozen encoding of @p v to @p os
+    SONNET_API void freeze(const value& v, std::ostream& os);
+
+    /// @ingroup SonnetFrozen
+    /// @brief Returns a view of the root of the frozen document in @p bytes
+    ///
+    /// @details
+    /// Only the header is checked; see `verify_frozen` for untrusted input.
+    /// @p bytes must outlive every view derived from the result.
+    [[nodiscard]] SONNET_API std::expected<frozen_view, ParseError> open_frozen(std::span<const std::byte> bytes);
+
+    /// @ingroup SonnetFrozen
+    /// @brief Checks that @p bytes hold a well-formed frozen document
+    ///
+    /// @details
+    /// Walks every node once: offsets must stay inside the buffer and
+    /// follow the canonical layout, strings must be valid UTF-8 and object
+    /// keys strictly increasing.
+    [[nodiscard]] SONNET_API std::expected<void, ParseError> verify_frozen(std::span<const std::byte> bytes);
+
+    /// @ingroup SonnetFrozen
+    /// @brief Read-only memory mapping of a file
+    ///
+    /// @details
+    /// Move-only; the mapping is released by the destructor.
+    class MappedFile {
+    public:
+        /// @ingroup SonnetFrozen
+        /// @brief Maps the file at @p path
+        /// @return The mapping, or the operating system error
+        [[nodiscard]] SONNET_API static std::expected<MappedFile, std::error_code> open(const std::filesystem::path& path);
+
+        SONNET_API MappedFile(MappedFile&& other) noexcept;
+        SONNET_API MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        SONNET_API ~MappedFile();
+
+        /// @ingroup SonnetFrozen
+        /// @brief The mapped bytes
+        [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return { m_Data, m_Size }; }
+
+    private:
+        MappedFile() = default;
+        void release() noexcept;
+
+        const std::byte* m_Data = nullptr;
+        std::size_t m_Size = 0;
+        std::vector<std::byte> m_Fallback;
+    };
+
+} // namespace Sonnet
@@ -0,0 +1,192 @@
+#pragma once
+
+
+/*
+    -----------------------------------------
+    Sonnet hashing - content digests of values
+    -----------------------------------------
+    This header defines hashing utilities over `Sonnet::value` trees
+
+    ----------------------------
+    Content Hash - content_hash
+    ----------------------------
+    - `content_hash(v)` is the SHA-256 digest of the canonical (RFC 8785)
+      serialization of `v`, i.e. of `dump(v, {.canonical = true})`
+    - The canonical bytes are fed to the hash while they are produced; the
+      serialized text is never materialized
+    - Because the canonical form is unique for a given JSON value, the digest
+      is suitable for signatures, ETags and content-addressed caches
+
+    ----------------
+    SHA-256 - Sha256
+    ----------------
+    - `Sha256` is a small streaming FIPS 180-4 implementation exposed so
+      callers can hash canonical JSON together with other data
+      (e.g. a method and path when signing requests)
+
+    ----------------------
+    Structural Hash - hash
+    ----------------------
+    - `hash(v)` is a fast 64-bit hash of the structure and contents of `v`
+      for hash tables and deduplication; it is not cryptographic
+    - Equal values hash equally, including a packed array and the same
+      numbers stored unpacked, and `0` and `-0`
+    - The result only depends on the value: it is the same across runs,
+      processes and platforms, so it can be persisted
+    - `hash` stores nothing: every call walks the whole value. A
+      `hash_cache` remembers the hash of every container it has hashed,
+      keyed by node address, so hashing a document and then its subtrees
+      (or the same document again) walks each node once
+    - `hashed_equal(cache, a, b)` rejects values whose hashes differ before
+      comparing them with `==`; once both are in the cache the reject is
+      O(1). The cache is never told about edits: after modifying a value
+      it has seen, at any depth, call `clear()` before using it again,
+      otherwise `hashed_equal` may report equal values as different.
+      `==` itself never looks at hashes
+    - A `hash_cache` only reads the values, so several threads may hash
+      the same document with caches of their own
+    - `std::hash<Sonnet::value>` calls `hash(v)`, so unordered containers
+      of values work out of the box
+
+    -----
+    Usage
+    -----
+        auto digest = Sonnet::content_hash(doc);
+        std::string etag = Sonnet::to_hex(digest);
+*/
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "sonnet/value.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetHash Hashing
+/// @ingroup Sonnet
+/// @brief Digests and hashes of JSON values
+
+namespace Sonnet {
+
+    /// @ingroup SonnetHash
+    /// @brief Streaming SHA-256 hasher
+    ///
+    /// @details
+    /// Feed bytes with `update` and obtain the 32-byte digest with `finish`.
+    /// After `finish` the hasher is reset and may be reused.
+    ///
+    /// Example:
+    /// @code
+    /// Sonnet::Sha256 h;
+    /// h.update("abc");
+    /// auto d = h.finish();
+    /// @endcode
+    class Sha256 {
+    public:
+        /// @brief 256-bit digest
+        using digest = std::array<std::uint8_t, 32>;
+
+        /// @ingroup SonnetHash
+        /// @brief Constructs a hasher in its initial state
+        SONNET_API Sha256() noexcept;
+
+        /// @ingroup SonnetHash
+        /// @brief Appends @p n bytes at @p data to the message
+        SONNET_API void update(const void* data, std::size_t n) noexcept;
+
+        /// @ingroup SonnetHash
+        /// @brief Appends the bytes of @p s to the message
+        void update(std::string_view s) noexcept { update(s.data(), s.size()); }
+
+        /// @ingroup SonnetHash
+        /// @brief Pads the message, returns its digest and resets the hasher
+        [[nodiscard]] SONNET_API digest finish() noexcept;
+
+        /// @ingroup SonnetHash
+        /// @brief Resets the hasher to its initial state
+        SONNET_API void reset() noexcept;
+
+    private:
+        void compress(const std::uint8_t* block) noexcept;
+
+        std::array<std::uint32_t, 8> m_State{};
+        std::array<std::uint8_t, 64> m_Block{};
+        std::size_t m_BlockLen = 0;
+        std::uint64_t m_Length = 0;
+    };
+
+    /// @ingroup SonnetHash
+    /// @brief Computes the SHA-256 digest of the canonical serialization of @p v
+    ///
+    /// @details
+    /// Equivalent to hashing `dump(v, {.canonical = true})`, but computed in
+    /// a single pass without building the output string.
+    ///
+    /// @param v Value to hash
+    /// @return SHA-256 digest of the RFC 8785 canonical form of @p v
+    [[nodiscard]] SONNET_API Sha256::digest content_hash(const value& v);
+
+    /// @ingroup SonnetHash
+    /// @brief Formats a digest as lowercase hexadecimal
+    [[nodiscard]] SONNET_API std::string to_hex(const Sha256::digest& d);
+
+    /// @ingroup SonnetHash
+    /// @brief Computes a stable 64-bit structural hash of @p v
+    ///
+    /// @details
+    /// Equal values have equal hashes. Walks the whole value; see
+    /// `hash_cache` to hash many overlapping values.
+    ///
+    /// @param v Value to hash
+    /// @return The hash; never 0 for arrays and objects
+    [[nodiscard]] SONNET_API std::uint64_t hash(const value& v) noexcept;
+
+    /// @ingroup SonnetHash
+    /// @brief Memo of the structural hashes of containers
+    ///
+    /// @details
+    /// Entries are keyed by node address and never checked against the
+    /// contents: `clear()` after editing any value the cache has seen.
+    class hash_cache {
+    public:
+        /// @ingroup SonnetHash
+        /// @brief Returns `Sonnet::hash(v)`, reusing the hashes of
+        ///        containers hashed before
+        [[nodiscard]] SONNET_API std::uint64_t hash(const value& v);
+
+        /// @ingroup SonnetHash
+        /// @brief Forgets every stored hash
+        void clear() noexcept { m_Hashes.clear(); }
+
+        /// @ingroup SonnetHash
+        /// @brief Number of containers whose hash is stored
+        [[nodiscard]] std::size_t size() const noexcept { return m_Hashes.size(); }
+
+    private:
+        std::unordered_map<const value*, std::uint64_t> m_Hashes;
+    };
+
+    /// @ingroup SonnetHash
+    /// @brief Equality that first rejects values with different hashes
+    ///
+    /// @details
+    /// The hashes come from @p cache, so the reject is O(1) for values
+    /// it has seen. Only exact while neither value changed since the
+    /// cache saw it; `==` has no such caveat.
+    [[nodiscard]] inline bool hashed_equal(hash_cache& cache, const value& lhs, const value& rhs) {
+        return cache.hash(lhs) == cache.hash(rhs) && lhs == rhs;
+    }
+
+} // namespace Sonnet
+
+/// @ingroup SonnetHash
+/// @brief Hashes a value with `Sonnet::hash`
+template<>
+struct std::hash<Sonnet::value> {
+    std::size_t operator()(const Sonnet::value& v) const noexcept {
+        return static_cast<std::size_t>(Sonnet::hash(v));
+    }
+};
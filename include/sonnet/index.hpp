@@ -0,0 +1,174 @@
+#pragma once
+
+
+/*
+    ---------------------------------------
+    Sonnet indexes - lookups by a key field
+    ---------------------------------------
+    This header builds hash indexes over arrays of objects, so elements
+    can be found by the value of a field without scanning the array
+
+    -------------------
+    Building - index_by
+    -------------------
+    - `index_by(arr, key)` evaluates the JSON Pointer `key` on every
+      element of `arr` and indexes the element under the value found;
+      elements where `key` does not resolve are left out
+    - Keys may be any JSON value and compare structurally (`1` and `1.0`
+      are the same key). They are hashed with the structural hash of
+      `hash.hpp`
+    - The table uses open addressing with linear probing over a
+      power-of-two number of slots. Elements sharing a key are stored
+      contiguously in array order, so non-unique keys (a multi-index)
+      cost no extra allocation per key
+
+    -----------------
+    Looking up - find
+    -----------------
+    - `find(key)` returns the first element with that key in array order,
+      `find_all(key)` every one of them. Overloads taking a
+      `std::string_view` or a `double` neither allocate nor build a
+      `value`
+    - The index holds pointers into `arr`, which must outlive it
+
+    - Elements of a packed array (see `value::pack`) are indexed as the
+      number values its const accessors read, e.g. with the key `""`
+
+    ------------
+    Invalidation
+    ------------
+    - The index records where the elements of `arr` are stored and how
+      many there are. Assigning to `arr`, growing or shrinking it, or
+      unpacking, editing or repacking a packed array moves or drops that
+      storage and marks the index stale: `valid()` turns false and
+      lookups throw `std::logic_error` until `rebuild()`
+    - Keys and their hashes are copied into the index, so only the
+      element pointers refer into `arr`. An element edited in place is
+      not noticed: after changing keys, call `rebuild()`
+    - Building only reads `arr`, so it may run while other threads read
+      the same document
+
+    -----
+    Usage
+    -----
+        auto by_id = Sonnet::index_by(doc["items"], Sonnet::pointer{ "/id" });
+
+        if (const Sonnet::value* item = by_id.find(42)) use(*item);
+        for (const Sonnet::value* order : by_customer.find_all("c-17")) ship(*order);
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/pointer.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetIndex Indexes
+/// @ingroup Sonnet
+/// @brief Hash indexes over arrays of objects
+
+namespace Sonnet {
+
+    /// @ingroup SonnetIndex
+    /// @brief Hash index from a key field to the elements of an array
+    class array_index {
+    public:
+        /// @ingroup SonnetIndex
+        /// @brief Returns whether the indexed array is unchanged since the
+        ///        index was built
+        [[nodiscard]] SONNET_API bool valid() const noexcept;
+
+        /// @ingroup SonnetIndex
+        /// @brief Rebuilds the index from the current contents of the array
+        SONNET_API void rebuild();
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns the first element whose key equals @p key
+        /// @return The element, or `nullptr` if no element has that key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] SONNET_API const value* find(const value& key) const;
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns the first element whose key is the string @p key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] SONNET_API const value* find(std::string_view key) const;
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns the first element whose key is the string @p key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] const value* find(const char* key) const { return find(std::string_view{ key }); }
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns the first element whose key is the number @p key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] SONNET_API const value* find(double key) const;
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns every element whose key equals @p key, in array order
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] SONNET_API std::span<const value* const> find_all(const value& key) const;
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns every element whose key is the string @p key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] SONNET_API std::span<const value* const> find_all(std::string_view key) const;
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns every element whose key is the string @p key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] std::span<const value* const> find_all(const char* key) const { return find_all(std::string_view{ key }); }
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns every element whose key is the number @p key
+        /// @throws std::logic_error if the index is stale
+        [[nodiscard]] SONNET_API std::span<const value* const> find_all(double key) const;
+
+        /// @ingroup SonnetIndex
+        /// @brief Number of distinct keys
+        [[nodiscard]] std::size_t size() const noexcept { return m_Groups.size(); }
+
+        /// @ingroup SonnetIndex
+        /// @brief Returns whether no two elements share a key
+        [[nodiscard]] bool unique() const noexcept { return m_Groups.size() == m_Elements.size(); }
+
+    private:
+        // Elements sharing one key: m_Elements[offset, offset + count)
+        struct Group {
+            std::uint64_t hash = 0;
+            value key{ nullptr };
+            std::uint32_t offset = 0;
+            std::uint32_t count = 0;
+        };
+
+        template<typename Match>
+        std::span<const value* const> lookup(std::uint64_t hash, Match&& match) const;
+
+        // The storage of the elements of @p arr, or nullptr if it has none
+        static const value* elements_of(const value& arr) noexcept;
+
+        friend SONNET_API array_index index_by(const value& arr, pointer key);
+
+        const value* m_Array = nullptr;
+        pointer m_Key;
+        const value* m_Data = nullptr; // element storage the pointers below point into
+        std::size_t m_Count = 0;
+        std::vector<std::uint32_t> m_Slots;
+        std::vector<Group> m_Groups;
+        std::vector<const value*> m_Elements;
+    };
+
+    /// @ingroup SonnetIndex
+    /// @brief Indexes the elements of @p arr by the value @p key refers to
+    ///        in each of them
+    ///
+    /// @details
+    /// Never writes to @p arr. The elements of a packed array are indexed
+    /// as number values.
+    /// @throws std::invalid_argument if @p arr is not an array
+    [[nodiscard]] SONNET_API array_index index_by(const value& arr, pointer key);
+
+} // namespace Sonnet
@@ -0,0 +1,59 @@
+#pragma once
+
+
+/*
+    --------------------------------------------
+    Sonnet interning - sharing repeated subtrees
+    --------------------------------------------
+    This header deduplicates a `Sonnet::value` tree in place: subtrees that
+    occur more than once are stored once and referred to from every place
+    they occur (hash-consing)
+
+    -----------------------------------
+    Interning - intern_subtrees(value&)
+    -----------------------------------
+    - Every node is hashed once with the structural hash (see `hash.hpp`);
+      only nodes whose hash occurs at least twice are considered, so
+      unique subtrees are left exactly as they were
+    - The first occurrence of a repeated subtree is moved into a
+      `shared_value` and every later equal occurrence becomes a reference
+      to it (see "Shared Subtrees" in `value.hpp`). Equality is checked
+      with `==`, never assumed from the hash
+    - Candidates are non-empty arrays and objects, and strings too long
+      to be stored inside the `value` itself; the string nodes shared
+      this way form the per-document string pool. Object keys are not
+      pooled
+    - Interned documents read, compare, copy and serialize like the
+      original. Modifying one only copies the nodes on the modified path
+    - `ParseOptions::intern_subtrees` runs the pass on the parsed document
+
+    -----
+    Usage
+    -----
+        auto catalog = Sonnet::parse(text, { .intern_subtrees = true });
+
+        std::size_t shared = Sonnet::intern_subtrees(snapshot);
+*/
+
+#include <cstddef>
+
+#include "sonnet/value.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetIntern Interning
+/// @ingroup Sonnet
+/// @brief Sharing repeated subtrees of a document
+
+namespace Sonnet {
+
+    /// @ingroup SonnetIntern
+    /// @brief Replaces repeated subtrees of @p root by references to a
+    ///        single shared copy
+    ///
+    /// @details
+    /// Calling it again on an interned document only shares the subtrees
+    /// added since.
+    /// @return The number of subtrees that now refer to an earlier copy
+    SONNET_API std::size_t intern_subtrees(value& root);
+
+} // namespace Sonnet
@@ -0,0 +1,167 @@
+#pragma once
+
+
+/*
+    -----------------------------------------
+    Sonnet JSONPath - compiled query plans
+    -----------------------------------------
+    This header compiles JSONPath expressions (RFC 9535) into reusable
+    query plans and evaluates them against documents or JSON text
+
+    ---------
+    Compiling
+    ---------
+    - `jsonpath::compile("$.store.book[?(@.price < 10)].title")` parses the
+      expression once and returns a `query`. Queries are immutable and
+      cheap to copy (they share the plan), so one compiled query can be
+      used from many threads
+    - Syntax errors are reported as a `ParseError` whose offset points
+      into the expression
+    - Supported:
+        * Root `$`, child segments `.name`, `.*`, `[...]` and descendant
+          segments `..name`, `..*`, `..[...]`
+        * Selectors: quoted names, `*`, indices (negative counts from the
+          end), slices `start:end:step`, and unions of them
+        * Filters `?expr` (the Goessner form `?(expr)` is accepted too)
+          with `@`/`$` paths, number, string, `true`, `false` and `null`
+          literals, `== != < <= > >=`, `&&`, `||`, `!` and parentheses.
+          A bare path tests for existence; paths compared with an operator
+          must be singular (only names and indices)
+    - Function extensions (`length()`, `match()`, ...) are not supported
+
+    ----------
+    Evaluating
+    ----------
+    - `q.for_each(root, f)` calls `f(const value&)` for every result in
+      document order without collecting them; if `f` returns `bool`,
+      returning false stops the evaluation
+    - `q.first(root)` returns the first result or `nullptr`;
+      `q.evaluate(root)` collects all results into a vector
+    - A descendant segment walks the subtree below each node it is applied
+      to once
+    - Elements of packed arrays (see `value::pack`) are selected as
+      number values, exactly like the elements of the unpacked array
+
+    ---------
+    Streaming
+    ---------
+    - `jsonpath::stream(json, q, f)` evaluates `q` while parsing `json`,
+      without building the document. Navigation by names, wildcards,
+      non-negative indices and forward slices happens on the parse events;
+      only matched nodes, and nodes a filter, negative index or backward
+      slice has to look at as a whole, are materialized
+    - The value passed to `f` is only valid during the call, and each node
+      is reported at most once
+    - Filters that refer to the root (`$`) need the whole document, which
+      is then parsed normally
+
+    -----
+    Usage
+    -----
+        static const auto cheap = Sonnet::jsonpath::compile("$.store.book[?@.price < 10].title");
+
+        cheap->for_each(doc, [](const Sonnet::value& title) { print(title.as_string()); });
+        auto r = Sonnet::jsonpath::stream(text, *cheap, [](const Sonnet::value& t) { print(t.as_string()); });
+*/
+
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetJsonPath JSONPath
+/// @ingroup Sonnet
+/// @brief Compiled JSONPath queries
+
+namespace Sonnet::jsonpath {
+
+    namespace detail { struct Plan; }
+
+    class query;
+
+    template<typename F>
+        requires std::invocable<F&, const value&>
+    std::expected<void, ParseError> stream(std::string_view json, const query& q, F&& f, const ParseOptions& opts = {});
+
+    /// @ingroup SonnetJsonPath
+    /// @brief A compiled JSONPath expression
+    class query {
+    public:
+        /// @ingroup SonnetJsonPath
+        /// @brief Calls @p f with every result of the query on @p root
+        ///
+        /// @details
+        /// @p f is invoked as `f(const value&)` in document order. If it
+        /// returns something convertible to `bool`, `false` stops the
+        /// evaluation.
+        template<typename F>
+            requires std::invocable<F&, const value&>
+        void for_each(const value& root, F&& f) const {
+            run(root, &thunk<std::remove_reference_t<F>>, const_cast<void*>(static_cast<const void*>(std::addressof(f))));
+        }
+
+        /// @ingroup SonnetJsonPath
+        /// @brief Returns the first result, or `nullptr` if there is none
+        [[nodiscard]] SONNET_API const value* first(const value& root) const;
+
+        /// @ingroup SonnetJsonPath
+        /// @brief Collects every result
+        [[nodiscard]] SONNET_API std::vector<const value*> evaluate(const value& root) const;
+
+        /// @ingroup SonnetJsonPath
+        /// @brief The expression this query was compiled from
+        [[nodiscard]] SONNET_API std::string_view text() const noexcept;
+
+    private:
+        using callback = bool (*)(void* ctx, const value& v);
+
+        template<typename F>
+        static bool thunk(void* ctx, const value& v) {
+            auto& f = *static_cast<F*>(ctx);
+            if constexpr (std::is_void_v<std::invoke_result_t<F&, const value&>>) {
+                f(v);
+                return true;
+            } else {
+                return static_cast<bool>(f(v));
+            }
+        }
+
+        SONNET_API void run(const value& root, callback cb, void* ctx) const;
+        SONNET_API std::expected<void, ParseError> run_stream(std::string_view json, const ParseOptions& opts, callback cb, void* ctx) const;
+
+        friend SONNET_API std::expected<query, ParseError> compile(std::string_view path);
+
+        template<typename F>
+            requires std::invocable<F&, const value&>
+        friend std::expected<void, ParseError> stream(std::string_view json, const query& q, F&& f, const ParseOptions& opts);
+
+        std::shared_ptr<const detail::Plan> m_Plan;
+    };
+
+    /// @ingroup SonnetJsonPath
+    /// @brief Compiles a JSONPath expression
+    /// @return The query, or the position and reason of a syntax error
+    [[nodiscard]] SONNET_API std::expected<query, ParseError> compile(std::string_view path);
+
+    /// @ingroup SonnetJsonPath
+    /// @brief Evaluates @p q over JSON text without building the document
+    ///
+    /// @details
+    /// @p f is called as in `query::for_each`, with values that are only
+    /// valid during the call. Stopping early through @p f is not an error.
+    /// @return Nothing on success, or the parse error of @p json
+    template<typename F>
+        requires std::invocable<F&, const value&>
+    std::expected<void, ParseError> stream(std::string_view json, const query& q, F&& f, const ParseOptions& opts) {
+        return q.run_stream(json, opts, &query::thunk<std::remove_reference_t<F>>, const_cast<void*>(static_cast<const void*>(std::addressof(f))));
+    }
+
+} // namespace Sonnet::jsonpath
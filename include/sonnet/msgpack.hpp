@@ -0,0 +1,108 @@
+#pragma once
+
+
+/*
+    ----------------------------------------
+    Sonnet MessagePack - binary interchange
+    ----------------------------------------
+    This header converts `Sonnet::value` trees to and from MessagePack
+
+    --------
+    Encoding
+    --------
+    - `to_msgpack(v)` returns the encoding as bytes; overloads append to an
+      existing byte vector or write to a `std::ostream`
+    - Every item uses the smallest format that holds it:
+        * Integral numbers that fit in 64 bits use positive/negative fixint,
+          `uint 8..64` or `int 8..64`
+        * Other numbers use `float 32` when that is exact, else `float 64`
+        * Strings, arrays and maps use the fix, 8 (strings only), 16 or 32
+          bit length forms
+    - Output is deterministic: map entries follow the object's key order
+
+    --------
+    Decoding
+    --------
+    - `from_msgpack(bytes, res)` decodes one item into a `value` allocated
+      from `res`
+    - `from_msgpack(bytes, handler)` reports the item to a `SaxHandler`
+      (see `sax.hpp`); strings and keys are passed to the handler as views
+      borrowed from `bytes`, so nothing is copied unless the handler does
+    - `bin` items become base64url strings without padding, as in CBOR
+    - `ext` items and map keys that are not strings have no JSON
+      equivalent and fail with `ParseError::code::unsupported_type`
+    - `ParseOptions::max_depth` limits nesting; the other parse options do
+      not apply to binary input
+    - Errors report the byte offset of the offending item; `line` is always
+      1 and `column` is `offset + 1`
+
+    -----
+    Usage
+    -----
+        std::vector<std::byte> wire = Sonnet::to_msgpack(doc);
+
+        std::pmr::monotonic_buffer_resource arena;
+        auto back = Sonnet::from_msgpack(wire, &arena);
+*/
+
+#include <cstddef>
+#include <expected>
+#include <iosfwd>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/sax.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetMsgpack MessagePack
+/// @ingroup Sonnet
+/// @brief Conversion between `Sonnet::value` and MessagePack
+
+namespace Sonnet {
+
+    /// @ingroup SonnetMsgpack
+    /// @brief Encodes @p v as MessagePack using the smallest format for every item
+    /// @param v Value to encode
+    /// @return The encoded bytes
+    [[nodiscard]] SONNET_API std::vector<std::byte> to_msgpack(const value& v);
+
+    /// @ingroup SonnetMsgpack
+    /// @brief Appends the MessagePack encoding of @p v to @p out
+    SONNET_API void to_msgpack(const value& v, std::vector<std::byte>& out);
+
+    /// @ingroup SonnetMsgpack
+    /// @brief Writes the MessagePack encoding of @p v to @p os
+    SONNET_API void to_msgpack(const value& v, std::ostream& os);
+
+    /// @ingroup SonnetMsgpack
+    /// @brief Decodes a single MessagePack item into a `value`
+    ///
+    /// @details
+    /// The whole input must be consumed by the item; extra bytes fail with
+    /// `trailing_characters`.
+    ///
+    /// @param bytes MessagePack input
+    /// @param res   Memory resource for the resulting tree
+    /// @param opts  Parse options; only `max_depth` is used
+    /// @return The decoded value, or a `ParseError` describing the failure
+    [[nodiscard]] SONNET_API std::expected<value, ParseError> from_msgpack(std::span<const std::byte> bytes,
+                                                                          std::pmr::memory_resource* res = std::pmr::get_default_resource(),
+                                                                          const ParseOptions& opts = {});
+
+    /// @ingroup SonnetMsgpack
+    /// @brief Decodes a single MessagePack item, reporting it to @p handler
+    ///
+    /// @param bytes   MessagePack input
+    /// @param handler Receives one event per decoded item; string views
+    ///                point into @p bytes
+    /// @param opts    Parse options; only `max_depth` is used
+    /// @return Nothing on success, or a `ParseError` describing the failure
+    ///         (`aborted` if the handler stopped decoding)
+    [[nodiscard]] SONNET_API std::expected<void, ParseError> from_msgpack(std::span<const std::byte> bytes, SaxHandler& handler,
+                                                                         const ParseOptions& opts = {});
+
+} // namespace Sonnet
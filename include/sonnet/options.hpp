@@ -27,6 +27,12 @@
         * Optional limit on nesting depth of arrays/objects
         * If exceeded, the parser fails with `depth_limit_exceeded`
         * A value of 0 is treated as no explicit limit
+    - `bool pack_numeric_arrays`:
+        * When true, non-empty arrays whose elements are all numbers are
+          stored packed as contiguous doubles (see `value::numbers()`)
+    - `bool intern_subtrees`:
+        * When true, repeated subtrees and long strings of the parsed
+          document are stored once (see `intern.hpp`)
     
     - Additional fields may be added in the future to control
       performance and validation behavior (e.g. max str len, max arr size)
@@ -48,6 +54,16 @@
           underlying container type does not already guarantee ordering
         * For `std::pmr::map`-based objects (already ordered), this flag
           has no effect but is provided for future expansions
+    - `bool canonical`:
+        * When true, output follows the JSON Canonicalization Scheme
+          (RFC 8785): no whitespace, keys ordered by UTF-16 code units,
+          ECMAScript number formatting and minimal string escaping
+        * Overrides `pretty`; `KeyCache` is bypassed
+    - `bool ensure_ascii`:
+        * When true, every non-ASCII character in strings and keys is
+          written as a `\uXXXX` escape (a surrogate pair above U+FFFF), so
+          the output is pure 7-bit ASCII
+        * Ignored when `canonical` is set; `KeyCache` is bypassed
 
     -----
     Usage
@@ -95,6 +111,13 @@ namespace Sonnet {
     ///   - A value of `0` means "no explicit depth limit"
     ///   - If the nesting depth exceeds this limit during parsing, a
     ///     `ParseError` with code `depth_limit_exceeded` is returned.
+    /// `pack_numeric_arrays`
+    ///   - When `true`, every non-empty array that contains only numbers is
+    ///     stored as a packed `number_array` instead of individual values.
+    ///   - When `false` (default), all arrays hold `value` elements.
+    /// `intern_subtrees`
+    ///   - When `true`, the parsed document is passed to `intern_subtrees`,
+    ///     so repeated subtrees share a single copy.
     ///
     /// Example:
     /// @code
@@ -107,6 +130,8 @@ namespace Sonnet {
         bool allow_comments = false; ///< Accept `//` and `/* */` comments if true
         bool allow_trailing_commas = false; ///< Permit trailing commas in arrays/objects if true
         size_t max_depth = 0; ///< Maximum allowed nesting depth (0 = unlimited)
+        bool pack_numeric_arrays = false; ///< Store all-number arrays packed if true
+        bool intern_subtrees = false; ///< Share repeated subtrees of the result if true
     };
 
     /// @ingroup SonnetOptions
@@ -135,6 +160,23 @@ namespace Sonnet {
     ///   - For containers that already maintain sorted keys (e.g. `pmr::map`),
     ///     this may have no observable effect.
     ///
+    /// `canonical`:
+    ///   - When `true`, produces RFC 8785 canonical JSON suitable for hashing
+    ///     and signing: compact output, members sorted by UTF-16 code units,
+    ///     numbers formatted as ECMAScript `Number.prototype.toString` does,
+    ///     and only `"`, `\\` and control characters escaped (`\u00xx` in
+    ///     lowercase hex).
+    ///   - Takes precedence over `pretty` and `indent`.
+    ///   - Non-finite numbers, which RFC 8785 cannot represent, are written
+    ///     as `null` as in regular output.
+    ///
+    /// `ensure_ascii`:
+    ///   - When `true`, non-ASCII characters are escaped as `\uXXXX`, using
+    ///     UTF-16 surrogate pairs for code points above U+FFFF. Malformed
+    ///     UTF-8 bytes are written as `\uFFFD`.
+    ///   - Has no effect when `canonical` is set, since RFC 8785 forbids
+    ///     escaping non-ASCII characters.
+    ///
     /// Example:
     /// @code
     /// WriteOptions wo;
@@ -146,6 +188,8 @@ namespace Sonnet {
         bool pretty = false;        ///< Enable pretty-printing (formatted output).
         std::size_t indent = 2;     ///< Number of spaces per indentation level.
         bool sort_keys = false;     ///< Sort object keys before writing if true.
+        bool canonical = false;     ///< Emit RFC 8785 canonical JSON if true.
+        bool ensure_ascii = false;  ///< Escape all non-ASCII characters if true.
     };
 
 
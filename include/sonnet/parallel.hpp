@@ -0,0 +1,243 @@
+#pragma once
+
+
+/*
+    -------------------------------------------
+    Sonnet parallel conversion - bulk of arrays
+    -------------------------------------------
+    This header converts large arrays into `std::vector<T>` on several
+    threads at once, from a document or straight from JSON text
+
+    -------------------
+    Executors - threads
+    -------------------
+    - An executor is any type with a member
+
+        void bulk(std::size_t n, const std::function<void(std::size_t)>& f);
+
+      that calls `f(i)` once for every `i` in `[0, n)`, possibly
+      concurrently, and returns when all calls have finished. If a call
+      throws, `bulk` rethrows one of the exceptions afterwards
+    - `thread_executor` starts its threads for each `bulk` call and runs
+      one share of the work on the calling thread. An adapter over an
+      existing thread pool only needs the `bulk` member
+
+    -----------------------------------------
+    From a document - deserialize_parallel<V>
+    -----------------------------------------
+    - `deserialize_parallel<std::vector<T>>(arr, ex)` sizes the vector
+      once, splits the indices into contiguous ranges of
+      `parallel_grain` elements and converts every range as one task
+      through `from_json_into`, each element into its own slot
+    - The result and any failure are those of
+      `deserialize<std::vector<T>>(arr)`: when elements fail, the one
+      with the lowest index is reported, however the tasks were
+      scheduled. Ranges after a failed one are not started
+    - The converters run concurrently on elements of the same document,
+      so they must only read it, as the builtin ones do. Do not run it
+      while another thread writes to `arr`
+
+    -------------------------------------
+    From JSON text - parse_as_parallel<V>
+    -------------------------------------
+    - `parse_as_parallel<std::vector<T>>(json, ex)` finds where every
+      element of a top-level array starts and ends with one sequential
+      scan that only tracks strings and nesting, then runs the typed
+      parser of `parse_as` (see `describe.hpp`) on every element in
+      parallel, each straight into its slot of the sized vector
+    - Elements are parsed as complete JSON values, so together they
+      validate the whole text. When anything fails, the text is parsed
+      once more with `parse_as`, which reports exactly the error it
+      would have reported alone: the first one in the text
+    - Texts that are not a single array, and options that allow comments
+      or trailing commas, are parsed by `parse_as` directly
+
+    -----
+    Usage
+    -----
+        Sonnet::thread_executor pool;
+
+        auto records = Sonnet::deserialize_parallel<std::vector<record>>(doc["records"], pool);
+
+        auto cached = Sonnet::parse_as_parallel<std::vector<record>>(text, pool);
+        if (!cached) return log(cached.error().msg);
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/error.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/convert.hpp"
+#include "sonnet/describe.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetParallel Parallel Conversion
+/// @ingroup Sonnet
+/// @brief Converting large arrays on several threads
+
+namespace Sonnet {
+
+    /// @ingroup SonnetParallel
+    /// @brief Types that can run a batch of indexed tasks, possibly
+    ///        concurrently
+    template<typename E>
+    concept Executor = requires(E& ex, std::size_t n, const std::function<void(std::size_t)>& f) { ex.bulk(n, f); };
+
+    /// @ingroup SonnetParallel
+    /// @brief Runs the tasks of each batch on threads of its own
+    class thread_executor {
+    public:
+        /// @ingroup SonnetParallel
+        /// @brief Creates an executor using up to @p threads threads,
+        ///        the calling one included
+        /// @param threads Thread count; 0 uses `std::thread::hardware_concurrency()`
+        SONNET_API explicit thread_executor(unsigned threads = 0) noexcept;
+
+        /// @ingroup SonnetParallel
+        /// @brief Calls @p f with every index in `[0, n)` and waits for all
+        ///        of them
+        /// @throws The first exception thrown by @p f, once all threads stopped
+        SONNET_API void bulk(std::size_t n, const std::function<void(std::size_t)>& f) const;
+
+        /// @ingroup SonnetParallel
+        /// @brief Returns the number of threads a batch may use
+        [[nodiscard]] unsigned threads() const noexcept { return m_Threads; }
+
+    private:
+        unsigned m_Threads;
+    };
+
+    /// @ingroup SonnetParallel
+    /// @brief Number of consecutive elements converted by one task
+    inline constexpr std::size_t parallel_grain = 512;
+
+    namespace detail {
+        template<typename V>
+        struct is_parallel_vector : std::false_type {};
+
+        template<typename T, typename A>
+            requires (!std::same_as<T, bool>)
+        struct is_parallel_vector<std::vector<T, A>> : std::true_type {};
+
+        /// @brief Where each element of a top-level array lies in @p json
+        struct ElementSpan {
+            std::size_t offset;
+            std::size_t length;
+        };
+
+        /// @brief Splits a top-level JSON array into its element texts
+        /// @return The spans, or nothing when @p json is not a single
+        ///         array of that shape; the elements are not validated
+        [[nodiscard]] SONNET_API std::optional<std::vector<ElementSpan>> split_array(std::string_view json);
+
+        inline constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+        // The failed index of one task, if any, with its failure
+        template<typename Failure>
+        struct TaskResult {
+            std::size_t index = none;
+            Failure failure{};
+        };
+
+        // Runs `convert(i, failure)` for every index in `[0, n)` in tasks
+        // of `parallel_grain` indices; returns the lowest index whose
+        // conversion failed, with its failure, or nothing
+        template<typename Failure, typename Ex, typename F>
+        std::optional<std::pair<std::size_t, Failure>> run_parallel(std::size_t n, Ex& ex, F&& convert) {
+            const std::size_t tasks = (n + parallel_grain - 1) / parallel_grain;
+            std::vector<TaskResult<Failure>> results(tasks);
+            std::atomic<std::size_t> first_failed{ none };
+
+            ex.bulk(tasks, [&](std::size_t task) {
+                // A failure in an earlier task makes this one irrelevant;
+                // later failures never hide an earlier one
+                if (task > first_failed.load(std::memory_order_relaxed)) return;
+                const std::size_t end = std::min(n, (task + 1) * parallel_grain);
+                for (std::size_t i = task * parallel_grain; i < end; i++) {
+                    if (convert(i, results[task].failure)) continue;
+                    results[task].index = i;
+                    std::size_t seen = first_failed.load(std::memory_order_relaxed);
+                    while (task < seen && !first_failed.compare_exchange_weak(seen, task, std::memory_order_relaxed)) {}
+                    return;
+                }
+            });
+
+            for (auto& r : results) {
+                if (r.index != none) return std::pair{ r.index, std::move(r.failure) };
+            }
+            return std::nullopt;
+        }
+    } // namespace detail
+
+    /// @ingroup SonnetParallel
+    /// @brief Deserializes an array into a `std::vector` on the threads of
+    ///        @p ex
+    ///
+    /// @details
+    /// Equivalent to `deserialize<V>(v)`; see "From a document" above.
+    /// @tparam V A `std::vector<T>` whose elements have a `from_json`
+    /// @throws std::invalid_argument Naming the JSON Pointer of the first
+    ///         failing element, or when @p v is not an array
+    template<typename V, Executor Ex>
+        requires detail::is_parallel_vector<V>::value && std::default_initializable<typename V::value_type> &&
+                 (JsonCheckedDeserializable<typename V::value_type> || JsonDeserializable<typename V::value_type>)
+    [[nodiscard]] V deserialize_parallel(const value& v, Ex&& ex) {
+        if (!v.is_array()) throw std::invalid_argument{ "Sonnet::deserialize: expected an array" };
+
+        V out(v.size());
+        auto failed = detail::run_parallel<ConvertError>(out.size(), ex, [&](std::size_t i, ConvertError& err) {
+            if (v.is_packed()) return from_json_into(value{ v.numbers()[i] }, out[i], err);
+            return from_json_into(v.as_array()[i], out[i], err);
+        });
+        if (failed) {
+            ConvertError& err = failed->second;
+            detail::within(err, failed->first);
+            throw std::invalid_argument{ "Sonnet::deserialize: " + err.path + ": " + err.msg };
+        }
+        return out;
+    }
+
+    /// @ingroup SonnetParallel
+    /// @brief Parses a JSON array straight into a `std::vector` on the
+    ///        threads of @p ex
+    ///
+    /// @details
+    /// Equivalent to `parse_as<V>(json, opts)`; see "From JSON text" above.
+    /// @tparam V A `std::vector<T>` whose elements `parse_as` can fill
+    /// @return The vector, or the error `parse_as` reports
+    template<typename V, Executor Ex>
+        requires detail::is_parallel_vector<V>::value && std::default_initializable<typename V::value_type> &&
+                 (describe::detail::shape_of<typename V::value_type>() != describe::detail::Shape::none)
+    [[nodiscard]] std::expected<V, ParseError> parse_as_parallel(std::string_view json, Ex&& ex, const ParseOptions& opts = {}) {
+        using T = typename V::value_type;
+        if (opts.allow_comments || opts.allow_trailing_commas || opts.max_depth == 1) return parse_as<V>(json, opts);
+
+        auto spans = detail::split_array(json);
+        if (!spans) return parse_as<V>(json, opts);
+
+        // Every element sits one level below the array
+        ParseOptions element_opts = opts;
+        if (element_opts.max_depth > 0) element_opts.max_depth--;
+
+        V out(spans->size());
+        auto failed = detail::run_parallel<bool>(out.size(), ex, [&](std::size_t i, bool&) {
+            const auto [offset, length] = (*spans)[i];
+            return describe::detail::parse_into(json.substr(offset, length), { &out[i], &describe::detail::reader_of<T> }, element_opts).has_value();
+        });
+        if (failed) return parse_as<V>(json, opts);
+        return out;
+    }
+
+} // namespace Sonnet
@@ -0,0 +1,98 @@
+#pragma once
+
+
+/*
+    ----------------------------------------------
+    Sonnet patches - JSON Patch and Merge Patch
+    ----------------------------------------------
+    This header applies RFC 6902 JSON Patch and RFC 7396 JSON Merge Patch
+    documents to a `Sonnet::value` in place
+
+    ------------------------
+    JSON Patch - apply_patch
+    ------------------------
+    - The patch is an array of operation objects (`add`, `remove`,
+      `replace`, `move`, `copy`, `test`), applied in order
+    - Every operation is checked for well-formedness before the target is
+      touched; so is every `test` that no earlier operation can affect
+      (none writes inside, above or next to the tested location), which
+      covers the usual "test, then change" patches
+    - The patch is atomic: if an operation fails, the operations already
+      applied are undone and the target is left as it was
+    - Rollback uses an undo log instead of a copy of the target: replaced
+      and removed values are moved into the log and moved back on failure
+    - Taking the patch by rvalue moves the operands of `add` and
+      `replace` into the target instead of copying them
+    - `add`, `replace` and `remove` into a packed array (see `value::pack`)
+      unpack it first, and a rollback packs it again; `test` and `copy`
+      read packed elements without unpacking
+
+    -------------------------------
+    Merge Patch - apply_merge_patch
+    -------------------------------
+    - An object patch merges member by member: `null` removes a member,
+      objects merge recursively, anything else replaces the member
+    - Any other patch replaces the target
+    - A merge patch cannot fail
+
+    -----
+    Usage
+    -----
+        if (auto r = Sonnet::apply_patch(state, std::move(*patch)); !r)
+            log("op ", r.error().op_index, ": ", r.error().msg);
+
+        Sonnet::apply_merge_patch(config, overrides);
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string>
+
+#include "sonnet/value.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetPatch Patching
+/// @ingroup Sonnet
+/// @brief RFC 6902 JSON Patch and RFC 7396 JSON Merge Patch
+
+namespace Sonnet {
+
+    /// @ingroup SonnetPatch
+    /// @brief Why a JSON Patch could not be applied
+    struct PatchError {
+        /// @ingroup SonnetPatch
+        /// @brief Failure categories
+        enum class code : std::uint8_t {
+            invalid_patch,  ///< The patch or one of its operations is malformed
+            path_not_found, ///< A `path` or `from` location does not exist
+            test_failed,    ///< A `test` operation did not match
+        };
+
+        code errc{};             ///< The classification of the failure.
+        std::size_t op_index{};  ///< Index of the failing operation in the patch.
+        std::string msg{};       ///< Human-readable diagnostic message.
+    };
+
+    /// @ingroup SonnetPatch
+    /// @brief Applies an RFC 6902 JSON Patch to @p target
+    /// @return Nothing on success; on failure @p target is unchanged
+    [[nodiscard]] SONNET_API std::expected<void, PatchError> apply_patch(value& target, const value& patch);
+
+    /// @ingroup SonnetPatch
+    /// @brief Applies an RFC 6902 JSON Patch to @p target, moving operand
+    ///        values out of @p patch
+    /// @return Nothing on success; on failure @p target is unchanged and
+    ///         @p patch is left in a valid but unspecified state
+    [[nodiscard]] SONNET_API std::expected<void, PatchError> apply_patch(value& target, value&& patch);
+
+    /// @ingroup SonnetPatch
+    /// @brief Applies an RFC 7396 JSON Merge Patch to @p target
+    SONNET_API void apply_merge_patch(value& target, const value& patch);
+
+    /// @ingroup SonnetPatch
+    /// @brief Applies an RFC 7396 JSON Merge Patch to @p target, moving
+    ///        values out of @p patch
+    SONNET_API void apply_merge_patch(value& target, value&& patch);
+
+} // namespace Sonnet
@@ -0,0 +1,159 @@
+#pragma once
+
+
+/*
+    ------------------------------------------
+    Sonnet::pointer - compiled JSON Pointers
+    ------------------------------------------
+    This header defines `Sonnet::pointer`, a JSON Pointer (RFC 6901) that
+    is parsed once and then applied to any number of documents
+
+    -----------
+    Compilation
+    -----------
+    - `pointer{ "/a/b~1c/0" }` splits the text into reference tokens and
+      decodes the `~0` / `~1` escapes up front; `pointer::parse` does the
+      same without throwing
+    - Tokens that are valid array indices (`0` or digits without a leading
+      zero) also carry their numeric value, so array steps do no parsing
+    - The empty pointer `""` refers to the whole document
+
+    ----------
+    Evaluation
+    ----------
+    - `resolve(root)` walks the document and returns the referenced node
+      or `nullptr`. Object steps look the decoded token up directly in
+      the member map, so resolving only allocates the first time it steps
+      into a packed array (see `value::pack`), whose element nodes the
+      const `as_array()` then builds
+    - `set(root, v)` stores `v` at the referenced location, creating
+      missing members on the way like chained `operator[]` does:
+        * A step into an object creates the member if it is absent
+        * A step into an array takes an index or `-` (append) and grows
+          the array with nulls as needed
+        * A step into any other kind replaces it with an empty object
+    - `erase(root)` removes the referenced member or array element
+    - `set` into a packed array unpacks it first; `erase` removes the
+      number without unpacking
+
+    -----
+    Usage
+    -----
+        static const Sonnet::pointer limit{ "/tenants/0/limits/rps" };
+
+        if (const Sonnet::value* v = limit.resolve(doc)) use(v->as_number());
+        limit.set(doc, Sonnet::value{ 250 });
+*/
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetPointer JSON Pointer
+/// @ingroup Sonnet
+/// @brief Pre-compiled RFC 6901 JSON Pointers
+
+namespace Sonnet {
+
+    /// @ingroup SonnetPointer
+    /// @brief A JSON Pointer compiled into decoded reference tokens
+    class pointer {
+    public:
+        /// @ingroup SonnetPointer
+        /// @brief Returned by `index` for tokens that are not array indices
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// @ingroup SonnetPointer
+        /// @brief Constructs the empty pointer, which refers to the root
+        pointer() = default;
+
+        /// @ingroup SonnetPointer
+        /// @brief Compiles @p text
+        /// @throws std::invalid_argument if @p text is not a valid JSON Pointer
+        SONNET_API explicit pointer(std::string_view text);
+
+        /// @ingroup SonnetPointer
+        /// @brief Compiles @p text
+        /// @return The pointer, or `std::nullopt` if @p text is not a valid
+        ///         JSON Pointer (it must be empty or start with `/`, and `~`
+        ///         must be followed by `0` or `1`)
+        [[nodiscard]] SONNET_API static std::optional<pointer> parse(std::string_view text);
+
+        /// @ingroup SonnetPointer
+        /// @brief Number of reference tokens
+        [[nodiscard]] std::size_t size() const noexcept { return m_Tokens.size(); }
+
+        /// @ingroup SonnetPointer
+        /// @brief Returns whether this is the root pointer
+        [[nodiscard]] bool empty() const noexcept { return m_Tokens.empty(); }
+
+        /// @ingroup SonnetPointer
+        /// @brief Decoded reference token @p idx
+        [[nodiscard]] std::string_view token(std::size_t idx) const noexcept { return m_Tokens[idx].key; }
+
+        /// @ingroup SonnetPointer
+        /// @brief Array index encoded by token @p idx, or `npos`
+        [[nodiscard]] std::size_t index(std::size_t idx) const noexcept { return m_Tokens[idx].index; }
+
+        /// @ingroup SonnetPointer
+        /// @brief Returns the pointer in its escaped text form
+        [[nodiscard]] SONNET_API std::string to_string() const;
+
+        /// @ingroup SonnetPointer
+        /// @brief Returns the node this pointer refers to in @p root
+        /// @return The node, or `nullptr` if the pointer does not resolve
+        [[nodiscard]] SONNET_API const value* resolve(const value& root) const;
+
+        /// @ingroup SonnetPointer
+        /// @brief Returns the node this pointer refers to in @p root
+        ///
+        /// @details
+        /// Shared subtrees along the path are copied (see
+        /// `value::unshare`) so the result can be modified.
+        /// @return The node, or `nullptr` if the pointer does not resolve
+        [[nodiscard]] SONNET_API value* resolve(value& root) const;
+
+        /// @ingroup SonnetPointer
+        /// @brief Returns the container holding the location this pointer
+        ///        refers to, which itself need not exist
+        /// @return The parent node, or `nullptr` for the root pointer or if
+        ///         the parent does not resolve
+        [[nodiscard]] SONNET_API value* resolve_parent(value& root) const;
+
+        /// @ingroup SonnetPointer
+        /// @brief Stores @p v at the location this pointer refers to
+        ///
+        /// @details
+        /// Missing members and array elements are created along the way.
+        /// @return Reference to the stored value
+        /// @throws std::invalid_argument if a token applied to an array is
+        ///         not an index or `-`
+        SONNET_API value& set(value& root, value v) const;
+
+        /// @ingroup SonnetPointer
+        /// @brief Removes the member or array element this pointer refers to
+        /// @return Whether anything was removed; the root cannot be erased
+        SONNET_API bool erase(value& root) const;
+
+        friend bool operator==(const pointer& lhs, const pointer& rhs) noexcept { return lhs.m_Tokens == rhs.m_Tokens; }
+
+    private:
+        struct Token {
+            std::string key;
+            std::size_t index = npos; ///< Array index, or `npos`
+
+            friend bool operator==(const Token&, const Token&) = default;
+        };
+
+        const value* resolve_prefix(const value& root, std::size_t count) const;
+        value* resolve_prefix(value& root, std::size_t count) const;
+
+        std::vector<Token> m_Tokens;
+    };
+
+} // namespace Sonnet
@@ -0,0 +1,146 @@
+#pragma once
+
+
+/*
+    ------------------------------------------
+    Sonnet reductions - numeric aggregation
+    ------------------------------------------
+    This header provides aggregate functions over the numbers of an array,
+    or over one numeric field of every row in an array of objects
+
+    ---------
+    Functions
+    ---------
+    - `sum`, `count`, `mean`, `min`, `max`
+    - `count_if(arr, op, threshold)` counts the numbers for which
+      `x op threshold` holds
+    - `histogram(arr, lo, hi, bins)` counts numbers in `bins` equal-width
+      bins over `[lo, hi]`
+    - Every function has an overload taking a `Sonnet::pointer` (see
+      `pointer.hpp`): `sum(rows, pointer{ "/metrics/latency" })`
+      aggregates that field of each row. The pointer is parsed once by
+      the caller, so a malformed one is rejected where it is built
+
+    ---------
+    Semantics
+    ---------
+    - Elements (or fields) that are not numbers are skipped, as are rows
+      where the pointer does not resolve; a value that is not an array is
+      treated as an empty array. Rows of a packed array are numbers, so
+      only the empty pointer `""` resolves in them
+    - `min`, `max` and `mean` return `std::nullopt` when there are no numbers
+    - NaN, which parsed JSON never contains, propagates through `sum` and
+      `mean` and is ignored by the other functions
+
+    -----------
+    Performance
+    -----------
+    - Packed arrays (see `value::pack` and
+      `ParseOptions::pack_numeric_arrays`) are reduced directly over their
+      contiguous doubles, using AVX2 when the CPU supports it (checked once
+      at run time on x86 GCC/Clang builds, or enabled at compile time with
+      `/arch:AVX2` on MSVC)
+    - Unpacked arrays use a scalar loop with one kind check per element
+    - Pointer overloads first gather the field values, then use the
+      contiguous kernels
+    - The vector `sum` adds in a different order than a sequential loop,
+      so the last bits of the result may differ between the two paths
+
+    -----
+    Usage
+    -----
+        auto doc = Sonnet::parse(text, { .pack_numeric_arrays = true });
+        double total = Sonnet::reduce::sum(doc->at("samples"));
+        auto slow = Sonnet::reduce::count_if(doc->at("samples"), Sonnet::reduce::compare::greater, 250.0);
+        static const Sonnet::pointer p99_field{ "/latency/p99" };
+        auto p99 = Sonnet::reduce::max(doc->at("hosts"), p99_field);
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/pointer.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetReduce Reductions
+/// @ingroup Sonnet
+/// @brief Numeric aggregation over arrays
+
+namespace Sonnet::reduce {
+
+    /// @ingroup SonnetReduce
+    /// @brief Comparison applied by `count_if`
+    enum class compare : std::uint8_t {
+        less,          ///< `x < threshold`
+        less_equal,    ///< `x <= threshold`
+        greater,       ///< `x > threshold`
+        greater_equal, ///< `x >= threshold`
+    };
+
+    /// @ingroup SonnetReduce
+    /// @brief Sum of the numbers in @p arr (0 if there are none)
+    [[nodiscard]] SONNET_API double sum(const value& arr) noexcept;
+
+    /// @ingroup SonnetReduce
+    /// @brief Number of numeric elements in @p arr
+    [[nodiscard]] SONNET_API std::size_t count(const value& arr) noexcept;
+
+    /// @ingroup SonnetReduce
+    /// @brief Arithmetic mean of the numbers in @p arr
+    [[nodiscard]] SONNET_API std::optional<double> mean(const value& arr) noexcept;
+
+    /// @ingroup SonnetReduce
+    /// @brief Smallest number in @p arr
+    [[nodiscard]] SONNET_API std::optional<double> min(const value& arr) noexcept;
+
+    /// @ingroup SonnetReduce
+    /// @brief Largest number in @p arr
+    [[nodiscard]] SONNET_API std::optional<double> max(const value& arr) noexcept;
+
+    /// @ingroup SonnetReduce
+    /// @brief Counts the numbers `x` in @p arr for which `x op threshold` holds
+    [[nodiscard]] SONNET_API std::size_t count_if(const value& arr, compare op, double threshold) noexcept;
+
+    /// @ingroup SonnetReduce
+    /// @brief Counts the numbers of @p arr in equal-width bins over `[lo, hi]`
+    ///
+    /// @details
+    /// Bin `i` covers `[lo + i * w, lo + (i + 1) * w)` with
+    /// `w = (hi - lo) / bins`; `hi` itself falls into the last bin and
+    /// numbers outside `[lo, hi]` are not counted.
+    /// @throws std::invalid_argument if @p bins is 0 or `lo < hi` does not hold
+    [[nodiscard]] SONNET_API std::vector<std::size_t> histogram(const value& arr, double lo, double hi, std::size_t bins);
+
+    /// @ingroup SonnetReduce
+    /// @brief Sum of the field at @p field over the rows of @p rows
+    [[nodiscard]] SONNET_API double sum(const value& rows, const pointer& field);
+
+    /// @ingroup SonnetReduce
+    /// @brief Number of rows whose field at @p field is a number
+    [[nodiscard]] SONNET_API std::size_t count(const value& rows, const pointer& field);
+
+    /// @ingroup SonnetReduce
+    /// @brief Mean of the field at @p field over the rows of @p rows
+    [[nodiscard]] SONNET_API std::optional<double> mean(const value& rows, const pointer& field);
+
+    /// @ingroup SonnetReduce
+    /// @brief Smallest value of the field at @p field
+    [[nodiscard]] SONNET_API std::optional<double> min(const value& rows, const pointer& field);
+
+    /// @ingroup SonnetReduce
+    /// @brief Largest value of the field at @p field
+    [[nodiscard]] SONNET_API std::optional<double> max(const value& rows, const pointer& field);
+
+    /// @ingroup SonnetReduce
+    /// @brief Counts the rows whose field at @p field satisfies `x op threshold`
+    [[nodiscard]] SONNET_API std::size_t count_if(const value& rows, const pointer& field, compare op, double threshold);
+
+    /// @ingroup SonnetReduce
+    /// @brief Histogram of the field at @p field (see the array overload)
+    /// @throws std::invalid_argument if @p bins is 0 or `lo < hi` does not hold
+    [[nodiscard]] SONNET_API std::vector<std::size_t> histogram(const value& rows, const pointer& field, double lo, double hi, std::size_t bins);
+
+} // namespace Sonnet::reduce
@@ -0,0 +1,164 @@
+#pragma once
+
+
+/*
+    ------------------------------------------
+    Sonnet SAX interface - event-based decoding
+    ------------------------------------------
+    This header defines the callback interface used by Sonnet's streaming
+    decoders (`parse_sax`, `from_cbor`, `from_msgpack`). Instead of building
+    a `Sonnet::value`, a decoder reports each item it reads to a
+    `SaxHandler` as it goes
+
+    -------------------------
+    Handler - SaxHandler
+    -------------------------
+    - Scalars are reported with `on_null`, `on_bool`, `on_number` and
+      `on_string`
+    - Containers are bracketed by `on_start_array` / `on_end_array` and
+      `on_start_object` / `on_end_object`; inside an object every member
+      is reported as `on_key` followed by exactly one value
+    - Start events carry the element (or member) count when the encoding
+      declares it up front, and `SaxHandler::unknown_size` otherwise
+    - Every callback returns `bool`; returning false stops decoding and the
+      decoder fails with `ParseError::code::aborted`
+    - String views passed to callbacks are only valid for the duration of
+      the call; they usually point straight into the input buffer
+    - The default implementation of every callback accepts the event, so a
+      handler only overrides what it is interested in
+
+    ------------------------
+    DOM Builder - DomBuilder
+    ------------------------
+    - `DomBuilder` is the handler the decoders use to produce a
+      `Sonnet::value`; it is exposed so custom handlers can forward to it
+      for the parts of a document they want materialized. `parse` itself
+      is `parse_sax` into a `DomBuilder`
+    - Duplicate object keys follow the parser: the last occurrence wins
+    - With `pack_numeric_arrays`, arrays collect their numbers into the
+      packed store until the first element of another kind, exactly as
+      `ParseOptions::pack_numeric_arrays` describes
+
+    -----
+    Usage
+    -----
+        struct Counter : Sonnet::SaxHandler {
+            std::size_t strings = 0;
+            bool on_string(std::string_view) override { strings++; return true; }
+        };
+
+        Counter c;
+        if (auto r = Sonnet::from_cbor(bytes, c); !r) report(r.error());
+*/
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+#include "sonnet/value.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetSax SAX Interface
+/// @ingroup Sonnet
+/// @brief Event-based decoding callbacks
+
+namespace Sonnet {
+
+    /// @ingroup SonnetSax
+    /// @brief Receives decoding events from a streaming decoder
+    ///
+    /// @details
+    /// Override the callbacks of interest; each returns `true` to continue
+    /// or `false` to stop decoding. Keys and strings are passed as views
+    /// that are valid only until the callback returns.
+    class SaxHandler {
+    public:
+        /// @brief Size reported by start events when the count is not known in advance
+        static constexpr std::size_t unknown_size = std::numeric_limits<std::size_t>::max();
+
+        virtual ~SaxHandler() = default;
+
+        /// @brief Called for a `null` value
+        virtual bool on_null() { return true; }
+
+        /// @brief Called for a boolean value
+        virtual bool on_bool(bool) { return true; }
+
+        /// @brief Called for a numeric value
+        virtual bool on_number(double) { return true; }
+
+        /// @brief Called for a string value
+        virtual bool on_string(std::string_view) { return true; }
+
+        /// @brief Called when an array begins
+        /// @param size Number of elements, or `unknown_size`
+        virtual bool on_start_array(std::size_t /*size*/) { return true; }
+
+        /// @brief Called when the innermost open array ends
+        virtual bool on_end_array() { return true; }
+
+        /// @brief Called when an object begins
+        /// @param size Number of members, or `unknown_size`
+        virtual bool on_start_object(std::size_t /*size*/) { return true; }
+
+        /// @brief Called with the key of the next object member
+        virtual bool on_key(std::string_view) { return true; }
+
+        /// @brief Called when the innermost open object ends
+        virtual bool on_end_object() { return true; }
+    };
+
+    /// @ingroup SonnetSax
+    /// @brief SAX handler that assembles the reported events into a `value`
+    ///
+    /// @details
+    /// All nodes are allocated from the memory resource given at
+    /// construction. After a successful decode the document is available
+    /// through `result()`; `reset()` prepares the builder for another
+    /// document.
+    class DomBuilder final : public SaxHandler {
+    public:
+        /// @ingroup SonnetSax
+        /// @brief Constructs a builder allocating from @p res
+        /// @param pack_numeric_arrays Store arrays of only numbers packed
+        SONNET_API explicit DomBuilder(std::pmr::memory_resource* res = std::pmr::get_default_resource(), bool pack_numeric_arrays = false);
+
+        SONNET_API bool on_null() override;
+        SONNET_API bool on_bool(bool b) override;
+        SONNET_API bool on_number(double d) override;
+        SONNET_API bool on_string(std::string_view s) override;
+        SONNET_API bool on_start_array(std::size_t size) override;
+        SONNET_API bool on_end_array() override;
+        SONNET_API bool on_start_object(std::size_t size) override;
+        SONNET_API bool on_key(std::string_view k) override;
+        SONNET_API bool on_end_object() override;
+
+        /// @ingroup SonnetSax
+        /// @brief Adopts a string the decoder already allocated
+        SONNET_API bool on_string(string&& s);
+
+        /// @ingroup SonnetSax
+        /// @brief Adopts a key the decoder already allocated
+        SONNET_API bool on_key(string&& k);
+
+        /// @ingroup SonnetSax
+        /// @brief Returns the assembled document
+        [[nodiscard]] value& result() noexcept { return m_Root; }
+
+        /// @ingroup SonnetSax
+        /// @brief Discards the current document and any open containers
+        SONNET_API void reset();
+
+    private:
+        value* add(value&& v);
+
+        std::pmr::memory_resource* m_MemRes;
+        value m_Root;
+        std::vector<value*> m_Stack;
+        string m_Key;
+        bool m_Pack;
+    };
+
+} // namespace Sonnet
@@ -0,0 +1,199 @@
+#pragma once
+
+
+/*
+    ----------------------------------------
+    Sonnet JSON Schema - compiled validators
+    ----------------------------------------
+    This header compiles JSON Schema (draft 2020-12) documents into
+    validators that check `Sonnet::value` trees or JSON text as it is
+    parsed
+
+    ---------
+    Compiling
+    ---------
+    - `schema::compile(schema)` walks the schema once and returns a
+      `validator`. Validators are immutable and cheap to copy (they share
+      the compiled program), so one validator can serve many threads
+    - Supported keywords:
+        * `type` (a name or an array of names, `integer` included)
+        * `enum`, `const`
+        * `minimum`, `maximum`, `exclusiveMinimum`, `exclusiveMaximum`
+        * `minLength`, `maxLength` (in code points), `pattern`
+        * `items` (a single schema), `minItems`, `maxItems`
+        * `properties`, `required`, `additionalProperties`
+        * `$ref` to a JSON Pointer fragment of the same document
+          (`#`, `#/$defs/name`, ...); recursive references are allowed
+        * `true` / `false` schemas
+    - Other applicators and assertions (`allOf`, `anyOf`, `oneOf`, `not`,
+      `if`, `prefixItems`, `patternProperties`, `uniqueItems`, ...) are
+      rejected with `SchemaError::code::unsupported_keyword` rather than
+      silently ignored. Annotations (`title`, `description`, `default`,
+      `format`, ...) and unknown keywords are ignored
+    - Object members are compiled into one key table per schema, sorted
+      for binary search; `required` entries share it. Each distinct
+      `pattern` is compiled once into a small NFA, searched anywhere in
+      the string and matched on code points. The grammar is the subset of
+      ECMAScript that JSON Schema recommends: classes, `\d \w \s \b`
+      and their negations, anchors, groups, alternation and quantifiers.
+      Backreferences and lookaround are `invalid_pattern`. Matching never
+      backtracks or recurses, so its time is linear in the string and
+      long inbound strings are safe
+
+    ----------
+    Validating
+    ----------
+    - Validation stops at the first violation and reports it as a
+      `ValidationError`: a JSON Pointer to the offending value, a JSON
+      Pointer to the keyword in the schema and a message
+    - `v.validate(doc)` checks a document; `v.validate_json(text)` checks
+      JSON text while parsing it, without building the document
+    - `ValidatingHandler` is the `SaxHandler` behind `validate_json`. It
+      can be driven by any decoder (`parse_sax`, `from_cbor`, ...) and can
+      forward accepted events to another handler, e.g. a `DomBuilder`,
+      so a document is validated and built in one pass and the build
+      stops at the first violation
+    - Containers checked against `enum` or `const` are materialized by
+      the handler to be compared as a whole
+
+    -----
+    Usage
+    -----
+        static const auto order = Sonnet::schema::compile(*Sonnet::parse(order_schema));
+
+        if (auto r = order->validate_json(body); !r)
+            return bad_request(r.error().instance_path + ": " + r.error().msg);
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "sonnet/value.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/sax.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetSchema JSON Schema
+/// @ingroup Sonnet
+/// @brief Compiled JSON Schema validators
+
+namespace Sonnet::schema {
+
+    namespace detail {
+        struct Program;
+        class Streamer;
+    }
+
+    /// @ingroup SonnetSchema
+    /// @brief Why a schema could not be compiled
+    struct SchemaError {
+        /// @ingroup SonnetSchema
+        /// @brief Failure categories
+        enum class code : std::uint8_t {
+            invalid_schema,      ///< A schema or keyword value is malformed
+            unsupported_keyword, ///< The schema uses a keyword this validator does not implement
+            unresolved_ref,      ///< A `$ref` does not point into the schema document
+            invalid_pattern,     ///< A `pattern` is not a valid regular expression
+        };
+
+        code errc{};        ///< The classification of the failure.
+        std::string path{}; ///< JSON Pointer to the offending location in the schema.
+        std::string msg{};  ///< Human-readable diagnostic message.
+    };
+
+    /// @ingroup SonnetSchema
+    /// @brief Why an instance was rejected
+    struct ValidationError {
+        /// @ingroup SonnetSchema
+        /// @brief Failure categories
+        enum class code : std::uint8_t {
+            invalid_value, ///< The instance violates the schema
+            invalid_json,  ///< The text is not valid JSON (`validate_json` only)
+        };
+
+        code errc{};                 ///< The classification of the failure.
+        std::string instance_path{}; ///< JSON Pointer to the rejected value.
+        std::string schema_path{};   ///< JSON Pointer to the failing keyword in the schema.
+        std::string msg{};           ///< Human-readable diagnostic message.
+    };
+
+    /// @ingroup SonnetSchema
+    /// @brief A compiled JSON Schema
+    class validator {
+    public:
+        /// @ingroup SonnetSchema
+        /// @brief Checks @p instance against the schema
+        /// @return Nothing if it is valid, otherwise the first violation
+        [[nodiscard]] SONNET_API std::expected<void, ValidationError> validate(const value& instance) const;
+
+        /// @ingroup SonnetSchema
+        /// @brief Checks JSON text against the schema while parsing it
+        ///
+        /// @details
+        /// No document is built, apart from containers that `enum` or
+        /// `const` compare as a whole.
+        /// @return Nothing if the text is valid JSON and satisfies the
+        ///         schema, otherwise the first violation or parse error
+        [[nodiscard]] SONNET_API std::expected<void, ValidationError> validate_json(std::string_view json, const ParseOptions& opts = {}) const;
+
+        /// @ingroup SonnetSchema
+        /// @brief Returns whether @p instance satisfies the schema
+        [[nodiscard]] bool is_valid(const value& instance) const { return validate(instance).has_value(); }
+
+    private:
+        friend SONNET_API std::expected<validator, SchemaError> compile(const value& schema);
+        friend class ValidatingHandler;
+
+        std::shared_ptr<const detail::Program> m_Program;
+    };
+
+    /// @ingroup SonnetSchema
+    /// @brief Compiles a JSON Schema document
+    /// @return The validator, or the location and reason of the first
+    ///         problem in @p schema
+    [[nodiscard]] SONNET_API std::expected<validator, SchemaError> compile(const value& schema);
+
+    /// @ingroup SonnetSchema
+    /// @brief SAX handler that validates the reported document
+    ///
+    /// @details
+    /// The first event that violates the schema returns `false`, which
+    /// stops the decoder, and the violation is available from `error()`.
+    /// Accepted events are forwarded to the handler given at construction,
+    /// if any; a `false` from it stops decoding without an `error()`.
+    class ValidatingHandler final : public SaxHandler {
+    public:
+        /// @ingroup SonnetSchema
+        /// @brief Constructs a handler for one document at a time
+        /// @param v Validator to apply; must outlive the handler
+        /// @param next Handler receiving the accepted events, or `nullptr`
+        SONNET_API explicit ValidatingHandler(const validator& v, SaxHandler* next = nullptr);
+        SONNET_API ~ValidatingHandler() override;
+
+        SONNET_API bool on_null() override;
+        SONNET_API bool on_bool(bool b) override;
+        SONNET_API bool on_number(double d) override;
+        SONNET_API bool on_string(std::string_view s) override;
+        SONNET_API bool on_start_array(std::size_t size) override;
+        SONNET_API bool on_end_array() override;
+        SONNET_API bool on_start_object(std::size_t size) override;
+        SONNET_API bool on_key(std::string_view k) override;
+        SONNET_API bool on_end_object() override;
+
+        /// @ingroup SonnetSchema
+        /// @brief Returns the violation that stopped decoding, or `nullptr`
+        [[nodiscard]] SONNET_API const ValidationError* error() const noexcept;
+
+        /// @ingroup SonnetSchema
+        /// @brief Prepares the handler for another document
+        SONNET_API void reset();
+
+    private:
+        std::unique_ptr<detail::Streamer> m_Impl;
+    };
+
+} // namespace Sonnet::schema
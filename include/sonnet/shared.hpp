@@ -0,0 +1,196 @@
+#pragma once
+
+
+/*
+    -------------------------------------------------------
+    Sonnet shared documents - cross-process read in place
+    -------------------------------------------------------
+    This header defines a JSON document that lives in a named POSIX
+    shared-memory segment, so one process can publish it and any number of
+    other processes can read it without holding their own parsed copy
+
+    ------
+    Design
+    ------
+    - A `value` cannot be shared: its containers hold raw pointers that are
+      only meaningful at the address where they were allocated. The shared
+      document instead stores the frozen format (see `frozen.hpp`), whose
+      offsets are self-relative, so the segment may be mapped at a
+      different address in every process
+    - The segment holds a small header and two document slots of
+      `capacity` bytes each. The writer always fills the slot readers are
+      not using and then bumps a generation counter, so readers never see
+      a partially written document
+    - Slots start at the first page boundary after the header, using the
+      system page size, so they can be mapped read-only for readers
+
+    --------------------------------
+    Writing - SharedDocument::create
+    --------------------------------
+    - `SharedDocument::create(name, capacity)` creates the segment and
+      fails with `std::errc::file_exists` if it already exists, so two
+      writers cannot silently share one; `unlink` a stale segment first
+    - `publish(v)` freezes `v` into the idle slot and makes it current.
+      Before reusing a slot it waits until no reader still holds a
+      snapshot of that slot, i.e. it may block on a reader that holds a
+      snapshot from two publications ago. With a timeout it gives up
+      after that long and throws `std::system_error` with
+      `std::errc::timed_out`, leaving the current document in place
+
+    ------------------------------
+    Reading - SharedDocument::open
+    ------------------------------
+    - `SharedDocument::open(name)` maps an existing segment; the document
+      slots are mapped read-only, only the pin counters in the header are
+      written by readers
+    - Every handle leases one entry of a reader table in the header,
+      tagged with its process id, and counts its pins there. A process
+      that dies while holding snapshots leaves its entry behind; the
+      writer reclaims it once the process no longer exists instead of
+      waiting on it forever. The table has `shared_max_handles` entries;
+      beyond that `open` fails with
+      `std::errc::resource_unavailable_try_again`
+    - `snapshot()` pins the current slot and returns a `SharedSnapshot`;
+      its `root()` view stays valid and unchanged until the snapshot is
+      destroyed, even if the writer publishes in the meantime. A snapshot
+      keeps the mapping alive, so it may outlive its `SharedDocument`
+    - Snapshots are cheap (two atomic operations) but should be
+      short-lived, since they hold back the writer
+
+    -----
+    Usage
+    -----
+        // writer process
+        auto doc = Sonnet::SharedDocument::create("/app-config", 64 << 20);
+        doc->publish(config);
+
+        // reader processes
+        auto doc = Sonnet::SharedDocument::open("/app-config");
+        auto snap = doc->snapshot();
+        auto limit = snap.root().at("limits").at("rps").as_number();
+
+    Shared documents require POSIX shared memory; elsewhere `create` and
+    `open` fail with `std::errc::function_not_supported`. Dead readers are
+    recognised by process id, so all processes of a segment must share a
+    pid namespace
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+#include "sonnet/value.hpp"
+#include "sonnet/frozen.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetShared Shared Documents
+/// @ingroup Sonnet
+/// @brief Documents shared between processes through shared memory
+
+namespace Sonnet {
+
+    namespace detail { struct ShmMapping; }
+
+    /// @ingroup SonnetShared
+    /// @brief Number of handles that can have a segment open at once
+    inline constexpr std::size_t shared_max_handles = 256;
+
+    /// @ingroup SonnetShared
+    /// @brief Pinned, immutable view of one published document
+    ///
+    /// @details
+    /// Move-only. While a snapshot exists, the writer will not overwrite the
+    /// slot it refers to, and the segment stays mapped even if the
+    /// `SharedDocument` it came from is destroyed. A default-constructed
+    /// snapshot, or one taken before anything was published, views `null`.
+    class SharedSnapshot {
+    public:
+        SharedSnapshot() = default;
+        SONNET_API SharedSnapshot(SharedSnapshot&& other) noexcept;
+        SONNET_API SharedSnapshot& operator=(SharedSnapshot&& other) noexcept;
+        SharedSnapshot(const SharedSnapshot&) = delete;
+        SharedSnapshot& operator=(const SharedSnapshot&) = delete;
+        SONNET_API ~SharedSnapshot();
+
+        /// @ingroup SonnetShared
+        /// @brief Root of the pinned document
+        [[nodiscard]] frozen_view root() const noexcept { return m_Root; }
+
+        /// @ingroup SonnetShared
+        /// @brief Publication number of the pinned document (0 if none)
+        [[nodiscard]] std::uint64_t generation() const noexcept { return m_Generation; }
+
+    private:
+        friend class SharedDocument;
+        void release() noexcept;
+
+        std::shared_ptr<detail::ShmMapping> m_Map;
+        unsigned m_Slot = 0;
+        std::uint64_t m_Generation = 0;
+        frozen_view m_Root{};
+    };
+
+    /// @ingroup SonnetShared
+    /// @brief Handle to a JSON document in a named shared-memory segment
+    ///
+    /// @details
+    /// Move-only; the segment is unmapped once the handle and all its
+    /// snapshots are destroyed, but it is not removed (see `unlink`).
+    class SharedDocument {
+    public:
+        /// @ingroup SonnetShared
+        /// @brief Creates the segment @p name for writing
+        /// @param name     Segment name; a leading `/` is added if missing
+        /// @param capacity Largest frozen document size the segment can hold
+        /// @return The handle, or `std::errc::file_exists` if the segment
+        ///         already exists
+        [[nodiscard]] SONNET_API static std::expected<SharedDocument, std::error_code> create(std::string_view name, std::size_t capacity);
+
+        /// @ingroup SonnetShared
+        /// @brief Maps the existing segment @p name for reading
+        [[nodiscard]] SONNET_API static std::expected<SharedDocument, std::error_code> open(std::string_view name);
+
+        /// @ingroup SonnetShared
+        /// @brief Removes the segment @p name; existing mappings stay valid
+        SONNET_API static std::error_code unlink(std::string_view name);
+
+        SONNET_API SharedDocument(SharedDocument&& other) noexcept;
+        SONNET_API SharedDocument& operator=(SharedDocument&& other) noexcept;
+        SharedDocument(const SharedDocument&) = delete;
+        SharedDocument& operator=(const SharedDocument&) = delete;
+        SONNET_API ~SharedDocument();
+
+        /// @ingroup SonnetShared
+        /// @brief Makes @p v the current document
+        /// @param timeout How long to wait for readers to release the idle
+        ///                slot; the default waits as long as they hold it
+        /// @throws std::logic_error if this handle was opened for reading
+        /// @throws std::length_error if the frozen document exceeds the capacity
+        /// @throws std::system_error with `std::errc::timed_out` if readers
+        ///         still hold the idle slot after @p timeout
+        SONNET_API void publish(const value& v, std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+
+        /// @ingroup SonnetShared
+        /// @brief Pins and returns the current document
+        [[nodiscard]] SONNET_API SharedSnapshot snapshot() const;
+
+        /// @ingroup SonnetShared
+        /// @brief Number of documents published so far
+        [[nodiscard]] SONNET_API std::uint64_t generation() const noexcept;
+
+        /// @ingroup SonnetShared
+        /// @brief Capacity of each document slot in bytes
+        [[nodiscard]] SONNET_API std::size_t capacity() const noexcept;
+
+    private:
+        SharedDocument() = default;
+
+        std::shared_ptr<detail::ShmMapping> m_Map;
+        bool m_Writable = false;
+    };
+
+} // namespace Sonnet
@@ -24,19 +24,63 @@
         * `Sonnet::value` represents any JSON value and uses `std::pmr`
           allocators for efficient memory management
         * It supports structural equality, object/array manipulation
+        * `Sonnet::pointer` compiles an RFC 6901 JSON Pointer once for
+          repeated resolve/set/erase (see `pointer.hpp`)
+        * `jsonpath::compile` turns an RFC 9535 JSONPath expression into
+          a reusable query, evaluated on a `value` or while parsing text
+          (see `jsonpath.hpp`)
+        * `apply_patch` / `apply_merge_patch` apply RFC 6902 JSON Patch
+          and RFC 7396 Merge Patch documents in place (see `patch.hpp`)
+        * `diff` / `diff_changes` compute the JSON Patch between two
+          values, skipping identical subtrees by hash (see `diff.hpp`)
+        * `intern_subtrees` stores repeated subtrees and long strings of
+          a document once, shared copy-on-write (see `intern.hpp`)
+        * `schema::compile` turns a JSON Schema into a validator for
+          values or for JSON text while it is parsed (see `schema.hpp`)
+        * `index_by` builds a hash index over an array of objects keyed
+          by a field, unique or not (see `index.hpp`)
     - Parsing:
         * `std::expected<value, ParseError> parse(std::string_view, const ParseOptions& = {})`
         * `std::expected<value, ParseError> parse(std::istream&, const ParseOptions& = {})`
         * `std::expected<value, ParseError> parse(const std::filesystem::path&, const ParseOptions& = {})`
+        * `std::expected<void, ParseError> parse_sax(std::string_view, SaxHandler&, const ParseOptions& = {})`
         * Parsing is configurable via `ParseOptions` (comments, trailing commas, depth limits, etc.)
     - Serialization: 
         * `std::string dump(const value&, const WriteOptions& = {})`
         * `void dump(const value&, std::ostream&, const WriteOptions& = {})`
         * Pretty-printing and compact output are controlled via `WriteOptions`
+        * Overloads taking a `KeyCache&` reuse pre-escaped object keys
+          across calls (see `writer.hpp`)
+        * `WriteOptions::canonical` selects RFC 8785 canonical output;
+          `content_hash(const value&)` digests it in one pass (see `hash.hpp`)
+        * `hash(const value&)` is a stable, optionally cached 64-bit
+          structural hash, also used by `std::hash<value>` (see `hash.hpp`)
+    - Binary formats:
+        * `to_cbor` / `from_cbor` convert to and from CBOR (see `cbor.hpp`)
+        * `to_msgpack` / `from_msgpack` convert to and from MessagePack
+          (see `msgpack.hpp`)
+        * `freeze` / `open_frozen` write and read a memory-mappable
+          document format that is used in place (see `frozen.hpp`)
+        * `SharedDocument` publishes a frozen document to other processes
+          through POSIX shared memory (see `shared.hpp`)
+        * Decoders can report items to a `SaxHandler` instead of building
+          a tree (see `sax.hpp`); `parse_sax` does the same for JSON text
+    - Columnar export:
+        * `to_columns` / `parse_columns` turn an array of objects into
+          Arrow-compatible typed columns (see `columns.hpp`)
+    - Aggregation:
+        * `reduce::sum`, `min`, `max`, `mean`, `count_if` and `histogram`
+          over numeric arrays or a field of every row (see `reduce.hpp`)
     - Conversion:
         - User-defined types can be converted to/from `Sonnet::value` via
           `to_json` and `from_json` customization points defined in
           `convert.hpp`
+        - `SONNET_DEFINE_TYPE` describes the members of a type once and
+          generates its conversions, `parse_as<T>` and `dump(t)` (see
+          `describe.hpp`)
+        - `deserialize_parallel` and `parse_as_parallel` convert large
+          arrays into a `std::vector` on several threads (see
+          `parallel.hpp`)
     
     ------------
     Design Goals
@@ -93,6 +137,24 @@
 #include "sonnet/value.hpp"
 #include "sonnet/error.hpp"
 #include "sonnet/options.hpp"
+#include "sonnet/writer.hpp"
+#include "sonnet/hash.hpp"
+#include "sonnet/sax.hpp"
+#include "sonnet/cbor.hpp"
+#include "sonnet/msgpack.hpp"
+#include "sonnet/frozen.hpp"
+#include "sonnet/shared.hpp"
+#include "sonnet/pointer.hpp"
+#include "sonnet/jsonpath.hpp"
+#include "sonnet/patch.hpp"
+#include "sonnet/diff.hpp"
+#include "sonnet/intern.hpp"
+#include "sonnet/schema.hpp"
+#include "sonnet/index.hpp"
+#include "sonnet/columns.hpp"
+#include "sonnet/reduce.hpp"
+#include "sonnet/describe.hpp"
+#include "sonnet/parallel.hpp"
 #include "sonnet/config.hpp"
 
 namespace Sonnet {
@@ -161,6 +223,23 @@ namespace Sonnet {
     /// @return A `ParseResult` containing either a DOM tree or a parse error
     [[nodiscard]] SONNET_API ParseResult parse(std::istream& is, const ParseOptions& opts = {});
 
+    /// @ingroup SonnetAPI
+    /// @brief Parses a JSON document and reports it to a SAX handler
+    ///
+    /// @details
+    /// Accepts exactly the same input as `parse(input, opts)` but builds no
+    /// tree: every scalar, key and container boundary is passed to
+    /// @p handler as it is read. Container sizes are not known up front, so
+    /// `on_start_array`/`on_start_object` receive `SaxHandler::unknown_size`.
+    /// If a handler callback returns `false`, parsing stops with
+    /// `ParseError::code::aborted`.
+    ///
+    /// @param input UTF-8 encoded JSON text to parse
+    /// @param handler Receives the parse events
+    /// @param opts Parsing configuration options (comments, trailing commas, etc.)
+    /// @return Nothing on success, or the parse error
+    [[nodiscard]] SONNET_API std::expected<void, ParseError> parse_sax(std::string_view input, SaxHandler& handler, const ParseOptions& opts = {});
+
     /// @ingroup SonnetAPI
     /// @brief Serializes a JSON DOM value to a string
     ///
@@ -202,4 +281,37 @@ namespace Sonnet {
     /// @param opts Formatting options 
     SONNET_API void dump(const value& v, std::ostream& os, const WriteOptions& opts = {});
 
+    /// @ingroup SonnetAPI
+    /// @brief Serializes a JSON DOM value to a string, reusing escaped keys
+    ///
+    /// @details
+    /// Behaves like `dump(v, opts)` but emits object keys through @p keys.
+    /// Keys already present in the cache are written with a single copy of
+    /// their pre-escaped bytes; new keys are escaped once and cached.
+    ///
+    /// Example:
+    /// @code
+    /// Sonnet::KeyCache keys;
+    /// for (const auto& rec : records) out << Sonnet::dump(rec, keys) << '\n';
+    /// @endcode
+    ///
+    /// @param v The DOM value to serialize
+    /// @param keys Key cache shared between calls
+    /// @param opts Formatting options
+    /// @return A UTF-8 JSON string representation of @p `v`.
+    [[nodiscard]] SONNET_API std::string dump(const value& v, KeyCache& keys, const WriteOptions& opts = {});
+
+    /// @ingroup SonnetAPI
+    /// @brief Serializes a JSON DOM value to an output stream, reusing escaped keys
+    ///
+    /// @details
+    /// Stream counterpart of `dump(v, keys, opts)`; intended for writing
+    /// record streams such as NDJSON where the same keys repeat in every record.
+    ///
+    /// @param v The DOM value to serialize
+    /// @param os Output stream to receive JSON text
+    /// @param keys Key cache shared between calls
+    /// @param opts Formatting options
+    SONNET_API void dump(const value& v, std::ostream& os, KeyCache& keys, const WriteOptions& opts = {});
+
 } // namespace Sonnet
@@ -67,16 +67,53 @@
           new elements are default-constructed (i.e. `null` values)
         * Returns a reference to the element at `index`
 
+    ----------------------
+    Packed Numeric Arrays
+    ----------------------
+    - An array whose elements are all numbers can be stored packed, as a
+      contiguous `number_array` of doubles instead of one `value` per
+      element (about a sixth of the memory)
+        * `ParseOptions::pack_numeric_arrays` makes the parser produce
+          packed arrays; `pack()` converts an existing array in place
+        * A packed array is still `kind::array`: `size()`, comparison and
+          every writer and encoder treat it like the unpacked array
+        * `numbers()` exposes the elements as a `std::span<double>`, e.g.
+          to feed them to vectorized code
+        * Mutable access through `as_array()` or `operator[](size_t)`
+          unpacks the array first; `unpack()` does so explicitly
+        * The const `as_array()` and `operator[](size_t)` read a packed
+          array through element nodes built from the numbers on first use
+          and kept until the next mutable access. That costs the memory
+          packing saved, so loops over numbers should use `numbers()`
+
     ---------------------
     Equality and Ordering
     ---------------------
-    - `value` supports structural equality and ordering via defaulted 
-      three-way comparison:
+    - `value` supports structural equality and ordering via three-way
+      comparison:
         * Two values compare equal if they have the same kind and equal
-          underlying contents (for arrays/objects, structural equality)
+          underlying contents (for arrays/objects, structural equality);
+          a packed array equals the unpacked array with the same numbers
         * Comparison across different kinds are well-defined but primarily
           useful for mapping/ordering, not for semantic ranking
     
+    ---------------
+    Shared Subtrees
+    ---------------
+    - A value may refer to an immutable node owned by a `shared_value`
+      (see `intern_subtrees` in `intern.hpp`) instead of holding its
+      contents, so identical subtrees are stored once
+        * Reading is transparent: `type()`, the const accessors,
+          comparison and every writer and encoder see the shared contents
+        * Copying a value copies the reference, not the subtree
+        * Mutable access (`as_array()`, `as_object()`, `as_string()`,
+          `operator[]`, `storage()`, ...) first replaces the reference by
+          a private copy of the node, one level at a time: the children of
+          the copy still refer to the shared nodes. `unshare()` does so
+          explicitly
+        * Shared nodes are never written to, so copies of a value that
+          refer to the same nodes can be used from different threads
+
     -------------
     Thread-Safety
     -------------
@@ -95,12 +132,16 @@
 /// @ingroup Sonnet
 
 #include <variant>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <memory_resource>
 #include <compare>
 #include <cstddef>
+#include <cstdint>
+#include <span>
 #include <concepts>
 #include <utility>
 #include "sonnet/config.hpp"
@@ -138,6 +179,52 @@ namespace Sonnet {
     /// @brief Object type used by Sonnet::value (JSON objects)
     using object = pmr_map<string, value>;
 
+    /// @ingroup SonnetValue
+    /// @brief Numbers of a packed numeric array (see `value::pack`)
+    using number_array = pmr_vector<double>;
+
+    /// @ingroup SonnetValue
+    /// @brief Storage of a packed numeric array (see `value::pack`)
+    ///
+    /// @details
+    /// Holds the numbers and, once a const accessor asked for `value`
+    /// elements, the element nodes materialized from them. Copies carry
+    /// only the numbers.
+    struct packed_array {
+        number_array nums; ///< The elements
+
+        SONNET_API explicit packed_array(number_array n) noexcept;
+        SONNET_API packed_array(const packed_array& other);
+        SONNET_API packed_array(packed_array&& other) noexcept;
+        SONNET_API packed_array& operator=(const packed_array& other);
+        SONNET_API packed_array& operator=(packed_array&& other) noexcept;
+        SONNET_API ~packed_array();
+
+        /// @brief Returns the elements as number values using @p res
+        ///
+        /// @details
+        /// Built from `nums` on the first call and kept until
+        /// `drop_elements()`; concurrent calls build them once.
+        [[nodiscard]] SONNET_API const array& elements(std::pmr::memory_resource* res) const;
+
+        /// @brief Returns the element nodes if they are built, else `nullptr`
+        [[nodiscard]] const array* built_elements() const noexcept { return m_Elements.load(std::memory_order_acquire); }
+
+        /// @brief Releases the element nodes, e.g. after `nums` changed
+        SONNET_API void drop_elements() noexcept;
+
+        friend bool operator==(const packed_array& lhs, const packed_array& rhs) { return lhs.nums == rhs.nums; }
+        friend auto operator<=>(const packed_array& lhs, const packed_array& rhs) { return lhs.nums <=> rhs.nums; }
+
+    private:
+        mutable std::atomic<array*> m_Elements{ nullptr };
+    };
+
+    /// @ingroup SonnetValue
+    /// @brief Immutable node referred to by a shared subtree (see
+    ///        `value::is_shared`)
+    using shared_value = std::shared_ptr<const value>;
+
     /// @ingroup SonnetValue
     /// @brief Variant storage used internally by Sonnet::value
     /// @details Exposed only for completness; most users interact via
@@ -148,7 +235,9 @@ namespace Sonnet {
         double,
         string,
         array,
-        object
+        object,
+        packed_array,
+        shared_value
     >;
 
     
@@ -254,6 +343,21 @@ namespace Sonnet {
         ///            allocator, contents are cloned into a new object
         SONNET_API value(object o, std::pmr::memory_resource* res = std::pmr::get_default_resource());
 
+        /// @ingroup SonnetValue
+        /// @brief Constructs a packed numeric array
+        ///
+        /// @param a Numbers to store. May be moved from
+        /// @param res Memory resource associated with the value
+        SONNET_API value(number_array a, std::pmr::memory_resource* res = std::pmr::get_default_resource());
+
+        /// @ingroup SonnetValue
+        /// @brief Constructs a reference to a shared immutable node
+        ///
+        /// @details
+        /// The value adopts the memory resource of the node.
+        /// @param node Node to refer to; must not be null or itself shared
+        SONNET_API explicit value(shared_value node) noexcept;
+
         /// @ingroup SonnetValue
         /// @brief Copy-constructs a JSON value
         ///
@@ -331,6 +435,22 @@ namespace Sonnet {
         /// @ingroup SonnetValue
         /// @brief Checks whether the value holds an object
         SONNET_API [[nodiscard]] bool is_object() const noexcept { return type() == kind::object;  }
+
+        /// @ingroup SonnetValue
+        /// @brief Checks whether the value holds a packed numeric array
+        [[nodiscard]] bool is_packed() const noexcept { return std::holds_alternative<packed_array>(target().m_Storage); }
+
+        /// @ingroup SonnetValue
+        /// @brief Checks whether the value refers to a shared immutable node
+        [[nodiscard]] bool is_shared() const noexcept { return std::holds_alternative<shared_value>(m_Storage); }
+
+        /// @ingroup SonnetValue
+        /// @brief Replaces a reference to a shared node by a private copy
+        ///
+        /// @details
+        /// Has no effect unless `is_shared()` is true. Only the node itself
+        /// is copied; its children keep referring to shared nodes.
+        SONNET_API void unshare();
         
         // ------------------------------------------------------------
         // Scalar accessors
@@ -376,7 +496,8 @@ namespace Sonnet {
         /// @ingroup SonnetValue
         /// @brief Returns a reference to the stored array value 
         /// @details
-        /// If `is_array()` is true, returns the existing array.
+        /// If `is_array()` is true, returns the existing array, unpacking
+        /// it first if it is packed.
         /// Otherwise, the current contents are discarded and replaced with
         /// an empty array allocated from `resource()`, and that array is returned
         /// @pre `is_array()` must be true. Calling this when the active kind
@@ -385,9 +506,38 @@ namespace Sonnet {
 
         /// @ingroup SonnetValue
         /// @brief Returns a const reference to the stored array value 
+        /// @details
+        /// A packed array returns its element nodes, built on the first
+        /// call and valid until the next mutable access to the value.
         /// @pre `is_array()` must be true.
         SONNET_API [[nodiscard]] const array& as_array() const;
 
+        /// @ingroup SonnetValue
+        /// @brief Returns the elements of a packed array
+        /// @return The packed numbers, or an empty span if `is_packed()` is false
+        SONNET_API [[nodiscard]] std::span<double>       numbers();
+
+        /// @ingroup SonnetValue
+        /// @brief Returns the elements of a packed array
+        /// @return The packed numbers, or an empty span if `is_packed()` is false
+        SONNET_API [[nodiscard]] std::span<const double> numbers() const noexcept;
+
+        /// @ingroup SonnetValue
+        /// @brief Packs a non-empty array whose elements are all numbers
+        ///
+        /// @details
+        /// References to the former elements are invalidated.
+        /// @return Whether the value is now packed
+        SONNET_API bool pack();
+
+        /// @ingroup SonnetValue
+        /// @brief Converts a packed array back into an array of values
+        ///
+        /// @details
+        /// Has no effect unless `is_packed()` is true. Spans returned by
+        /// `numbers()` are invalidated.
+        SONNET_API void unpack();
+
         /// @ingroup SonnetValue
         /// @brief Returns a reference to the stored object value
         /// @details
@@ -438,6 +588,7 @@ namespace Sonnet {
         ///  - The current value is already an array
         ///  - The index @p idx is within array bounds
         /// If either condition is violated, resulting behavior is undefined
+        /// Elements of a packed array are read like in `as_array()`.
         /// @param idx Zero based into the array
         /// @return Const reference to the value at index @p idx
         SONNET_API const value& operator[](size_t idx) const;
@@ -479,12 +630,21 @@ namespace Sonnet {
         SONNET_API const value& at(std::string_view key) const;
 
         /// @ingroup SonnetValue
-        /// @brief Defaulted three-way comparison for structural ordering.
+        /// @brief Three-way comparison for structural ordering.
         /// 
         /// @details 
         /// Values are compared first by kind, then by their stored contents.
-        /// For arrays and objects, comparison is structural (lexicographical for arrays, key/value-wise for objects)
-        SONNET_API friend auto operator<=>(const value& lhs, const value& rhs) = default;
+        /// For arrays and objects, comparison is structural (lexicographical for arrays, key/value-wise for objects).
+        /// Packed arrays compare like their unpacked form.
+        SONNET_API friend std::partial_ordering operator<=>(const value& lhs, const value& rhs);
+
+        /// @ingroup SonnetValue
+        /// @brief Structural equality, consistent with `operator<=>`
+        ///
+        /// @details
+        /// Always compares the contents; to reject values by memoized
+        /// hashes first, see `Sonnet::hashed_equal`.
+        SONNET_API friend bool operator==(const value& lhs, const value& rhs);
         
         /// @ingroup SonnetValue
         /// @brief Returns the memory resource associated with this value 
@@ -503,7 +663,7 @@ namespace Sonnet {
         /// This function provides direct access to the internal `storage_t` 
         /// variant that backs this `value`. The returned reference exposes the
         /// raw representation:
-        ///         std::variant<std::monostate, bool, double, string, array, object>
+        ///         std::variant<std::monostate, bool, double, string, array, object, packed_array, shared_value>
         /// Typical users should prefer higher-level accessors such as the `as_*()` functions, 
         /// which provide safer, JSON-semantic behavior.
         /// @return Const reference to the internal storage variant
@@ -523,14 +683,30 @@ namespace Sonnet {
         /// `operator[]`, or type predicates (`is_array()`, `is_object()`, etc.).
         ///
         /// **Use with extreme caution.**
+        /// A shared value is unshared first, so the result never holds a
+        /// `shared_value`, and the element nodes of a packed array are
+        /// released.
         /// @return Mutable reference to the internal storage variant
-        [[nodiscard]] SONNET_API storage_t& storage() noexcept { return m_Storage; }
+        [[nodiscard]] SONNET_API storage_t& storage() {
+            unshare();
+            if (auto* p = std::get_if<packed_array>(&m_Storage)) p->drop_elements();
+            return m_Storage;
+        }
 
         
     private:
         std::pmr::memory_resource* m_MemRes{};
         storage_t m_Storage{};
 
+        friend class array_index;
+
+        // The node whose contents this value reads: the shared node if
+        // there is one, otherwise the value itself
+        const value& target() const noexcept {
+            auto* node = std::get_if<shared_value>(&m_Storage);
+            return node ? **node : *this;
+        }
+
         static storage_t clone_storage(const storage_t& s, std::pmr::memory_resource* res);
     };
 
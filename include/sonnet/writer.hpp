@@ -0,0 +1,369 @@
+#pragma once
+
+
+/*
+    ------------------------------------------
+    Sonnet writer helpers - reusable dump state
+    ------------------------------------------
+    This header defines helper objects that can be threaded through
+    repeated calls to `Sonnet::dump(...)` to avoid redoing work that is
+    identical from one document to the next
+
+    ------------------------
+    Key Cache - KeyCache
+    ------------------------
+    - Record-oriented output (NDJSON exports, log lines, API responses)
+      writes the same small set of object keys millions of times
+    - `KeyCache` maps a raw key to its fully escaped form, including the
+      surrounding quotes and the trailing `:`, e.g. `id` -> `"id":`
+    - On a hit, emitting a key is a single `write` of pre-escaped bytes
+      instead of a per-character escape loop
+    - The cache is bounded by `max_entries`; once full, unseen keys are
+      escaped on the fly and are not inserted, so documents with
+      unbounded key sets (e.g. maps keyed by ids) cannot grow it forever
+
+    ---------------------------------------
+    Serialization Templates - Template
+    ---------------------------------------
+    - Responses often share a fixed envelope around a handful of variable
+      fields. `compile_template(prototype, holes)` serializes the prototype
+      once, cutting the output at every hole
+    - Holes are JSON Pointers (RFC 6901) into the prototype; the value found
+      at each pointer is only a placeholder and is not part of the output
+    - `render(tmpl, args...)` writes the static fragments with plain copies
+      and serializes only the arguments, one per hole, in the order the holes
+      were given to `compile_template`
+    - Formatting options are fixed at compile time; in pretty mode each hole
+      value is indented to the depth of the hole it fills
+
+    ----------------------------------------
+    Resumable Serialization - DumpState
+    ----------------------------------------
+    - `dump_to(v, buf, state)` writes as much of `v` as fits into the
+      caller-supplied `buf` and returns the number of bytes written
+    - `state` remembers where output stopped; calling `dump_to` again with
+      the same value and state continues exactly there, until
+      `state.done()` reports that the document is complete
+    - No heap memory is allocated: the traversal stack lives inside
+      `DumpState` and is bounded by `DumpState::max_depth` nesting levels.
+      Deeper documents stop with `state.failed()`
+    - The one exception is canonical output of an object whose keys sort
+      differently in UTF-16 than in UTF-8 (code points from U+E000 up):
+      its member pointers are sorted once, into a buffer in `DumpState`
+      that later documents reuse
+    - The value must not be modified between calls for the same state
+
+    -----
+    Usage
+    -----
+        Sonnet::KeyCache keys;
+        for (const auto& record : records) {
+            Sonnet::dump(record, out, keys);
+            out.put('\n');
+        }
+
+        auto tmpl = Sonnet::compile_template(envelope, {"/data", "/meta/id"});
+        std::string body = Sonnet::render(tmpl, payload, Sonnet::value{ 42 });
+
+        Sonnet::DumpState state;
+        while (!state.done() && !state.failed()) {
+            auto slot = ring.acquire();
+            slot.commit(Sonnet::dump_to(doc, slot.bytes(), state));
+        }
+
+    `KeyCache` and `Template` are not thread-safe to mutate; a compiled
+    `Template` may be rendered concurrently from several threads
+*/
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+#include <vector>
+#include <span>
+#include <array>
+#include <memory>
+#include <concepts>
+#include <initializer_list>
+#include <iosfwd>
+#include <cstdint>
+
+#include "sonnet/value.hpp"
+#include "sonnet/options.hpp"
+#include "sonnet/config.hpp"
+
+/// @defgroup SonnetWriter Writer Helpers
+/// @ingroup Sonnet
+/// @brief Reusable state that speeds up repeated serialization
+
+namespace Sonnet {
+
+    /// @ingroup SonnetWriter
+    /// @brief Cache of pre-escaped object keys shared across `dump` calls
+    ///
+    /// @details
+    /// Each entry maps a raw key to its escaped JSON form including the
+    /// quotes and the `:` separator (`"key":`). Passing the same cache to
+    /// every `dump` of a record stream turns key emission into a single
+    /// memcpy per key.
+    ///
+    /// Example:
+    /// @code
+    /// Sonnet::KeyCache keys;
+    /// std::string line = Sonnet::dump(record, keys);
+    /// @endcode
+    class KeyCache {
+    public:
+        /// @ingroup SonnetWriter
+        /// @brief Constructs an empty cache
+        /// @param max_entries Upper bound on the number of cached keys.
+        ///        Keys seen after the cache is full are escaped on every use.
+        SONNET_API explicit KeyCache(std::size_t max_entries = 4096);
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the escaped form (`"key":`) of @p key
+        ///
+        /// @details
+        /// On a miss the key is escaped and, if there is room, stored for
+        /// subsequent calls. The returned view is valid until the next call
+        /// to `lookup` or `clear`.
+        ///
+        /// @param key Raw (unescaped) object key
+        /// @return View of the quoted, escaped key followed by `:`
+        [[nodiscard]] SONNET_API std::string_view lookup(std::string_view key);
+
+        /// @ingroup SonnetWriter
+        /// @brief Removes every cached entry
+        SONNET_API void clear() noexcept;
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the number of cached keys
+        [[nodiscard]] std::size_t size() const noexcept { return m_Entries.size(); }
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the maximum number of keys the cache will hold
+        [[nodiscard]] std::size_t max_entries() const noexcept { return m_MaxEntries; }
+
+    private:
+        struct key_hash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view sv) const noexcept { return std::hash<std::string_view>{}(sv); }
+        };
+
+        std::unordered_map<std::string, std::string, key_hash, std::equal_to<>> m_Entries;
+        std::string m_Scratch;
+        std::size_t m_MaxEntries;
+    };
+
+    /// @ingroup SonnetWriter
+    /// @brief Pre-serialized document with holes for dynamic values
+    ///
+    /// @details
+    /// Produced by `compile_template`. Holds every static byte of the
+    /// prototype in one buffer plus a list of slots; each slot records the
+    /// buffer offset at which a hole value is spliced in.
+    class Template {
+    public:
+        /// @brief Position of a hole inside the pre-rendered bytes
+        struct slot {
+            std::size_t offset; ///< Byte offset into `bytes()` where the hole value is written
+            std::size_t hole;   ///< Index of the hole (argument position in `render`)
+            std::size_t depth;  ///< Nesting depth of the hole, used for pretty indentation
+        };
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the number of holes, i.e. the number of `render` arguments
+        [[nodiscard]] std::size_t hole_count() const noexcept { return m_Slots.size(); }
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns all static bytes of the template, concatenated
+        [[nodiscard]] std::string_view bytes() const noexcept { return m_Bytes; }
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the slots in output order
+        [[nodiscard]] std::span<const slot> slots() const noexcept { return m_Slots; }
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the formatting options the template was compiled with
+        [[nodiscard]] const WriteOptions& options() const noexcept { return m_Opts; }
+
+    private:
+        friend SONNET_API Template compile_template(const value& prototype, std::span<const std::string_view> holes, const WriteOptions& opts);
+
+        std::string m_Bytes;
+        std::vector<slot> m_Slots;
+        WriteOptions m_Opts;
+    };
+
+    /// @ingroup SonnetWriter
+    /// @brief Pre-serializes @p prototype, leaving holes at the given JSON Pointers
+    ///
+    /// @details
+    /// Every hole must resolve to a node of @p prototype, holes must be
+    /// distinct and no hole may lie inside another one.
+    ///
+    /// Example:
+    /// @code
+    /// Sonnet::value env;
+    /// env["status"] = "ok";
+    /// env["data"];
+    /// std::string_view holes[] = { "/data" };
+    /// auto tmpl = Sonnet::compile_template(env, holes);
+    /// @endcode
+    ///
+    /// @param prototype Document whose static parts are serialized
+    /// @param holes JSON Pointers to the dynamic nodes, in argument order
+    /// @param opts Formatting options baked into the template
+    /// @return The compiled template
+    /// @throws std::invalid_argument If a hole does not resolve or holes overlap
+    [[nodiscard]] SONNET_API Template compile_template(const value& prototype, std::span<const std::string_view> holes, const WriteOptions& opts = {});
+
+    /// @ingroup SonnetWriter
+    /// @brief Convenience overload of `compile_template` taking a braced list of holes
+    [[nodiscard]] inline Template compile_template(const value& prototype, std::initializer_list<std::string_view> holes, const WriteOptions& opts = {}) {
+        return compile_template(prototype, std::span<const std::string_view>{ holes.begin(), holes.size() }, opts);
+    }
+
+    /// @ingroup SonnetWriter
+    /// @brief Renders @p tmpl to @p os, filling hole `i` with `*args[i]`
+    /// @throws std::invalid_argument If `args.size() != tmpl.hole_count()`
+    SONNET_API void render(const Template& tmpl, std::ostream& os, std::span<const value* const> args);
+
+    /// @ingroup SonnetWriter
+    /// @brief Renders @p tmpl to a string, filling hole `i` with `*args[i]`
+    /// @throws std::invalid_argument If `args.size() != tmpl.hole_count()`
+    [[nodiscard]] SONNET_API std::string render(const Template& tmpl, std::span<const value* const> args);
+
+    /// @ingroup SonnetWriter
+    /// @brief Renders @p tmpl to a string with one `value` argument per hole
+    ///
+    /// Example:
+    /// @code
+    /// std::string body = Sonnet::render(tmpl, payload);
+    /// @endcode
+    template<typename... Args>
+        requires (std::same_as<Args, value> && ...)
+    [[nodiscard]] std::string render(const Template& tmpl, const Args&... args) {
+        std::array<const value*, sizeof...(Args)> ptrs{ std::addressof(args)... };
+        return render(tmpl, std::span<const value* const>{ ptrs });
+    }
+
+    /// @ingroup SonnetWriter
+    /// @brief Renders @p tmpl to @p os with one `value` argument per hole
+    template<typename... Args>
+        requires (std::same_as<Args, value> && ...)
+    void render(const Template& tmpl, std::ostream& os, const Args&... args) {
+        std::array<const value*, sizeof...(Args)> ptrs{ std::addressof(args)... };
+        render(tmpl, os, std::span<const value* const>{ ptrs });
+    }
+
+    namespace detail { struct ChunkWriter; }
+
+    /// @ingroup SonnetWriter
+    /// @brief Cursor for resumable, allocation-free serialization with `dump_to`
+    ///
+    /// @details
+    /// A default-constructed state starts a new document on the next call to
+    /// `dump_to`. The state keeps a pointer to the value being written and
+    /// iterators into it, so the value must outlive the state and must not
+    /// change until `done()` returns true or the state is `reset()`. Only
+    /// canonical objects that need reordering allocate, see `dump_to`.
+    class DumpState {
+    public:
+        /// @brief Maximum array/object nesting depth `dump_to` can serialize
+        static constexpr std::size_t max_depth = 128;
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns true once the whole document has been written
+        [[nodiscard]] bool done() const noexcept { return m_Phase == phase::done; }
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns true if the document nests deeper than `max_depth`,
+        ///        or sorting the members of a canonical object ran out of memory
+        [[nodiscard]] bool failed() const noexcept { return m_Phase == phase::failed; }
+
+        /// @ingroup SonnetWriter
+        /// @brief Returns the total number of bytes produced so far
+        [[nodiscard]] std::size_t total_written() const noexcept { return m_Total; }
+
+        /// @ingroup SonnetWriter
+        /// @brief Discards progress so the next `dump_to` starts a new document
+        void reset() noexcept {
+            m_Phase = phase::idle;
+            m_Depth = 0;
+            m_Next = nullptr;
+            m_Str = m_StrEnd = nullptr;
+            m_InString = m_StrIsKey = false;
+            m_PendingLen = m_PendingPos = 0;
+            m_Spaces = 0;
+            m_Total = 0;
+            m_Sorted.clear();
+        }
+
+    private:
+        friend struct detail::ChunkWriter;
+
+        enum class phase : std::uint8_t { idle, running, done, failed };
+        enum class step : std::uint8_t { member, key, value, number, closing };
+
+        struct frame {
+            const value* node = nullptr;
+            std::size_t index = 0;                       ///< Elements / members emitted so far
+            object::const_iterator it{};                 ///< Next member in map order
+            const object::value_type* member = nullptr;  ///< Member currently being written
+            step next = step::member;
+            bool reorder = false;                        ///< Canonical: walk members in UTF-16 order
+            std::size_t sorted = 0;                      ///< Reorder: where the sorted members start in `m_Sorted`
+        };
+
+        std::array<frame, max_depth> m_Stack{};
+        std::vector<const object::value_type*> m_Sorted; ///< Members of reordered frames, innermost last
+        std::size_t m_Depth = 0;
+        const value* m_Next = nullptr;
+        const char* m_Str = nullptr;
+        const char* m_StrEnd = nullptr;
+        bool m_InString = false;
+        bool m_StrIsKey = false;
+        std::array<char, 40> m_Pending{};
+        std::uint8_t m_PendingLen = 0;
+        std::uint8_t m_PendingPos = 0;
+        std::size_t m_Spaces = 0;
+        std::size_t m_Total = 0;
+        WriteOptions m_Opts{};
+        phase m_Phase = phase::idle;
+    };
+
+    /// @ingroup SonnetWriter
+    /// @brief Writes the next part of @p v into @p buf without allocating
+    ///
+    /// @details
+    /// On the first call for a fresh @p state, serialization of @p v starts
+    /// with @p opts (later calls keep the options captured then). Each call
+    /// fills @p buf as far as possible and returns the number of bytes
+    /// written; a return value smaller than `buf.size()` means the document
+    /// is complete or failed. Output is byte-for-byte identical to
+    /// `dump(v, opts)` except that `KeyCache`s are not used. The only
+    /// allocation is in canonical mode, for objects with keys from U+E000
+    /// up: their members are sorted once per object into a buffer that
+    /// @p state keeps for later documents.
+    ///
+    /// Example:
+    /// @code
+    /// Sonnet::DumpState st;
+    /// char buf[4096];
+    /// while (!st.done()) {
+    ///     size_t n = Sonnet::dump_to(v, buf, st);
+    ///     if (st.failed()) break;
+    ///     sock.send(buf, n);
+    /// }
+    /// @endcode
+    ///
+    /// @param v Value to serialize; must be the same object on every call
+    /// @param buf Destination buffer
+    /// @param state Resumable cursor
+    /// @param opts Formatting options, read on the first call only
+    /// @return Number of bytes written into @p buf
+    SONNET_API std::size_t dump_to(const value& v, std::span<char> buf, DumpState& state, const WriteOptions& opts = {}) noexcept;
+
+} // namespace Sonnet
@@ -22,7 +22,25 @@ int main(int argc, char** argv) {
     };
 
     const char* lib_srcs[] = {
+        "src/cbor.cpp",
+        "src/columns.cpp",
+        "src/describe.cpp",
+        "src/diff.cpp",
         "src/error.cpp",
+        "src/frozen.cpp",
+        "src/hash.cpp",
+        "src/index.cpp",
+        "src/intern.cpp",
+        "src/jsonpath.cpp",
+        "src/msgpack.cpp",
+        "src/parallel.cpp",
+        "src/patch.cpp",
+        "src/pointer.cpp",
+        "src/reduce.cpp",
+        "src/regex.cpp",
+        "src/sax.cpp",
+        "src/schema.cpp",
+        "src/shared.cpp",
         "src/sonnet.cpp",
         "src/value.cpp",
         NULL
@@ -0,0 +1,159 @@
+#pragma once
+
+// Internal helpers shared by the binary encoders and decoders (CBOR, MessagePack)
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "sonnet/error.hpp"
+
+
+namespace Sonnet::detail {
+
+    // Appends encoded bytes to a caller-owned vector
+    struct ByteVectorSink {
+        std::vector<std::byte>& out;
+
+        void put(std::uint8_t b) { out.push_back(std::byte{ b }); }
+
+        void write(const void* data, std::size_t n) {
+            const auto* b = static_cast<const std::byte*>(data);
+            out.insert(out.end(), b, b + n);
+        }
+
+        void flush() noexcept {}
+    };
+
+    // Buffers encoded bytes in front of an ostream so small heads and
+    // scalars do not each cost a virtual `write`
+    struct ByteStreamSink {
+        std::ostream& os;
+        std::array<char, 512> buf{};
+        std::size_t len = 0;
+
+        explicit ByteStreamSink(std::ostream& o) : os{ o } {}
+
+        void put(std::uint8_t b) {
+            if (len == buf.size()) flush();
+            buf[len++] = static_cast<char>(b);
+        }
+
+        void write(const void* data, std::size_t n) {
+            if (n > buf.size() - len) {
+                flush();
+                if (n >= buf.size()) {
+                    os.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+                    return;
+                }
+            }
+            std::memcpy(buf.data() + len, data, n);
+            len += n;
+        }
+
+        void flush() {
+            os.write(buf.data(), static_cast<std::streamsize>(len));
+            len = 0;
+        }
+    };
+
+    template<typename T>
+    [[nodiscard]] inline T load_be(const std::uint8_t* p) noexcept {
+        T v{};
+        std::memcpy(&v, p, sizeof(T));
+        if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1) v = std::byteswap(v);
+        return v;
+    }
+
+    // Writes a one-byte prefix followed by @p v in network byte order
+    template<typename Sink, typename T>
+    inline void put_be(Sink& out, std::uint8_t prefix, T v) {
+        if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1) v = std::byteswap(v);
+        std::uint8_t b[1 + sizeof(T)];
+        b[0] = prefix;
+        std::memcpy(b + 1, &v, sizeof(T));
+        out.write(b, sizeof(b));
+    }
+
+    // Binary input has no lines; the column mirrors the byte offset
+    [[nodiscard]] inline ParseError binary_error(ParseError::code c, std::size_t offset, std::string_view msg) {
+        return ParseError::make(c, offset, 1, offset + 1, msg);
+    }
+
+    // Converts a float to IEEE 754 binary16 if that is lossless
+    [[nodiscard]] inline bool to_half(float f, std::uint16_t& out) noexcept {
+        std::uint32_t b = std::bit_cast<std::uint32_t>(f);
+        auto sign = static_cast<std::uint16_t>((b >> 16) & 0x8000);
+        std::uint32_t exp = (b >> 23) & 0xFF;
+        std::uint32_t mant = b & 0x7FFFFF;
+
+        if (exp == 0xFF) {
+            if (mant != 0) return false;
+            out = static_cast<std::uint16_t>(sign | 0x7C00);
+            return true;
+        }
+        if (exp == 0) {
+            if (mant != 0) return false;
+            out = sign;
+            return true;
+        }
+
+        int e = static_cast<int>(exp) - 127;
+        if (e > 15 || e < -24) return false;
+        if (e >= -14) {
+            if (mant & 0x1FFF) return false;
+            out = static_cast<std::uint16_t>(sign | static_cast<std::uint32_t>(e + 15) << 10 | mant >> 13);
+            return true;
+        }
+
+        std::uint32_t sig = 0x800000 | mant;
+        int shift = -e - 1;
+        if (sig & ((1u << shift) - 1)) return false;
+        out = static_cast<std::uint16_t>(sign | (sig >> shift));
+        return true;
+    }
+
+    [[nodiscard]] inline double from_half(std::uint16_t h) noexcept {
+        int exp = (h >> 10) & 0x1F;
+        int mant = h & 0x3FF;
+        double d;
+        if (exp == 0) d = std::ldexp(mant, -24);
+        else if (exp == 31) d = mant == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        else d = std::ldexp(mant + 1024, exp - 25);
+        return (h & 0x8000) ? -d : d;
+    }
+
+    // Binary strings map to JSON as unpadded base64url (RFC 8949 section 6.1)
+    inline void append_base64url(std::string_view bytes, std::string& out) {
+        static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        const auto* p = reinterpret_cast<const std::uint8_t*>(bytes.data());
+        size_t n = bytes.size();
+        size_t i = 0;
+        for (; i + 3 <= n; i += 3) {
+            std::uint32_t w = static_cast<std::uint32_t>(p[i]) << 16 | static_cast<std::uint32_t>(p[i + 1]) << 8 | p[i + 2];
+            out.push_back(alphabet[(w >> 18) & 0x3F]);
+            out.push_back(alphabet[(w >> 12) & 0x3F]);
+            out.push_back(alphabet[(w >> 6) & 0x3F]);
+            out.push_back(alphabet[w & 0x3F]);
+        }
+        if (n - i == 1) {
+            std::uint32_t w = static_cast<std::uint32_t>(p[i]) << 16;
+            out.push_back(alphabet[(w >> 18) & 0x3F]);
+            out.push_back(alphabet[(w >> 12) & 0x3F]);
+        } else if (n - i == 2) {
+            std::uint32_t w = static_cast<std::uint32_t>(p[i]) << 16 | static_cast<std::uint32_t>(p[i + 1]) << 8;
+            out.push_back(alphabet[(w >> 18) & 0x3F]);
+            out.push_back(alphabet[(w >> 12) & 0x3F]);
+            out.push_back(alphabet[(w >> 6) & 0x3F]);
+        }
+    }
+
+} // namespace Sonnet::detail
@@ -0,0 +1,370 @@
+#include "sonnet/cbor.hpp"
+#include "binary.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+#include <string>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        using expected_void = std::expected<void, ParseError>;
+
+        template<typename Sink>
+        struct CborEncoder {
+            Sink& out;
+            const CborOptions& opts;
+            std::vector<const object::value_type*> order;
+
+            void head(std::uint8_t major, std::uint64_t n) {
+                auto mt = static_cast<std::uint8_t>(major << 5);
+                if (n < 24) out.put(static_cast<std::uint8_t>(mt | n));
+                else if (n <= 0xFF) put_be(out, mt | 24, static_cast<std::uint8_t>(n));
+                else if (n <= 0xFFFF) put_be(out, mt | 25, static_cast<std::uint16_t>(n));
+                else if (n <= 0xFFFFFFFF) put_be(out, mt | 26, static_cast<std::uint32_t>(n));
+                else put_be(out, mt | 27, n);
+            }
+
+            void number(double d) {
+                if (std::isnan(d)) {
+                    put_be(out, 0xF9, std::uint16_t{ 0x7E00 });
+                    return;
+                }
+                if (std::isfinite(d) && d == std::trunc(d) && !(d == 0 && std::signbit(d))) {
+                    if (d >= 0 && d < 0x1p64) {
+                        head(0, static_cast<std::uint64_t>(d));
+                        return;
+                    }
+                    if (d < 0 && d > -0x1p64) {
+                        head(1, static_cast<std::uint64_t>(-d) - 1);
+                        return;
+                    }
+                }
+
+                auto f = static_cast<float>(d);
+                if (static_cast<double>(f) == d) {
+                    std::uint16_t h;
+                    if (to_half(f, h)) put_be(out, 0xF9, h);
+                    else put_be(out, 0xFA, std::bit_cast<std::uint32_t>(f));
+                    return;
+                }
+                put_be(out, 0xFB, std::bit_cast<std::uint64_t>(d));
+            }
+
+            void text(std::string_view s) {
+                head(3, s.size());
+                out.write(s.data(), s.size());
+            }
+
+            void encode(const value& v) {
+                switch (v.type()) {
+                case kind::null: out.put(0xF6); return;
+                case kind::boolean: out.put(v.as_bool() ? 0xF5 : 0xF4); return;
+                case kind::number: number(v.as_number()); return;
+                case kind::string: text(v.as_string()); return;
+                case kind::array: {
+                    head(4, v.size());
+                    if (v.is_packed()) {
+                        for (double d : v.numbers()) number(d);
+                        return;
+                    }
+                    for (const auto& e : v.as_array()) encode(e);
+                    return;
+                }
+                case kind::object: {
+                    const auto& obj = v.as_object();
+                    head(5, obj.size());
+                    if (!opts.canonical) {
+                        for (const auto& [k, e] : obj) {
+                            text(k);
+                            encode(e);
+                        }
+                        return;
+                    }
+
+                    // Deterministic order compares encoded keys; the length
+                    // is part of the head, so shorter keys sort first
+                    size_t base = order.size();
+                    for (const auto& m : obj) order.push_back(&m);
+                    std::stable_sort(order.begin() + static_cast<std::ptrdiff_t>(base), order.end(), [](auto* a, auto* b) {
+                        return a->first.size() < b->first.size();
+                    });
+                    for (size_t i = base; i < base + obj.size(); i++) {
+                        text(order[i]->first);
+                        encode(order[i]->second);
+                    }
+                    order.resize(base);
+                    return;
+                }
+                }
+            }
+        };
+
+        template<typename Sink>
+        void encode_cbor(const value& v, Sink& out, const CborOptions& opts) {
+            CborEncoder<Sink> enc{ out, opts, {} };
+            enc.encode(v);
+            out.flush();
+        }
+
+        // Iterative decoder: open containers live on an explicit stack so
+        // hostile nesting cannot exhaust the call stack
+        template<typename Handler>
+        struct CborDecoder {
+            struct frame {
+                std::uint64_t remaining; // items (pairs for maps) left in a definite container
+                bool indefinite;
+                bool is_map;
+                bool want_key;
+            };
+
+            static constexpr std::uint64_t no_tag = ~std::uint64_t{ 0 };
+
+            const std::uint8_t* begin;
+            const std::uint8_t* p;
+            const std::uint8_t* end;
+            Handler& h;
+            size_t max_depth;
+            std::vector<frame> stack{};
+            std::string chunks{};
+            std::string text{};
+
+            std::unexpected<ParseError> fail(ParseError::code c, const std::uint8_t* at, std::string_view msg) const {
+                return std::unexpected(binary_error(c, static_cast<size_t>(at - begin), msg));
+            }
+
+            std::unexpected<ParseError> aborted() const {
+                return fail(ParseError::code::aborted, p, "Decoding stopped by handler");
+            }
+
+            std::expected<std::uint64_t, ParseError> argument(std::uint8_t ai, const std::uint8_t* item) {
+                if (ai < 24) return ai;
+                if (ai > 27) return fail(ParseError::code::unexpected_character, item, "Reserved or misplaced CBOR additional information");
+                size_t len = size_t{ 1 } << (ai - 24);
+                if (static_cast<size_t>(end - p) < len) return fail(ParseError::code::unexpected_end_of_input, item, "Truncated CBOR argument");
+                std::uint64_t n = 0;
+                switch (len) {
+                case 1: n = *p; break;
+                case 2: n = load_be<std::uint16_t>(p); break;
+                case 4: n = load_be<std::uint32_t>(p); break;
+                default: n = load_be<std::uint64_t>(p); break;
+                }
+                p += len;
+                return n;
+            }
+
+            std::expected<std::string_view, ParseError> string_item(std::uint8_t major, std::uint8_t ai, const std::uint8_t* item) {
+                if (ai != 31) {
+                    auto n = argument(ai, item);
+                    if (!n) return std::unexpected(n.error());
+                    if (*n > static_cast<std::uint64_t>(end - p)) return fail(ParseError::code::unexpected_end_of_input, item, "CBOR string length exceeds input");
+                    std::string_view s{ reinterpret_cast<const char*>(p), static_cast<size_t>(*n) };
+                    p += *n;
+                    return s;
+                }
+
+                chunks.clear();
+                while (true) {
+                    const std::uint8_t* chunk = p;
+                    if (p == end) return fail(ParseError::code::unexpected_end_of_input, item, "Unterminated indefinite-length CBOR string");
+                    std::uint8_t ib = *p++;
+                    if (ib == 0xFF) break;
+                    if ((ib >> 5) != major || (ib & 0x1F) == 31) return fail(ParseError::code::unexpected_character, chunk, "Invalid chunk in indefinite-length CBOR string");
+                    auto s = string_item(major, ib & 0x1F, chunk);
+                    if (!s) return s;
+                    chunks.append(*s);
+                }
+                return std::string_view{ chunks };
+            }
+
+            std::expected<std::string_view, ParseError> text_item(std::uint8_t ai, const std::uint8_t* item) {
+                auto s = string_item(3, ai, item);
+                if (!s) return s;
+                size_t bad = 0;
+                if (!is_valid_utf8(*s, bad)) return fail(ParseError::code::invalid_string, item, "Invalid UTF-8 in CBOR text string");
+                return s;
+            }
+
+            expected_void open(bool is_map, std::uint8_t ai, const std::uint8_t* item) {
+                if (max_depth != 0 && stack.size() + 1 > max_depth) return fail(ParseError::code::depth_limit_exceeded, item, "Maximum nesting depth exceeded");
+
+                size_t size = SaxHandler::unknown_size;
+                if (ai == 31) stack.push_back(frame{ 0, true, is_map, true });
+                else {
+                    auto n = argument(ai, item);
+                    if (!n) return std::unexpected(n.error());
+                    // Every item takes at least one byte, which bounds honest lengths
+                    std::uint64_t avail = static_cast<std::uint64_t>(end - p);
+                    if (*n > avail || (is_map && *n > avail / 2)) return fail(ParseError::code::unexpected_end_of_input, item, "CBOR container length exceeds input");
+                    size = static_cast<size_t>(*n);
+                    stack.push_back(frame{ *n, false, is_map, true });
+                }
+                if (!(is_map ? h.on_start_object(size) : h.on_start_array(size))) return aborted();
+                return {};
+            }
+
+            expected_void simple(std::uint8_t ai, const std::uint8_t* item) {
+                bool ok = true;
+                switch (ai) {
+                case 20: ok = h.on_bool(false); break;
+                case 21: ok = h.on_bool(true); break;
+                case 24: {
+                    if (p == end) return fail(ParseError::code::unexpected_end_of_input, item, "Truncated CBOR simple value");
+                    if (*p++ < 32) return fail(ParseError::code::unexpected_character, item, "Invalid two-byte CBOR simple value");
+                    ok = h.on_null();
+                    break;
+                }
+                case 25:
+                case 26:
+                case 27: {
+                    auto n = argument(ai, item);
+                    if (!n) return std::unexpected(n.error());
+                    double d = ai == 25 ? from_half(static_cast<std::uint16_t>(*n))
+                             : ai == 26 ? static_cast<double>(std::bit_cast<float>(static_cast<std::uint32_t>(*n)))
+                             : std::bit_cast<double>(*n);
+                    ok = h.on_number(d);
+                    break;
+                }
+                case 28:
+                case 29:
+                case 30:
+                case 31: return fail(ParseError::code::unexpected_character, item, "Reserved or misplaced CBOR simple value");
+                default: ok = h.on_null(); break; // null, undefined and unassigned simple values
+                }
+                if (!ok) return aborted();
+                return {};
+            }
+
+            expected_void item() {
+                const std::uint8_t* start = p;
+                if (p == end) return fail(ParseError::code::unexpected_end_of_input, p, "Unexpected end of CBOR input");
+
+                if (*p == 0xFF) {
+                    if (stack.empty() || !stack.back().indefinite) return fail(ParseError::code::unexpected_character, p, "Unexpected CBOR break code");
+                    frame f = stack.back();
+                    if (f.is_map && !f.want_key) return fail(ParseError::code::unexpected_character, p, "Missing value for CBOR map key");
+                    p++;
+                    stack.pop_back();
+                    if (!(f.is_map ? h.on_end_object() : h.on_end_array())) return aborted();
+                    return {};
+                }
+
+                bool is_key = false;
+                if (!stack.empty()) {
+                    frame& f = stack.back();
+                    if (f.is_map) {
+                        is_key = f.want_key;
+                        f.want_key = !f.want_key;
+                        if (!is_key && !f.indefinite) f.remaining--;
+                    } else if (!f.indefinite) f.remaining--;
+                }
+
+                std::uint64_t tag = no_tag;
+                std::uint8_t ib = *p++;
+                while ((ib >> 5) == 6) {
+                    auto t = argument(ib & 0x1F, start);
+                    if (!t) return std::unexpected(t.error());
+                    tag = *t;
+                    start = p;
+                    if (p == end) return fail(ParseError::code::unexpected_end_of_input, p, "CBOR tag without content");
+                    ib = *p++;
+                }
+                auto major = static_cast<std::uint8_t>(ib >> 5);
+                auto ai = static_cast<std::uint8_t>(ib & 0x1F);
+
+                if (is_key) {
+                    if (major != 3) return fail(ParseError::code::unsupported_type, start, "CBOR map keys must be text strings");
+                    auto k = text_item(ai, start);
+                    if (!k) return std::unexpected(k.error());
+                    if (!h.on_key(*k)) return aborted();
+                    return {};
+                }
+
+                bool ok = true;
+                switch (major) {
+                case 0:
+                case 1: {
+                    auto n = argument(ai, start);
+                    if (!n) return std::unexpected(n.error());
+                    ok = h.on_number(major == 0 ? static_cast<double>(*n) : -1.0 - static_cast<double>(*n));
+                    break;
+                }
+                case 2: {
+                    auto s = string_item(2, ai, start);
+                    if (!s) return std::unexpected(s.error());
+                    if (tag == 2 || tag == 3) {
+                        double m = 0;
+                        for (char c : *s) m = m * 256 + static_cast<std::uint8_t>(c);
+                        ok = h.on_number(tag == 2 ? m : -1.0 - m);
+                        break;
+                    }
+                    text.clear();
+                    append_base64url(*s, text);
+                    ok = h.on_string(text);
+                    break;
+                }
+                case 3: {
+                    auto s = text_item(ai, start);
+                    if (!s) return std::unexpected(s.error());
+                    ok = h.on_string(*s);
+                    break;
+                }
+                case 4:
+                case 5: return open(major == 5, ai, start);
+                default: return simple(ai, start);
+                }
+                if (!ok) return aborted();
+                return {};
+            }
+
+            expected_void run() {
+                do {
+                    if (auto r = item(); !r) return r;
+                    while (!stack.empty() && !stack.back().indefinite && stack.back().remaining == 0) {
+                        bool is_map = stack.back().is_map;
+                        stack.pop_back();
+                        if (!(is_map ? h.on_end_object() : h.on_end_array())) return aborted();
+                    }
+                } while (!stack.empty());
+
+                if (p != end) return fail(ParseError::code::trailing_characters, p, "Trailing bytes after CBOR data item");
+                return {};
+            }
+        };
+
+        template<typename Handler>
+        expected_void decode_cbor(std::span<const std::byte> bytes, Handler& h, const ParseOptions& opts) {
+            const auto* data = reinterpret_cast<const std::uint8_t*>(bytes.data());
+            CborDecoder<Handler> dec{ data, data, data + bytes.size(), h, opts.max_depth };
+            return dec.run();
+        }
+    } // namespace detail
+
+    std::vector<std::byte> to_cbor(const value& v, const CborOptions& opts) {
+        std::vector<std::byte> out;
+        to_cbor(v, out, opts);
+        return out;
+    }
+
+    void to_cbor(const value& v, std::vector<std::byte>& out, const CborOptions& opts) {
+        detail::ByteVectorSink sink{ out };
+        detail::encode_cbor(v, sink, opts);
+    }
+
+    void to_cbor(const value& v, std::ostream& os, const CborOptions& opts) {
+        detail::ByteStreamSink sink{ os };
+        detail::encode_cbor(v, sink, opts);
+    }
+
+    std::expected<value, ParseError> from_cbor(std::span<const std::byte> bytes, std::pmr::memory_resource* res, const ParseOptions& opts) {
+        DomBuilder builder{ res };
+        if (auto r = detail::decode_cbor(bytes, builder, opts); !r) return std::unexpected(std::move(r.error()));
+        return std::move(builder.result());
+    }
+
+    std::expected<void, ParseError> from_cbor(std::span<const std::byte> bytes, SaxHandler& handler, const ParseOptions& opts) {
+        return detail::decode_cbor(bytes, handler, opts);
+    }
+
+} // namespace Sonnet
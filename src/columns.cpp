@@ -0,0 +1,336 @@
+#include "sonnet/columns.hpp"
+#include "sonnet/sonnet.hpp"
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        inline bool fits_int64(double d) noexcept {
+            return d >= -9223372036854775808.0 && d < 9223372036854775808.0 && std::trunc(d) == d;
+        }
+
+        inline void push_bit(std::vector<std::uint8_t>& bitmap, std::size_t idx, bool bit) {
+            if ((idx & 7) == 0) bitmap.push_back(0);
+            if (bit) bitmap.back() |= static_cast<std::uint8_t>(1u << (idx & 7));
+        }
+
+        inline void pop_bit(std::vector<std::uint8_t>& bitmap, std::size_t idx) {
+            if ((idx & 7) == 0) bitmap.pop_back();
+            else bitmap.back() &= static_cast<std::uint8_t>(~(1u << (idx & 7)));
+        }
+
+        inline std::int32_t checked_offset(std::size_t n) {
+            if (n > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+                throw std::length_error{ "Sonnet::to_columns: utf8 column exceeds 2 GiB" };
+            return static_cast<std::int32_t>(n);
+        }
+
+        // Appends rows to a table one member at a time; shared by the DOM
+        // and the SAX paths so both apply the same type rules
+        class ColumnSink {
+        public:
+            explicit ColumnSink(ColumnTable& t) : m_Table{ t } {}
+
+            void begin_row() { m_Seen.assign(m_Table.columns.size(), 0); }
+
+            void end_row() {
+                for (size_t i = 0; i < m_Table.columns.size(); i++)
+                    if (!m_Seen[i]) append_null(m_Table.columns[i]);
+                m_Table.rows++;
+            }
+
+            // Returns the column for the next member of the current row
+            Column& column(std::string_view name) {
+                size_t idx;
+                if (auto it = m_Index.find(name); it != m_Index.end()) {
+                    idx = it->second;
+                    if (m_Seen[idx]) drop_last(m_Table.columns[idx]);
+                } else {
+                    idx = m_Table.columns.size();
+                    Column& c = m_Table.columns.emplace_back();
+                    c.name.assign(name);
+                    for (size_t r = 0; r < m_Table.rows; r++) append_null(c);
+                    m_Index.emplace(c.name, idx);
+                    m_Seen.push_back(0);
+                }
+                m_Seen[idx] = 1;
+                return m_Table.columns[idx];
+            }
+
+            void null(Column& c) { append_null(c); }
+
+            void boolean(Column& c, bool b) {
+                if (c.type == column_type::null) retype(c, column_type::boolean);
+                if (c.type == column_type::boolean) push_bit(c.bits, c.length, b);
+                else append_text(c, b ? "true" : "false");
+                mark_valid(c);
+            }
+
+            void number(Column& c, double d) {
+                bool integral = fits_int64(d);
+                if (c.type == column_type::null) retype(c, integral ? column_type::int64 : column_type::float64);
+                if (c.type == column_type::int64 && !integral) {
+                    c.doubles.assign(c.ints.begin(), c.ints.end());
+                    c.ints.clear();
+                    c.type = column_type::float64;
+                }
+
+                if (c.type == column_type::int64) c.ints.push_back(static_cast<std::int64_t>(d));
+                else if (c.type == column_type::float64) c.doubles.push_back(d);
+                else append_text(c, dump(value{ d }));
+                mark_valid(c);
+            }
+
+            void string(Column& c, std::string_view s) {
+                if (c.type == column_type::null) retype(c, column_type::utf8);
+                append_text(c, s);
+                mark_valid(c);
+            }
+
+            // Nested arrays and objects, already rendered as compact JSON
+            void json(Column& c, std::string_view text) { string(c, text); }
+
+        private:
+            static void append_null(Column& c) {
+                push_bit(c.validity, c.length, false);
+                switch (c.type) {
+                case column_type::null: break;
+                case column_type::boolean: push_bit(c.bits, c.length, false); break;
+                case column_type::int64: c.ints.push_back(0); break;
+                case column_type::float64: c.doubles.push_back(0.0); break;
+                case column_type::utf8: c.offsets.push_back(c.offsets.back()); break;
+                }
+                c.length++;
+                c.null_count++;
+            }
+
+            static void mark_valid(Column& c) {
+                push_bit(c.validity, c.length, true);
+                c.length++;
+            }
+
+            // Undoes the last row of a column, for a key repeated in a row
+            static void drop_last(Column& c) {
+                size_t row = --c.length;
+                if (!c.is_valid(row)) c.null_count--;
+                pop_bit(c.validity, row);
+                switch (c.type) {
+                case column_type::null: break;
+                case column_type::boolean: pop_bit(c.bits, row); break;
+                case column_type::int64: c.ints.pop_back(); break;
+                case column_type::float64: c.doubles.pop_back(); break;
+                case column_type::utf8:
+                    c.offsets.pop_back();
+                    c.data.resize(static_cast<size_t>(c.offsets.back()));
+                    break;
+                }
+            }
+
+            // Gives an all-null column its first type, with a zero slot per row
+            static void retype(Column& c, column_type t) {
+                c.type = t;
+                switch (t) {
+                case column_type::null: break;
+                case column_type::boolean: c.bits.assign((c.length + 7) / 8, 0); break;
+                case column_type::int64: c.ints.assign(c.length, 0); break;
+                case column_type::float64: c.doubles.assign(c.length, 0.0); break;
+                case column_type::utf8: c.offsets.assign(c.length + 1, 0); break;
+                }
+            }
+
+            // Appends a string slot, first converting the column to utf8 if
+            // it held another type
+            static void append_text(Column& c, std::string_view s) {
+                if (c.type != column_type::utf8) to_utf8(c);
+                c.data.append(s);
+                c.offsets.push_back(checked_offset(c.data.size()));
+            }
+
+            static void to_utf8(Column& c) {
+                std::vector<std::int32_t> offsets{ 0 };
+                offsets.reserve(c.length + 1);
+                std::string data;
+                for (size_t row = 0; row < c.length; row++) {
+                    if (c.is_valid(row)) {
+                        switch (c.type) {
+                        case column_type::boolean: data += c.bool_at(row) ? "true" : "false"; break;
+                        case column_type::int64: data += std::to_string(c.ints[row]); break;
+                        case column_type::float64: data += dump(value{ c.doubles[row] }); break;
+                        default: break;
+                        }
+                    }
+                    offsets.push_back(checked_offset(data.size()));
+                }
+                c.bits.clear();
+                c.ints.clear();
+                c.doubles.clear();
+                c.offsets = std::move(offsets);
+                c.data = std::move(data);
+                c.type = column_type::utf8;
+            }
+
+            ColumnTable& m_Table;
+            std::map<std::string, size_t, std::less<>> m_Index;
+            std::vector<std::uint8_t> m_Seen;
+        };
+
+        // Feeds parse events into a ColumnSink. Member values that are
+        // containers are assembled with a DomBuilder and stored as JSON text
+        class ColumnHandler final : public SaxHandler {
+        public:
+            explicit ColumnHandler(ColumnTable& t) : m_Sink{ t } {}
+
+            [[nodiscard]] bool bad_shape() const noexcept { return m_BadShape; }
+
+            bool on_null() override {
+                if (m_Nested) return m_Builder.on_null();
+                if (m_Depth != 2) return reject();
+                m_Sink.null(*m_Column);
+                return true;
+            }
+
+            bool on_bool(bool b) override {
+                if (m_Nested) return m_Builder.on_bool(b);
+                if (m_Depth != 2) return reject();
+                m_Sink.boolean(*m_Column, b);
+                return true;
+            }
+
+            bool on_number(double d) override {
+                if (m_Nested) return m_Builder.on_number(d);
+                if (m_Depth != 2) return reject();
+                m_Sink.number(*m_Column, d);
+                return true;
+            }
+
+            bool on_string(std::string_view s) override {
+                if (m_Nested) return m_Builder.on_string(s);
+                if (m_Depth != 2) return reject();
+                m_Sink.string(*m_Column, s);
+                return true;
+            }
+
+            bool on_start_array(std::size_t size) override {
+                if (m_Nested) {
+                    m_Nested++;
+                    return m_Builder.on_start_array(size);
+                }
+                if (m_Depth == 0) {
+                    m_Depth = 1;
+                    return true;
+                }
+                if (m_Depth == 1) return reject();
+                return start_nested(), m_Builder.on_start_array(size);
+            }
+
+            bool on_end_array() override {
+                if (m_Nested) return end_nested(m_Builder.on_end_array());
+                m_Depth = 0;
+                return true;
+            }
+
+            bool on_start_object(std::size_t size) override {
+                if (m_Nested) {
+                    m_Nested++;
+                    return m_Builder.on_start_object(size);
+                }
+                if (m_Depth == 0) return reject();
+                if (m_Depth == 1) {
+                    m_Sink.begin_row();
+                    m_Depth = 2;
+                    return true;
+                }
+                return start_nested(), m_Builder.on_start_object(size);
+            }
+
+            bool on_key(std::string_view k) override {
+                if (m_Nested) return m_Builder.on_key(k);
+                m_Column = &m_Sink.column(k);
+                return true;
+            }
+
+            bool on_end_object() override {
+                if (m_Nested) return end_nested(m_Builder.on_end_object());
+                m_Sink.end_row();
+                m_Depth = 1;
+                return true;
+            }
+
+        private:
+            bool reject() {
+                m_BadShape = true;
+                return false;
+            }
+
+            void start_nested() {
+                m_Builder.reset();
+                m_Nested = 1;
+            }
+
+            bool end_nested(bool ok) {
+                if (--m_Nested == 0) m_Sink.json(*m_Column, dump(m_Builder.result()));
+                return ok;
+            }
+
+            ColumnSink m_Sink;
+            DomBuilder m_Builder;
+            Column* m_Column = nullptr;
+            int m_Depth = 0;  // 0 before the rows, 1 between rows, 2 inside a row
+            int m_Nested = 0; // open containers inside the current member value
+            bool m_BadShape = false;
+        };
+    } // namespace detail
+
+    const Column* ColumnTable::find(std::string_view name) const noexcept {
+        for (const auto& c : columns)
+            if (c.name == name) return &c;
+        return nullptr;
+    }
+
+    ColumnTable to_columns(const value& v) {
+        if (!v.is_array()) throw std::invalid_argument{ "Sonnet::to_columns: value is not an array" };
+
+        if (v.is_packed()) throw std::invalid_argument{ "Sonnet::to_columns: array element is not an object" };
+
+        ColumnTable table;
+        detail::ColumnSink sink{ table };
+        for (const auto& row : v.as_array()) {
+            if (!row.is_object()) throw std::invalid_argument{ "Sonnet::to_columns: array element is not an object" };
+
+            sink.begin_row();
+            for (const auto& [k, e] : row.as_object()) {
+                Column& c = sink.column(k);
+                switch (e.type()) {
+                case kind::null: sink.null(c); break;
+                case kind::boolean: sink.boolean(c, e.as_bool()); break;
+                case kind::number: sink.number(c, e.as_number()); break;
+                case kind::string: sink.string(c, e.as_string()); break;
+                case kind::array:
+                case kind::object: sink.json(c, dump(e)); break;
+                }
+            }
+            sink.end_row();
+        }
+        return table;
+    }
+
+    std::expected<ColumnTable, ParseError> parse_columns(std::string_view json, const ParseOptions& opts) {
+        ColumnTable table;
+        detail::ColumnHandler handler{ table };
+        if (auto r = parse_sax(json, handler, opts); !r) {
+            ParseError err = std::move(r.error());
+            if (handler.bad_shape()) {
+                err.errc = ParseError::code::unsupported_type;
+                err.msg = "Expected an array of objects";
+            }
+            return std::unexpected(std::move(err));
+        }
+        return table;
+    }
+
+} // namespace Sonnet
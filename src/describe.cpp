@@ -0,0 +1,255 @@
+#include "sonnet/describe.hpp"
+#include "sonnet/sonnet.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace Sonnet::describe::detail {
+
+    // Drives the readers of `describe.hpp` from SAX events. The next
+    // value goes to the slot in `m_Next`, or to the next element when an
+    // array is being filled in; values without a slot (unknown keys,
+    // elements past a fixed size) are skipped, and `dom` slots are
+    // materialized by a DomBuilder
+    class Filler final : public SaxHandler {
+    public:
+        explicit Filler(Slot root) : m_Next{ root } {}
+
+        bool on_null() override {
+            Scalar s;
+            return scalar(s);
+        }
+
+        bool on_bool(bool b) override {
+            Scalar s;
+            s.type = kind::boolean;
+            s.b = b;
+            return scalar(s);
+        }
+
+        bool on_number(double d) override {
+            Scalar s;
+            s.type = kind::number;
+            s.d = d;
+            return scalar(s);
+        }
+
+        bool on_string(std::string_view str) override {
+            Scalar s;
+            s.type = kind::string;
+            s.s = str;
+            return scalar(s);
+        }
+
+        bool on_start_array(std::size_t size) override {
+            if (inside()) return forward([&](SaxHandler& h) { return h.on_start_array(size); }, 1);
+            Slot slot = take(false);
+            if (!slot.reader) return skip();
+            if (slot.reader->shape == Shape::dom) return capture(slot, [&](SaxHandler& h) { return h.on_start_array(size); });
+            if (slot.reader->shape != Shape::array) return reject(slot);
+
+            slot.reader->begin(slot.obj, size);
+            m_Stack.push_back({ slot, npos, m_Seen.size(), 0, {} });
+            return true;
+        }
+
+        bool on_end_array() override {
+            if (inside()) return forward([](SaxHandler& h) { return h.on_end_array(); }, -1);
+            Frame f = std::move(m_Stack.back());
+            m_Stack.pop_back();
+            return f.slot.reader->finish(f.slot.obj, f.index, m_Failure) || located();
+        }
+
+        bool on_start_object(std::size_t size) override {
+            if (inside()) return forward([&](SaxHandler& h) { return h.on_start_object(size); }, 1);
+            Slot slot = take(false);
+            if (!slot.reader) return skip();
+            if (slot.reader->shape == Shape::dom) return capture(slot, [&](SaxHandler& h) { return h.on_start_object(size); });
+            if (slot.reader->shape == Shape::map) slot.reader->begin(slot.obj, size);
+            else if (slot.reader->shape != Shape::object) return reject(slot);
+
+            m_Stack.push_back({ slot, npos, m_Seen.size(), 0, {} });
+            m_Seen.resize(m_Seen.size() + slot.reader->fields, false);
+            return true;
+        }
+
+        bool on_key(std::string_view k) override {
+            if (inside()) return forward([&](SaxHandler& h) { return h.on_key(k); }, 0);
+            Frame& f = m_Stack.back();
+            if (f.slot.reader->shape == Shape::map) {
+                f.key.assign(k);
+                f.field = 0;
+                m_Next = f.slot.reader->entry(f.slot.obj, k);
+                return true;
+            }
+            f.field = f.slot.reader->find(k);
+            if (f.field == npos) return true;
+            m_Seen[f.seen + f.field] = true;
+            m_Next = f.slot.reader->member(f.slot.obj, f.field);
+            return true;
+        }
+
+        bool on_end_object() override {
+            if (inside()) return forward([](SaxHandler& h) { return h.on_end_object(); }, -1);
+            Frame& f = m_Stack.back();
+            f.field = npos;
+            f.key.clear();
+            for (std::size_t i = 0; i < f.slot.reader->fields; i++) {
+                if (m_Seen[f.seen + i] || !f.slot.reader->required[i]) continue;
+                fail(m_Failure, ConvertError::code::missing_member, "missing member");
+                m_Failure.path = path();
+                Sonnet::detail::append_token(m_Failure.path, f.slot.reader->names[i]);
+                return false;
+            }
+            m_Seen.resize(f.seen);
+            m_Stack.pop_back();
+            return true;
+        }
+
+        [[nodiscard]] std::optional<std::string> error() const {
+            if (m_Failure.msg.empty()) return std::nullopt;
+            return m_Failure.path.empty() ? m_Failure.msg : m_Failure.path + ": " + m_Failure.msg;
+        }
+
+    private:
+        struct Frame {
+            Slot slot;
+            std::size_t field; // object: member being filled in, or npos; map: 0 once keyed
+            std::size_t seen;  // object: first of its bits in m_Seen
+            std::size_t index; // array: elements started so far
+            std::string key;   // map: key being filled in
+        };
+
+        // Whether events belong to a value being skipped or captured
+        [[nodiscard]] bool inside() const noexcept { return m_Skip > 0 || m_Depth > 0; }
+
+        // The slot the next value goes to, past any optionals around it.
+        // A null disengages an optional and leaves nothing to fill in
+        Slot take(bool null) {
+            Slot slot;
+            if (!m_Stack.empty() && m_Stack.back().slot.reader->shape == Shape::array) {
+                Frame& f = m_Stack.back();
+                slot = f.slot.reader->element(f.slot.obj, f.index++);
+            } else {
+                slot = std::exchange(m_Next, Slot{});
+            }
+            while (slot.reader && slot.reader->shape == Shape::optional) {
+                if (null) {
+                    slot.reader->disengage(slot.obj);
+                    return {};
+                }
+                slot = slot.reader->engage(slot.obj);
+            }
+            return slot;
+        }
+
+        // Passes an event to the skipped or captured value; `nesting` is
+        // +1 for a start event, -1 for an end event and 0 otherwise
+        template<typename Event>
+        bool forward(Event&& ev, int nesting) {
+            if (m_Skip > 0) {
+                m_Skip = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(m_Skip) + nesting);
+                return true;
+            }
+            if (!ev(*m_Dom)) return false;
+            m_Depth = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(m_Depth) + nesting);
+            return m_Depth > 0 || adopt();
+        }
+
+        bool scalar(const Scalar& s) {
+            if (inside()) {
+                return forward([&](SaxHandler& h) {
+                    switch (s.type) {
+                    case kind::boolean: return h.on_bool(s.b);
+                    case kind::number: return h.on_number(s.d);
+                    case kind::string: return h.on_string(s.s);
+                    default: return h.on_null();
+                    }
+                }, 0);
+            }
+
+            Slot slot = take(s.type == kind::null);
+            if (!slot.reader) return true;
+            if (slot.reader->shape == Shape::dom) {
+                value v{ nullptr };
+                if (s.type == kind::boolean) v = s.b;
+                else if (s.type == kind::number) v = s.d;
+                else if (s.type == kind::string) v = value{ s.s };
+                return slot.reader->adopt(slot.obj, std::move(v), m_Failure) || located();
+            }
+            if (slot.reader->shape != Shape::scalar) return reject(slot);
+            return slot.reader->scalar(slot.obj, s, m_Failure) || located();
+        }
+
+        bool skip() {
+            m_Skip = 1;
+            return true;
+        }
+
+        template<typename Event>
+        bool capture(Slot slot, Event&& ev) {
+            if (!m_Dom) m_Dom = std::make_unique<DomBuilder>();
+            m_Dom->reset();
+            m_Captured = slot;
+            m_Depth = 1;
+            return ev(*m_Dom);
+        }
+
+        bool adopt() {
+            return m_Captured.reader->adopt(m_Captured.obj, std::move(m_Dom->result()), m_Failure) || located();
+        }
+
+        bool reject(Slot slot) {
+            mismatch(m_Failure, slot.reader->expects);
+            m_Failure.path = path();
+            return false;
+        }
+
+        // Prefixes the path of the value a reader failed in
+        bool located() {
+            m_Failure.path.insert(0, path());
+            if (m_Failure.msg.empty()) fail(m_Failure, ConvertError::code::invalid_value, "invalid value");
+            return false;
+        }
+
+        [[nodiscard]] std::string path() const {
+            std::string p;
+            for (const auto& f : m_Stack) {
+                switch (f.slot.reader->shape) {
+                case Shape::array:
+                    if (f.index > 0) Sonnet::detail::append_token(p, std::to_string(f.index - 1));
+                    break;
+                case Shape::map:
+                    if (f.field != npos) Sonnet::detail::append_token(p, f.key);
+                    break;
+                default:
+                    if (f.field != npos) Sonnet::detail::append_token(p, f.slot.reader->names[f.field]);
+                    break;
+                }
+            }
+            return p;
+        }
+
+        Slot m_Next;
+        std::vector<Frame> m_Stack;
+        std::vector<bool> m_Seen;
+        std::size_t m_Skip = 0;
+        std::size_t m_Depth = 0;
+        Slot m_Captured;
+        std::unique_ptr<DomBuilder> m_Dom;
+        ConvertError m_Failure;
+    };
+
+    std::expected<void, ParseError> parse_into(std::string_view json, Slot root, const ParseOptions& opts) {
+        Filler filler{ root };
+        auto r = parse_sax(json, filler, opts);
+        if (!r) {
+            if (auto msg = filler.error()) r.error().msg = std::move(*msg);
+        }
+        return r;
+    }
+
+} // namespace Sonnet::describe::detail
@@ -0,0 +1,218 @@
+#include "sonnet/diff.hpp"
+#include "sonnet/hash.hpp"
+
+#include <algorithm>
+#include <span>
+#include <string_view>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        enum class edit : std::uint8_t { keep, del, ins };
+
+        // Myers' greedy shortest edit script between @p a and @p b. Only
+        // the diagonals reached at each step are kept for the backtrack,
+        // so memory is O(D^2). Returns false if more than @p limit edits
+        // are needed
+        bool myers(std::span<const std::uint64_t> a, std::span<const std::uint64_t> b, std::size_t limit, std::vector<edit>& script) {
+            const auto n = static_cast<std::ptrdiff_t>(a.size());
+            const auto m = static_cast<std::ptrdiff_t>(b.size());
+            const auto max = std::min(static_cast<std::ptrdiff_t>(limit), n + m);
+            const std::ptrdiff_t off = max + 1;
+
+            std::vector<std::ptrdiff_t> v(static_cast<size_t>(2 * max + 3), 0);
+            std::vector<std::vector<std::ptrdiff_t>> trace;
+            auto at = [&](std::ptrdiff_t k) -> std::ptrdiff_t& { return v[static_cast<size_t>(k + off)]; };
+
+            for (std::ptrdiff_t d = 0; d <= max; d++) {
+                trace.emplace_back(v.begin() + (off - d), v.begin() + (off + d + 1));
+                for (std::ptrdiff_t k = -d; k <= d; k += 2) {
+                    std::ptrdiff_t x = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? at(k + 1) : at(k - 1) + 1;
+                    std::ptrdiff_t y = x - k;
+                    while (x < n && y < m && a[static_cast<size_t>(x)] == b[static_cast<size_t>(y)]) x++, y++;
+                    at(k) = x;
+                    if (x < n || y < m) continue;
+
+                    // Walk back through the stored diagonals
+                    script.clear();
+                    for (std::ptrdiff_t e = d; e > 0; e--) {
+                        const auto& prev = trace[static_cast<size_t>(e)];
+                        auto pv = [&](std::ptrdiff_t kk) { return prev[static_cast<size_t>(kk + e)]; };
+                        std::ptrdiff_t kk = x - y;
+                        std::ptrdiff_t pk = (kk == -e || (kk != e && pv(kk - 1) < pv(kk + 1))) ? kk + 1 : kk - 1;
+                        std::ptrdiff_t px = pv(pk);
+                        std::ptrdiff_t py = px - pk;
+                        for (; x > px && y > py; x--, y--) script.push_back(edit::keep);
+                        script.push_back(x == px ? edit::ins : edit::del);
+                        x = px;
+                        y = py;
+                    }
+                    for (; x > 0; x--) script.push_back(edit::keep);
+                    std::ranges::reverse(script);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        class Differ {
+        public:
+            Differ(const DiffOptions& opts, std::vector<Change>& out) : m_Opts{ opts }, m_Out{ out } {}
+
+            void node(const value& a, const value& b) {
+                if (&a == &b) return;
+                if (a.type() != b.type()) return emit(change_kind::replace, &b);
+
+                switch (a.type()) {
+                case kind::null: return;
+                case kind::boolean:
+                    if (a.as_bool() != b.as_bool()) emit(change_kind::replace, &b);
+                    return;
+                case kind::number:
+                    if (a.as_number() != b.as_number()) emit(change_kind::replace, &b);
+                    return;
+                case kind::string:
+                    if (std::string_view{ a.as_string() } != std::string_view{ b.as_string() }) emit(change_kind::replace, &b);
+                    return;
+                case kind::array:
+                case kind::object:
+                    break;
+                }
+
+                if (m_Hashes.hash(a) == m_Hashes.hash(b)) return;
+                if (a.is_object()) return merge(a.as_object(), b.as_object());
+                if (a.is_packed() || b.is_packed()) return emit(change_kind::replace, &b);
+                align(a.as_array(), b.as_array());
+            }
+
+        private:
+            void emit(change_kind k, const value* v) {
+                m_Out.push_back({ k, m_Path, v });
+            }
+
+            size_t push(std::string_view key) {
+                size_t mark = m_Path.size();
+                m_Path.push_back('/');
+                for (char c : key) {
+                    if (c == '~') m_Path += "~0";
+                    else if (c == '/') m_Path += "~1";
+                    else m_Path.push_back(c);
+                }
+                return mark;
+            }
+
+            size_t push(size_t index) {
+                size_t mark = m_Path.size();
+                m_Path.push_back('/');
+                m_Path += std::to_string(index);
+                return mark;
+            }
+
+            void pop(size_t mark) { m_Path.resize(mark); }
+
+            void merge(const object& a, const object& b) {
+                auto ia = a.begin();
+                auto ib = b.begin();
+                while (ia != a.end() || ib != b.end()) {
+                    int c = ia == a.end() ? 1 : ib == b.end() ? -1 : std::string_view{ ia->first }.compare(std::string_view{ ib->first });
+                    size_t mark = push(c > 0 ? std::string_view{ ib->first } : std::string_view{ ia->first });
+                    if (c < 0) emit(change_kind::remove, nullptr);
+                    else if (c > 0) emit(change_kind::add, &ib->second);
+                    else node(ia->second, ib->second);
+                    pop(mark);
+                    if (c <= 0) ++ia;
+                    if (c >= 0) ++ib;
+                }
+            }
+
+            // Compares a[i] to b[j] at index @p at of the array being patched
+            void element(const value& a, const value& b, size_t at) {
+                size_t mark = push(at);
+                node(a, b);
+                pop(mark);
+            }
+
+            void insert(const value& b, size_t at) {
+                size_t mark = push(at);
+                emit(change_kind::add, &b);
+                pop(mark);
+            }
+
+            void erase(size_t at) {
+                size_t mark = push(at);
+                emit(change_kind::remove, nullptr);
+                pop(mark);
+            }
+
+            void align(const array& a, const array& b) {
+                std::vector<std::uint64_t> ha, hb;
+                ha.reserve(a.size());
+                hb.reserve(b.size());
+                for (const auto& e : a) ha.push_back(m_Hashes.hash(e));
+                for (const auto& e : b) hb.push_back(m_Hashes.hash(e));
+
+                size_t pre = 0;
+                while (pre < a.size() && pre < b.size() && ha[pre] == hb[pre]) pre++;
+                size_t suf = 0;
+                while (suf < a.size() - pre && suf < b.size() - pre && ha[a.size() - 1 - suf] == hb[b.size() - 1 - suf]) suf++;
+
+                const size_t n = a.size() - pre - suf;
+                const size_t m = b.size() - pre - suf;
+                std::vector<edit> script;
+                if (!myers(std::span{ ha }.subspan(pre, n), std::span{ hb }.subspan(pre, m), m_Opts.array_edit_limit, script)) {
+                    // Too far apart to align: compare position by position
+                    size_t common = std::min(n, m);
+                    for (size_t i = 0; i < common; i++) element(a[pre + i], b[pre + i], pre + i);
+                    for (size_t i = common; i < n; i++) erase(pre + common);
+                    for (size_t i = common; i < m; i++) insert(b[pre + i], pre + i);
+                    return;
+                }
+
+                // Runs of deletions and insertions between kept elements
+                // replace a[i, i + dels) by b[j, j + ins) at position `at`
+                size_t i = pre, j = pre, at = pre;
+                for (size_t s = 0; s < script.size();) {
+                    if (script[s] == edit::keep) {
+                        i++, j++, at++, s++;
+                        continue;
+                    }
+                    size_t dels = 0, ins = 0;
+                    for (; s < script.size() && script[s] != edit::keep; s++) (script[s] == edit::del ? dels : ins)++;
+
+                    size_t paired = std::min(dels, ins);
+                    for (size_t p = 0; p < paired; p++) element(a[i + p], b[j + p], at++);
+                    for (size_t p = paired; p < dels; p++) erase(at);
+                    for (size_t p = paired; p < ins; p++) insert(b[j + p], at++);
+                    i += dels;
+                    j += ins;
+                }
+            }
+
+            const DiffOptions& m_Opts;
+            std::vector<Change>& m_Out;
+            hash_cache m_Hashes;
+            std::string m_Path;
+        };
+    } // namespace detail
+
+    std::vector<Change> diff_changes(const value& a, const value& b, const DiffOptions& opts) {
+        std::vector<Change> out;
+        detail::Differ{ opts, out }.node(a, b);
+        return out;
+    }
+
+    value diff(const value& a, const value& b, const DiffOptions& opts) {
+        value patch{ array{} };
+        auto& ops = patch.as_array();
+        for (const auto& c : diff_changes(a, b, opts)) {
+            value op{ object{} };
+            op["op"] = value{ c.kind == change_kind::add ? "add" : c.kind == change_kind::remove ? "remove" : "replace" };
+            op["path"] = value{ std::string_view{ c.path } };
+            if (c.target) op["value"] = *c.target;
+            ops.push_back(std::move(op));
+        }
+        return patch;
+    }
+
+} // namespace Sonnet
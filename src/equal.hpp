@@ -0,0 +1,51 @@
+#pragma once
+
+// Internal structural equality shared by JSONPath filters and JSON Patch tests
+
+#include <algorithm>
+#include <string_view>
+
+#include "sonnet/value.hpp"
+
+
+namespace Sonnet::detail {
+
+    inline bool json_equal(const value& a, const value& b);
+
+    // Equality of two arrays where either side may be packed
+    inline bool array_equal(const value& a, const value& b) {
+        if (a.size() != b.size()) return false;
+        if (b.is_packed()) return a.is_packed() ? std::ranges::equal(a.numbers(), b.numbers()) : array_equal(b, a);
+
+        const auto& rhs = b.as_array();
+        if (a.is_packed()) {
+            auto lhs = a.numbers();
+            for (size_t i = 0; i < lhs.size(); i++)
+                if (!rhs[i].is_number() || rhs[i].as_number() != lhs[i]) return false;
+            return true;
+        }
+        return std::ranges::equal(a.as_array(), rhs, [](const value& l, const value& r) { return json_equal(l, r); });
+    }
+
+    // Unlike `value::operator==` this does not care which memory resource
+    // either side lives in
+    inline bool json_equal(const value& a, const value& b) {
+        if (a.type() != b.type()) return false;
+        switch (a.type()) {
+        case kind::null: return true;
+        case kind::boolean: return a.as_bool() == b.as_bool();
+        case kind::number: return a.as_number() == b.as_number();
+        case kind::string: return std::string_view{ a.as_string() } == std::string_view{ b.as_string() };
+        case kind::array: return array_equal(a, b);
+        case kind::object: {
+            const auto& x = a.as_object();
+            const auto& y = b.as_object();
+            return x.size() == y.size() && std::ranges::equal(x, y, [](const auto& l, const auto& r) {
+                return std::string_view{ l.first } == std::string_view{ r.first } && json_equal(l.second, r.second);
+            });
+        }
+        }
+        return false;
+    }
+
+} // namespace Sonnet::detail
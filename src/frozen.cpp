@@ -0,0 +1,404 @@
+#include "sonnet/frozen.hpp"
+#include "binary.hpp"
+#include "utf8.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#if SONNET_PLATFORM_WINDOWS
+#define SONNET_HAS_MMAP 0
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SONNET_HAS_MMAP 1
+#endif
+
+
+namespace Sonnet {
+
+    namespace detail {
+        enum class frozen_kind : std::uint8_t { null, false_, true_, number, string, array, object };
+
+        constexpr char frozen_magic[4] = { 'S', 'N', 'F', 'Z' };
+        constexpr std::uint32_t frozen_version = 1;
+        constexpr std::size_t frozen_header_size = 16;
+        constexpr std::size_t frozen_max_depth = 1024;
+
+        const std::byte frozen_null_node[1] = { std::byte{ 0 } };
+
+        template<typename T>
+        [[nodiscard]] inline T load_le(const std::byte* p) noexcept {
+            T v{};
+            std::memcpy(&v, p, sizeof(T));
+            if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) v = std::byteswap(v);
+            return v;
+        }
+
+        template<typename T>
+        inline void store_le(std::byte* p, T v) noexcept {
+            if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) v = std::byteswap(v);
+            std::memcpy(p, &v, sizeof(T));
+        }
+
+        inline frozen_kind kind_of(const std::byte* node) noexcept { return static_cast<frozen_kind>(*node); }
+        inline std::uint32_t count_of(const std::byte* node) noexcept { return load_le<std::uint32_t>(node + 1); }
+
+        // Follows the self-relative offset stored at @p slot
+        inline const std::byte* follow(const std::byte* slot) noexcept { return slot + load_le<std::uint32_t>(slot); }
+
+        inline std::string_view string_of(const std::byte* node) noexcept {
+            return { reinterpret_cast<const char*>(node + 5), count_of(node) };
+        }
+
+        struct FrozenWriter {
+            std::vector<std::byte>& out;
+
+            size_t reserve(size_t n) {
+                size_t at = out.size();
+                out.resize(at + n);
+                return at;
+            }
+
+            // Points the offset field at @p slot to the end of the buffer,
+            // where the next node is about to be written
+            void link(size_t slot) {
+                size_t rel = out.size() - slot;
+                if (rel > std::numeric_limits<std::uint32_t>::max()) throw std::length_error{ "Sonnet::freeze: document exceeds 4 GiB" };
+                store_le(out.data() + slot, static_cast<std::uint32_t>(rel));
+            }
+
+            void head(frozen_kind k, std::uint32_t n) {
+                size_t at = reserve(5);
+                out[at] = static_cast<std::byte>(k);
+                store_le(out.data() + at + 1, n);
+            }
+
+            std::uint32_t count(size_t n) {
+                if (n > std::numeric_limits<std::uint32_t>::max()) throw std::length_error{ "Sonnet::freeze: container or string too large" };
+                return static_cast<std::uint32_t>(n);
+            }
+
+            void text(std::string_view s) {
+                head(frozen_kind::string, count(s.size()));
+                const auto* b = reinterpret_cast<const std::byte*>(s.data());
+                out.insert(out.end(), b, b + s.size());
+            }
+
+            void number(double d) {
+                size_t at = reserve(9);
+                out[at] = static_cast<std::byte>(frozen_kind::number);
+                store_le(out.data() + at + 1, std::bit_cast<std::uint64_t>(d));
+            }
+
+            void write(const value& v) {
+                switch (v.type()) {
+                case kind::null: out.push_back(static_cast<std::byte>(frozen_kind::null)); return;
+                case kind::boolean: out.push_back(static_cast<std::byte>(v.as_bool() ? frozen_kind::true_ : frozen_kind::false_)); return;
+                case kind::number: number(v.as_number()); return;
+                case kind::string: text(v.as_string()); return;
+                case kind::array: {
+                    size_t n = v.size();
+                    head(frozen_kind::array, count(n));
+                    size_t table = reserve(n * 4);
+                    for (size_t i = 0; i < n; i++) {
+                        link(table + i * 4);
+                        if (v.is_packed()) number(v.numbers()[i]);
+                        else write(v.as_array()[i]);
+                    }
+                    return;
+                }
+                case kind::object: {
+                    // pmr::map already orders keys bytewise, which is the
+                    // order lookups binary-search in
+                    const auto& obj = v.as_object();
+                    head(frozen_kind::object, count(obj.size()));
+                    size_t table = reserve(obj.size() * 8);
+                    for (const auto& [k, e] : obj) {
+                        link(table);
+                        text(k);
+                        link(table + 4);
+                        write(e);
+                        table += 8;
+                    }
+                    return;
+                }
+                }
+            }
+        };
+
+        struct FrozenVerifier {
+            const std::byte* begin;
+            const std::byte* end;
+
+            std::unexpected<ParseError> fail(ParseError::code c, const std::byte* at, std::string_view msg) const {
+                return std::unexpected(binary_error(c, static_cast<size_t>(at - begin), msg));
+            }
+
+            bool has(const std::byte* p, std::uint64_t n) const noexcept { return n <= static_cast<std::uint64_t>(end - p); }
+
+            // Checks the node at @p node and returns the position right after
+            // its subtree; children must start exactly where the previous one
+            // ended, which also makes the walk linear
+            std::expected<const std::byte*, ParseError> node(const std::byte* node, size_t depth, std::string_view* as_key = nullptr) {
+                if (!has(node, 1)) return fail(ParseError::code::unexpected_end_of_input, node, "Truncated frozen node");
+                auto k = kind_of(node);
+                if (as_key && k != frozen_kind::string) return fail(ParseError::code::unsupported_type, node, "Frozen object key is not a string");
+
+                switch (k) {
+                case frozen_kind::null:
+                case frozen_kind::false_:
+                case frozen_kind::true_: return node + 1;
+                case frozen_kind::number:
+                    if (!has(node, 9)) return fail(ParseError::code::unexpected_end_of_input, node, "Truncated frozen number");
+                    return node + 9;
+                case frozen_kind::string: {
+                    if (!has(node, 5) || !has(node + 5, count_of(node))) return fail(ParseError::code::unexpected_end_of_input, node, "Truncated frozen string");
+                    std::string_view s = string_of(node);
+                    size_t bad = 0;
+                    if (!is_valid_utf8(s, bad)) return fail(ParseError::code::invalid_string, node + 5 + bad, "Invalid UTF-8 in frozen string");
+                    if (as_key) *as_key = s;
+                    return node + 5 + s.size();
+                }
+                case frozen_kind::array:
+                case frozen_kind::object: {
+                    if (depth >= frozen_max_depth) return fail(ParseError::code::depth_limit_exceeded, node, "Maximum nesting depth exceeded");
+                    if (!has(node, 5)) return fail(ParseError::code::unexpected_end_of_input, node, "Truncated frozen container");
+                    bool is_object = k == frozen_kind::object;
+                    std::uint64_t slots = std::uint64_t{ count_of(node) } * (is_object ? 2 : 1);
+                    if (!has(node + 5, slots * 4)) return fail(ParseError::code::unexpected_end_of_input, node, "Truncated frozen offset table");
+
+                    const std::byte* cursor = node + 5 + slots * 4;
+                    std::string_view prev;
+                    for (std::uint64_t i = 0; i < slots; i++) {
+                        const std::byte* slot = node + 5 + i * 4;
+                        if (follow(slot) != cursor) return fail(ParseError::code::unexpected_character, slot, "Frozen offset does not follow the canonical layout");
+                        bool is_key = is_object && i % 2 == 0;
+                        std::string_view key;
+                        auto next = this->node(cursor, depth + 1, is_key ? &key : nullptr);
+                        if (!next) return next;
+                        if (is_key) {
+                            if (i > 0 && !(prev < key)) return fail(ParseError::code::unexpected_character, cursor, "Frozen object keys are not strictly increasing");
+                            prev = key;
+                        }
+                        cursor = *next;
+                    }
+                    return cursor;
+                }
+                }
+                return fail(ParseError::code::unexpected_character, node, "Unknown frozen node kind");
+            }
+        };
+
+        std::expected<std::uint64_t, ParseError> check_frozen_header(std::span<const std::byte> bytes) {
+            if (bytes.size() < frozen_header_size) return std::unexpected(binary_error(ParseError::code::unexpected_end_of_input, bytes.size(), "Frozen document header is truncated"));
+            if (std::memcmp(bytes.data(), frozen_magic, 4) != 0) return std::unexpected(binary_error(ParseError::code::unexpected_character, 0, "Not a frozen document"));
+            if (load_le<std::uint32_t>(bytes.data() + 4) != frozen_version) return std::unexpected(binary_error(ParseError::code::unsupported_type, 4, "Unsupported frozen document version"));
+            std::uint64_t size = load_le<std::uint64_t>(bytes.data() + 8);
+            if (size > bytes.size() || size <= frozen_header_size) return std::unexpected(binary_error(ParseError::code::unexpected_end_of_input, bytes.size(), "Frozen document is truncated"));
+            return size;
+        }
+
+        value thaw(const std::byte* node, std::pmr::memory_resource* res) {
+            switch (kind_of(node)) {
+            case frozen_kind::null: return value{ nullptr, res };
+            case frozen_kind::false_: return value{ false, res };
+            case frozen_kind::true_: return value{ true, res };
+            case frozen_kind::number: return value{ std::bit_cast<double>(load_le<std::uint64_t>(node + 1)), res };
+            case frozen_kind::string: return value{ string_of(node), res };
+            case frozen_kind::array: {
+                std::uint32_t n = count_of(node);
+                array arr{ allocator_type{ res } };
+                arr.reserve(n);
+                for (std::uint32_t i = 0; i < n; i++) arr.push_back(thaw(follow(node + 5 + i * 4), res));
+                return value{ std::move(arr), res };
+            }
+            case frozen_kind::object: {
+                std::uint32_t n = count_of(node);
+                object obj{ std::less<>{}, res };
+                for (std::uint32_t i = 0; i < n; i++) {
+                    const std::byte* slot = node + 5 + i * 8;
+                    std::string_view k = string_of(follow(slot));
+                    obj.emplace_hint(obj.end(), string{ k.begin(), k.end(), res }, thaw(follow(slot + 4), res));
+                }
+                return value{ std::move(obj), res };
+            }
+            }
+            return value{ res };
+        }
+    } // namespace detail
+
+    frozen_view::frozen_view() noexcept : m_Node{ detail::frozen_null_node } {}
+
+    kind frozen_view::type() const noexcept {
+        switch (detail::kind_of(m_Node)) {
+        case detail::frozen_kind::null: return kind::null;
+        case detail::frozen_kind::false_:
+        case detail::frozen_kind::true_: return kind::boolean;
+        case detail::frozen_kind::number: return kind::number;
+        case detail::frozen_kind::string: return kind::string;
+        case detail::frozen_kind::array: return kind::array;
+        case detail::frozen_kind::object: return kind::object;
+        }
+        return kind::null;
+    }
+
+    bool frozen_view::as_bool() const {
+        if (!is_bool()) throw std::invalid_argument{ "Sonnet::frozen_view::as_bool: not a boolean" };
+        return detail::kind_of(m_Node) == detail::frozen_kind::true_;
+    }
+
+    double frozen_view::as_number() const {
+        if (!is_number()) throw std::invalid_argument{ "Sonnet::frozen_view::as_number: not a number" };
+        return std::bit_cast<double>(detail::load_le<std::uint64_t>(m_Node + 1));
+    }
+
+    std::string_view frozen_view::as_string() const {
+        if (!is_string()) throw std::invalid_argument{ "Sonnet::frozen_view::as_string: not a string" };
+        return detail::string_of(m_Node);
+    }
+
+    size_t frozen_view::size() const noexcept {
+        if (!is_array() && !is_object()) return 0;
+        return detail::count_of(m_Node);
+    }
+
+    frozen_view frozen_view::operator[](size_t idx) const noexcept {
+        if (!is_array() || idx >= size()) return frozen_view{};
+        return frozen_view{ detail::follow(m_Node + 5 + idx * 4) };
+    }
+
+    std::optional<frozen_view> frozen_view::find(std::string_view key) const noexcept {
+        if (!is_object()) return std::nullopt;
+        size_t lo = 0;
+        size_t hi = size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            const std::byte* slot = m_Node + 5 + mid * 8;
+            int c = detail::string_of(detail::follow(slot)).compare(key);
+            if (c == 0) return frozen_view{ detail::follow(slot + 4) };
+            if (c < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return std::nullopt;
+    }
+
+    frozen_view frozen_view::at(std::string_view key) const {
+        if (auto v = find(key)) return *v;
+        throw std::out_of_range{ "Sonnet::frozen_view::at: key not found" };
+    }
+
+    std::string_view frozen_view::key(size_t idx) const {
+        if (!is_object() || idx >= size()) throw std::out_of_range{ "Sonnet::frozen_view::key: member index out of range" };
+        return detail::string_of(detail::follow(m_Node + 5 + idx * 8));
+    }
+
+    frozen_view frozen_view::member(size_t idx) const {
+        if (!is_object() || idx >= size()) throw std::out_of_range{ "Sonnet::frozen_view::member: member index out of range" };
+        return frozen_view{ detail::follow(m_Node + 5 + idx * 8 + 4) };
+    }
+
+    value frozen_view::to_value(std::pmr::memory_resource* res) const {
+        return detail::thaw(m_Node, res);
+    }
+
+    std::vector<std::byte> freeze(const value& v) {
+        std::vector<std::byte> out(detail::frozen_header_size);
+        std::memcpy(out.data(), detail::frozen_magic, 4);
+        detail::store_le(out.data() + 4, detail::frozen_version);
+
+        detail::FrozenWriter w{ out };
+        w.write(v);
+        detail::store_le(out.data() + 8, static_cast<std::uint64_t>(out.size()));
+        return out;
+    }
+
+    void freeze(const value& v, std::ostream& os) {
+        auto bytes = freeze(v);
+        os.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    std::expected<frozen_view, ParseError> open_frozen(std::span<const std::byte> bytes) {
+        if (auto h = detail::check_frozen_header(bytes); !h) return std::unexpected(std::move(h.error()));
+        return frozen_view{ bytes.data() + detail::frozen_header_size };
+    }
+
+    std::expected<void, ParseError> verify_frozen(std::span<const std::byte> bytes) {
+        auto size = detail::check_frozen_header(bytes);
+        if (!size) return std::unexpected(std::move(size.error()));
+
+        detail::FrozenVerifier check{ bytes.data(), bytes.data() + *size };
+        auto end = check.node(bytes.data() + detail::frozen_header_size, 0);
+        if (!end) return std::unexpected(std::move(end.error()));
+        if (*end != check.end) return check.fail(ParseError::code::trailing_characters, *end, "Trailing bytes after frozen root");
+        return {};
+    }
+
+    std::expected<MappedFile, std::error_code> MappedFile::open(const std::filesystem::path& path) {
+        MappedFile f;
+#if SONNET_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return std::unexpected(std::error_code{ errno, std::system_category() });
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            std::error_code ec{ errno, std::system_category() };
+            ::close(fd);
+            return std::unexpected(ec);
+        }
+
+        f.m_Size = static_cast<size_t>(st.st_size);
+        if (f.m_Size > 0) {
+            void* p = ::mmap(nullptr, f.m_Size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                std::error_code ec{ errno, std::system_category() };
+                ::close(fd);
+                return std::unexpected(ec);
+            }
+            f.m_Data = static_cast<const std::byte*>(p);
+        }
+        ::close(fd);
+#else
+        std::ifstream in{ path, std::ios::binary };
+        if (!in) return std::unexpected(std::make_error_code(std::errc::no_such_file_or_directory));
+        std::error_code ec;
+        auto n = std::filesystem::file_size(path, ec);
+        if (ec) return std::unexpected(ec);
+        f.m_Fallback.resize(static_cast<size_t>(n));
+        in.read(reinterpret_cast<char*>(f.m_Fallback.data()), static_cast<std::streamsize>(n));
+        if (!in) return std::unexpected(std::make_error_code(std::errc::io_error));
+        f.m_Data = f.m_Fallback.data();
+        f.m_Size = f.m_Fallback.size();
+#endif
+        return f;
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : m_Data{ std::exchange(other.m_Data, nullptr) }, m_Size{ std::exchange(other.m_Size, 0) }, m_Fallback{ std::move(other.m_Fallback) } {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this == &other) return *this;
+        release();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+        m_Fallback = std::move(other.m_Fallback);
+        return *this;
+    }
+
+    MappedFile::~MappedFile() { release(); }
+
+    void MappedFile::release() noexcept {
+#if SONNET_HAS_MMAP
+        if (m_Data) ::munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Fallback.clear();
+    }
+
+} // namespace Sonnet
@@ -0,0 +1,135 @@
+#include "sonnet/hash.hpp"
+#include "structural_hash.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+
+namespace Sonnet {
+
+    namespace {
+        constexpr std::uint32_t k_Rounds[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+        };
+
+        constexpr std::uint32_t rotr(std::uint32_t x, int n) noexcept { return (x >> n) | (x << (32 - n)); }
+    } // namespace
+
+    Sha256::Sha256() noexcept { reset(); }
+
+    void Sha256::reset() noexcept {
+        m_State = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        m_BlockLen = 0;
+        m_Length = 0;
+    }
+
+    void Sha256::compress(const std::uint8_t* block) noexcept {
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (static_cast<std::uint32_t>(block[i * 4]) << 24) | (static_cast<std::uint32_t>(block[i * 4 + 1]) << 16)
+                 | (static_cast<std::uint32_t>(block[i * 4 + 2]) << 8) | static_cast<std::uint32_t>(block[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; i++) {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        std::uint32_t a = m_State[0], b = m_State[1], c = m_State[2], d = m_State[3];
+        std::uint32_t e = m_State[4], f = m_State[5], g = m_State[6], h = m_State[7];
+        for (int i = 0; i < 64; i++) {
+            std::uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            std::uint32_t ch = (e & f) ^ (~e & g);
+            std::uint32_t t1 = h + s1 + ch + k_Rounds[i] + w[i];
+            std::uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            std::uint32_t t2 = s0 + maj;
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        m_State[0] += a; m_State[1] += b; m_State[2] += c; m_State[3] += d;
+        m_State[4] += e; m_State[5] += f; m_State[6] += g; m_State[7] += h;
+    }
+
+    void Sha256::update(const void* data, std::size_t n) noexcept {
+        const auto* p = static_cast<const std::uint8_t*>(data);
+        m_Length += n;
+
+        if (m_BlockLen > 0) {
+            std::size_t take = std::min(n, m_Block.size() - m_BlockLen);
+            std::memcpy(m_Block.data() + m_BlockLen, p, take);
+            m_BlockLen += take;
+            p += take;
+            n -= take;
+            if (m_BlockLen < m_Block.size()) return;
+            compress(m_Block.data());
+            m_BlockLen = 0;
+        }
+
+        while (n >= m_Block.size()) {
+            compress(p);
+            p += m_Block.size();
+            n -= m_Block.size();
+        }
+
+        std::memcpy(m_Block.data(), p, n);
+        m_BlockLen = n;
+    }
+
+    Sha256::digest Sha256::finish() noexcept {
+        std::uint64_t bits = m_Length * 8;
+
+        m_Block[m_BlockLen++] = 0x80;
+        if (m_BlockLen > 56) {
+            std::memset(m_Block.data() + m_BlockLen, 0, m_Block.size() - m_BlockLen);
+            compress(m_Block.data());
+            m_BlockLen = 0;
+        }
+        std::memset(m_Block.data() + m_BlockLen, 0, 56 - m_BlockLen);
+        for (int i = 0; i < 8; i++) m_Block[static_cast<std::size_t>(56 + i)] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+        compress(m_Block.data());
+
+        digest d{};
+        for (std::size_t i = 0; i < 8; i++) {
+            d[i * 4]     = static_cast<std::uint8_t>(m_State[i] >> 24);
+            d[i * 4 + 1] = static_cast<std::uint8_t>(m_State[i] >> 16);
+            d[i * 4 + 2] = static_cast<std::uint8_t>(m_State[i] >> 8);
+            d[i * 4 + 3] = static_cast<std::uint8_t>(m_State[i]);
+        }
+        reset();
+        return d;
+    }
+
+    std::string to_hex(const Sha256::digest& d) {
+        static constexpr char hex[] = "0123456789abcdef";
+        std::string out;
+        out.reserve(d.size() * 2);
+        for (std::uint8_t b : d) {
+            out.push_back(hex[b >> 4]);
+            out.push_back(hex[b & 0xF]);
+        }
+        return out;
+    }
+
+    std::uint64_t hash(const value& v) noexcept {
+        return detail::structural_hash(v, [](const value& e) { return hash(e); });
+    }
+
+    std::uint64_t hash_cache::hash(const value& v) {
+        auto child = [this](const value& e) { return hash(e); };
+        if (!v.is_array() && !v.is_object()) return detail::structural_hash(v, child);
+
+        if (auto it = m_Hashes.find(&v); it != m_Hashes.end()) return it->second;
+        std::uint64_t h = detail::structural_hash(v, child);
+        m_Hashes.emplace(&v, h);
+        return h;
+    }
+
+} // namespace Sonnet
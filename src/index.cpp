@@ -0,0 +1,127 @@
+#include "sonnet/index.hpp"
+#include "sonnet/hash.hpp"
+#include "structural_hash.hpp"
+#include "equal.hpp"
+
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+
+namespace Sonnet {
+
+    // A packed array's elements are the nodes its const access built;
+    // they are gone once mutable access dropped them
+    const value* array_index::elements_of(const value& arr) noexcept {
+        const value& t = arr.target();
+        if (auto* packed = std::get_if<packed_array>(&t.m_Storage)) {
+            const array* nodes = packed->built_elements();
+            return nodes ? nodes->data() : nullptr;
+        }
+        if (auto* elems = std::get_if<array>(&t.m_Storage)) return elems->data();
+        return nullptr;
+    }
+
+    bool array_index::valid() const noexcept {
+        return m_Array && elements_of(*m_Array) == m_Data && m_Array->size() == m_Count;
+    }
+
+    void array_index::rebuild() {
+        if (!m_Array) return;
+        *this = index_by(*m_Array, std::move(m_Key));
+    }
+
+    template<typename Match>
+    std::span<const value* const> array_index::lookup(std::uint64_t hash, Match&& match) const {
+        if (!valid()) throw std::logic_error{ "Sonnet::array_index: the array changed since the index was built" };
+        if (m_Slots.empty()) return {};
+
+        const std::size_t mask = m_Slots.size() - 1;
+        for (std::size_t s = static_cast<std::size_t>(hash) & mask;; s = (s + 1) & mask) {
+            std::uint32_t g = m_Slots[s];
+            if (g == 0) return {};
+            const Group& group = m_Groups[g - 1];
+            if (group.hash == hash && match(group.key)) return { m_Elements.data() + group.offset, group.count };
+        }
+    }
+
+    std::span<const value* const> array_index::find_all(const value& key) const {
+        return lookup(hash(key), [&](const value& k) { return detail::json_equal(k, key); });
+    }
+
+    std::span<const value* const> array_index::find_all(std::string_view key) const {
+        return lookup(detail::hash_bytes(key), [&](const value& k) { return k.is_string() && std::string_view{ k.as_string() } == key; });
+    }
+
+    std::span<const value* const> array_index::find_all(double key) const {
+        return lookup(detail::hash_number(key), [&](const value& k) { return k.is_number() && k.as_number() == key; });
+    }
+
+    const value* array_index::find(const value& key) const {
+        auto all = find_all(key);
+        return all.empty() ? nullptr : all.front();
+    }
+
+    const value* array_index::find(std::string_view key) const {
+        auto all = find_all(key);
+        return all.empty() ? nullptr : all.front();
+    }
+
+    const value* array_index::find(double key) const {
+        auto all = find_all(key);
+        return all.empty() ? nullptr : all.front();
+    }
+
+    array_index index_by(const value& arr, pointer key) {
+        if (!arr.is_array()) throw std::invalid_argument{ "Sonnet::index_by: value is not an array" };
+
+        array_index idx;
+        idx.m_Array = &arr;
+        idx.m_Key = std::move(key);
+
+        const auto& elems = arr.as_array();
+        idx.m_Data = array_index::elements_of(arr);
+        idx.m_Count = elems.size();
+        if (elems.size() > std::numeric_limits<std::uint32_t>::max()) throw std::length_error{ "Sonnet::index_by: array too large" };
+
+        // At most half the slots are used, so probe sequences stay short
+        idx.m_Slots.assign(std::bit_ceil(std::max<std::size_t>(elems.size() * 2, 8)), 0);
+        const std::size_t mask = idx.m_Slots.size() - 1;
+
+        // Assign every element to the group of its key, then lay the
+        // groups out contiguously in array order
+        std::vector<std::uint32_t> group_of(elems.size(), 0);
+        for (std::size_t i = 0; i < elems.size(); i++) {
+            const value* k = idx.m_Key.resolve(elems[i]);
+            if (!k) continue;
+            std::uint64_t h = hash(*k);
+
+            std::size_t s = static_cast<std::size_t>(h) & mask;
+            for (; idx.m_Slots[s] != 0; s = (s + 1) & mask) {
+                const auto& g = idx.m_Groups[idx.m_Slots[s] - 1];
+                if (g.hash == h && detail::json_equal(g.key, *k)) break;
+            }
+            if (idx.m_Slots[s] == 0) {
+                idx.m_Groups.push_back({ h, *k, 0, 0 });
+                idx.m_Slots[s] = static_cast<std::uint32_t>(idx.m_Groups.size());
+            }
+            group_of[i] = idx.m_Slots[s];
+            idx.m_Groups[idx.m_Slots[s] - 1].count++;
+        }
+
+        std::uint32_t offset = 0;
+        for (auto& g : idx.m_Groups) {
+            g.offset = offset;
+            offset += g.count;
+            g.count = 0;
+        }
+        idx.m_Elements.resize(offset);
+        for (std::size_t i = 0; i < elems.size(); i++) {
+            if (group_of[i] == 0) continue;
+            auto& g = idx.m_Groups[group_of[i] - 1];
+            idx.m_Elements[g.offset + g.count++] = &elems[i];
+        }
+        return idx;
+    }
+
+} // namespace Sonnet
@@ -0,0 +1,84 @@
+#include "sonnet/intern.hpp"
+#include "sonnet/hash.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        class Interner {
+        public:
+            // Counts the candidates by hash. Shared nodes are not entered:
+            // they were interned before and never change
+            void count(const value& v) {
+                if (!candidate(v)) return;
+                m_Counts[m_Hashes.hash(v)]++;
+                if (v.is_shared() || v.is_packed()) return;
+                if (v.is_array()) for (const auto& e : v.as_array()) count(e);
+                else if (v.is_object()) for (const auto& [k, e] : v.as_object()) count(e);
+            }
+
+            void intern(value& v) {
+                if (!candidate(v)) return;
+                const std::uint64_t h = m_Hashes.hash(v);
+                if (m_Counts[h] < 2) return children(v);
+
+                auto& bucket = m_Nodes[h];
+                const value* own = v.is_shared() ? std::get<shared_value>(std::as_const(v).storage()).get() : nullptr;
+                for (const auto& node : bucket) {
+                    if (node.get() == own || *node != v) continue;
+                    v = value{ node };
+                    m_Shared++;
+                    return;
+                }
+                if (own) {
+                    bucket.push_back(std::get<shared_value>(std::as_const(v).storage()));
+                    return;
+                }
+
+                // First occurrence: share its own repeated parts, then
+                // move it into a node
+                children(v);
+                shared_value node = std::allocate_shared<value>(allocator_type{ v.resource() }, std::move(v));
+                bucket.push_back(node);
+                v = value{ std::move(node) };
+            }
+
+            std::size_t shared() const noexcept { return m_Shared; }
+
+        private:
+            bool candidate(const value& v) const noexcept {
+                if (v.is_string()) return v.as_string().size() > m_Inline;
+                return (v.is_array() || v.is_object()) && v.size() > 0;
+            }
+
+            void children(value& v) {
+                if (v.is_packed()) return;
+                if (v.is_array()) for (auto& e : v.as_array()) intern(e);
+                else if (v.is_object()) for (auto& [k, e] : v.as_object()) intern(e);
+            }
+
+            // Longest string kept inside the `value` without a heap block
+            const std::size_t m_Inline = string{}.capacity();
+            // Slots keep their address and only take equal contents while
+            // being interned, so the hashes of the counting pass stay valid
+            hash_cache m_Hashes;
+            std::unordered_map<std::uint64_t, std::uint32_t> m_Counts;
+            std::unordered_map<std::uint64_t, std::vector<shared_value>> m_Nodes;
+            std::size_t m_Shared = 0;
+        };
+    } // namespace detail
+
+    std::size_t intern_subtrees(value& root) {
+        detail::Interner interner;
+        interner.count(root);
+        interner.intern(root);
+        return interner.shared();
+    }
+
+} // namespace Sonnet
@@ -0,0 +1,860 @@
+#include "sonnet/jsonpath.hpp"
+#include "sonnet/sonnet.hpp"
+#include "equal.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+
+namespace Sonnet::jsonpath {
+
+    namespace detail {
+        enum class sel : std::uint8_t { name, wildcard, index, slice, filter };
+        enum class op : std::uint8_t { exists, literal, not_, and_, or_, eq, ne, lt, le, gt, ge };
+
+        struct Selector {
+            sel kind = sel::wildcard;
+            std::string name;
+            std::int64_t index = 0;              ///< Index, or slice start
+            std::optional<std::int64_t> start;
+            std::optional<std::int64_t> end;
+            std::int64_t step = 1;
+            std::size_t filter = 0;              ///< Root expression in `Plan::exprs`
+        };
+
+        struct Segment {
+            bool descendant = false;
+            std::vector<Selector> selectors;
+        };
+
+        // Filter expressions live in one pool and refer to their operands
+        // by index. `exists` is a path (a test, or an operand of a
+        // comparison when it is singular); `literal` holds a constant
+        struct Expr {
+            op kind = op::literal;
+            bool absolute = false;
+            std::vector<Segment> path;
+            value literal;
+            std::size_t lhs = 0;
+            std::size_t rhs = 0;
+        };
+
+        struct Plan {
+            std::string text;
+            std::vector<Segment> segments;
+            std::vector<Expr> exprs;
+            std::vector<std::uint8_t> needs_dom; ///< Per segment: cannot be applied on parse events
+            bool uses_root = false;
+        };
+
+        constexpr std::int64_t max_index = (std::int64_t{ 1 } << 53) - 1;
+
+        inline bool name_first(char c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+        }
+
+        inline bool name_char(char c) noexcept {
+            return name_first(c) || (c >= '0' && c <= '9');
+        }
+
+        inline void append_utf8(std::uint32_t cp, std::string& out) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        // Whether a selector can be matched knowing only the key or index of
+        // a child, i.e. without the array length or the child's contents
+        inline bool streamable(const Selector& s) noexcept {
+            switch (s.kind) {
+            case sel::name:
+            case sel::wildcard: return true;
+            case sel::index: return s.index >= 0;
+            case sel::slice: return s.step > 0 && s.start.value_or(0) >= 0 && s.end.value_or(0) >= 0;
+            case sel::filter: return false;
+            }
+            return false;
+        }
+
+        inline bool singular(const std::vector<Segment>& path) noexcept {
+            return std::ranges::all_of(path, [](const Segment& s) {
+                return !s.descendant && s.selectors.size() == 1 &&
+                       (s.selectors[0].kind == sel::name || s.selectors[0].kind == sel::index);
+            });
+        }
+
+        // Recursive-descent compiler. The first error is recorded and every
+        // rule returns false from then on
+        class Compiler {
+        public:
+            Compiler(std::string_view text, Plan& plan) : m_Text{ text }, m_Plan{ plan } {}
+
+            std::optional<ParseError> run() {
+                skip_ws();
+                if (!consume('$')) {
+                    fail(ParseError::code::unexpected_character, "Expected '$' at the start of the query");
+                    return m_Error;
+                }
+                if (segments(m_Plan.segments)) {
+                    skip_ws();
+                    if (!eof()) fail(ParseError::code::trailing_characters, "Unexpected characters after the query");
+                }
+                return m_Error;
+            }
+
+        private:
+            bool eof() const noexcept { return m_Pos >= m_Text.size(); }
+            char peek(size_t ahead = 0) const noexcept { return m_Pos + ahead < m_Text.size() ? m_Text[m_Pos + ahead] : '\0'; }
+
+            bool consume(char c) noexcept {
+                if (peek() != c || eof()) return false;
+                m_Pos++;
+                return true;
+            }
+
+            void skip_ws() noexcept {
+                while (!eof() && (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r')) m_Pos++;
+            }
+
+            bool fail(ParseError::code c, std::string_view msg) {
+                if (!m_Error) {
+                    if (eof() && c == ParseError::code::unexpected_character) c = ParseError::code::unexpected_end_of_input;
+                    m_Error = ParseError::make(c, m_Pos, 1, m_Pos + 1, msg);
+                }
+                return false;
+            }
+
+            // Segments up to the first character that cannot start one
+            bool segments(std::vector<Segment>& out) {
+                while (true) {
+                    size_t mark = m_Pos;
+                    skip_ws();
+                    if (peek() == '.' && peek(1) == '.') {
+                        m_Pos += 2;
+                        if (!child(out.emplace_back(), true)) return false;
+                    } else if (peek() == '.') {
+                        m_Pos++;
+                        if (!shorthand(out.emplace_back())) return false;
+                    } else if (peek() == '[') {
+                        if (!bracket(out.emplace_back())) return false;
+                    } else {
+                        m_Pos = mark;
+                        return true;
+                    }
+                }
+            }
+
+            // After `..`: a shorthand name, `*` or a bracketed selection
+            bool child(Segment& seg, bool descendant) {
+                seg.descendant = descendant;
+                if (peek() == '[') return bracket(seg);
+                return shorthand(seg);
+            }
+
+            bool shorthand(Segment& seg) {
+                if (consume('*')) {
+                    seg.selectors.emplace_back().kind = sel::wildcard;
+                    return true;
+                }
+                if (!name_first(peek())) return fail(ParseError::code::unexpected_character, "Expected a member name or '*'");
+                size_t begin = m_Pos;
+                while (!eof() && name_char(peek())) m_Pos++;
+                Selector& s = seg.selectors.emplace_back();
+                s.kind = sel::name;
+                s.name.assign(m_Text.substr(begin, m_Pos - begin));
+                return true;
+            }
+
+            bool bracket(Segment& seg) {
+                m_Pos++; // '['
+                while (true) {
+                    skip_ws();
+                    if (!selector(seg.selectors.emplace_back())) return false;
+                    skip_ws();
+                    if (consume(']')) return true;
+                    if (!consume(',')) return fail(ParseError::code::unexpected_character, "Expected ',' or ']'");
+                }
+            }
+
+            bool selector(Selector& s) {
+                char c = peek();
+                if (c == '\'' || c == '"') {
+                    s.kind = sel::name;
+                    return quoted(s.name);
+                }
+                if (consume('*')) {
+                    s.kind = sel::wildcard;
+                    return true;
+                }
+                if (consume('?')) {
+                    s.kind = sel::filter;
+                    skip_ws();
+                    return logical_or(s.filter);
+                }
+                if (c == '-' || (c >= '0' && c <= '9') || c == ':') return index_or_slice(s);
+                return fail(ParseError::code::unexpected_character, "Expected a selector");
+            }
+
+            bool integer(std::int64_t& out) {
+                size_t begin = m_Pos;
+                bool neg = consume('-');
+                if (!(peek() >= '0' && peek() <= '9')) return fail(ParseError::code::invalid_number, "Expected an integer");
+                if (peek() == '0' && ((peek(1) >= '0' && peek(1) <= '9') || neg)) return fail(ParseError::code::invalid_number, "Invalid integer");
+                while (peek() >= '0' && peek() <= '9') m_Pos++;
+
+                auto [p, ec] = std::from_chars(m_Text.data() + begin, m_Text.data() + m_Pos, out);
+                if (ec != std::errc{} || out > max_index || out < -max_index) {
+                    m_Pos = begin;
+                    return fail(ParseError::code::invalid_number, "Integer out of range");
+                }
+                return true;
+            }
+
+            bool index_or_slice(Selector& s) {
+                std::int64_t n = 0;
+                bool has_start = peek() != ':';
+                if (has_start && !integer(n)) return false;
+                skip_ws();
+                if (!consume(':')) {
+                    s.kind = sel::index;
+                    s.index = n;
+                    return true;
+                }
+
+                s.kind = sel::slice;
+                if (has_start) s.start = n;
+                skip_ws();
+                if (peek() == '-' || (peek() >= '0' && peek() <= '9')) {
+                    if (!integer(n)) return false;
+                    s.end = n;
+                    skip_ws();
+                }
+                if (consume(':')) {
+                    skip_ws();
+                    if (peek() == '-' || (peek() >= '0' && peek() <= '9')) {
+                        if (!integer(s.step)) return false;
+                    }
+                }
+                return true;
+            }
+
+            bool hex4(std::uint32_t& out) {
+                out = 0;
+                for (int i = 0; i < 4; i++) {
+                    char h = peek();
+                    out <<= 4;
+                    if (h >= '0' && h <= '9') out |= static_cast<std::uint32_t>(h - '0');
+                    else if (h >= 'a' && h <= 'f') out |= static_cast<std::uint32_t>(h - 'a' + 10);
+                    else if (h >= 'A' && h <= 'F') out |= static_cast<std::uint32_t>(h - 'A' + 10);
+                    else return fail(ParseError::code::invalid_unicode_escape, "Expected four hex digits");
+                    m_Pos++;
+                }
+                return true;
+            }
+
+            // A single- or double-quoted string with JSON escapes
+            bool quoted(std::string& out) {
+                char quote = peek();
+                m_Pos++;
+                while (true) {
+                    if (eof()) return fail(ParseError::code::unexpected_end_of_input, "Unterminated string");
+                    char c = peek();
+                    if (c == quote) {
+                        m_Pos++;
+                        return true;
+                    }
+                    if (static_cast<unsigned char>(c) < 0x20) return fail(ParseError::code::invalid_string, "Control character in string");
+                    m_Pos++;
+                    if (c != '\\') {
+                        out.push_back(c);
+                        continue;
+                    }
+
+                    char e = peek();
+                    m_Pos++;
+                    switch (e) {
+                    case '"': case '\'': case '\\': case '/': out.push_back(e); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u': {
+                        std::uint32_t cp = 0;
+                        if (!hex4(cp)) return false;
+                        if (cp >= 0xD800 && cp <= 0xDBFF) {
+                            std::uint32_t low = 0;
+                            if (!consume('\\') || !consume('u') || !hex4(low) || low < 0xDC00 || low > 0xDFFF)
+                                return fail(ParseError::code::invalid_unicode_escape, "Unpaired surrogate");
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                            return fail(ParseError::code::invalid_unicode_escape, "Unpaired surrogate");
+                        }
+                        append_utf8(cp, out);
+                        break;
+                    }
+                    default:
+                        m_Pos--;
+                        return fail(ParseError::code::invalid_escape, "Invalid escape sequence");
+                    }
+                }
+            }
+
+            size_t add(op kind, size_t lhs = 0, size_t rhs = 0) {
+                Expr& e = m_Plan.exprs.emplace_back();
+                e.kind = kind;
+                e.lhs = lhs;
+                e.rhs = rhs;
+                return m_Plan.exprs.size() - 1;
+            }
+
+            bool logical_or(size_t& out) {
+                if (!logical_and(out)) return false;
+                while (true) {
+                    skip_ws();
+                    if (peek() != '|' || peek(1) != '|') return true;
+                    m_Pos += 2;
+                    skip_ws();
+                    size_t rhs = 0;
+                    if (!logical_and(rhs)) return false;
+                    out = add(op::or_, out, rhs);
+                }
+            }
+
+            bool logical_and(size_t& out) {
+                if (!basic(out)) return false;
+                while (true) {
+                    skip_ws();
+                    if (peek() != '&' || peek(1) != '&') return true;
+                    m_Pos += 2;
+                    skip_ws();
+                    size_t rhs = 0;
+                    if (!basic(rhs)) return false;
+                    out = add(op::and_, out, rhs);
+                }
+            }
+
+            bool basic(size_t& out) {
+                // `!` applies to a parenthesized expression or an existence test
+                if (consume('!')) {
+                    skip_ws();
+                    size_t inner = 0;
+                    if (peek() == '(') {
+                        if (!basic(inner)) return false;
+                    } else {
+                        if (!operand(inner)) return false;
+                        if (m_Plan.exprs[inner].kind != op::exists) return fail(ParseError::code::unexpected_character, "Expected a path or '(' after '!'");
+                    }
+                    out = add(op::not_, inner);
+                    return true;
+                }
+                if (consume('(')) {
+                    skip_ws();
+                    if (!logical_or(out)) return false;
+                    skip_ws();
+                    if (!consume(')')) return fail(ParseError::code::unexpected_character, "Expected ')'");
+                    return true;
+                }
+
+                size_t start = m_Pos;
+                size_t lhs = 0;
+                if (!operand(lhs)) return false;
+                skip_ws();
+
+                op cmp = op::exists;
+                if (peek() == '=' && peek(1) == '=') cmp = op::eq;
+                else if (peek() == '!' && peek(1) == '=') cmp = op::ne;
+                else if (peek() == '<' && peek(1) == '=') cmp = op::le;
+                else if (peek() == '>' && peek(1) == '=') cmp = op::ge;
+                else if (peek() == '<') cmp = op::lt;
+                else if (peek() == '>') cmp = op::gt;
+
+                if (cmp == op::exists) {
+                    if (m_Plan.exprs[lhs].kind == op::literal) return fail(ParseError::code::unexpected_character, "Expected a comparison operator");
+                    out = lhs;
+                    return true;
+                }
+                m_Pos += (cmp == op::lt || cmp == op::gt) ? 1 : 2;
+                skip_ws();
+
+                size_t rhs_start = m_Pos;
+                size_t rhs = 0;
+                if (!operand(rhs)) return false;
+                if (!comparable(lhs, start) || !comparable(rhs, rhs_start)) return false;
+                out = add(cmp, lhs, rhs);
+                return true;
+            }
+
+            bool comparable(size_t e, size_t at) {
+                const Expr& x = m_Plan.exprs[e];
+                if (x.kind == op::exists && !singular(x.path)) {
+                    m_Pos = at;
+                    return fail(ParseError::code::unexpected_character, "Only singular paths (names and indices) can be compared");
+                }
+                return true;
+            }
+
+            // A path starting with `@` or `$`, or a literal
+            bool operand(size_t& out) {
+                char c = peek();
+                if (c == '@' || c == '$') {
+                    m_Pos++;
+                    // Nested filters add to the pool, so the path is built
+                    // before its own entry exists
+                    std::vector<Segment> path;
+                    if (!segments(path)) return false;
+                    out = add(op::exists);
+                    m_Plan.exprs[out].absolute = c == '$';
+                    m_Plan.exprs[out].path = std::move(path);
+                    m_Plan.uses_root |= c == '$';
+                    return true;
+                }
+
+                value lit;
+                if (c == '\'' || c == '"') {
+                    std::string s;
+                    if (!quoted(s)) return false;
+                    lit = value{ std::string_view{ s } };
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    if (!number(lit)) return false;
+                } else if (m_Text.substr(m_Pos, 4) == "true") {
+                    m_Pos += 4;
+                    lit = value{ true };
+                } else if (m_Text.substr(m_Pos, 5) == "false") {
+                    m_Pos += 5;
+                    lit = value{ false };
+                } else if (m_Text.substr(m_Pos, 4) == "null") {
+                    m_Pos += 4;
+                    lit = value{ nullptr };
+                } else {
+                    return fail(ParseError::code::unexpected_character, "Expected a path or a literal");
+                }
+                out = add(op::literal);
+                m_Plan.exprs[out].literal = std::move(lit);
+                return true;
+            }
+
+            bool number(value& out) {
+                size_t begin = m_Pos;
+                auto digits = [&] {
+                    size_t d = m_Pos;
+                    while (peek() >= '0' && peek() <= '9') m_Pos++;
+                    return m_Pos > d;
+                };
+
+                consume('-');
+                if (!digits()) return fail(ParseError::code::invalid_number, "Expected a digit");
+                if (consume('.') && !digits()) return fail(ParseError::code::invalid_number, "Expected a digit after '.'");
+                if (peek() == 'e' || peek() == 'E') {
+                    m_Pos++;
+                    if (!consume('+')) consume('-');
+                    if (!digits()) return fail(ParseError::code::invalid_number, "Expected an exponent");
+                }
+
+                double d = 0.0;
+                auto [p, ec] = std::from_chars(m_Text.data() + begin, m_Text.data() + m_Pos, d);
+                if (ec != std::errc{}) {
+                    m_Pos = begin;
+                    return fail(ParseError::code::invalid_number, "Invalid number");
+                }
+                out = value{ d };
+                return true;
+            }
+
+            std::string_view m_Text;
+            Plan& m_Plan;
+            size_t m_Pos = 0;
+            std::optional<ParseError> m_Error;
+        };
+
+        // Filter comparisons (RFC 9535 section 2.3.5.2.2): `nullptr` is the
+        // empty result of a path that selected nothing
+        bool less(const value* a, const value* b) {
+            if (!a || !b) return false;
+            if (a->is_number() && b->is_number()) return a->as_number() < b->as_number();
+            if (a->is_string() && b->is_string()) return std::string_view{ a->as_string() } < std::string_view{ b->as_string() };
+            return false;
+        }
+
+        bool equal(const value* a, const value* b) {
+            if (!a || !b) return !a && !b;
+            return Sonnet::detail::json_equal(*a, *b);
+        }
+
+        // Applies a plan's segments to a document
+        class Evaluator {
+        public:
+            Evaluator(const Plan& plan, const value& root) : m_Plan{ plan }, m_Root{ root } {}
+
+            // Calls `f(node)` for every node selected by `segs[i..]` from
+            // @p node; returns false as soon as `f` does
+            template<typename F>
+            bool walk(const std::vector<Segment>& segs, size_t i, const value& node, F& f) const {
+                if (i == segs.size()) return f(node);
+                auto next = [&](const value& child) { return walk(segs, i + 1, child, f); };
+                if (segs[i].descendant) return descend(segs[i], node, next);
+                return select(segs[i], node, next);
+            }
+
+        private:
+            template<typename F>
+            bool descend(const Segment& seg, const value& node, F& f) const {
+                if (!select(seg, node, f)) return false;
+                if (node.is_object()) {
+                    for (const auto& [k, child] : node.as_object())
+                        if (!descend(seg, child, f)) return false;
+                } else if (node.is_array()) {
+                    for (const auto& child : node.as_array())
+                        if (!descend(seg, child, f)) return false;
+                }
+                return true;
+            }
+
+            template<typename F>
+            bool select(const Segment& seg, const value& node, F& f) const {
+                for (const auto& s : seg.selectors)
+                    if (!select(s, node, f)) return false;
+                return true;
+            }
+
+            template<typename F>
+            bool select(const Selector& s, const value& node, F& f) const {
+                if (node.is_object()) {
+                    const auto& obj = node.as_object();
+                    if (s.kind == sel::name) {
+                        auto it = obj.find(std::string_view{ s.name });
+                        return it == obj.end() || f(it->second);
+                    }
+                    if (s.kind == sel::wildcard || s.kind == sel::filter) {
+                        for (const auto& [k, child] : obj)
+                            if ((s.kind == sel::wildcard || test(s.filter, child)) && !f(child)) return false;
+                    }
+                    return true;
+                }
+
+                if (!node.is_array()) return true;
+                const auto& arr = node.as_array();
+                const auto len = static_cast<std::int64_t>(arr.size());
+                switch (s.kind) {
+                case sel::name: return true;
+                case sel::wildcard:
+                case sel::filter:
+                    for (const auto& child : arr)
+                        if ((s.kind == sel::wildcard || test(s.filter, child)) && !f(child)) return false;
+                    return true;
+                case sel::index: {
+                    std::int64_t i = s.index < 0 ? len + s.index : s.index;
+                    return i < 0 || i >= len || f(arr[static_cast<size_t>(i)]);
+                }
+                case sel::slice: {
+                    if (s.step == 0) return true;
+                    auto norm = [&](std::int64_t i) { return i >= 0 ? i : len + i; };
+                    if (s.step > 0) {
+                        std::int64_t lo = std::clamp<std::int64_t>(norm(s.start.value_or(0)), 0, len);
+                        std::int64_t hi = std::clamp<std::int64_t>(norm(s.end.value_or(len)), 0, len);
+                        for (std::int64_t i = lo; i < hi; i += s.step)
+                            if (!f(arr[static_cast<size_t>(i)])) return false;
+                    } else {
+                        std::int64_t hi = std::clamp<std::int64_t>(norm(s.start.value_or(len - 1)), -1, len - 1);
+                        std::int64_t lo = std::clamp<std::int64_t>(norm(s.end.value_or(-len - 1)), -1, len - 1);
+                        for (std::int64_t i = hi; lo < i; i += s.step)
+                            if (!f(arr[static_cast<size_t>(i)])) return false;
+                    }
+                    return true;
+                }
+                }
+                return true;
+            }
+
+            const value* singular_path(const Expr& e, const value& current) const {
+                const value* out = nullptr;
+                auto take = [&](const value& v) { out = &v; return false; };
+                walk(e.path, 0, e.absolute ? m_Root : current, take);
+                return out;
+            }
+
+            const value* operand(size_t idx, const value& current) const {
+                const Expr& e = m_Plan.exprs[idx];
+                return e.kind == op::literal ? &e.literal : singular_path(e, current);
+            }
+
+            bool test(size_t idx, const value& current) const {
+                const Expr& e = m_Plan.exprs[idx];
+                switch (e.kind) {
+                case op::exists: return singular_path(e, current) != nullptr;
+                case op::literal: return false;
+                case op::not_: return !test(e.lhs, current);
+                case op::and_: return test(e.lhs, current) && test(e.rhs, current);
+                case op::or_: return test(e.lhs, current) || test(e.rhs, current);
+                default: break;
+                }
+
+                const value* a = operand(e.lhs, current);
+                const value* b = operand(e.rhs, current);
+                switch (e.kind) {
+                case op::eq: return equal(a, b);
+                case op::ne: return !equal(a, b);
+                case op::lt: return less(a, b);
+                case op::le: return less(a, b) || equal(a, b);
+                case op::gt: return less(b, a);
+                case op::ge: return less(b, a) || equal(a, b);
+                default: return false;
+                }
+            }
+
+            const Plan& m_Plan;
+            const value& m_Root;
+        };
+
+        // Evaluates a plan on parse events. Every open container that may
+        // still contain results keeps the set of segments left to apply to
+        // it (descendant segments stay in the set of every child). A child
+        // is materialized only when it is a result or when a segment in its
+        // set has to see it whole; the DOM evaluator then takes over for
+        // that subtree
+        class StreamHandler final : public SaxHandler {
+        public:
+            StreamHandler(const Plan& plan, bool (*cb)(void*, const value&), void* ctx)
+                : m_Plan{ plan }, m_Callback{ cb }, m_Ctx{ ctx } {}
+
+            [[nodiscard]] bool stopped() const noexcept { return m_Stopped; }
+
+            bool on_null() override { return scalar([&] { return m_Builder.on_null(); }); }
+            bool on_bool(bool b) override { return scalar([&] { return m_Builder.on_bool(b); }); }
+            bool on_number(double d) override { return scalar([&] { return m_Builder.on_number(d); }); }
+            bool on_string(std::string_view s) override { return scalar([&] { return m_Builder.on_string(s); }); }
+
+            bool on_start_array(std::size_t size) override {
+                return open(true, [&] { return m_Builder.on_start_array(size); });
+            }
+
+            bool on_start_object(std::size_t size) override {
+                return open(false, [&] { return m_Builder.on_start_object(size); });
+            }
+
+            bool on_key(std::string_view k) override {
+                if (m_Capture) return m_Builder.on_key(k);
+                if (m_Skip == 0) m_Frames.back().key.assign(k);
+                return true;
+            }
+
+            bool on_end_array() override { return close([&] { return m_Builder.on_end_array(); }); }
+            bool on_end_object() override { return close([&] { return m_Builder.on_end_object(); }); }
+
+        private:
+            struct Frame {
+                bool array = false;
+                std::size_t next = 0; ///< Index of the next element
+                std::string key;      ///< Key of the current member
+                std::size_t begin = 0;
+                std::size_t end = 0;  ///< States of this container in `m_States`
+            };
+
+            // Computes the states of the next child of the innermost open
+            // container into `m_Next`
+            void child_states() {
+                m_Next.clear();
+                auto add = [&](std::uint32_t k) {
+                    if (std::ranges::find(m_Next, k) == m_Next.end()) m_Next.push_back(k);
+                };
+                if (m_Frames.empty()) {
+                    add(0);
+                    return;
+                }
+
+                Frame& f = m_Frames.back();
+                const auto idx = static_cast<std::int64_t>(f.next++);
+                for (size_t s = f.begin; s < f.end; s++) {
+                    std::uint32_t k = m_States[s];
+                    const Segment& seg = m_Plan.segments[k];
+                    if (seg.descendant) add(k);
+                    for (const auto& sl : seg.selectors) {
+                        bool hit = false;
+                        switch (sl.kind) {
+                        case sel::name: hit = !f.array && f.key == sl.name; break;
+                        case sel::wildcard: hit = true; break;
+                        case sel::index: hit = f.array && idx == sl.index; break;
+                        case sel::slice:
+                            hit = f.array && idx >= sl.start.value_or(0) && (!sl.end || idx < *sl.end) &&
+                                  (idx - sl.start.value_or(0)) % sl.step == 0;
+                            break;
+                        case sel::filter: break;
+                        }
+                        if (hit) add(k + 1);
+                    }
+                }
+            }
+
+            bool complete() const noexcept {
+                return std::ranges::find(m_Next, static_cast<std::uint32_t>(m_Plan.segments.size())) != m_Next.end();
+            }
+
+            bool needs_capture() const noexcept {
+                return complete() || std::ranges::any_of(m_Next, [&](std::uint32_t k) {
+                    return k < m_Plan.segments.size() && m_Plan.needs_dom[k];
+                });
+            }
+
+            bool emit(const value& v) {
+                if (m_Callback(m_Ctx, v)) return true;
+                m_Stopped = true;
+                return false;
+            }
+
+            template<typename Build>
+            bool scalar(Build build) {
+                if (m_Capture) return build();
+                if (m_Skip) return true;
+
+                child_states();
+                if (!complete()) return true;
+                m_Builder.reset();
+                build();
+                return emit(m_Builder.result());
+            }
+
+            template<typename Build>
+            bool open(bool array, Build build) {
+                if (m_Capture) {
+                    m_Capture++;
+                    return build();
+                }
+                if (m_Skip) {
+                    m_Skip++;
+                    return true;
+                }
+
+                child_states();
+                if (m_Next.empty()) {
+                    m_Skip = 1;
+                    return true;
+                }
+                if (needs_capture()) {
+                    m_Builder.reset();
+                    m_Capture = 1;
+                    m_CaptureStates = m_Next;
+                    return build();
+                }
+
+                Frame& f = m_Frames.emplace_back();
+                f.array = array;
+                f.begin = m_States.size();
+                m_States.insert(m_States.end(), m_Next.begin(), m_Next.end());
+                f.end = m_States.size();
+                return true;
+            }
+
+            template<typename Build>
+            bool close(Build build) {
+                if (m_Capture) {
+                    if (!build()) return false;
+                    return --m_Capture > 0 || finish_capture();
+                }
+                if (m_Skip) {
+                    m_Skip--;
+                    return true;
+                }
+                m_States.resize(m_Frames.back().begin);
+                m_Frames.pop_back();
+                return true;
+            }
+
+            // Runs the DOM evaluator from every state of the captured node,
+            // reporting each resulting node once
+            bool finish_capture() {
+                const value& node = m_Builder.result();
+                Evaluator eval{ m_Plan, node };
+                std::unordered_set<const value*> seen;
+                auto report = [&](const value& v) { return !seen.insert(&v).second || emit(v); };
+                for (std::uint32_t k : m_CaptureStates)
+                    if (!eval.walk(m_Plan.segments, k, node, report)) return false;
+                return true;
+            }
+
+            const Plan& m_Plan;
+            bool (*m_Callback)(void*, const value&);
+            void* m_Ctx;
+
+            std::vector<Frame> m_Frames;
+            std::vector<std::uint32_t> m_States;
+            std::vector<std::uint32_t> m_Next;
+            std::vector<std::uint32_t> m_CaptureStates;
+            DomBuilder m_Builder;
+            int m_Capture = 0; ///< Open containers inside the node being materialized
+            int m_Skip = 0;    ///< Open containers inside a node that cannot hold results
+            bool m_Stopped = false;
+        };
+    } // namespace detail
+
+    std::expected<query, ParseError> compile(std::string_view path) {
+        auto plan = std::make_shared<detail::Plan>();
+        plan->text.assign(path);
+
+        detail::Compiler compiler{ plan->text, *plan };
+        if (auto err = compiler.run()) return std::unexpected(std::move(*err));
+
+        plan->needs_dom.reserve(plan->segments.size());
+        for (const auto& seg : plan->segments)
+            plan->needs_dom.push_back(!std::ranges::all_of(seg.selectors, detail::streamable));
+
+        query q;
+        q.m_Plan = std::move(plan);
+        return q;
+    }
+
+    void query::run(const value& root, callback cb, void* ctx) const {
+        detail::Evaluator eval{ *m_Plan, root };
+        auto f = [&](const value& v) { return cb(ctx, v); };
+        eval.walk(m_Plan->segments, 0, root, f);
+    }
+
+    const value* query::first(const value& root) const {
+        const value* out = nullptr;
+        for_each(root, [&](const value& v) {
+            out = &v;
+            return false;
+        });
+        return out;
+    }
+
+    std::vector<const value*> query::evaluate(const value& root) const {
+        std::vector<const value*> out;
+        for_each(root, [&](const value& v) { out.push_back(&v); });
+        return out;
+    }
+
+    std::string_view query::text() const noexcept {
+        return m_Plan->text;
+    }
+
+    std::expected<void, ParseError> query::run_stream(std::string_view json, const ParseOptions& opts, callback cb, void* ctx) const {
+        if (m_Plan->uses_root) {
+            auto doc = parse(json, opts);
+            if (!doc) return std::unexpected(std::move(doc.error()));
+            run(*doc, cb, ctx);
+            return {};
+        }
+
+        detail::StreamHandler handler{ *m_Plan, cb, ctx };
+        auto r = parse_sax(json, handler, opts);
+        if (!r && handler.stopped()) return {};
+        return r;
+    }
+
+} // namespace Sonnet::jsonpath
@@ -0,0 +1,320 @@
+#include "sonnet/msgpack.hpp"
+#include "binary.hpp"
+#include "utf8.hpp"
+
+#include <string>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        using expected_void = std::expected<void, ParseError>;
+
+        template<typename Sink>
+        struct MsgpackEncoder {
+            Sink& out;
+
+            // Writes a length using the fix form when @p fix_limit allows it,
+            // otherwise the first of the 8/16/32-bit forms (opcodes in @p wide)
+            void length(std::size_t n, std::uint8_t fix, std::size_t fix_limit, const std::uint8_t (&wide)[3]) {
+                if (n < fix_limit) out.put(static_cast<std::uint8_t>(fix | n));
+                else if (wide[0] != 0 && n <= 0xFF) put_be(out, wide[0], static_cast<std::uint8_t>(n));
+                else if (n <= 0xFFFF) put_be(out, wide[1], static_cast<std::uint16_t>(n));
+                else put_be(out, wide[2], static_cast<std::uint32_t>(n));
+            }
+
+            void number(double d) {
+                if (std::isfinite(d) && d == std::trunc(d) && !(d == 0 && std::signbit(d))) {
+                    if (d >= 0 && d < 0x1p64) {
+                        auto n = static_cast<std::uint64_t>(d);
+                        if (n < 0x80) out.put(static_cast<std::uint8_t>(n));
+                        else if (n <= 0xFF) put_be(out, 0xCC, static_cast<std::uint8_t>(n));
+                        else if (n <= 0xFFFF) put_be(out, 0xCD, static_cast<std::uint16_t>(n));
+                        else if (n <= 0xFFFFFFFF) put_be(out, 0xCE, static_cast<std::uint32_t>(n));
+                        else put_be(out, 0xCF, n);
+                        return;
+                    }
+                    if (d < 0 && d >= -0x1p63) {
+                        auto n = static_cast<std::int64_t>(d);
+                        if (n >= -32) out.put(static_cast<std::uint8_t>(n));
+                        else if (n >= INT8_MIN) put_be(out, 0xD0, static_cast<std::uint8_t>(n));
+                        else if (n >= INT16_MIN) put_be(out, 0xD1, static_cast<std::uint16_t>(n));
+                        else if (n >= INT32_MIN) put_be(out, 0xD2, static_cast<std::uint32_t>(n));
+                        else put_be(out, 0xD3, static_cast<std::uint64_t>(n));
+                        return;
+                    }
+                }
+
+                auto f = static_cast<float>(d);
+                if (static_cast<double>(f) == d || std::isnan(d)) put_be(out, 0xCA, std::bit_cast<std::uint32_t>(f));
+                else put_be(out, 0xCB, std::bit_cast<std::uint64_t>(d));
+            }
+
+            void text(std::string_view s) {
+                length(s.size(), 0xA0, 32, { 0xD9, 0xDA, 0xDB });
+                out.write(s.data(), s.size());
+            }
+
+            void encode(const value& v) {
+                switch (v.type()) {
+                case kind::null: out.put(0xC0); return;
+                case kind::boolean: out.put(v.as_bool() ? 0xC3 : 0xC2); return;
+                case kind::number: number(v.as_number()); return;
+                case kind::string: text(v.as_string()); return;
+                case kind::array: {
+                    length(v.size(), 0x90, 16, { 0, 0xDC, 0xDD });
+                    if (v.is_packed()) {
+                        for (double d : v.numbers()) number(d);
+                        return;
+                    }
+                    for (const auto& e : v.as_array()) encode(e);
+                    return;
+                }
+                case kind::object: {
+                    const auto& obj = v.as_object();
+                    length(obj.size(), 0x80, 16, { 0, 0xDE, 0xDF });
+                    for (const auto& [k, e] : obj) {
+                        text(k);
+                        encode(e);
+                    }
+                    return;
+                }
+                }
+            }
+        };
+
+        template<typename Sink>
+        void encode_msgpack(const value& v, Sink& out) {
+            MsgpackEncoder<Sink> enc{ out };
+            enc.encode(v);
+            out.flush();
+        }
+
+        // Iterative decoder mirroring the CBOR one; MessagePack containers
+        // always carry their length, so a frame only counts what is left
+        template<typename Handler>
+        struct MsgpackDecoder {
+            struct frame {
+                std::uint64_t remaining; // elements, or keys and values for maps
+                bool is_map;
+            };
+
+            const std::uint8_t* begin;
+            const std::uint8_t* p;
+            const std::uint8_t* end;
+            Handler& h;
+            size_t max_depth;
+            std::vector<frame> stack{};
+            std::string text{};
+
+            std::unexpected<ParseError> fail(ParseError::code c, const std::uint8_t* at, std::string_view msg) const {
+                return std::unexpected(binary_error(c, static_cast<size_t>(at - begin), msg));
+            }
+
+            std::unexpected<ParseError> aborted() const {
+                return fail(ParseError::code::aborted, p, "Decoding stopped by handler");
+            }
+
+            // Reads a big-endian T and widens it to R
+            template<typename T, typename R = T>
+            std::expected<R, ParseError> fixed(const std::uint8_t* item) {
+                if (static_cast<size_t>(end - p) < sizeof(T)) return fail(ParseError::code::unexpected_end_of_input, item, "Truncated MessagePack item");
+                R v = load_be<T>(p);
+                p += sizeof(T);
+                return v;
+            }
+
+            // Reads a big-endian integer of 1, 2, 4 or 8 bytes (lengths, uint 8..64)
+            std::expected<std::uint64_t, ParseError> unsigned_n(int width, const std::uint8_t* item) {
+                switch (width) {
+                case 1: return fixed<std::uint8_t, std::uint64_t>(item);
+                case 2: return fixed<std::uint16_t, std::uint64_t>(item);
+                case 4: return fixed<std::uint32_t, std::uint64_t>(item);
+                default: return fixed<std::uint64_t>(item);
+                }
+            }
+
+            std::expected<std::int64_t, ParseError> signed_n(int width, const std::uint8_t* item) {
+                switch (width) {
+                case 1: return fixed<std::int8_t, std::int64_t>(item);
+                case 2: return fixed<std::int16_t, std::int64_t>(item);
+                case 4: return fixed<std::int32_t, std::int64_t>(item);
+                default: return fixed<std::int64_t>(item);
+                }
+            }
+
+            std::expected<std::string_view, ParseError> bytes(std::uint64_t n, const std::uint8_t* item) {
+                if (n > static_cast<size_t>(end - p)) return fail(ParseError::code::unexpected_end_of_input, item, "MessagePack string length exceeds input");
+                std::string_view s{ reinterpret_cast<const char*>(p), static_cast<size_t>(n) };
+                p += n;
+                return s;
+            }
+
+            std::expected<std::string_view, ParseError> str(std::uint64_t n, const std::uint8_t* item) {
+                auto s = bytes(n, item);
+                if (!s) return s;
+                size_t bad = 0;
+                if (!is_valid_utf8(*s, bad)) return fail(ParseError::code::invalid_string, item, "Invalid UTF-8 in MessagePack string");
+                return s;
+            }
+
+            expected_void open(bool is_map, std::uint64_t n, const std::uint8_t* item) {
+                if (max_depth != 0 && stack.size() + 1 > max_depth) return fail(ParseError::code::depth_limit_exceeded, item, "Maximum nesting depth exceeded");
+                std::uint64_t items = is_map ? std::uint64_t{ n } * 2 : n;
+                // Every item takes at least one byte, which bounds honest lengths
+                if (items > static_cast<std::uint64_t>(end - p)) return fail(ParseError::code::unexpected_end_of_input, item, "MessagePack container length exceeds input");
+                stack.push_back(frame{ items, is_map });
+                if (!(is_map ? h.on_start_object(static_cast<size_t>(n)) : h.on_start_array(static_cast<size_t>(n)))) return aborted();
+                return {};
+            }
+
+            expected_void key(std::uint8_t op, const std::uint8_t* item) {
+                std::expected<std::uint64_t, ParseError> n = op & 0x1Fu;
+                if (op >= 0xD9 && op <= 0xDB) n = unsigned_n(1 << (op - 0xD9), item);
+                else if ((op & 0xE0) != 0xA0) return fail(ParseError::code::unsupported_type, item, "MessagePack map keys must be strings");
+                if (!n) return std::unexpected(n.error());
+
+                auto k = str(*n, item);
+                if (!k) return std::unexpected(k.error());
+                if (!h.on_key(*k)) return aborted();
+                return {};
+            }
+
+            expected_void item() {
+                const std::uint8_t* start = p;
+                if (p == end) return fail(ParseError::code::unexpected_end_of_input, p, "Unexpected end of MessagePack input");
+
+                bool is_key = false;
+                if (!stack.empty()) {
+                    frame& f = stack.back();
+                    is_key = f.is_map && (f.remaining % 2 == 0);
+                    f.remaining--;
+                }
+
+                std::uint8_t op = *p++;
+                if (is_key) return key(op, start);
+
+                bool ok = true;
+                if (op < 0x80) ok = h.on_number(op);
+                else if (op >= 0xE0) ok = h.on_number(static_cast<std::int8_t>(op));
+                else if (op < 0x90) return open(true, op & 0x0Fu, start);
+                else if (op < 0xA0) return open(false, op & 0x0Fu, start);
+                else if (op < 0xC0) {
+                    auto s = str(op & 0x1Fu, start);
+                    if (!s) return std::unexpected(s.error());
+                    ok = h.on_string(*s);
+                } else switch (op) {
+                case 0xC0: ok = h.on_null(); break;
+                case 0xC2: ok = h.on_bool(false); break;
+                case 0xC3: ok = h.on_bool(true); break;
+                case 0xC4:
+                case 0xC5:
+                case 0xC6: {
+                    auto n = unsigned_n(1 << (op - 0xC4), start);
+                    if (!n) return std::unexpected(n.error());
+                    auto b = bytes(*n, start);
+                    if (!b) return std::unexpected(b.error());
+                    text.clear();
+                    append_base64url(*b, text);
+                    ok = h.on_string(text);
+                    break;
+                }
+                case 0xCA: {
+                    auto b = fixed<std::uint32_t>(start);
+                    if (!b) return std::unexpected(b.error());
+                    ok = h.on_number(std::bit_cast<float>(*b));
+                    break;
+                }
+                case 0xCB: {
+                    auto b = fixed<std::uint64_t>(start);
+                    if (!b) return std::unexpected(b.error());
+                    ok = h.on_number(std::bit_cast<double>(*b));
+                    break;
+                }
+                case 0xCC: case 0xCD: case 0xCE: case 0xCF: {
+                    auto n = unsigned_n(1 << (op - 0xCC), start);
+                    if (!n) return std::unexpected(n.error());
+                    ok = h.on_number(static_cast<double>(*n));
+                    break;
+                }
+                case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+                    auto n = signed_n(1 << (op - 0xD0), start);
+                    if (!n) return std::unexpected(n.error());
+                    ok = h.on_number(static_cast<double>(*n));
+                    break;
+                }
+                case 0xD9:
+                case 0xDA:
+                case 0xDB: {
+                    auto n = unsigned_n(1 << (op - 0xD9), start);
+                    if (!n) return std::unexpected(n.error());
+                    auto s = str(*n, start);
+                    if (!s) return std::unexpected(s.error());
+                    ok = h.on_string(*s);
+                    break;
+                }
+                case 0xDC:
+                case 0xDD:
+                case 0xDE:
+                case 0xDF: {
+                    auto n = unsigned_n(op & 1 ? 4 : 2, start);
+                    if (!n) return std::unexpected(n.error());
+                    return open(op >= 0xDE, *n, start);
+                }
+                case 0xC1: return fail(ParseError::code::unexpected_character, start, "Invalid MessagePack opcode 0xc1");
+                default: return fail(ParseError::code::unsupported_type, start, "MessagePack ext types have no JSON equivalent");
+                }
+                if (!ok) return aborted();
+                return {};
+            }
+
+            expected_void run() {
+                do {
+                    if (auto r = item(); !r) return r;
+                    while (!stack.empty() && stack.back().remaining == 0) {
+                        bool is_map = stack.back().is_map;
+                        stack.pop_back();
+                        if (!(is_map ? h.on_end_object() : h.on_end_array())) return aborted();
+                    }
+                } while (!stack.empty());
+
+                if (p != end) return fail(ParseError::code::trailing_characters, p, "Trailing bytes after MessagePack item");
+                return {};
+            }
+        };
+
+        template<typename Handler>
+        expected_void decode_msgpack(std::span<const std::byte> bytes, Handler& h, const ParseOptions& opts) {
+            const auto* data = reinterpret_cast<const std::uint8_t*>(bytes.data());
+            MsgpackDecoder<Handler> dec{ data, data, data + bytes.size(), h, opts.max_depth };
+            return dec.run();
+        }
+    } // namespace detail
+
+    std::vector<std::byte> to_msgpack(const value& v) {
+        std::vector<std::byte> out;
+        to_msgpack(v, out);
+        return out;
+    }
+
+    void to_msgpack(const value& v, std::vector<std::byte>& out) {
+        detail::ByteVectorSink sink{ out };
+        detail::encode_msgpack(v, sink);
+    }
+
+    void to_msgpack(const value& v, std::ostream& os) {
+        detail::ByteStreamSink sink{ os };
+        detail::encode_msgpack(v, sink);
+    }
+
+    std::expected<value, ParseError> from_msgpack(std::span<const std::byte> bytes, std::pmr::memory_resource* res, const ParseOptions& opts) {
+        DomBuilder builder{ res };
+        if (auto r = detail::decode_msgpack(bytes, builder, opts); !r) return std::unexpected(std::move(r.error()));
+        return std::move(builder.result());
+    }
+
+    std::expected<void, ParseError> from_msgpack(std::span<const std::byte> bytes, SaxHandler& handler, const ParseOptions& opts) {
+        return detail::decode_msgpack(bytes, handler, opts);
+    }
+
+} // namespace Sonnet
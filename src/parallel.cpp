@@ -0,0 +1,99 @@
+#include "sonnet/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace Sonnet {
+
+    thread_executor::thread_executor(unsigned threads) noexcept
+        : m_Threads{ threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()) } {}
+
+    void thread_executor::bulk(std::size_t n, const std::function<void(std::size_t)>& f) const {
+        std::atomic<std::size_t> next{ 0 };
+        std::exception_ptr failure;
+        std::mutex failure_lock;
+
+        auto work = [&] {
+            for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;) {
+                try {
+                    f(i);
+                } catch (...) {
+                    std::scoped_lock lock{ failure_lock };
+                    if (!failure) failure = std::current_exception();
+                    next.store(n, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> workers;
+            const std::size_t extra = std::min<std::size_t>(m_Threads, n) - (n > 0 ? 1 : 0);
+            workers.reserve(extra);
+            for (std::size_t t = 0; t < extra; t++) workers.emplace_back(work);
+            work();
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    namespace detail {
+        std::optional<std::vector<ElementSpan>> split_array(std::string_view json) {
+            auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+            std::size_t i = 0;
+            auto skip_space = [&] {
+                while (i < json.size() && is_space(json[i])) i++;
+            };
+
+            skip_space();
+            if (i == json.size() || json[i] != '[') return std::nullopt;
+            i++;
+            skip_space();
+
+            std::vector<ElementSpan> spans;
+            if (i < json.size() && json[i] == ']') {
+                i++;
+            } else {
+                for (;;) {
+                    const std::size_t start = i;
+                    std::size_t depth = 0;
+                    for (; i < json.size(); i++) {
+                        const char c = json[i];
+                        if (c == '"') {
+                            // The string ends at the first quote not escaped
+                            for (i++; i < json.size() && json[i] != '"'; i++) {
+                                if (json[i] == '\\') i++;
+                            }
+                            if (i >= json.size()) return std::nullopt;
+                        } else if (c == '[' || c == '{') {
+                            depth++;
+                        } else if (c == ']' || c == '}') {
+                            if (depth == 0) break;
+                            depth--;
+                        } else if (c == ',' && depth == 0) {
+                            break;
+                        }
+                    }
+                    if (i == json.size()) return std::nullopt;
+
+                    std::size_t end = i;
+                    while (end > start && is_space(json[end - 1])) end--;
+                    spans.push_back({ start, end - start });
+
+                    const char sep = json[i++];
+                    if (sep == ']') break;
+                    if (sep != ',') return std::nullopt;
+                    skip_space();
+                }
+            }
+
+            skip_space();
+            if (i != json.size()) return std::nullopt;
+            return spans;
+        }
+    } // namespace detail
+
+} // namespace Sonnet
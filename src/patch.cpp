@@ -0,0 +1,387 @@
+#include "sonnet/patch.hpp"
+#include "sonnet/pointer.hpp"
+#include "equal.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        enum class patch_op : std::uint8_t { add, remove, replace, move, copy, test };
+
+        // A validated operation. `arg` points at the operation's `value`
+        // member inside the patch, which is mutable when the patch was
+        // passed by rvalue
+        template<typename V>
+        struct PatchOp {
+            patch_op kind = patch_op::test;
+            pointer path;
+            pointer from;
+            V* arg = nullptr;
+        };
+
+        // One change made to the target. Undoing an entry leaves the value
+        // it displaced in `Patcher::m_Carry`; a `carried` entry restores
+        // that value instead of its own, which is how `move` is undone
+        // without a copy. A `repack` entry packs the parent of `at` again
+        // after an operation had to unpack it
+        struct Undo {
+            enum class action : std::uint8_t { erase, insert, restore, repack };
+
+            action act = action::restore;
+            const pointer* at = nullptr;
+            std::size_t index = 0; ///< Array position for `erase` and `insert`
+            value old;
+            bool carried = false;
+        };
+
+        inline value take(const value& v) { return v; }
+        inline value take(value& v) { return std::move(v); }
+
+        inline std::unexpected<PatchError> patch_error(PatchError::code c, std::size_t op, std::string_view msg) {
+            return std::unexpected(PatchError{ c, op, std::string{ msg } });
+        }
+
+        // Whether the first @p len tokens of @p a and the tokens of @p b lie
+        // on one branch, i.e. one sequence is a prefix of the other
+        inline bool same_branch(const pointer& a, std::size_t len, const pointer& b) noexcept {
+            std::size_t n = std::min(len, b.size());
+            for (std::size_t i = 0; i < n; i++)
+                if (a.token(i) != b.token(i)) return false;
+            return true;
+        }
+
+        template<typename V>
+        std::expected<std::vector<PatchOp<V>>, PatchError> compile_patch(V& patch) {
+            using code = PatchError::code;
+            std::vector<PatchOp<V>> ops;
+            if (!patch.is_array() || patch.size() == 0) {
+                if (patch.is_array()) return ops;
+                return patch_error(code::invalid_patch, 0, "Patch is not an array");
+            }
+            if (patch.is_packed()) return patch_error(code::invalid_patch, 0, "Operation is not an object");
+
+            auto& arr = patch.as_array();
+            ops.reserve(arr.size());
+            for (std::size_t i = 0; i < arr.size(); i++) {
+                auto& e = arr[i];
+                if (!e.is_object()) return patch_error(code::invalid_patch, i, "Operation is not an object");
+
+                auto& obj = e.as_object();
+                auto member = [&](std::string_view k) -> V* {
+                    auto it = obj.find(k);
+                    return it == obj.end() ? nullptr : &it->second;
+                };
+                auto location = [&](std::string_view k) -> std::optional<pointer> {
+                    V* p = member(k);
+                    if (!p || !p->is_string()) return std::nullopt;
+                    return pointer::parse(p->as_string());
+                };
+
+                PatchOp<V>& op = ops.emplace_back();
+                V* name = member("op");
+                if (!name || !name->is_string()) return patch_error(code::invalid_patch, i, "Missing \"op\"");
+
+                std::string_view n = name->as_string();
+                if (n == "add") op.kind = patch_op::add;
+                else if (n == "remove") op.kind = patch_op::remove;
+                else if (n == "replace") op.kind = patch_op::replace;
+                else if (n == "move") op.kind = patch_op::move;
+                else if (n == "copy") op.kind = patch_op::copy;
+                else if (n == "test") op.kind = patch_op::test;
+                else return patch_error(code::invalid_patch, i, "Unknown \"op\"");
+
+                auto path = location("path");
+                if (!path) return patch_error(code::invalid_patch, i, "Missing or invalid \"path\"");
+                op.path = std::move(*path);
+
+                if (op.kind == patch_op::move || op.kind == patch_op::copy) {
+                    auto from = location("from");
+                    if (!from) return patch_error(code::invalid_patch, i, "Missing or invalid \"from\"");
+                    op.from = std::move(*from);
+                    if (op.kind == patch_op::move && op.from.size() < op.path.size() && same_branch(op.from, op.from.size(), op.path))
+                        return patch_error(code::invalid_patch, i, "Cannot move a value into one of its children");
+                }
+                if (op.kind == patch_op::add || op.kind == patch_op::replace || op.kind == patch_op::test) {
+                    op.arg = member("value");
+                    if (!op.arg) return patch_error(code::invalid_patch, i, "Missing \"value\"");
+                }
+            }
+            return ops;
+        }
+
+        // Whether operation @p w can change what is found at @p p: it writes
+        // inside, above or next to it
+        template<typename V>
+        bool writes_near(const PatchOp<V>& w, const pointer& p) noexcept {
+            auto near = [&](const pointer& q) { return q.empty() || same_branch(q, q.size() - 1, p); };
+            switch (w.kind) {
+            case patch_op::test: return false;
+            case patch_op::move: return near(w.from) || near(w.path);
+            default: return near(w.path);
+            }
+        }
+
+        // Applies operations to a document, logging how to undo each change
+        class Patcher {
+        public:
+            explicit Patcher(value& root) : m_Root{ root } {}
+
+            [[nodiscard]] std::string_view error() const noexcept { return m_Error; }
+            [[nodiscard]] bool test_failed() const noexcept { return m_TestFailed; }
+
+            template<typename V>
+            bool run(const PatchOp<V>& op) {
+                switch (op.kind) {
+                case patch_op::add: {
+                    value v = take(*op.arg);
+                    return add(op.path, v);
+                }
+                case patch_op::remove: {
+                    value out;
+                    if (!remove(op.path, out)) return false;
+                    m_Log.back().old = std::move(out);
+                    return true;
+                }
+                case patch_op::replace: {
+                    value* dst = find(op.path);
+                    if (!dst) return fail("\"path\" does not exist");
+                    log(Undo::action::restore, op.path, 0, std::exchange(*dst, take(*op.arg)));
+                    return true;
+                }
+                case patch_op::move: {
+                    if (op.from == op.path) return true;
+                    value v;
+                    if (!remove(op.from, v)) return false;
+                    m_Log.back().carried = true;
+                    if (add(op.path, v)) return true;
+                    m_Carry = std::move(v);
+                    return false;
+                }
+                case patch_op::copy: {
+                    const value* src = op.from.resolve(std::as_const(m_Root));
+                    if (!src) return fail("\"from\" does not exist");
+                    value v{ *src };
+                    return add(op.path, v);
+                }
+                case patch_op::test:
+                    return test(op.path, *op.arg);
+                }
+                return false;
+            }
+
+            bool test(const pointer& at, const value& expected) {
+                const value* v = at.resolve(std::as_const(m_Root));
+                if (v && json_equal(*v, expected)) return true;
+                m_TestFailed = true;
+                return fail("Test failed");
+            }
+
+            void rollback() {
+                for (auto it = m_Log.rbegin(); it != m_Log.rend(); ++it) undo(*it);
+                m_Log.clear();
+                m_Carry = value{};
+            }
+
+        private:
+            bool fail(std::string_view msg) {
+                m_Error = msg;
+                return false;
+            }
+
+            void log(Undo::action act, const pointer& at, std::size_t index, value old = value{}) {
+                Undo& u = m_Log.emplace_back();
+                u.act = act;
+                u.at = &at;
+                u.index = index;
+                u.old = std::move(old);
+            }
+
+            // The container holding @p at, with packed arrays unpacked so
+            // their elements can be written; the unpack is logged so a
+            // rollback packs the array again
+            value* parent_of(const pointer& at) {
+                value* parent = at.resolve_parent(m_Root);
+                if (parent && parent->is_packed()) {
+                    parent->unpack();
+                    log(Undo::action::repack, at, 0);
+                }
+                return parent;
+            }
+
+            value* find(const pointer& at) {
+                if (!at.empty()) parent_of(at);
+                return at.resolve(m_Root);
+            }
+
+            // Moves from @p v only on success
+            bool add(const pointer& at, value& v) {
+                if (at.empty()) {
+                    log(Undo::action::restore, at, 0, std::exchange(m_Root, std::move(v)));
+                    return true;
+                }
+
+                value* parent = parent_of(at);
+                if (!parent) return fail("Parent of \"path\" does not exist");
+                std::string_view key = at.token(at.size() - 1);
+                if (parent->is_object()) {
+                    auto& obj = parent->as_object();
+                    if (auto it = obj.find(key); it != obj.end()) {
+                        log(Undo::action::restore, at, 0, std::exchange(it->second, std::move(v)));
+                    } else {
+                        obj.emplace(string{ key, parent->resource() }, std::move(v));
+                        log(Undo::action::erase, at, 0);
+                    }
+                    return true;
+                }
+                if (!parent->is_array()) return fail("Parent of \"path\" is not a container");
+
+                auto& arr = parent->as_array();
+                std::size_t idx = key == "-" ? arr.size() : at.index(at.size() - 1);
+                if (idx == pointer::npos || idx > arr.size()) return fail("Array index out of range");
+                arr.insert(arr.begin() + static_cast<std::ptrdiff_t>(idx), std::move(v));
+                log(Undo::action::erase, at, idx);
+                return true;
+            }
+
+            // Moves the removed value into @p out; the caller decides what
+            // the undo entry restores
+            bool remove(const pointer& at, value& out) {
+                if (at.empty()) return fail("Cannot remove the root");
+                value* parent = parent_of(at);
+                if (parent && parent->is_object()) {
+                    auto& obj = parent->as_object();
+                    auto it = obj.find(at.token(at.size() - 1));
+                    if (it == obj.end()) return fail("Location does not exist");
+                    out = std::move(it->second);
+                    obj.erase(it);
+                    log(Undo::action::insert, at, 0);
+                    return true;
+                }
+                if (!parent || !parent->is_array()) return fail("Location does not exist");
+
+                auto& arr = parent->as_array();
+                std::size_t idx = at.index(at.size() - 1);
+                if (idx >= arr.size()) return fail("Location does not exist");
+                out = std::move(arr[idx]);
+                arr.erase(arr.begin() + static_cast<std::ptrdiff_t>(idx));
+                log(Undo::action::insert, at, idx);
+                return true;
+            }
+
+            void undo(Undo& u) {
+                if (u.act == Undo::action::repack) {
+                    (void)u.at->resolve_parent(m_Root)->pack();
+                    return;
+                }
+
+                value old = u.carried ? std::move(m_Carry) : std::move(u.old);
+                value displaced;
+                if (u.act == Undo::action::restore) {
+                    displaced = std::exchange(*u.at->resolve(m_Root), std::move(old));
+                    m_Carry = std::move(displaced);
+                    return;
+                }
+
+                value* parent = u.at->resolve_parent(m_Root);
+                std::string_view key = u.at->token(u.at->size() - 1);
+                if (parent->is_object()) {
+                    auto& obj = parent->as_object();
+                    if (u.act == Undo::action::insert) {
+                        obj.emplace(string{ key, parent->resource() }, std::move(old));
+                    } else {
+                        auto it = obj.find(key);
+                        displaced = std::move(it->second);
+                        obj.erase(it);
+                    }
+                } else {
+                    auto& arr = parent->as_array();
+                    auto pos = arr.begin() + static_cast<std::ptrdiff_t>(u.index);
+                    if (u.act == Undo::action::insert) {
+                        arr.insert(pos, std::move(old));
+                    } else {
+                        displaced = std::move(*pos);
+                        arr.erase(pos);
+                    }
+                }
+                m_Carry = std::move(displaced);
+            }
+
+            value& m_Root;
+            std::vector<Undo> m_Log;
+            value m_Carry;
+            std::string_view m_Error;
+            bool m_TestFailed = false;
+        };
+
+        template<typename V>
+        std::expected<void, PatchError> apply_patch(value& target, V& patch) {
+            auto ops = compile_patch(patch);
+            if (!ops) return std::unexpected(std::move(ops.error()));
+
+            // Tests that no earlier operation can affect are checked before
+            // anything is changed
+            Patcher patcher{ target };
+            std::vector<std::uint8_t> done(ops->size(), 0);
+            for (std::size_t i = 0; i < ops->size(); i++) {
+                const auto& op = (*ops)[i];
+                if (op.kind != patch_op::test) continue;
+                bool affected = std::any_of(ops->begin(), ops->begin() + static_cast<std::ptrdiff_t>(i),
+                                            [&](const PatchOp<V>& w) { return writes_near(w, op.path); });
+                if (affected) continue;
+                if (!patcher.test(op.path, *op.arg)) return patch_error(PatchError::code::test_failed, i, patcher.error());
+                done[i] = 1;
+            }
+
+            for (std::size_t i = 0; i < ops->size(); i++) {
+                if (done[i] || patcher.run((*ops)[i])) continue;
+                patcher.rollback();
+                auto c = patcher.test_failed() ? PatchError::code::test_failed : PatchError::code::path_not_found;
+                return patch_error(c, i, patcher.error());
+            }
+            return {};
+        }
+
+        template<typename V>
+        void merge_patch(value& target, V& patch) {
+            if (!patch.is_object()) {
+                target = take(patch);
+                return;
+            }
+            if (!target.is_object()) target = value{ object{ std::less<>{}, target.resource() }, target.resource() };
+
+            auto& obj = target.as_object();
+            for (auto& [k, v] : patch.as_object()) {
+                auto it = obj.find(std::string_view{ k });
+                if (v.is_null()) {
+                    if (it != obj.end()) obj.erase(it);
+                    continue;
+                }
+                if (it == obj.end()) it = obj.emplace(string{ k, target.resource() }, value{ target.resource() }).first;
+                merge_patch(it->second, v);
+            }
+        }
+    } // namespace detail
+
+    std::expected<void, PatchError> apply_patch(value& target, const value& patch) {
+        return detail::apply_patch(target, patch);
+    }
+
+    std::expected<void, PatchError> apply_patch(value& target, value&& patch) {
+        return detail::apply_patch(target, patch);
+    }
+
+    void apply_merge_patch(value& target, const value& patch) {
+        detail::merge_patch(target, patch);
+    }
+
+    void apply_merge_patch(value& target, value&& patch) {
+        detail::merge_patch(target, patch);
+    }
+
+} // namespace Sonnet
@@ -0,0 +1,166 @@
+#include "sonnet/pointer.hpp"
+
+#include <charconv>
+#include <stdexcept>
+
+
+namespace Sonnet {
+
+    namespace detail {
+        // Array index tokens are "0" or digits without a leading zero
+        inline size_t token_index(std::string_view t, size_t none) noexcept {
+            if (t.empty() || (t.size() > 1 && t.front() == '0')) return none;
+            size_t idx = 0;
+            auto [p, ec] = std::from_chars(t.data(), t.data() + t.size(), idx);
+            if (ec != std::errc{} || p != t.data() + t.size()) return none;
+            return idx;
+        }
+    } // namespace detail
+
+    pointer::pointer(std::string_view text) {
+        auto p = parse(text);
+        if (!p) throw std::invalid_argument{ "Sonnet::pointer: invalid JSON Pointer" };
+        *this = std::move(*p);
+    }
+
+    std::optional<pointer> pointer::parse(std::string_view text) {
+        pointer p;
+        if (text.empty()) return p;
+        if (text.front() != '/') return std::nullopt;
+
+        size_t pos = 1;
+        while (true) {
+            size_t end = text.find('/', pos);
+            if (end == std::string_view::npos) end = text.size();
+
+            Token t;
+            t.key.reserve(end - pos);
+            for (size_t i = pos; i < end; i++) {
+                char c = text[i];
+                if (c != '~') {
+                    t.key.push_back(c);
+                    continue;
+                }
+                if (i + 1 >= end) return std::nullopt;
+                char e = text[++i];
+                if (e == '0') t.key.push_back('~');
+                else if (e == '1') t.key.push_back('/');
+                else return std::nullopt;
+            }
+            t.index = detail::token_index(t.key, npos);
+            p.m_Tokens.push_back(std::move(t));
+
+            if (end == text.size()) return p;
+            pos = end + 1;
+        }
+    }
+
+    std::string pointer::to_string() const {
+        std::string out;
+        for (const auto& t : m_Tokens) {
+            out.push_back('/');
+            for (char c : t.key) {
+                if (c == '~') out += "~0";
+                else if (c == '/') out += "~1";
+                else out.push_back(c);
+            }
+        }
+        return out;
+    }
+
+    const value* pointer::resolve_prefix(const value& root, size_t count) const {
+        const value* cur = &root;
+        for (size_t i = 0; i < count; i++) {
+            const Token& t = m_Tokens[i];
+            if (cur->is_object()) {
+                const auto& obj = cur->as_object();
+                auto it = obj.find(std::string_view{ t.key });
+                if (it == obj.end()) return nullptr;
+                cur = &it->second;
+            } else if (cur->is_array()) {
+                const auto& arr = cur->as_array();
+                if (t.index >= arr.size()) return nullptr;
+                cur = &arr[t.index];
+            } else return nullptr;
+        }
+        return cur;
+    }
+
+    // Walks through the mutable storage of every container on the way, so
+    // shared subtrees are copied before the caller can modify a child
+    value* pointer::resolve_prefix(value& root, size_t count) const {
+        value* cur = &root;
+        for (size_t i = 0; i < count; i++) {
+            const Token& t = m_Tokens[i];
+            auto& s = cur->storage();
+            if (auto* obj = std::get_if<object>(&s)) {
+                auto it = obj->find(std::string_view{ t.key });
+                if (it == obj->end()) return nullptr;
+                cur = &it->second;
+            } else if (auto* arr = std::get_if<array>(&s)) {
+                if (t.index >= arr->size()) return nullptr;
+                cur = &(*arr)[t.index];
+            } else return nullptr;
+        }
+        if (cur->is_array() || cur->is_object()) (void)cur->storage();
+        return cur;
+    }
+
+    const value* pointer::resolve(const value& root) const {
+        return resolve_prefix(root, m_Tokens.size());
+    }
+
+    value* pointer::resolve(value& root) const {
+        return resolve_prefix(root, m_Tokens.size());
+    }
+
+    value* pointer::resolve_parent(value& root) const {
+        if (m_Tokens.empty()) return nullptr;
+        return resolve_prefix(root, m_Tokens.size() - 1);
+    }
+
+    value& pointer::set(value& root, value v) const {
+        value* cur = &root;
+        for (const auto& t : m_Tokens) {
+            if (cur->is_array()) {
+                size_t idx = t.key == "-" ? cur->size() : t.index;
+                if (idx == npos) throw std::invalid_argument{ "Sonnet::pointer::set: array step is not an index" };
+                cur = &(*cur)[idx];
+                continue;
+            }
+
+            auto& obj = cur->as_object();
+            auto it = obj.find(std::string_view{ t.key });
+            if (it == obj.end()) it = obj.emplace(string{ t.key, cur->resource() }, value{ cur->resource() }).first;
+            cur = &it->second;
+        }
+        *cur = std::move(v);
+        return *cur;
+    }
+
+    bool pointer::erase(value& root) const {
+        value* parent = resolve_parent(root);
+        if (!parent) return false;
+
+        const Token& last = m_Tokens.back();
+        if (parent->is_object()) {
+            auto& obj = parent->as_object();
+            auto it = obj.find(std::string_view{ last.key });
+            if (it == obj.end()) return false;
+            obj.erase(it);
+            return true;
+        }
+        if (!parent->is_array() || last.index >= parent->size()) return false;
+
+        // Packed arrays lose an element without being unpacked
+        if (parent->is_packed()) {
+            auto& nums = std::get<packed_array>(parent->storage()).nums;
+            nums.erase(nums.begin() + static_cast<std::ptrdiff_t>(last.index));
+            return true;
+        }
+        auto& arr = parent->as_array();
+        arr.erase(arr.begin() + static_cast<std::ptrdiff_t>(last.index));
+        return true;
+    }
+
+} // namespace Sonnet
@@ -0,0 +1,311 @@
+#include "sonnet/reduce.hpp"
+#include "sonnet/pointer.hpp"
+
+#include <bit>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SONNET_HAS_AVX2 1
+#define SONNET_AVX2_RUNTIME 1
+#define SONNET_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SONNET_HAS_AVX2 1
+#define SONNET_AVX2_RUNTIME 0
+#define SONNET_TARGET_AVX2
+#else
+#define SONNET_HAS_AVX2 0
+#endif
+
+
+namespace Sonnet::reduce {
+
+    namespace detail {
+        using numbers = std::span<const double>;
+
+        struct Extremes {
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+        };
+
+        // Scalar kernels, also used for the tails of the vector kernels
+        double sum_scalar(const double* p, size_t n) noexcept {
+            double s = 0.0;
+            for (size_t i = 0; i < n; i++) s += p[i];
+            return s;
+        }
+
+        void extremes_scalar(const double* p, size_t n, Extremes& e) noexcept {
+            for (size_t i = 0; i < n; i++) {
+                if (p[i] < e.min) e.min = p[i];
+                if (p[i] > e.max) e.max = p[i];
+            }
+        }
+
+        bool test(double x, compare op, double t) noexcept {
+            switch (op) {
+            case compare::less: return x < t;
+            case compare::less_equal: return x <= t;
+            case compare::greater: return x > t;
+            case compare::greater_equal: return x >= t;
+            }
+            return false;
+        }
+
+        size_t count_scalar(const double* p, size_t n, compare op, double t) noexcept {
+            size_t c = 0;
+            for (size_t i = 0; i < n; i++) c += test(p[i], op, t);
+            return c;
+        }
+
+#if SONNET_HAS_AVX2
+        bool has_avx2() noexcept {
+#if SONNET_AVX2_RUNTIME
+            static const bool yes = __builtin_cpu_supports("avx2");
+            return yes;
+#else
+            return true;
+#endif
+        }
+
+        SONNET_TARGET_AVX2 double sum_avx2(const double* p, size_t n) noexcept {
+            __m256d a0 = _mm256_setzero_pd();
+            __m256d a1 = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+                a1 = _mm256_add_pd(a1, _mm256_loadu_pd(p + i + 4));
+            }
+            a0 = _mm256_add_pd(a0, a1);
+            if (i + 4 <= n) {
+                a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+                i += 4;
+            }
+
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, a0);
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sum_scalar(p + i, n - i);
+        }
+
+        // minpd/maxpd return their second operand when either is NaN, so
+        // keeping the accumulator second skips NaN elements
+        SONNET_TARGET_AVX2 void extremes_avx2(const double* p, size_t n, Extremes& e) noexcept {
+            __m256d lo = _mm256_set1_pd(e.min);
+            __m256d hi = _mm256_set1_pd(e.max);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d x = _mm256_loadu_pd(p + i);
+                lo = _mm256_min_pd(x, lo);
+                hi = _mm256_max_pd(x, hi);
+            }
+
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, lo);
+            for (double d : lanes) e.min = d < e.min ? d : e.min;
+            _mm256_store_pd(lanes, hi);
+            for (double d : lanes) e.max = d > e.max ? d : e.max;
+            extremes_scalar(p + i, n - i, e);
+        }
+
+        template<int Pred>
+        SONNET_TARGET_AVX2 size_t count_avx2(const double* p, size_t n, double t) noexcept {
+            const __m256d thr = _mm256_set1_pd(t);
+            size_t c = 0;
+            for (size_t i = 0; i + 4 <= n; i += 4) {
+                __m256d hits = _mm256_cmp_pd(_mm256_loadu_pd(p + i), thr, Pred);
+                c += static_cast<size_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_pd(hits))));
+            }
+            return c;
+        }
+#endif
+
+        double sum(numbers s) noexcept {
+#if SONNET_HAS_AVX2
+            if (has_avx2()) return sum_avx2(s.data(), s.size());
+#endif
+            return sum_scalar(s.data(), s.size());
+        }
+
+        void extremes(numbers s, Extremes& e) noexcept {
+#if SONNET_HAS_AVX2
+            if (has_avx2()) return extremes_avx2(s.data(), s.size(), e);
+#endif
+            extremes_scalar(s.data(), s.size(), e);
+        }
+
+        size_t count_if(numbers s, compare op, double t) noexcept {
+#if SONNET_HAS_AVX2
+            if (has_avx2()) {
+                size_t tail = s.size() & ~size_t{ 3 };
+                size_t rest = count_scalar(s.data() + tail, s.size() - tail, op, t);
+                switch (op) {
+                case compare::less: return count_avx2<_CMP_LT_OQ>(s.data(), tail, t) + rest;
+                case compare::less_equal: return count_avx2<_CMP_LE_OQ>(s.data(), tail, t) + rest;
+                case compare::greater: return count_avx2<_CMP_GT_OQ>(s.data(), tail, t) + rest;
+                case compare::greater_equal: return count_avx2<_CMP_GE_OQ>(s.data(), tail, t) + rest;
+                }
+            }
+#endif
+            return count_scalar(s.data(), s.size(), op, t);
+        }
+
+        // Hands the numbers of @p arr to @p packed in one span if the array
+        // is packed, otherwise to @p each one element at a time
+        template<typename Packed, typename Each>
+        void for_each_number(const value& arr, Packed&& packed, Each&& each) {
+            if (arr.is_packed()) {
+                packed(arr.numbers());
+                return;
+            }
+            if (!arr.is_array()) return;
+            for (const auto& e : arr.as_array()) {
+                if (e.is_number()) each(e.as_number());
+            }
+        }
+
+        std::vector<double> gather(const value& rows, const pointer& field) {
+            std::vector<double> out;
+            if (!rows.is_array()) return out;
+
+            // The rows of a packed array are its numbers, which only the
+            // empty pointer resolves in
+            if (rows.is_packed()) {
+                if (field.empty()) out.assign(rows.numbers().begin(), rows.numbers().end());
+                return out;
+            }
+
+            out.reserve(rows.size());
+            for (const auto& row : rows.as_array()) {
+                const value* v = field.resolve(row);
+                if (v && v->is_number()) out.push_back(v->as_number());
+            }
+            return out;
+        }
+
+        // An accumulator still at its starting infinity means either no
+        // numbers or an actual infinity in the data
+        std::optional<double> finish_min(const Extremes& e, numbers hint) noexcept {
+            if (e.min != std::numeric_limits<double>::infinity()) return e.min;
+            for (double d : hint) if (d == e.min) return e.min;
+            return std::nullopt;
+        }
+
+        std::optional<double> finish_max(const Extremes& e, numbers hint) noexcept {
+            if (e.max != -std::numeric_limits<double>::infinity()) return e.max;
+            for (double d : hint) if (d == e.max) return e.max;
+            return std::nullopt;
+        }
+
+        std::vector<size_t> histogram(numbers s, double lo, double hi, size_t bins) {
+            if (bins == 0 || !(lo < hi)) throw std::invalid_argument{ "Sonnet::reduce::histogram: requires bins > 0 and lo < hi" };
+
+            std::vector<size_t> out(bins, 0);
+            const double scale = static_cast<double>(bins) / (hi - lo);
+            for (double d : s) {
+                if (!(d >= lo && d <= hi)) continue;
+                auto bin = static_cast<size_t>((d - lo) * scale);
+                out[bin < bins ? bin : bins - 1]++;
+            }
+            return out;
+        }
+    } // namespace detail
+
+    double sum(const value& arr) noexcept {
+        double s = 0.0;
+        detail::for_each_number(arr, [&](detail::numbers n) { s = detail::sum(n); }, [&](double d) { s += d; });
+        return s;
+    }
+
+    size_t count(const value& arr) noexcept {
+        size_t c = 0;
+        detail::for_each_number(arr, [&](detail::numbers n) { c = n.size(); }, [&](double) { c++; });
+        return c;
+    }
+
+    std::optional<double> mean(const value& arr) noexcept {
+        size_t c = 0;
+        double s = 0.0;
+        detail::for_each_number(arr, [&](detail::numbers n) { c = n.size(); s = detail::sum(n); }, [&](double d) { c++; s += d; });
+        if (c == 0) return std::nullopt;
+        return s / static_cast<double>(c);
+    }
+
+    std::optional<double> min(const value& arr) noexcept {
+        if (arr.is_packed()) {
+            detail::Extremes e;
+            detail::extremes(arr.numbers(), e);
+            return detail::finish_min(e, arr.numbers());
+        }
+
+        std::optional<double> m;
+        detail::for_each_number(arr, [](detail::numbers) {}, [&](double d) { if (!m || d < *m) m = d; });
+        return m;
+    }
+
+    std::optional<double> max(const value& arr) noexcept {
+        if (arr.is_packed()) {
+            detail::Extremes e;
+            detail::extremes(arr.numbers(), e);
+            return detail::finish_max(e, arr.numbers());
+        }
+
+        std::optional<double> m;
+        detail::for_each_number(arr, [](detail::numbers) {}, [&](double d) { if (!m || d > *m) m = d; });
+        return m;
+    }
+
+    size_t count_if(const value& arr, compare op, double threshold) noexcept {
+        size_t c = 0;
+        detail::for_each_number(arr, [&](detail::numbers n) { c = detail::count_if(n, op, threshold); },
+                           [&](double d) { c += detail::test(d, op, threshold); });
+        return c;
+    }
+
+    std::vector<size_t> histogram(const value& arr, double lo, double hi, size_t bins) {
+        if (arr.is_packed()) return detail::histogram(arr.numbers(), lo, hi, bins);
+
+        std::vector<double> nums;
+        detail::for_each_number(arr, [](detail::numbers) {}, [&](double d) { nums.push_back(d); });
+        return detail::histogram(nums, lo, hi, bins);
+    }
+
+    double sum(const value& rows, const pointer& field) {
+        return detail::sum(detail::gather(rows, field));
+    }
+
+    size_t count(const value& rows, const pointer& field) {
+        return detail::gather(rows, field).size();
+    }
+
+    std::optional<double> mean(const value& rows, const pointer& field) {
+        auto nums = detail::gather(rows, field);
+        if (nums.empty()) return std::nullopt;
+        return detail::sum(nums) / static_cast<double>(nums.size());
+    }
+
+    std::optional<double> min(const value& rows, const pointer& field) {
+        auto nums = detail::gather(rows, field);
+        detail::Extremes e;
+        detail::extremes(nums, e);
+        return detail::finish_min(e, nums);
+    }
+
+    std::optional<double> max(const value& rows, const pointer& field) {
+        auto nums = detail::gather(rows, field);
+        detail::Extremes e;
+        detail::extremes(nums, e);
+        return detail::finish_max(e, nums);
+    }
+
+    size_t count_if(const value& rows, const pointer& field, compare op, double threshold) {
+        return detail::count_if(detail::gather(rows, field), op, threshold);
+    }
+
+    std::vector<size_t> histogram(const value& rows, const pointer& field, double lo, double hi, size_t bins) {
+        return detail::histogram(detail::gather(rows, field), lo, hi, bins);
+    }
+
+} // namespace Sonnet::reduce
@@ -0,0 +1,532 @@
+#include "regex.hpp"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace Sonnet::detail {
+
+    namespace {
+        constexpr std::uint32_t unbounded = std::numeric_limits<std::uint32_t>::max();
+        constexpr std::size_t max_nesting = 256;
+        constexpr std::size_t max_program = 1 << 16;
+        constexpr char32_t replacement = 0xFFFD;
+
+        // Decodes the code point at `s[i]`; bytes that do not start a
+        // valid sequence read as U+FFFD one at a time
+        char32_t decode(std::string_view s, std::size_t i, std::size_t& len) noexcept {
+            const auto b = [&](std::size_t k) { return static_cast<unsigned char>(s[i + k]); };
+            const unsigned char c = b(0);
+            len = 1;
+            if (c < 0x80) return c;
+
+            std::size_t n = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0;
+            if (n == 0 || i + n > s.size()) return replacement;
+            char32_t cp = c & (0x7F >> n);
+            for (std::size_t k = 1; k < n; k++) {
+                if ((b(k) & 0xC0) != 0x80) return replacement;
+                cp = (cp << 6) | (b(k) & 0x3F);
+            }
+            len = n;
+            return cp;
+        }
+
+        bool is_word(char32_t c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        using Ranges = std::vector<std::pair<char32_t, char32_t>>;
+
+        const Ranges digit_ranges{ { '0', '9' } };
+        const Ranges word_ranges{ { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } };
+        const Ranges space_ranges{
+            { 0x09, 0x0D }, { 0x20, 0x20 }, { 0xA0, 0xA0 }, { 0x1680, 0x1680 }, { 0x2000, 0x200A },
+            { 0x2028, 0x2029 }, { 0x202F, 0x202F }, { 0x205F, 0x205F }, { 0x3000, 0x3000 }, { 0xFEFF, 0xFEFF },
+        };
+
+        // The complement of sorted, non-overlapping ranges
+        Ranges complement(const Ranges& r) {
+            Ranges out;
+            char32_t next = 0;
+            for (auto [lo, hi] : r) {
+                if (lo > next) out.emplace_back(next, lo - 1);
+                next = hi + 1;
+            }
+            if (next <= 0x10FFFF) out.emplace_back(next, 0x10FFFF);
+            return out;
+        }
+
+        struct Node {
+            enum class kind : std::uint8_t { empty, chr, set, any, concat, alt, repeat, begin, end, word, not_word };
+
+            kind k = kind::empty;
+            char32_t c = 0;
+            std::uint32_t set = 0;
+            std::uint32_t min = 0;
+            std::uint32_t max = 0;
+            std::vector<Node> kids;
+        };
+
+        class Parser {
+        public:
+            Parser(std::u32string_view p, std::vector<Regex::CharSet>& sets) : m_P{ p }, m_Sets{ sets } {}
+
+            std::expected<Node, std::string> parse() {
+                Node n = alternation(0);
+                if (m_Error.empty() && m_I < m_P.size()) m_Error = "unmatched ')'";
+                if (!m_Error.empty()) return std::unexpected(std::move(m_Error));
+                return n;
+            }
+
+        private:
+            bool done() const noexcept { return m_I >= m_P.size(); }
+            char32_t peek() const noexcept { return m_P[m_I]; }
+
+            Node fail(std::string msg) {
+                if (m_Error.empty()) m_Error = std::move(msg);
+                m_I = m_P.size();
+                return {};
+            }
+
+            Node alternation(std::size_t depth) {
+                if (depth > max_nesting) return fail("pattern nests too deeply");
+                Node first = concatenation(depth);
+                if (done() || peek() != '|') return first;
+
+                Node alt;
+                alt.k = Node::kind::alt;
+                alt.kids.push_back(std::move(first));
+                while (!done() && peek() == '|') {
+                    m_I++;
+                    alt.kids.push_back(concatenation(depth));
+                }
+                return alt;
+            }
+
+            Node concatenation(std::size_t depth) {
+                Node cat;
+                cat.k = Node::kind::concat;
+                while (!done() && peek() != '|' && peek() != ')') cat.kids.push_back(term(depth));
+                return cat;
+            }
+
+            Node term(std::size_t depth) {
+                const char32_t c = peek();
+                Node atom;
+                bool assertion = false;
+                if (c == '^' || c == '$') {
+                    m_I++;
+                    atom.k = c == '^' ? Node::kind::begin : Node::kind::end;
+                    assertion = true;
+                } else if (c == '\\' && m_I + 1 < m_P.size() && (m_P[m_I + 1] == 'b' || m_P[m_I + 1] == 'B')) {
+                    atom.k = m_P[m_I + 1] == 'b' ? Node::kind::word : Node::kind::not_word;
+                    m_I += 2;
+                    assertion = true;
+                } else {
+                    atom = this->atom(depth);
+                }
+                if (!m_Error.empty()) return {};
+
+                std::uint32_t min = 0, max = 0;
+                if (!quantifier(min, max)) return atom;
+                if (assertion) return fail("nothing to repeat");
+                if (max < min) return fail("numbers out of order in {} quantifier");
+                if (!done() && peek() == '?') m_I++; // lazy: the same for a yes/no search
+
+                Node rep;
+                rep.k = Node::kind::repeat;
+                rep.min = min;
+                rep.max = max;
+                rep.kids.push_back(std::move(atom));
+                return rep;
+            }
+
+            bool quantifier(std::uint32_t& min, std::uint32_t& max) {
+                if (done()) return false;
+                switch (peek()) {
+                case '*': m_I++; min = 0; max = unbounded; return true;
+                case '+': m_I++; min = 1; max = unbounded; return true;
+                case '?': m_I++; min = 0; max = 1; return true;
+                case '{': break;
+                default: return false;
+                }
+
+                // `{` that does not start a valid quantifier is a literal
+                std::size_t i = m_I + 1;
+                auto number = [&](std::uint32_t& out) {
+                    const std::size_t start = i;
+                    std::uint64_t v = 0;
+                    while (i < m_P.size() && m_P[i] >= '0' && m_P[i] <= '9') {
+                        v = std::min<std::uint64_t>(v * 10 + (m_P[i] - '0'), unbounded - 1);
+                        i++;
+                    }
+                    out = static_cast<std::uint32_t>(v);
+                    return i > start;
+                };
+                if (!number(min)) return false;
+                max = min;
+                if (i < m_P.size() && m_P[i] == ',') {
+                    i++;
+                    if (!number(max)) max = unbounded;
+                }
+                if (i >= m_P.size() || m_P[i] != '}') return false;
+                m_I = i + 1;
+                return true;
+            }
+
+            Node atom(std::size_t depth) {
+                const char32_t c = m_P[m_I++];
+                Node n;
+                switch (c) {
+                case '(': {
+                    if (!done() && peek() == '?') {
+                        if (m_I + 1 < m_P.size() && m_P[m_I + 1] == ':') {
+                            m_I += 2;
+                        } else if (m_I + 1 < m_P.size() && m_P[m_I + 1] == '<' && m_I + 2 < m_P.size() && m_P[m_I + 2] != '=' && m_P[m_I + 2] != '!') {
+                            m_I = m_P.find('>', m_I);
+                            if (m_I == std::u32string_view::npos) return fail("unterminated group name");
+                            m_I++;
+                        } else {
+                            return fail("lookaround assertions are not supported");
+                        }
+                    }
+                    n = alternation(depth + 1);
+                    if (done() || peek() != ')') return fail("missing ')'");
+                    m_I++;
+                    return n;
+                }
+                case ')':
+                    return fail("unmatched ')'");
+                case '*': case '+': case '?':
+                    return fail("nothing to repeat");
+                case '{': {
+                    std::uint32_t min = 0, max = 0;
+                    m_I--;
+                    if (quantifier(min, max)) return fail("nothing to repeat");
+                    m_I++;
+                    return literal(c);
+                }
+                case '.':
+                    n.k = Node::kind::any;
+                    return n;
+                case '[':
+                    return char_class();
+                case '\\':
+                    return escape();
+                default:
+                    return literal(c);
+                }
+            }
+
+            Node literal(char32_t c) {
+                Node n;
+                n.k = Node::kind::chr;
+                n.c = c;
+                return n;
+            }
+
+            Node set(Ranges ranges, bool negated) {
+                std::ranges::sort(ranges);
+                Ranges merged;
+                for (auto r : ranges) {
+                    if (!merged.empty() && r.first <= merged.back().second + 1) merged.back().second = std::max(merged.back().second, r.second);
+                    else merged.push_back(r);
+                }
+                m_Sets.push_back({ std::move(merged), negated });
+                Node n;
+                n.k = Node::kind::set;
+                n.set = static_cast<std::uint32_t>(m_Sets.size() - 1);
+                return n;
+            }
+
+            // Parses the escape after a backslash into a single code point,
+            // or into `ranges` for class escapes; `in_class` treats `\b` as
+            // backspace
+            bool escape_into(char32_t& cp, Ranges& ranges, bool& is_class, bool in_class) {
+                if (done()) {
+                    fail("\\ at end of pattern");
+                    return false;
+                }
+                const char32_t c = m_P[m_I++];
+                is_class = false;
+                switch (c) {
+                case 'd': is_class = true; ranges = digit_ranges; return true;
+                case 'D': is_class = true; ranges = complement(digit_ranges); return true;
+                case 'w': is_class = true; ranges = word_ranges; return true;
+                case 'W': is_class = true; ranges = complement(word_ranges); return true;
+                case 's': is_class = true; ranges = space_ranges; return true;
+                case 'S': is_class = true; ranges = complement(space_ranges); return true;
+                case 't': cp = '\t'; return true;
+                case 'n': cp = '\n'; return true;
+                case 'r': cp = '\r'; return true;
+                case 'f': cp = '\f'; return true;
+                case 'v': cp = '\v'; return true;
+                case 'b':
+                    if (!in_class) break;
+                    cp = '\b';
+                    return true;
+                case '0':
+                    if (!done() && peek() >= '0' && peek() <= '9') break;
+                    cp = 0;
+                    return true;
+                case 'c':
+                    if (done() || !((peek() >= 'a' && peek() <= 'z') || (peek() >= 'A' && peek() <= 'Z'))) break;
+                    cp = m_P[m_I++] % 32;
+                    return true;
+                case 'x':
+                    return hex(cp, 2);
+                case 'u':
+                    return hex(cp, 4);
+                default:
+                    if (c >= '1' && c <= '9') {
+                        fail("backreferences are not supported");
+                        return false;
+                    }
+                    if (is_word(c)) break;
+                    cp = c; // identity escape of a syntax character
+                    return true;
+                }
+                fail("invalid escape");
+                return false;
+            }
+
+            bool hex(char32_t& cp, std::size_t digits) {
+                cp = 0;
+                for (std::size_t k = 0; k < digits; k++) {
+                    if (done()) return fail("invalid escape"), false;
+                    const char32_t h = m_P[m_I++];
+                    std::uint32_t d = 0;
+                    if (h >= '0' && h <= '9') d = h - '0';
+                    else if (h >= 'a' && h <= 'f') d = h - 'a' + 10;
+                    else if (h >= 'A' && h <= 'F') d = h - 'A' + 10;
+                    else return fail("invalid escape"), false;
+                    cp = (cp << 4) | d;
+                }
+                return true;
+            }
+
+            Node escape() {
+                char32_t cp = 0;
+                Ranges ranges;
+                bool is_class = false;
+                if (!escape_into(cp, ranges, is_class, false)) return {};
+                return is_class ? set(std::move(ranges), false) : literal(cp);
+            }
+
+            Node char_class() {
+                bool negated = false;
+                if (!done() && peek() == '^') {
+                    negated = true;
+                    m_I++;
+                }
+
+                Ranges ranges;
+                // Reads one class atom: a code point, or a class escape
+                // whose ranges are added directly (it cannot bound a range)
+                auto class_atom = [&](char32_t& cp) {
+                    const char32_t c = m_P[m_I++];
+                    if (c != '\\') {
+                        cp = c;
+                        return 1;
+                    }
+                    Ranges escaped;
+                    bool is_class = false;
+                    if (!escape_into(cp, escaped, is_class, true)) return 0;
+                    if (!is_class) return 1;
+                    ranges.insert(ranges.end(), escaped.begin(), escaped.end());
+                    return 2;
+                };
+
+                while (!done() && peek() != ']') {
+                    char32_t lo = 0;
+                    const int first = class_atom(lo);
+                    if (first == 0) return {};
+                    if (first == 2) continue;
+                    if (m_I + 1 < m_P.size() && peek() == '-' && m_P[m_I + 1] != ']') {
+                        m_I++;
+                        char32_t hi = 0;
+                        const int second = class_atom(hi);
+                        if (second == 0) return {};
+                        if (second == 2) {
+                            // `[a-\d]` keeps `a` and `-` as literals
+                            ranges.emplace_back(lo, lo);
+                            ranges.emplace_back('-', '-');
+                            continue;
+                        }
+                        if (hi < lo) return fail("range out of order in character class");
+                        ranges.emplace_back(lo, hi);
+                    } else {
+                        ranges.emplace_back(lo, lo);
+                    }
+                }
+                if (done()) return fail("missing ']'");
+                m_I++;
+                return set(std::move(ranges), negated);
+            }
+
+            std::u32string_view m_P;
+            std::size_t m_I = 0;
+            std::vector<Regex::CharSet>& m_Sets;
+            std::string m_Error;
+        };
+
+        class Emitter {
+        public:
+            explicit Emitter(std::vector<Regex::Inst>& prog) : m_Prog{ prog } {}
+
+            bool emit(const Node& n) {
+                using op = Regex::Inst::op;
+                switch (n.k) {
+                case Node::kind::empty: return true;
+                case Node::kind::chr: return push({ op::chr, n.c, 0, 0 });
+                case Node::kind::set: return push({ op::set, 0, n.set, 0 });
+                case Node::kind::any: return push({ op::any, 0, 0, 0 });
+                case Node::kind::begin: return push({ op::begin, 0, 0, 0 });
+                case Node::kind::end: return push({ op::end, 0, 0, 0 });
+                case Node::kind::word: return push({ op::word, 0, 0, 0 });
+                case Node::kind::not_word: return push({ op::not_word, 0, 0, 0 });
+                case Node::kind::concat:
+                    return std::ranges::all_of(n.kids, [&](const Node& k) { return emit(k); });
+                case Node::kind::alt: {
+                    std::vector<std::uint32_t> exits;
+                    for (std::size_t i = 0; i + 1 < n.kids.size(); i++) {
+                        const std::uint32_t split = here();
+                        if (!push({ op::split, 0, split + 1, 0 }) || !emit(n.kids[i])) return false;
+                        exits.push_back(here());
+                        if (!push({ op::jmp, 0, 0, 0 })) return false;
+                        m_Prog[split].y = here();
+                    }
+                    if (!emit(n.kids.back())) return false;
+                    for (auto e : exits) m_Prog[e].x = here();
+                    return true;
+                }
+                case Node::kind::repeat: {
+                    const Node& body = n.kids.front();
+                    for (std::uint32_t i = 0; i < n.min; i++) {
+                        if (!emit(body)) return false;
+                    }
+                    if (n.max == unbounded) {
+                        const std::uint32_t loop = here();
+                        if (!push({ op::split, 0, loop + 1, 0 }) || !emit(body) || !push({ op::jmp, 0, loop, 0 })) return false;
+                        m_Prog[loop].y = here();
+                        return true;
+                    }
+                    std::vector<std::uint32_t> skips;
+                    for (std::uint32_t i = n.min; i < n.max; i++) {
+                        skips.push_back(here());
+                        if (!push({ op::split, 0, here() + 1, 0 }) || !emit(body)) return false;
+                    }
+                    for (auto s : skips) m_Prog[s].y = here();
+                    return true;
+                }
+                }
+                return true;
+            }
+
+        private:
+            std::uint32_t here() const noexcept { return static_cast<std::uint32_t>(m_Prog.size()); }
+
+            bool push(Regex::Inst i) {
+                if (m_Prog.size() >= max_program) return false;
+                m_Prog.push_back(i);
+                return true;
+            }
+
+            std::vector<Regex::Inst>& m_Prog;
+        };
+
+        // Emitting recurses over the parsed tree, whose depth is bounded
+        // by max_nesting; this only decodes the pattern
+        std::u32string to_code_points(std::string_view s) {
+            std::u32string out;
+            for (std::size_t i = 0, len = 0; i < s.size(); i += len) out.push_back(decode(s, i, len));
+            return out;
+        }
+    } // namespace
+
+    bool Regex::CharSet::contains(char32_t c) const noexcept {
+        auto it = std::ranges::upper_bound(ranges, c, {}, [](const auto& r) { return r.first; });
+        const bool in = it != ranges.begin() && c <= std::prev(it)->second;
+        return in != negated;
+    }
+
+    std::expected<Regex, std::string> Regex::compile(std::string_view pattern) {
+        Regex re;
+        const std::u32string cps = to_code_points(pattern);
+        auto tree = Parser{ cps, re.m_Sets }.parse();
+        if (!tree) return std::unexpected(std::move(tree.error()));
+        if (!Emitter{ re.m_Prog }.emit(*tree) || re.m_Prog.size() >= max_program) return std::unexpected("pattern is too large");
+        re.m_Prog.push_back({ Inst::op::match, 0, 0, 0 });
+        re.m_Anchored = re.m_Prog.front().code == Inst::op::begin;
+        return re;
+    }
+
+    bool Regex::search(std::string_view s) const {
+        using op = Inst::op;
+        const std::size_t n = m_Prog.size();
+
+        // Threads are program counters; `seen` marks those already added
+        // at the current position, so every position costs O(n)
+        std::vector<std::uint32_t> pending, current, stack;
+        std::vector<std::size_t> seen(n, std::numeric_limits<std::size_t>::max());
+        pending.reserve(n);
+        current.reserve(n);
+
+        constexpr char32_t nothing = std::numeric_limits<char32_t>::max();
+        char32_t prev = nothing;
+        for (std::size_t i = 0, step = 0;; step++) {
+            const bool at_end = i >= s.size();
+            std::size_t len = 0;
+            const char32_t cp = at_end ? nothing : decode(s, i, len);
+            const bool boundary = (prev != nothing && is_word(prev)) != (cp != nothing && is_word(cp));
+
+            // Follows jumps and assertions from `pc`; consuming
+            // instructions are collected in `current`
+            auto add = [&](std::uint32_t start) {
+                stack.push_back(start);
+                while (!stack.empty()) {
+                    const std::uint32_t pc = stack.back();
+                    stack.pop_back();
+                    if (seen[pc] == step) continue;
+                    seen[pc] = step;
+
+                    const Inst& in = m_Prog[pc];
+                    switch (in.code) {
+                    case op::jmp: stack.push_back(in.x); break;
+                    case op::split: stack.push_back(in.y); stack.push_back(in.x); break;
+                    case op::begin: if (i == 0) stack.push_back(pc + 1); break;
+                    case op::end: if (at_end) stack.push_back(pc + 1); break;
+                    case op::word: if (boundary) stack.push_back(pc + 1); break;
+                    case op::not_word: if (!boundary) stack.push_back(pc + 1); break;
+                    case op::match: stack.clear(); return true;
+                    default: current.push_back(pc); break;
+                    }
+                }
+                return false;
+            };
+
+            current.clear();
+            for (auto pc : pending) {
+                if (add(pc)) return true;
+            }
+            if ((i == 0 || !m_Anchored) && add(0)) return true;
+            if (at_end || (current.empty() && m_Anchored)) return false;
+
+            pending.clear();
+            for (auto pc : current) {
+                const Inst& in = m_Prog[pc];
+                bool ok = false;
+                switch (in.code) {
+                case op::chr: ok = in.c == cp; break;
+                case op::set: ok = m_Sets[in.x].contains(cp); break;
+                case op::any: ok = cp != '\n' && cp != '\r' && cp != 0x2028 && cp != 0x2029; break;
+                default: break;
+                }
+                if (ok) pending.push_back(pc + 1);
+            }
+            prev = cp;
+            i += len;
+        }
+    }
+
+} // namespace Sonnet::detail
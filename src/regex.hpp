@@ -0,0 +1,55 @@
+#pragma once
+
+// Internal regular expressions for JSON Schema's `pattern`: the
+// ECMAScript subset the specification recommends, compiled to an NFA and
+// searched without backtracking or recursion, so time is linear in the
+// input for a given pattern and untrusted strings cannot exhaust the stack
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace Sonnet::detail {
+
+    class Regex {
+    public:
+        // Supports literals, `.`, classes with ranges and negation, the
+        // escapes `\d \D \w \W \s \S \b \B`, control and hex/unicode
+        // escapes, `^ $`, groups (capturing, non-capturing and named are
+        // all just groups), `|` and the quantifiers `* + ? {n} {n,}
+        // {n,m}`, greedy or lazy. Backreferences and lookaround are
+        // rejected. Matching is by code point; `^` and `$` only match at
+        // the ends of the input
+        static std::expected<Regex, std::string> compile(std::string_view pattern);
+
+        // Whether the pattern matches anywhere in `s`
+        bool search(std::string_view s) const;
+
+        struct CharSet {
+            std::vector<std::pair<char32_t, char32_t>> ranges;
+            bool negated = false;
+
+            bool contains(char32_t c) const noexcept;
+        };
+
+        struct Inst {
+            enum class op : std::uint8_t { chr, set, any, split, jmp, begin, end, word, not_word, match };
+
+            op code = op::match;
+            char32_t c = 0;     // chr: the code point
+            std::uint32_t x = 0; // set: class index; split, jmp: target
+            std::uint32_t y = 0; // split: second target
+        };
+
+    private:
+        std::vector<Inst> m_Prog;
+        std::vector<CharSet> m_Sets;
+        bool m_Anchored = false; // starts with `^`: only try at the start
+    };
+
+} // namespace Sonnet::detail
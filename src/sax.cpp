@@ -0,0 +1,105 @@
+#include "sonnet/sax.hpp"
+
+
+namespace Sonnet {
+
+    DomBuilder::DomBuilder(std::pmr::memory_resource* res, bool pack_numeric_arrays)
+        : m_MemRes{ res }, m_Root{ res }, m_Key{ res }, m_Pack{ pack_numeric_arrays } {}
+
+    value* DomBuilder::add(value&& v) {
+        if (m_Stack.empty()) {
+            m_Root = std::move(v);
+            return &m_Root;
+        }
+
+        value& parent = *m_Stack.back();
+        if (parent.is_array()) {
+            auto& arr = parent.as_array();
+            arr.push_back(std::move(v));
+            return &arr.back();
+        }
+
+        auto [it, inserted] = parent.as_object().insert_or_assign(std::move(m_Key), std::move(v));
+        m_Key = string{ m_MemRes };
+        return &it->second;
+    }
+
+    bool DomBuilder::on_null() {
+        add(value{ nullptr, m_MemRes });
+        return true;
+    }
+
+    bool DomBuilder::on_bool(bool b) {
+        add(value{ b, m_MemRes });
+        return true;
+    }
+
+    bool DomBuilder::on_number(double d) {
+        // A packed array stays packed while only numbers arrive; anything
+        // else goes through `add`, whose `as_array` unpacks it
+        if (!m_Stack.empty() && m_Stack.back()->is_packed()) {
+            std::get<packed_array>(m_Stack.back()->storage()).nums.push_back(d);
+            return true;
+        }
+        add(value{ d, m_MemRes });
+        return true;
+    }
+
+    bool DomBuilder::on_string(std::string_view s) {
+        add(value{ s, m_MemRes });
+        return true;
+    }
+
+    bool DomBuilder::on_string(string&& s) {
+        add(value{ std::move(s), m_MemRes });
+        return true;
+    }
+
+    bool DomBuilder::on_start_array(std::size_t size) {
+        if (m_Pack) {
+            number_array nums{ allocator_type{ m_MemRes } };
+            if (size != unknown_size) nums.reserve(size);
+            m_Stack.push_back(add(value{ std::move(nums), m_MemRes }));
+            return true;
+        }
+        array arr{ allocator_type{ m_MemRes } };
+        if (size != unknown_size) arr.reserve(size);
+        m_Stack.push_back(add(value{ std::move(arr), m_MemRes }));
+        return true;
+    }
+
+    bool DomBuilder::on_end_array() {
+        // `[]` has no numbers to pack and stays a plain array
+        value& arr = *m_Stack.back();
+        if (arr.is_packed() && arr.size() == 0) arr = value{ array{ allocator_type{ m_MemRes } }, m_MemRes };
+        m_Stack.pop_back();
+        return true;
+    }
+
+    bool DomBuilder::on_start_object(std::size_t) {
+        m_Stack.push_back(add(value{ object{ std::less<>{}, m_MemRes }, m_MemRes }));
+        return true;
+    }
+
+    bool DomBuilder::on_key(std::string_view k) {
+        m_Key.assign(k.begin(), k.end());
+        return true;
+    }
+
+    bool DomBuilder::on_key(string&& k) {
+        m_Key = std::move(k);
+        return true;
+    }
+
+    bool DomBuilder::on_end_object() {
+        m_Stack.pop_back();
+        return true;
+    }
+
+    void DomBuilder::reset() {
+        m_Root = value{ m_MemRes };
+        m_Stack.clear();
+        m_Key.clear();
+    }
+
+} // namespace Sonnet
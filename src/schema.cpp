@@ -0,0 +1,759 @@
+#include "sonnet/schema.hpp"
+#include "sonnet/sonnet.hpp"
+#include "sonnet/pointer.hpp"
+#include "equal.hpp"
+#include "regex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Sonnet::schema {
+
+    namespace detail {
+        constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+        constexpr double inf = std::numeric_limits<double>::infinity();
+
+        // Instance kinds as a bit set; numbers are split into integers and
+        // the rest so `type: integer` is a single mask test
+        constexpr std::uint8_t type_null     = 1 << 0;
+        constexpr std::uint8_t type_boolean  = 1 << 1;
+        constexpr std::uint8_t type_integer  = 1 << 2;
+        constexpr std::uint8_t type_fraction = 1 << 3;
+        constexpr std::uint8_t type_string   = 1 << 4;
+        constexpr std::uint8_t type_array    = 1 << 5;
+        constexpr std::uint8_t type_object   = 1 << 6;
+        constexpr std::uint8_t type_any      = 0x7F;
+
+        // An entry of a schema's key table: the subschema of `properties`
+        // and the bit of `required`, either of which may be absent
+        struct Member {
+            std::string key;
+            std::uint32_t schema = none;
+            std::uint32_t required = none;
+        };
+
+        struct Node {
+            std::string path;
+            bool never = false;
+            std::uint8_t types = type_any;
+            std::uint32_t ref = none;
+
+            bool has_enum = false;
+            std::vector<value> choices;
+            std::optional<value> constant;
+
+            double minimum = -inf;
+            double maximum = inf;
+            double exclusive_minimum = -inf;
+            double exclusive_maximum = inf;
+
+            std::size_t min_length = 0;
+            std::size_t max_length = std::numeric_limits<std::size_t>::max();
+            std::uint32_t pattern = none;
+
+            std::uint32_t items = none;
+            std::size_t min_items = 0;
+            std::size_t max_items = std::numeric_limits<std::size_t>::max();
+
+            std::vector<Member> members;
+            std::uint32_t required = 0;
+            std::uint32_t additional = none;
+
+            bool whole() const noexcept { return has_enum || constant; }
+
+            const Member* member(std::string_view key) const noexcept {
+                auto it = std::ranges::lower_bound(members, key, {}, [](const Member& m) { return std::string_view{ m.key }; });
+                return it != members.end() && it->key == key ? &*it : nullptr;
+            }
+
+            // Schema applied to the member @p key, or `none`
+            std::uint32_t child(std::string_view key) const noexcept {
+                const Member* m = member(key);
+                return m ? m->schema : additional;
+            }
+        };
+
+        struct Program {
+            std::vector<Node> nodes;
+            std::vector<Sonnet::detail::Regex> patterns;
+        };
+
+        std::string escape(std::string_view token) {
+            std::string out;
+            for (char c : token) {
+                if (c == '~') out += "~0";
+                else if (c == '/') out += "~1";
+                else out.push_back(c);
+            }
+            return out;
+        }
+
+        std::uint8_t type_of(const value& v) noexcept {
+            switch (v.type()) {
+            case kind::null: return type_null;
+            case kind::boolean: return type_boolean;
+            case kind::number: {
+                double d = v.as_number();
+                return std::isfinite(d) && d == std::floor(d) ? type_integer : type_fraction;
+            }
+            case kind::string: return type_string;
+            case kind::array: return type_array;
+            case kind::object: return type_object;
+            }
+            return type_null;
+        }
+
+        std::size_t code_points(std::string_view s) noexcept {
+            return static_cast<std::size_t>(std::ranges::count_if(s, [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+        }
+
+        std::string describe(double d) { return dump(value{ d }); }
+
+        // Keywords of draft 2020-12 that constrain instances but are not
+        // implemented; accepting them silently would let invalid data through
+        constexpr std::string_view unsupported[] = {
+            "allOf", "anyOf", "oneOf", "not", "if", "then", "else", "dependentSchemas",
+            "prefixItems", "contains", "patternProperties", "propertyNames",
+            "unevaluatedItems", "unevaluatedProperties", "multipleOf", "uniqueItems",
+            "minContains", "maxContains", "minProperties", "maxProperties",
+            "dependentRequired", "$dynamicRef", "$recursiveRef",
+        };
+
+        class Compiler {
+        public:
+            Compiler(const value& root, Program& prog) : m_Root{ root }, m_Prog{ prog } {}
+
+            std::optional<SchemaError> run() {
+                if (node(m_Root, "") != none) cycles();
+                return m_Error;
+            }
+
+        private:
+            bool fail(SchemaError::code c, std::string path, std::string_view msg) {
+                if (!m_Error) m_Error = SchemaError{ c, std::move(path), std::string{ msg } };
+                return false;
+            }
+
+            // Compiles the schema at @p path once; `$ref` cycles end at the
+            // node already registered for the path
+            std::uint32_t node(const value& s, const std::string& path) {
+                if (auto it = m_Compiled.find(path); it != m_Compiled.end()) return it->second;
+                auto idx = static_cast<std::uint32_t>(m_Prog.nodes.size());
+                m_Prog.nodes.emplace_back();
+                m_Compiled.emplace(path, idx);
+
+                // Built aside: compiling subschemas grows `nodes`
+                Node n;
+                n.path = path;
+                if (s.is_bool()) {
+                    n.never = !s.as_bool();
+                } else if (!s.is_object()) {
+                    fail(SchemaError::code::invalid_schema, path, "A schema must be an object or a boolean");
+                    return none;
+                } else {
+                    std::map<std::string, Member, std::less<>> members;
+                    for (const auto& [k, v] : s.as_object()) {
+                        if (!keyword(n, members, k, v, path + "/" + escape(k))) return none;
+                    }
+                    for (auto& [k, m] : members) {
+                        m.key = k;
+                        n.members.push_back(std::move(m));
+                    }
+                }
+                m_Prog.nodes[idx] = std::move(n);
+                return idx;
+            }
+
+            bool keyword(Node& n, std::map<std::string, Member, std::less<>>& members, std::string_view key, const value& v, const std::string& at) {
+                using code = SchemaError::code;
+
+                if (key == "type") {
+                    n.types = 0;
+                    if (v.is_string()) return type(n, v, at);
+                    if (!v.is_array() || v.is_packed()) return fail(code::invalid_schema, at, "\"type\" must be a string or an array of strings");
+                    for (const auto& t : v.as_array())
+                        if (!type(n, t, at)) return false;
+                    return true;
+                }
+                if (key == "enum") {
+                    if (!v.is_array()) return fail(code::invalid_schema, at, "\"enum\" must be an array");
+                    n.has_enum = true;
+                    if (v.is_packed()) for (double d : v.numbers()) n.choices.emplace_back(d);
+                    else n.choices.assign(v.as_array().begin(), v.as_array().end());
+                    return true;
+                }
+                if (key == "const") {
+                    n.constant.emplace(v);
+                    return true;
+                }
+                if (key == "minimum") return number(n.minimum, v, at);
+                if (key == "maximum") return number(n.maximum, v, at);
+                if (key == "exclusiveMinimum") return number(n.exclusive_minimum, v, at);
+                if (key == "exclusiveMaximum") return number(n.exclusive_maximum, v, at);
+                if (key == "minLength") return count(n.min_length, v, at);
+                if (key == "maxLength") return count(n.max_length, v, at);
+                if (key == "minItems") return count(n.min_items, v, at);
+                if (key == "maxItems") return count(n.max_items, v, at);
+                if (key == "pattern") return pattern(n, v, at);
+                if (key == "items") {
+                    if (v.is_array()) return fail(code::invalid_schema, at, "\"items\" must be a single schema; the array form is \"prefixItems\"");
+                    return (n.items = node(v, at)) != none;
+                }
+                if (key == "additionalProperties") return (n.additional = node(v, at)) != none;
+                if (key == "properties") {
+                    if (!v.is_object()) return fail(code::invalid_schema, at, "\"properties\" must be an object");
+                    for (const auto& [name, sub] : v.as_object()) {
+                        auto idx = node(sub, at + "/" + escape(name));
+                        if (idx == none) return false;
+                        members[std::string{ name }].schema = idx;
+                    }
+                    return true;
+                }
+                if (key == "required") {
+                    if (!v.is_array() || v.is_packed()) return fail(code::invalid_schema, at, "\"required\" must be an array of strings");
+                    for (const auto& name : v.as_array()) {
+                        if (!name.is_string()) return fail(code::invalid_schema, at, "\"required\" must be an array of strings");
+                        auto& m = members[std::string{ name.as_string() }];
+                        if (m.required == none) m.required = n.required++;
+                    }
+                    return true;
+                }
+                if (key == "$ref") return ref(n, v, at);
+                if (std::ranges::find(unsupported, key) != std::end(unsupported))
+                    return fail(code::unsupported_keyword, at, "Keyword \"" + std::string{ key } + "\" is not supported");
+                return true;
+            }
+
+            bool type(Node& n, const value& t, const std::string& at) {
+                static constexpr std::pair<std::string_view, std::uint8_t> names[] = {
+                    { "null", type_null }, { "boolean", type_boolean }, { "integer", type_integer },
+                    { "number", type_integer | type_fraction }, { "string", type_string },
+                    { "array", type_array }, { "object", type_object },
+                };
+                if (t.is_string()) {
+                    for (const auto& [name, bits] : names) {
+                        if (std::string_view{ t.as_string() } != name) continue;
+                        n.types |= bits;
+                        return true;
+                    }
+                }
+                return fail(SchemaError::code::invalid_schema, at, "Unknown type name");
+            }
+
+            bool number(double& out, const value& v, const std::string& at) {
+                if (!v.is_number()) return fail(SchemaError::code::invalid_schema, at, "Expected a number");
+                out = v.as_number();
+                return true;
+            }
+
+            bool count(std::size_t& out, const value& v, const std::string& at) {
+                if (type_of(v) != type_integer || v.as_number() < 0) return fail(SchemaError::code::invalid_schema, at, "Expected a non-negative integer");
+                double d = v.as_number();
+                out = d >= 0x1p63 ? std::numeric_limits<std::size_t>::max() : static_cast<std::size_t>(d);
+                return true;
+            }
+
+            bool pattern(Node& n, const value& v, const std::string& at) {
+                if (!v.is_string()) return fail(SchemaError::code::invalid_schema, at, "\"pattern\" must be a string");
+                std::string text{ v.as_string() };
+                if (auto it = m_Patterns.find(text); it != m_Patterns.end()) {
+                    n.pattern = it->second;
+                    return true;
+                }
+                auto re = Sonnet::detail::Regex::compile(text);
+                if (!re) return fail(SchemaError::code::invalid_pattern, at, re.error());
+                m_Prog.patterns.push_back(std::move(*re));
+                n.pattern = static_cast<std::uint32_t>(m_Prog.patterns.size() - 1);
+                m_Patterns.emplace(std::move(text), n.pattern);
+                return true;
+            }
+
+            bool ref(Node& n, const value& v, const std::string& at) {
+                using code = SchemaError::code;
+                if (!v.is_string()) return fail(code::invalid_schema, at, "\"$ref\" must be a string");
+                std::string_view uri = v.as_string();
+                if (!uri.starts_with('#')) return fail(code::unresolved_ref, at, "Only references into the same document (\"#...\") are supported");
+
+                // The fragment is a percent-encoded JSON Pointer
+                std::string fragment;
+                for (size_t i = 1; i < uri.size(); i++) {
+                    auto hex = [](char c) { return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1; };
+                    if (uri[i] == '%' && i + 2 < uri.size() && hex(uri[i + 1]) >= 0 && hex(uri[i + 2]) >= 0) {
+                        fragment.push_back(static_cast<char>(hex(uri[i + 1]) * 16 + hex(uri[i + 2])));
+                        i += 2;
+                    } else {
+                        fragment.push_back(uri[i]);
+                    }
+                }
+                auto ptr = pointer::parse(fragment);
+                if (!ptr) return fail(code::unresolved_ref, at, "Only JSON Pointer fragments are supported in \"$ref\"");
+                const value* target = ptr->resolve(m_Root);
+                if (!target) return fail(code::unresolved_ref, at, "\"$ref\" does not resolve");
+                return (n.ref = node(*target, ptr->to_string())) != none;
+            }
+
+            // A chain of `$ref` that comes back to where it started would
+            // never consume the instance
+            void cycles() {
+                const auto& nodes = m_Prog.nodes;
+                for (std::uint32_t i = 0; i < nodes.size(); i++) {
+                    std::size_t steps = 0;
+                    for (std::uint32_t j = nodes[i].ref; j != none; j = nodes[j].ref) {
+                        if (++steps > nodes.size()) {
+                            fail(SchemaError::code::invalid_schema, nodes[i].path + "/$ref", "\"$ref\" refers back to itself");
+                            return;
+                        }
+                    }
+                }
+            }
+
+            const value& m_Root;
+            Program& m_Prog;
+            std::unordered_map<std::string, std::uint32_t> m_Compiled;
+            std::unordered_map<std::string, std::uint32_t> m_Patterns;
+            std::optional<SchemaError> m_Error;
+        };
+
+        // Reason a single schema node rejects a value, or no keyword
+        struct Violation {
+            std::string_view keyword;
+            std::string msg;
+
+            explicit operator bool() const noexcept { return !keyword.empty() || !msg.empty(); }
+        };
+
+        Violation check_type(const Node& n, std::uint8_t type) {
+            if (n.never) return { {}, "No value is allowed here" };
+            if (!(n.types & type)) return { "type", "Value has the wrong type" };
+            return {};
+        }
+
+        Violation check_number(const Node& n, double d) {
+            if (d < n.minimum) return { "minimum", "Value is less than " + describe(n.minimum) };
+            if (d > n.maximum) return { "maximum", "Value is greater than " + describe(n.maximum) };
+            if (d <= n.exclusive_minimum) return { "exclusiveMinimum", "Value is not greater than " + describe(n.exclusive_minimum) };
+            if (d >= n.exclusive_maximum) return { "exclusiveMaximum", "Value is not less than " + describe(n.exclusive_maximum) };
+            return {};
+        }
+
+        Violation check_string(const Program& p, const Node& n, std::string_view s) {
+            if (n.min_length > 0 || n.max_length != std::numeric_limits<std::size_t>::max()) {
+                std::size_t len = code_points(s);
+                if (len < n.min_length) return { "minLength", "String is shorter than " + std::to_string(n.min_length) };
+                if (len > n.max_length) return { "maxLength", "String is longer than " + std::to_string(n.max_length) };
+            }
+            if (n.pattern != none && !p.patterns[n.pattern].search(s))
+                return { "pattern", "String does not match the pattern" };
+            return {};
+        }
+
+        Violation check_items(const Node& n, std::size_t size) {
+            if (size < n.min_items) return { "minItems", "Array has fewer than " + std::to_string(n.min_items) + " items" };
+            if (size > n.max_items) return { "maxItems", "Array has more than " + std::to_string(n.max_items) + " items" };
+            return {};
+        }
+
+        Violation check_choices(const Node& n, const value& v) {
+            if (n.has_enum && std::ranges::none_of(n.choices, [&](const value& c) { return Sonnet::detail::json_equal(c, v); }))
+                return { "enum", "Value is not one of the allowed values" };
+            if (n.constant && !Sonnet::detail::json_equal(*n.constant, v))
+                return { "const", "Value is not the expected constant" };
+            return {};
+        }
+
+        // The missing member of an object whose required bits are in @p seen
+        template<typename Seen>
+        Violation check_required(const Node& n, Seen&& seen) {
+            for (const auto& m : n.members)
+                if (m.required != none && !seen(m)) return { "required", "Missing required property \"" + m.key + "\"" };
+            return {};
+        }
+
+        // Path components of the instance location, formatted only when a
+        // violation is reported
+        struct Step {
+            std::string_view key;
+            std::size_t index = 0;
+            bool is_key = false;
+        };
+
+        ValidationError make_error(std::string instance_path, const Node& n, Violation&& why) {
+            ValidationError err;
+            err.errc = ValidationError::code::invalid_value;
+            err.instance_path = std::move(instance_path);
+            err.schema_path = n.path;
+            if (!why.keyword.empty()) {
+                err.schema_path += '/';
+                err.schema_path += why.keyword;
+            }
+            err.msg = std::move(why.msg);
+            return err;
+        }
+
+        class Checker {
+        public:
+            Checker(const Program& p, std::string prefix = {}) : m_Prog{ p }, m_Prefix{ std::move(prefix) } {}
+
+            // Checks @p v against node @p i and the nodes it refers to
+            bool check(std::uint32_t i, const value& v) {
+                for (; i != none; i = m_Prog.nodes[i].ref)
+                    if (!check_node(i, v)) return false;
+                return true;
+            }
+
+            ValidationError& error() noexcept { return m_Error; }
+
+            // Checks @p v against node @p i alone
+            bool check_node(std::uint32_t i, const value& v) {
+                const Node& n = m_Prog.nodes[i];
+                if (auto why = check_type(n, type_of(v))) return fail(n, std::move(why));
+                if (n.whole())
+                    if (auto why = check_choices(n, v)) return fail(n, std::move(why));
+
+                switch (v.type()) {
+                case kind::number:
+                    if (auto why = check_number(n, v.as_number())) return fail(n, std::move(why));
+                    return true;
+                case kind::string:
+                    if (auto why = check_string(m_Prog, n, v.as_string())) return fail(n, std::move(why));
+                    return true;
+                case kind::array:
+                    return array(n, v);
+                case kind::object:
+                    return object(n, v);
+                default:
+                    return true;
+                }
+            }
+
+        private:
+
+            bool array(const Node& n, const value& v) {
+                if (auto why = check_items(n, v.size())) return fail(n, std::move(why));
+                if (n.items == none) return true;
+
+                if (v.is_packed()) {
+                    auto nums = v.numbers();
+                    for (std::size_t i = 0; i < nums.size(); i++) {
+                        m_Steps.push_back({ {}, i, false });
+                        if (!check(n.items, value{ nums[i] })) return false;
+                        m_Steps.pop_back();
+                    }
+                    return true;
+                }
+                const auto& arr = v.as_array();
+                for (std::size_t i = 0; i < arr.size(); i++) {
+                    m_Steps.push_back({ {}, i, false });
+                    if (!check(n.items, arr[i])) return false;
+                    m_Steps.pop_back();
+                }
+                return true;
+            }
+
+            bool object(const Node& n, const value& v) {
+                std::uint32_t seen = 0;
+                for (const auto& [k, e] : v.as_object()) {
+                    std::string_view key = k;
+                    const Member* m = n.member(key);
+                    if (m && m->required != none) seen++;
+                    std::uint32_t sub = m ? m->schema : n.additional;
+                    if (sub == none) continue;
+                    m_Steps.push_back({ key, 0, true });
+                    if (!check(sub, e)) return false;
+                    m_Steps.pop_back();
+                }
+                if (seen < n.required)
+                    if (auto why = check_required(n, [&](const Member& m) { return v.find(m.key) != nullptr; })) return fail(n, std::move(why));
+                return true;
+            }
+
+            bool fail(const Node& n, Violation&& why) {
+                std::string path = m_Prefix;
+                for (const auto& s : m_Steps) {
+                    path += '/';
+                    path += s.is_key ? escape(s.key) : std::to_string(s.index);
+                }
+                m_Error = make_error(std::move(path), n, std::move(why));
+                return false;
+            }
+
+            const Program& m_Prog;
+            std::string m_Prefix;
+            std::vector<Step> m_Steps;
+            ValidationError m_Error;
+        };
+
+        // Incremental validation over SAX events. Every value is checked
+        // against a set of nodes kept on `m_Pool`: the nodes that apply to
+        // it and all the nodes they refer to. Containers keep their set
+        // for the checks made when they close
+        class Streamer {
+        public:
+            Streamer(const Program& p, SaxHandler* next) : m_Prog{ p }, m_Next{ next } {}
+
+            const ValidationError* error() const noexcept { return m_Error ? &*m_Error : nullptr; }
+
+            void reset() {
+                m_Pool.clear();
+                m_Frames.clear();
+                m_Seen.clear();
+                m_Depth = 0;
+                m_Builder.reset();
+                m_Error.reset();
+            }
+
+            template<typename Forward>
+            bool scalar(const value& v, Forward&& forward) {
+                if (m_Depth > 0) return forward(&m_Builder) && forward(m_Next);
+
+                std::uint32_t begin = enter();
+                for (std::uint32_t k = begin; k < m_Pool.size(); k++) {
+                    const Node& n = m_Prog.nodes[m_Pool[k]];
+                    if (auto why = check_type(n, type_of(v))) return fail(n, std::move(why), m_Frames.size());
+                    if (n.whole())
+                        if (auto why = check_choices(n, v)) return fail(n, std::move(why), m_Frames.size());
+                    Violation why;
+                    if (v.is_number()) why = check_number(n, v.as_number());
+                    else if (v.is_string()) why = check_string(m_Prog, n, v.as_string());
+                    if (why) return fail(n, std::move(why), m_Frames.size());
+                }
+                m_Pool.resize(begin);
+                done();
+                return forward(m_Next);
+            }
+
+            bool string(std::string_view s) {
+                // Strings are only copied into a value when a node needs one
+                if (m_Depth > 0) return m_Builder.on_string(s) && (!m_Next || m_Next->on_string(s));
+
+                std::uint32_t begin = enter();
+                for (std::uint32_t k = begin; k < m_Pool.size(); k++) {
+                    const Node& n = m_Prog.nodes[m_Pool[k]];
+                    if (auto why = check_type(n, type_string)) return fail(n, std::move(why), m_Frames.size());
+                    if (n.whole())
+                        if (auto why = check_choices(n, value{ s })) return fail(n, std::move(why), m_Frames.size());
+                    if (auto why = check_string(m_Prog, n, s)) return fail(n, std::move(why), m_Frames.size());
+                }
+                m_Pool.resize(begin);
+                done();
+                return !m_Next || m_Next->on_string(s);
+            }
+
+            bool open(bool is_array, std::size_t size) {
+                auto forward = [&](SaxHandler* h) { return !h || (is_array ? h->on_start_array(size) : h->on_start_object(size)); };
+                if (m_Depth > 0) {
+                    m_Depth++;
+                    return forward(&m_Builder) && forward(m_Next);
+                }
+
+                std::uint32_t begin = enter();
+                bool whole = false;
+                for (std::uint32_t k = begin; k < m_Pool.size(); k++) {
+                    const Node& n = m_Prog.nodes[m_Pool[k]];
+                    if (auto why = check_type(n, is_array ? type_array : type_object)) return fail(n, std::move(why), m_Frames.size());
+                    whole = whole || n.whole();
+                }
+
+                if (whole) {
+                    // `enum` and `const` compare the container as a whole
+                    m_Depth = 1;
+                    m_Builder.reset();
+                    m_Captured = begin;
+                    return forward(&m_Builder) && forward(m_Next);
+                }
+
+                Frame f;
+                f.begin = begin;
+                f.end = static_cast<std::uint32_t>(m_Pool.size());
+                f.is_array = is_array;
+                f.seen = m_Seen.size();
+                if (!is_array) {
+                    std::size_t bits = 0;
+                    for (std::uint32_t k = f.begin; k < f.end; k++) bits += m_Prog.nodes[m_Pool[k]].required;
+                    m_Seen.resize(m_Seen.size() + bits, 0);
+                }
+                m_Frames.push_back(std::move(f));
+                return forward(m_Next);
+            }
+
+            bool key(std::string_view k) {
+                if (m_Depth > 0) return m_Builder.on_key(k) && (!m_Next || m_Next->on_key(k));
+
+                Frame& f = m_Frames.back();
+                f.key.assign(k);
+                std::size_t bit = f.seen;
+                for (std::uint32_t i = f.begin; i < f.end; i++) {
+                    const Node& n = m_Prog.nodes[m_Pool[i]];
+                    if (const Member* m = n.member(k); m && m->required != none) m_Seen[bit + m->required] = 1;
+                    bit += n.required;
+                }
+                return !m_Next || m_Next->on_key(k);
+            }
+
+            bool close(bool is_array) {
+                auto forward = [&](SaxHandler* h) { return !h || (is_array ? h->on_end_array() : h->on_end_object()); };
+                if (m_Depth > 0) {
+                    if (!forward(&m_Builder)) return false;
+                    if (--m_Depth == 0 && !captured()) return false;
+                    return forward(m_Next);
+                }
+
+                const Frame& f = m_Frames.back();
+                std::size_t bit = f.seen;
+                for (std::uint32_t i = f.begin; i < f.end; i++) {
+                    const Node& n = m_Prog.nodes[m_Pool[i]];
+                    Violation why;
+                    if (is_array) why = check_items(n, f.count);
+                    else why = check_required(n, [&](const Member& m) { return m_Seen[bit + m.required] != 0; });
+                    if (why) return fail(n, std::move(why), m_Frames.size() - 1);
+                    bit += n.required;
+                }
+                m_Seen.resize(f.seen);
+                m_Pool.resize(f.begin);
+                m_Frames.pop_back();
+                done();
+                return forward(m_Next);
+            }
+
+        private:
+            struct Frame {
+                std::uint32_t begin = 0;
+                std::uint32_t end = 0;
+                bool is_array = false;
+                std::size_t count = 0;
+                std::size_t seen = 0;
+                std::string key;
+            };
+
+            void push(std::uint32_t i) {
+                for (; i != none; i = m_Prog.nodes[i].ref) m_Pool.push_back(i);
+            }
+
+            // Pushes the set of nodes for the value that starts now and
+            // returns where it begins
+            std::uint32_t enter() {
+                auto begin = static_cast<std::uint32_t>(m_Pool.size());
+                if (m_Frames.empty()) {
+                    push(0);
+                    return begin;
+                }
+                const Frame& f = m_Frames.back();
+                for (std::uint32_t k = f.begin; k < f.end; k++) {
+                    const Node& n = m_Prog.nodes[m_Pool[k]];
+                    push(f.is_array ? n.items : n.child(f.key));
+                }
+                return begin;
+            }
+
+            // A value of the innermost container is complete
+            void done() {
+                if (!m_Frames.empty()) m_Frames.back().count++;
+            }
+
+            // Checks a captured container against the nodes that asked for it
+            bool captured() {
+                Checker checker{ m_Prog, path(m_Frames.size()) };
+                const value& v = m_Builder.result();
+                for (std::uint32_t k = m_Captured; k < m_Pool.size(); k++) {
+                    // The set already lists every referenced node
+                    if (!checker.check_node(m_Pool[k], v)) {
+                        m_Error = std::move(checker.error());
+                        return false;
+                    }
+                }
+                m_Pool.resize(m_Captured);
+                done();
+                return true;
+            }
+
+            std::string path(std::size_t depth) const {
+                std::string out;
+                for (std::size_t d = 0; d < depth; d++) {
+                    const Frame& f = m_Frames[d];
+                    out += '/';
+                    out += f.is_array ? std::to_string(f.count) : escape(f.key);
+                }
+                return out;
+            }
+
+            bool fail(const Node& n, Violation&& why, std::size_t depth) {
+                m_Error = make_error(path(depth), n, std::move(why));
+                return false;
+            }
+
+            const Program& m_Prog;
+            SaxHandler* m_Next;
+            std::vector<std::uint32_t> m_Pool;
+            std::vector<Frame> m_Frames;
+            std::vector<char> m_Seen;
+            DomBuilder m_Builder;
+            std::size_t m_Depth = 0;
+            std::uint32_t m_Captured = 0;
+            std::optional<ValidationError> m_Error;
+        };
+    } // namespace detail
+
+    std::expected<validator, SchemaError> compile(const value& schema) {
+        auto prog = std::make_shared<detail::Program>();
+        detail::Compiler compiler{ schema, *prog };
+        if (auto err = compiler.run()) return std::unexpected(std::move(*err));
+
+        validator v;
+        v.m_Program = std::move(prog);
+        return v;
+    }
+
+    std::expected<void, ValidationError> validator::validate(const value& instance) const {
+        detail::Checker checker{ *m_Program };
+        if (!checker.check(0, instance)) return std::unexpected(std::move(checker.error()));
+        return {};
+    }
+
+    std::expected<void, ValidationError> validator::validate_json(std::string_view json, const ParseOptions& opts) const {
+        ValidatingHandler handler{ *this };
+        if (auto r = parse_sax(json, handler, opts); !r) {
+            if (const auto* err = handler.error()) return std::unexpected(*err);
+            ValidationError err;
+            err.errc = ValidationError::code::invalid_json;
+            err.msg = std::move(r.error().msg);
+            return std::unexpected(std::move(err));
+        }
+        return {};
+    }
+
+    ValidatingHandler::ValidatingHandler(const validator& v, SaxHandler* next)
+        : m_Impl{ std::make_unique<detail::Streamer>(*v.m_Program, next) } {}
+
+    ValidatingHandler::~ValidatingHandler() = default;
+
+    bool ValidatingHandler::on_null() {
+        return m_Impl->scalar(value{ nullptr }, [](SaxHandler* h) { return !h || h->on_null(); });
+    }
+
+    bool ValidatingHandler::on_bool(bool b) {
+        return m_Impl->scalar(value{ b }, [b](SaxHandler* h) { return !h || h->on_bool(b); });
+    }
+
+    bool ValidatingHandler::on_number(double d) {
+        return m_Impl->scalar(value{ d }, [d](SaxHandler* h) { return !h || h->on_number(d); });
+    }
+
+    bool ValidatingHandler::on_string(std::string_view s) { return m_Impl->string(s); }
+    bool ValidatingHandler::on_start_array(std::size_t size) { return m_Impl->open(true, size); }
+    bool ValidatingHandler::on_end_array() { return m_Impl->close(true); }
+    bool ValidatingHandler::on_start_object(std::size_t size) { return m_Impl->open(false, size); }
+    bool ValidatingHandler::on_key(std::string_view k) { return m_Impl->key(k); }
+    bool ValidatingHandler::on_end_object() { return m_Impl->close(false); }
+
+    const ValidationError* ValidatingHandler::error() const noexcept { return m_Impl->error(); }
+
+    void ValidatingHandler::reset() { m_Impl->reset(); }
+
+} // namespace Sonnet::schema
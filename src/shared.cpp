@@ -0,0 +1,318 @@
+#include "sonnet/shared.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if SONNET_PLATFORM_WINDOWS
+#define SONNET_HAS_SHM 0
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SONNET_HAS_SHM 1
+#endif
+
+
+namespace Sonnet {
+
+    namespace detail {
+        // One entry per open handle: the owning process and its pins on
+        // each slot. `pid` is 0 while free and `reaping` while a dead
+        // owner's pins are being cleared
+        struct ShmLease {
+            std::atomic<std::uint32_t> pid;
+            std::atomic<std::uint32_t> pins[2];
+        };
+
+        // Lives at the start of the segment. Slots follow at `slots_offset`,
+        // the first page boundary after the header, so they can be mapped
+        // read-only for readers
+        struct ShmHeader {
+            char magic[4];
+            std::uint32_t version;
+            std::uint64_t capacity;
+            std::uint64_t slots_offset;
+            std::uint64_t size[2];
+            alignas(64) std::atomic<std::uint64_t> generation;
+            alignas(64) ShmLease leases[shared_max_handles];
+        };
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+                      "shared documents need address-free atomics");
+
+        constexpr char shm_magic[4] = { 'S', 'N', 'S', 'H' };
+        constexpr std::uint32_t shm_version = 2;
+        constexpr std::uint32_t reaping = std::numeric_limits<std::uint32_t>::max();
+
+        // Owns one mapping of a segment and this handle's lease in it;
+        // shared by the handle and its snapshots, so the last one unmaps
+        struct ShmMapping {
+            ShmHeader* header = nullptr;
+            std::size_t size = 0;
+            ShmLease* lease = nullptr;
+
+            ~ShmMapping() {
+                if (lease) {
+                    lease->pins[0].store(0);
+                    lease->pins[1].store(0);
+                    lease->pid.store(0);
+                }
+#if SONNET_HAS_SHM
+                if (header) ::munmap(header, size);
+#endif
+            }
+        };
+
+        inline std::byte* slot_data(ShmHeader* h, unsigned slot) noexcept {
+            return reinterpret_cast<std::byte*>(h) + h->slots_offset + slot * h->capacity;
+        }
+
+        inline std::string shm_name(std::string_view name) {
+            std::string n;
+            if (name.empty() || name.front() != '/') n.push_back('/');
+            n.append(name);
+            return n;
+        }
+
+        inline std::error_code last_error() { return { errno, std::system_category() }; }
+
+#if SONNET_HAS_SHM
+        inline std::expected<std::size_t, std::error_code> page_size() {
+            long page = ::sysconf(_SC_PAGESIZE);
+            if (page <= 0) return std::unexpected(last_error());
+            return static_cast<std::size_t>(page);
+        }
+
+        // Frees @p lease if the process owning it no longer exists; only
+        // one caller clears the pins, so a new owner never loses its own
+        inline bool reap(ShmLease& lease) noexcept {
+            std::uint32_t pid = lease.pid.load();
+            if (pid == 0 || pid == reaping) return false;
+            if (::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH) return false;
+            if (!lease.pid.compare_exchange_strong(pid, reaping)) return false;
+            lease.pins[0].store(0);
+            lease.pins[1].store(0);
+            lease.pid.store(0);
+            return true;
+        }
+
+        inline ShmLease* claim_lease(ShmHeader* h) noexcept {
+            const auto pid = static_cast<std::uint32_t>(::getpid());
+            for (int attempt = 0; attempt < 2; attempt++) {
+                for (auto& lease : h->leases) {
+                    std::uint32_t free = 0;
+                    if (lease.pid.compare_exchange_strong(free, pid)) return &lease;
+                }
+                // The table is full: reclaim entries of dead processes
+                for (auto& lease : h->leases) reap(lease);
+            }
+            return nullptr;
+        }
+
+        inline std::expected<SharedDocument, std::error_code> fail_mapping(void* p, std::size_t size, std::error_code ec) {
+            ::munmap(p, size);
+            return std::unexpected(ec);
+        }
+#endif
+    } // namespace detail
+
+    SharedSnapshot::SharedSnapshot(SharedSnapshot&& other) noexcept
+        : m_Map{ std::move(other.m_Map) }, m_Slot{ other.m_Slot },
+          m_Generation{ std::exchange(other.m_Generation, 0) }, m_Root{ std::exchange(other.m_Root, frozen_view{}) } {}
+
+    SharedSnapshot& SharedSnapshot::operator=(SharedSnapshot&& other) noexcept {
+        if (this == &other) return *this;
+        release();
+        m_Map = std::move(other.m_Map);
+        m_Slot = other.m_Slot;
+        m_Generation = std::exchange(other.m_Generation, 0);
+        m_Root = std::exchange(other.m_Root, frozen_view{});
+        return *this;
+    }
+
+    SharedSnapshot::~SharedSnapshot() { release(); }
+
+    void SharedSnapshot::release() noexcept {
+        if (m_Map) m_Map->lease->pins[m_Slot].fetch_sub(1);
+        m_Map.reset();
+        m_Generation = 0;
+        m_Root = frozen_view{};
+    }
+
+    std::expected<SharedDocument, std::error_code> SharedDocument::create(std::string_view name, std::size_t capacity) {
+#if SONNET_HAS_SHM
+        auto page = detail::page_size();
+        if (!page) return std::unexpected(page.error());
+
+        std::string n = detail::shm_name(name);
+        int fd = ::shm_open(n.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) return std::unexpected(detail::last_error());
+
+        // Nobody else can use a segment we failed to set up
+        auto abandon = [&](std::error_code ec) {
+            ::close(fd);
+            ::shm_unlink(n.c_str());
+            return std::unexpected(ec);
+        };
+
+        capacity = (capacity + *page - 1) / *page * *page;
+        size_t offset = (sizeof(detail::ShmHeader) + *page - 1) / *page * *page;
+        size_t total = offset + 2 * capacity;
+        if (::ftruncate(fd, static_cast<off_t>(total)) != 0) return abandon(detail::last_error());
+
+        void* p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return abandon(detail::last_error());
+        ::close(fd);
+
+        auto* h = new (p) detail::ShmHeader{};
+        std::memcpy(h->magic, detail::shm_magic, 4);
+        h->version = detail::shm_version;
+        h->capacity = capacity;
+        h->slots_offset = offset;
+
+        SharedDocument doc;
+        doc.m_Map = std::make_shared<detail::ShmMapping>(h, total, detail::claim_lease(h));
+        doc.m_Writable = true;
+        return doc;
+#else
+        (void)name;
+        (void)capacity;
+        return std::unexpected(std::make_error_code(std::errc::function_not_supported));
+#endif
+    }
+
+    std::expected<SharedDocument, std::error_code> SharedDocument::open(std::string_view name) {
+#if SONNET_HAS_SHM
+        auto page = detail::page_size();
+        if (!page) return std::unexpected(page.error());
+
+        std::string n = detail::shm_name(name);
+        int fd = ::shm_open(n.c_str(), O_RDWR, 0);
+        if (fd < 0) return std::unexpected(detail::last_error());
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            auto ec = detail::last_error();
+            ::close(fd);
+            return std::unexpected(ec);
+        }
+        auto total = static_cast<size_t>(st.st_size);
+        if (total < sizeof(detail::ShmHeader)) {
+            ::close(fd);
+            return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+        }
+
+        void* p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return std::unexpected(detail::last_error());
+
+        auto* h = static_cast<detail::ShmHeader*>(p);
+        const std::uint64_t offset = h->slots_offset;
+        if (std::memcmp(h->magic, detail::shm_magic, 4) != 0 || h->version != detail::shm_version
+            || offset % *page != 0 || offset < sizeof(detail::ShmHeader) || offset > total
+            || h->capacity > (total - offset) / 2 || offset + 2 * h->capacity != total) {
+            return detail::fail_mapping(p, total, std::make_error_code(std::errc::invalid_argument));
+        }
+        if (::mprotect(detail::slot_data(h, 0), 2 * h->capacity, PROT_READ) != 0) return detail::fail_mapping(p, total, detail::last_error());
+
+        auto* lease = detail::claim_lease(h);
+        if (!lease) return detail::fail_mapping(p, total, std::make_error_code(std::errc::resource_unavailable_try_again));
+
+        SharedDocument doc;
+        doc.m_Map = std::make_shared<detail::ShmMapping>(h, total, lease);
+        return doc;
+#else
+        (void)name;
+        return std::unexpected(std::make_error_code(std::errc::function_not_supported));
+#endif
+    }
+
+    std::error_code SharedDocument::unlink(std::string_view name) {
+#if SONNET_HAS_SHM
+        if (::shm_unlink(detail::shm_name(name).c_str()) != 0) return detail::last_error();
+        return {};
+#else
+        (void)name;
+        return std::make_error_code(std::errc::function_not_supported);
+#endif
+    }
+
+    SharedDocument::SharedDocument(SharedDocument&& other) noexcept
+        : m_Map{ std::move(other.m_Map) }, m_Writable{ std::exchange(other.m_Writable, false) } {}
+
+    SharedDocument& SharedDocument::operator=(SharedDocument&& other) noexcept {
+        if (this == &other) return *this;
+        m_Map = std::move(other.m_Map);
+        m_Writable = std::exchange(other.m_Writable, false);
+        return *this;
+    }
+
+    SharedDocument::~SharedDocument() = default;
+
+    void SharedDocument::publish(const value& v, std::chrono::milliseconds timeout) {
+        if (!m_Writable) throw std::logic_error{ "Sonnet::SharedDocument::publish: handle is read-only" };
+
+        auto* h = m_Map->header;
+        auto bytes = freeze(v);
+        if (bytes.size() > h->capacity) throw std::length_error{ "Sonnet::SharedDocument::publish: document exceeds slot capacity" };
+
+        // Readers pin a slot and then re-check the generation, so once the
+        // idle slot's pins all read zero no reader can start using it until
+        // the generation below moves past it again
+        std::uint64_t gen = h->generation.load();
+        unsigned target = static_cast<unsigned>((gen + 1) & 1);
+        using clock = std::chrono::steady_clock;
+        const auto deadline = timeout == std::chrono::milliseconds::max() ? clock::time_point::max() : clock::now() + timeout;
+        for (auto& lease : h->leases) {
+            while (lease.pins[target].load() != 0) {
+#if SONNET_HAS_SHM
+                if (detail::reap(lease)) break;
+#endif
+                if (clock::now() >= deadline)
+                    throw std::system_error{ std::make_error_code(std::errc::timed_out), "Sonnet::SharedDocument::publish: readers still hold the idle slot" };
+                std::this_thread::yield();
+            }
+        }
+
+        std::memcpy(detail::slot_data(h, target), bytes.data(), bytes.size());
+        h->size[target] = bytes.size();
+        h->generation.store(gen + 1);
+    }
+
+    SharedSnapshot SharedDocument::snapshot() const {
+        auto* h = m_Map->header;
+        auto* lease = m_Map->lease;
+        SharedSnapshot snap;
+        while (true) {
+            std::uint64_t gen = h->generation.load();
+            if (gen == 0) return snap;
+
+            auto slot = static_cast<unsigned>(gen & 1);
+            lease->pins[slot].fetch_add(1);
+            if (h->generation.load() != gen) {
+                lease->pins[slot].fetch_sub(1);
+                continue;
+            }
+
+            snap.m_Map = m_Map;
+            snap.m_Slot = slot;
+            snap.m_Generation = gen;
+            auto root = open_frozen({ detail::slot_data(h, slot), static_cast<size_t>(h->size[slot]) });
+            if (root) snap.m_Root = *root;
+            return snap;
+        }
+    }
+
+    std::uint64_t SharedDocument::generation() const noexcept { return m_Map->header->generation.load(); }
+
+    std::size_t SharedDocument::capacity() const noexcept { return static_cast<size_t>(m_Map->header->capacity); }
+
+} // namespace Sonnet
@@ -1,23 +1,98 @@
 #include "sonnet/sonnet.hpp"
+#include "sonnet/hash.hpp"
+#include "sonnet/intern.hpp"
+#include "utf8.hpp"
 
 #include <sstream>
 #include <charconv>
 #include <cctype>
 #include <limits>
 #include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SONNET_HAS_SSE2 1
+#else
+#define SONNET_HAS_SSE2 0
+#endif
 
 
 namespace Sonnet {
 
     namespace detail {
+        struct TemplateBuilder {
+            std::vector<std::pair<const value*, size_t>> targets;
+            std::vector<Template::slot> slots;
+
+            bool try_mark(const value& v, size_t offset, size_t depth) {
+                for (const auto& [node, hole] : targets) {
+                    if (node != &v) continue;
+                    slots.push_back({ offset, hole, depth });
+                    return true;
+                }
+                return false;
+            }
+        };
+
+        // Byte sinks the serializer writes through. Each provides `put` and
+        // `write`; sinks that can report their position also provide `position`
+        struct StreamSink {
+            std::ostream& os;
+            void put(char c) { os.put(c); }
+            void write(const char* p, size_t n) { os.write(p, static_cast<std::streamsize>(n)); }
+        };
+
+        struct StringSink {
+            std::string& out;
+            void put(char c) { out.push_back(c); }
+            void write(const char* p, size_t n) { out.append(p, n); }
+            [[nodiscard]] size_t position() const noexcept { return out.size(); }
+        };
+
+        struct HashSink {
+            Sha256& hasher;
+            char buf[512];
+            size_t len = 0;
+
+            explicit HashSink(Sha256& h) : hasher{ h } {}
+
+            void put(char c) {
+                if (len == sizeof(buf)) flush();
+                buf[len++] = c;
+            }
+            void write(const char* p, size_t n) {
+                if (len + n > sizeof(buf)) flush();
+                if (n >= sizeof(buf)) { hasher.update(p, n); return; }
+                std::memcpy(buf + len, p, n);
+                len += n;
+            }
+            void flush() {
+                hasher.update(buf, len);
+                len = 0;
+            }
+        };
+
         ParseResult parse_impl(std::string_view text, const ParseOptions& opts);
-        void dump_impl(const value& v, std::ostream& os, const WriteOptions& opts, size_t depth);
+        std::expected<void, ParseError> parse_sax_impl(std::string_view text, SaxHandler& handler, const ParseOptions& opts);
+        template<typename Sink>
+        void dump_impl(const value& v, Sink& out, const WriteOptions& opts, size_t depth, KeyCache* keys, TemplateBuilder* holes = nullptr);
+        template<typename Sink>
+        void dump_string(std::string_view s, Sink& out, const WriteOptions& opts);
     } // namespace detail
 
     ParseResult parse(std::string_view input, const ParseOptions& opts) {
         return detail::parse_impl(input, opts);
     }
 
+    std::expected<void, ParseError> parse_sax(std::string_view input, SaxHandler& handler, const ParseOptions& opts) {
+        return detail::parse_sax_impl(input, handler, opts);
+    }
+
     ParseResult parse(std::istream& is, const ParseOptions& opts) {
         std::ostringstream oss;
         oss << is.rdbuf();
@@ -25,9 +100,109 @@ namespace Sonnet {
     }
 
     std::string dump(const value& v, const WriteOptions& opts) {
-        std::ostringstream oss;
-        detail::dump_impl(v, oss, opts, 0);
-        return oss.str();
+        std::string out;
+        detail::StringSink sink{ out };
+        detail::dump_impl(v, sink, opts, 0, nullptr);
+        return out;
+    }
+
+    void dump(const value& v, std::ostream& os, const WriteOptions& opts) {
+        detail::StreamSink sink{ os };
+        detail::dump_impl(v, sink, opts, 0, nullptr);
+    }
+
+    std::string dump(const value& v, KeyCache& keys, const WriteOptions& opts) {
+        std::string out;
+        detail::StringSink sink{ out };
+        detail::dump_impl(v, sink, opts, 0, &keys);
+        return out;
+    }
+
+    void dump(const value& v, std::ostream& os, KeyCache& keys, const WriteOptions& opts) {
+        detail::StreamSink sink{ os };
+        detail::dump_impl(v, sink, opts, 0, &keys);
+    }
+
+    Sha256::digest content_hash(const value& v) {
+        Sha256 hasher;
+        detail::HashSink sink{ hasher };
+        detail::dump_impl(v, sink, WriteOptions{ .canonical = true }, 0, nullptr);
+        sink.flush();
+        return hasher.finish();
+    }
+
+    KeyCache::KeyCache(std::size_t max_entries)
+        : m_MaxEntries{ max_entries } {}
+
+    std::string_view KeyCache::lookup(std::string_view key) {
+        if (auto it = m_Entries.find(key); it != m_Entries.end()) return it->second;
+
+        std::string esc;
+        detail::StringSink sink{ esc };
+        detail::dump_string(key, sink, WriteOptions{});
+        esc.push_back(':');
+
+        if (m_Entries.size() >= m_MaxEntries) {
+            m_Scratch = std::move(esc);
+            return m_Scratch;
+        }
+        auto [it, inserted] = m_Entries.emplace(std::string{ key }, std::move(esc));
+        return it->second;
+    }
+
+    void KeyCache::clear() noexcept {
+        m_Entries.clear();
+        m_Scratch.clear();
+    }
+
+    Template compile_template(const value& prototype, std::span<const std::string_view> holes, const WriteOptions& opts) {
+        detail::TemplateBuilder builder;
+        builder.targets.reserve(holes.size());
+        for (size_t i = 0; i < holes.size(); i++) {
+            auto ptr = pointer::parse(holes[i]);
+            const value* node = ptr ? ptr->resolve(prototype) : nullptr;
+            if (!node) throw std::invalid_argument{ "Sonnet::compile_template: hole does not resolve in prototype" };
+            for (const auto& t : builder.targets) 
+                if (t.first == node) throw std::invalid_argument{ "Sonnet::compile_template: duplicate hole" };
+            builder.targets.emplace_back(node, i);
+        }
+
+        Template t;
+        detail::StringSink sink{ t.m_Bytes };
+        detail::dump_impl(prototype, sink, opts, 0, nullptr, &builder);
+        if (builder.slots.size() != holes.size()) throw std::invalid_argument{ "Sonnet::compile_template: hole nested inside another hole" };
+
+        t.m_Slots = std::move(builder.slots);
+        t.m_Opts = opts;
+        return t;
+    }
+
+    namespace detail {
+        template<typename Sink>
+        void render_impl(const Template& tmpl, Sink& out, std::span<const value* const> args) {
+            if (args.size() != tmpl.hole_count()) throw std::invalid_argument{ "Sonnet::render: argument count does not match hole count" };
+
+            auto bytes = tmpl.bytes();
+            size_t pos = 0;
+            for (const auto& sl : tmpl.slots()) {
+                out.write(bytes.data() + pos, sl.offset - pos);
+                dump_impl(*args[sl.hole], out, tmpl.options(), sl.depth, nullptr);
+                pos = sl.offset;
+            }
+            out.write(bytes.data() + pos, bytes.size() - pos);
+        }
+    } // namespace detail
+
+    void render(const Template& tmpl, std::ostream& os, std::span<const value* const> args) {
+        detail::StreamSink sink{ os };
+        detail::render_impl(tmpl, sink, args);
+    }
+
+    std::string render(const Template& tmpl, std::span<const value* const> args) {
+        std::string out;
+        detail::StringSink sink{ out };
+        detail::render_impl(tmpl, sink, args);
+        return out;
     }
 
     
@@ -107,118 +282,11 @@ namespace Sonnet {
             }
         };
 
-        expected_t<value> parse_value(Scanner& s);
-        expected_t<value> parse_object(Scanner& s);
-        expected_t<value> parse_array(Scanner& s);
         expected_t<double> parse_number(Scanner& s);
         expected_t<string> parse_string(Scanner& s);
         expected_void parse_literal(Scanner& s, std::string_view literal, ParseError::code code, std::string_view fail_msg);
         expected_void skip_ws_and_comments(Scanner& s);
         
-        inline bool is_valid_utf8(std::string_view s, size_t& error_idx) {
-            const unsigned char* data = reinterpret_cast<const unsigned char*>(s.data());
-            size_t i = 0; 
-            size_t n = s.size();
-
-            auto fail = [&](size_t idx) { error_idx = idx; return false; };
-
-            while (i < n) {
-                unsigned char c = data[i];
-
-                if (c <= 0x7F) {
-                    i++;
-                    continue;
-                }
-
-                if (c >= 0xC2 && c <= 0xDF) {
-                    if (i + 1 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    if ((c1 & 0xC0) != 0x80) return fail(i);
-                    i += 2;
-                    continue;
-                }
-
-                if (c >= 0xE1 && c <= 0xEC) {
-                    if (i + 2 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    if ((c1 & 0xC0) != 0x80) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    i += 3;
-                    continue;
-                }
-
-                if (c == 0xE0) {
-                    if (i + 2 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    if (c1 < 0xA0 || c1 > 0xBF) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    i += 3;
-                    continue;
-                }
-
-                if (c == 0xED) {
-                    if (i + 2 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    if (c1 < 0x80 || c1 > 0x9F) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    i += 3;
-                    continue;
-                }
-
-                if (c >= 0xEE && c <= 0xEF) {
-                    if (i + 2 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    if ((c1 & 0xC0) != 0x80) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    i += 3;
-                    continue;
-                }
-
-                if (c == 0xF0) {
-                    if (i + 3 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    unsigned char c3 = data[i + 3];
-                    if (c1 < 0x90 || c1 > 0xBF) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    if ((c3 & 0xC0) != 0x80) return fail(i);
-                    i += 4;
-                    continue;
-                }
-
-                if (c >= 0xF1 && c <= 0xF3) {
-                    if (i + 3 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    unsigned char c3 = data[i + 3];
-                    if ((c1 & 0xC0) != 0x80) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    if ((c3 & 0xC0) != 0x80) return fail(i);
-                    i += 4;
-                    continue;
-                }
-
-                if (c == 0xF4) {
-                    if (i + 3 >= n) return fail(i);
-                    unsigned char c1 = data[i + 1];
-                    unsigned char c2 = data[i + 2];
-                    unsigned char c3 = data[i + 3];
-                    if (c1 < 0x80 || c1 > 0x8F) return fail(i);
-                    if ((c2 & 0xC0) != 0x80) return fail(i);
-                    if ((c3 & 0xC0) != 0x80) return fail(i);
-                    i += 4;
-                    continue;
-                }
-
-                return fail(i);
-            }
-            return true;
-        }
-
         void append_utf8(uint32_t cp, string& out) {
             if (cp <= 0x7F) {
                 out.push_back(static_cast<char>(cp));
@@ -406,126 +474,157 @@ namespace Sonnet {
             return res;
         }
 
-        expected_t<value> parse_array(Scanner& s) {
-            DepthGuard guard{ s };
-            if (s.max_depth != 0 && !guard.ok()) return std::unexpected(s.make_error(ParseError::code::depth_limit_exceeded, "Maximum nesting depth exceeded"));
-            if (!s.consume('[')) return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected '[' to start array"));
+        // The JSON grammar, written once for every consumer: each item is
+        // reported to a SAX-style handler `H` as it is read. `parse_sax`
+        // instantiates it with the virtual `SaxHandler`, `parse` with the
+        // final `DomBuilder`, whose calls are resolved statically and which
+        // adopts the parsed strings instead of copying them
+        template<typename H>
+        expected_void sax_value(Scanner& s, H& h);
 
-            array arr{ Sonnet::allocator_type(s.mem_res) };
-
-            if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-            if (s.consume(']')) return value{ std::move(arr), s.mem_res };
+        expected_void sax_aborted(const Scanner& s) {
+            return std::unexpected(s.make_error(ParseError::code::aborted, "Parsing stopped by handler"));
+        }
 
-            while (true) {
-                auto elem = parse_value(s);
-                if (!elem) return std::unexpected(std::move(elem.error()));
-                arr.emplace_back(std::move(*elem));
+        template<typename H>
+        expected_void sax_array(Scanner& s, H& h) {
+            DepthGuard guard{ s };
+            if (s.max_depth != 0 && !guard.ok()) return std::unexpected(s.make_error(ParseError::code::depth_limit_exceeded, "Maximum nesting depth exceeded"));
+            s.get();
+            if (!h.on_start_array(SaxHandler::unknown_size)) return sax_aborted(s);
 
-                if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
+            if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+            if (!s.consume(']')) {
+                while (true) {
+                    if (auto elem = sax_value(s, h); !elem) return elem;
+                    if (auto ws = skip_ws_and_comments(s); !ws) return ws;
 
-                char c = s.peek();
-                if (c == ',') {
-                    s.get();
-                    if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-                    
-                    char next = s.peek();
-                    if (next == ']') {
-                        if (s.opts.allow_trailing_commas) {
+                    char c = s.peek();
+                    if (c == ',') {
+                        s.get();
+                        if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+                        if (s.peek() == ']') {
+                            if (!s.opts.allow_trailing_commas) return std::unexpected(s.make_error(ParseError::code::trailing_characters, "Trailing commas not allowed"));
                             s.get();
                             break;
-                        } else return std::unexpected(s.make_error(ParseError::code::trailing_characters, "Trailing commas not allowed"));
+                        }
+                        continue;
                     }
-                    continue;
+                    if (c == ']') { s.get(); break; }
+                    if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminated array, expected ',' or ']'"));
+                    return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected ',' or ']' in array"));
                 }
-                if (c == ']') { s.get(); break; }
-                if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminated array, expected ',' or ']'"));
-                return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected ',' or ']' in array"));
             }
-            return value{ std::move(arr), s.mem_res };
+            if (!h.on_end_array()) return sax_aborted(s);
+            return {};
         }
 
-        expected_t<value> parse_object(Scanner& s) {
+        template<typename H>
+        expected_void sax_object(Scanner& s, H& h) {
             DepthGuard guard{ s };
             if (s.max_depth != 0 && !guard.ok()) return std::unexpected(s.make_error(ParseError::code::depth_limit_exceeded, "Maximum nesting depth exceeded"));
-            if (!s.consume('{')) return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected '{' to start object"));
-            object obj{ std::less<>{}, Sonnet::allocator_type(s.mem_res) };
-            if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-            if (s.consume('}')) return value{ std::move(obj), s.mem_res };
-            while (true) {
-                char c = s.peek();
-                if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminted object, expected '}' or string key"));
-                if (c != '"') return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected \" to start object key"));
-                auto key_val = parse_string(s);
-                if (!key_val) return std::unexpected(key_val.error());
-                string key = std::move(*key_val);
-                if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-                c = s.peek();
-                if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminated object, expected ':' after key"));
-                if (c != ':') return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected ':' after object key"));
-                s.get();
-                if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-                auto val = parse_value(s);
-                if (!val) return std::unexpected(val.error());
-                obj[std::move(key)] = std::move(*val); // Enforce last-wins here
-                if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-                c = s.peek();
-                if (c == ',') {
+            s.get();
+            if (!h.on_start_object(SaxHandler::unknown_size)) return sax_aborted(s);
+
+            if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+            if (!s.consume('}')) {
+                while (true) {
+                    char c = s.peek();
+                    if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminted object, expected '}' or string key"));
+                    if (c != '"') return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected \" to start object key"));
+                    auto key = parse_string(s);
+                    if (!key) return std::unexpected(std::move(key.error()));
+                    if (!h.on_key(std::move(*key))) return sax_aborted(s);
+
+                    if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+                    c = s.peek();
+                    if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminated object, expected ':' after key"));
+                    if (c != ':') return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected ':' after object key"));
                     s.get();
-                    if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-                    if (s.opts.allow_trailing_commas && s.peek() == '}') { s.get(); break; }
-                    continue;
+                    if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+                    if (auto val = sax_value(s, h); !val) return val;
+
+                    if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+                    c = s.peek();
+                    if (c == ',') {
+                        s.get();
+                        if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+                        if (s.opts.allow_trailing_commas && s.peek() == '}') { s.get(); break; }
+                        continue;
+                    }
+                    if (c == '}') { s.get(); break; }
+                    if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminated object, expected ',' or '}'"));
+                    return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected ',' or '}' in object"));
                 }
-                if (c == '}') { s.get(); break; }
-                if (c == '\0') return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Unterminated object, expected ',' or '}'"));
-                return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Expected ',' or '}' in object"));
             }
-            return value{ std::move(obj), s.mem_res };
+            if (!h.on_end_object()) return sax_aborted(s);
+            return {};
         }
 
-        expected_t<value> parse_value(Scanner& s) {
-            if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
+        template<typename H>
+        expected_void sax_value(Scanner& s, H& h) {
+            if (auto ws = skip_ws_and_comments(s); !ws) return ws;
             if (s.eof()) return std::unexpected(s.make_error(ParseError::code::unexpected_end_of_input, "Expected JSON value"));
+
+            bool ok = true;
             char c = s.peek();
             switch (c) {
-            case 'n': {
-                if (auto r = parse_literal(s, "null", ParseError::code::unexpected_character, "Invalid 'null' literal"); !r) return std::unexpected(r.error());
-                return value{ nullptr, s.mem_res };
-            } 
-            case 't': {
-                if (auto r = parse_literal(s, "true", ParseError::code::unexpected_character, "Invalid 'true' literal"); !r) return std::unexpected(r.error());
-                return value{ true, s.mem_res };
-            }
-            case 'f': {
-                if (auto r = parse_literal(s, "false", ParseError::code::unexpected_character, "Invalid 'false' literal"); !r) return std::unexpected(r.error());
-                return value{ false, s.mem_res };
-            }
+            case 'n':
+                if (auto r = parse_literal(s, "null", ParseError::code::unexpected_character, "Invalid 'null' literal"); !r) return r;
+                ok = h.on_null();
+                break;
+            case 't':
+                if (auto r = parse_literal(s, "true", ParseError::code::unexpected_character, "Invalid 'true' literal"); !r) return r;
+                ok = h.on_bool(true);
+                break;
+            case 'f':
+                if (auto r = parse_literal(s, "false", ParseError::code::unexpected_character, "Invalid 'false' literal"); !r) return r;
+                ok = h.on_bool(false);
+                break;
             case '"': {
                 auto str = parse_string(s);
-                if (!str) return std::unexpected(str.error());
-                return value{ std::move(*str), s.mem_res };
+                if (!str) return std::unexpected(std::move(str.error()));
+                ok = h.on_string(std::move(*str));
+                break;
             }
-            case '[': return parse_array(s);
-            case '{': return parse_object(s);
+            case '[': return sax_array(s, h);
+            case '{': return sax_object(s, h);
             default:
                 if (c == '-' || (c >= '0' && c <= '9')) {
                     auto num = parse_number(s);
-                    if (!num) return std::unexpected(num.error());
-                    return value{ *num, s.mem_res };
+                    if (!num) return std::unexpected(std::move(num.error()));
+                    ok = h.on_number(*num);
+                    break;
                 }
-                else if (c == '.') return std::unexpected(s.make_error(ParseError::code::invalid_number, "Fractional values must start with a 0"));
+                if (c == '.') return std::unexpected(s.make_error(ParseError::code::invalid_number, "Fractional values must start with a 0"));
                 return std::unexpected(s.make_error(ParseError::code::unexpected_character, "Unexpected character while parsing value"));
             }
+            if (!ok) return sax_aborted(s);
+            return {};
+        }
+
+        template<typename H>
+        expected_void sax_document(Scanner& s, H& h) {
+            if (auto v = sax_value(s, h); !v) return v;
+            if (auto ws = skip_ws_and_comments(s); !ws) return ws;
+            if (!s.eof()) return std::unexpected(s.make_error(ParseError::code::trailing_characters, "Trailing characters after top-level JSON value"));
+            return {};
         }
 
         ParseResult parse_impl(std::string_view text, const ParseOptions& opts) {
             std::pmr::memory_resource* res = std::pmr::get_default_resource();
             Scanner s{ text, opts, res };
+            DomBuilder builder{ res, opts.pack_numeric_arrays };
 
-            auto v = parse_value(s);
-            if (!v) return std::unexpected(v.error());
-            if (auto ws = skip_ws_and_comments(s); !ws) return std::unexpected(ws.error());
-            if (!s.eof()) return std::unexpected(s.make_error(ParseError::code::trailing_characters, "Trailing characters after top-level JSON value"));
-            return *std::move(v);
+            if (auto r = sax_document(s, builder); !r) return std::unexpected(std::move(r.error()));
+            value v = std::move(builder.result());
+            if (opts.intern_subtrees) intern_subtrees(v);
+            return v;
+        }
+
+        expected_void parse_sax_impl(std::string_view text, SaxHandler& handler, const ParseOptions& opts) {
+            Scanner s{ text, opts, std::pmr::get_default_resource() };
+            return sax_document(s, handler);
         }
 #pragma endregion
 #pragma region Serializer
@@ -534,114 +633,633 @@ namespace Sonnet {
         // Internal serializer implementation
         // ================================
 
-        void dump_string(const string& s, std::ostream& os) {
-            os.put('"');
-            for (unsigned char c : s) {
-                switch (c) {
-                case '"': os << "\\\""; break;
-                case '\\': os << "\\\\"; break;
-                case '\b': os << "\\b"; break;
-                case '\f': os << "\\f"; break;
-                case '\n': os << "\\n"; break;
-                case '\r': os << "\\r"; break;
-                case '\t': os << "\\t"; break;
-                default:
-                    if (c < 0x20) {
-                        // control characters -> \u00XX
-                        static constexpr char hex[] = "0123456789ABCDEF";
-                        os << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
-                    } else {
-                        os.put(static_cast<char>(c));
-                    }
-                    break;
+        // Returns the first byte in [p, end) that cannot be copied verbatim into
+        // a JSON string: a control character, '"', '\\' or, when `ascii_only`
+        // is set, any byte >= 0x80. Plain runs are skipped 16 bytes at a time
+        // where SSE2 is available
+        const char* find_escape(const char* p, const char* end, bool ascii_only) noexcept {
+#if SONNET_HAS_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i ctl_max = _mm_set1_epi8(0x1F);
+            const __m128i zero = _mm_setzero_si128();
+            while (end - p >= 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_max_epu8(chunk, ctl_max), ctl_max));
+                if (ascii_only) hits = _mm_or_si128(hits, _mm_cmplt_epi8(chunk, zero));
+                auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+                if (mask != 0) return p + std::countr_zero(mask);
+                p += 16;
+            }
+#endif
+            for (; p < end; p++) {
+                auto c = static_cast<unsigned char>(*p);
+                if (c < 0x20 || c == '"' || c == '\\' || (ascii_only && c >= 0x80)) return p;
+            }
+            return end;
+        }
+
+        // Decodes one UTF-8 sequence starting at `p`. Returns the code point and
+        // advances `p`; malformed input yields U+FFFD and consumes one byte
+        uint32_t decode_utf8(const char*& p, const char* end) noexcept {
+            auto b0 = static_cast<unsigned char>(p[0]);
+            auto cont = [&](ptrdiff_t i) { return static_cast<unsigned char>(p[i]) & 0x3Fu; };
+            auto is_cont = [&](ptrdiff_t i) { return i < end - p && (static_cast<unsigned char>(p[i]) & 0xC0u) == 0x80u; };
+
+            if (b0 >= 0xC2 && b0 <= 0xDF && is_cont(1)) {
+                uint32_t cp = ((b0 & 0x1Fu) << 6) | cont(1);
+                p += 2;
+                return cp;
+            }
+            if (b0 >= 0xE0 && b0 <= 0xEF && is_cont(1) && is_cont(2)) {
+                uint32_t cp = ((b0 & 0x0Fu) << 12) | (cont(1) << 6) | cont(2);
+                if (cp >= 0x800 && (cp < 0xD800 || cp > 0xDFFF)) {
+                    p += 3;
+                    return cp;
                 }
             }
-            os.put('"');
+            if (b0 >= 0xF0 && b0 <= 0xF4 && is_cont(1) && is_cont(2) && is_cont(3)) {
+                uint32_t cp = ((b0 & 0x07u) << 18) | (cont(1) << 12) | (cont(2) << 6) | cont(3);
+                if (cp >= 0x10000 && cp <= 0x10FFFF) {
+                    p += 4;
+                    return cp;
+                }
+            }
+            p += 1;
+            return 0xFFFD;
+        }
+
+        // Writes the escape sequence for the character at `p` (which
+        // `find_escape` stopped on) into `esc` and advances `p` past it.
+        // Returns the escape length, at most 12 bytes (a surrogate pair)
+        size_t escape_one(const char*& p, const char* end, const WriteOptions& opts, char* esc) noexcept {
+            // Canonical (RFC 8785) output uses lowercase hex in \u escapes and
+            // never escapes non-ASCII characters, so it overrides ensure_ascii
+            static constexpr char upper_hex[] = "0123456789ABCDEF";
+            static constexpr char lower_hex[] = "0123456789abcdef";
+            const char* hex = opts.canonical ? lower_hex : upper_hex;
+
+            auto put_u16 = [&](char* o, uint32_t unit) {
+                o[0] = '\\';
+                o[1] = 'u';
+                o[2] = hex[(unit >> 12) & 0xF];
+                o[3] = hex[(unit >> 8) & 0xF];
+                o[4] = hex[(unit >> 4) & 0xF];
+                o[5] = hex[unit & 0xF];
+            };
+
+            auto c = static_cast<unsigned char>(*p);
+            if (c >= 0x80) {
+                uint32_t cp = decode_utf8(p, end);
+                if (cp < 0x10000) {
+                    put_u16(esc, cp);
+                    return 6;
+                }
+                cp -= 0x10000;
+                put_u16(esc, 0xD800 + (cp >> 10));
+                put_u16(esc + 6, 0xDC00 + (cp & 0x3FF));
+                return 12;
+            }
+
+            p++;
+            esc[0] = '\\';
+            switch (c) {
+            case '"': esc[1] = '"'; return 2;
+            case '\\': esc[1] = '\\'; return 2;
+            case '\b': esc[1] = 'b'; return 2;
+            case '\f': esc[1] = 'f'; return 2;
+            case '\n': esc[1] = 'n'; return 2;
+            case '\r': esc[1] = 'r'; return 2;
+            case '\t': esc[1] = 't'; return 2;
+            default: put_u16(esc, c); return 6; // control characters -> \u00XX
+            }
+        }
+
+        template<typename Sink>
+        void dump_string(std::string_view s, Sink& out, const WriteOptions& opts) {
+            const bool ascii_only = opts.ensure_ascii && !opts.canonical;
+
+            out.put('"');
+            const char* p = s.data();
+            const char* end = p + s.size();
+            while (p < end) {
+                const char* run = p;
+                p = find_escape(p, end, ascii_only);
+                if (p != run) out.write(run, static_cast<size_t>(p - run));
+                if (p == end) break;
+
+                char esc[12];
+                out.write(esc, escape_one(p, end, opts, esc));
+            }
+            out.put('"');
         }
 
-        void dump_indent(std::ostream& os, size_t depth, const WriteOptions& opts) {
-            if (!opts.pretty || opts.indent == 0) return;
+        template<typename Sink>
+        void dump_indent(Sink& out, size_t depth, const WriteOptions& opts) {
+            if (!opts.pretty || opts.canonical || opts.indent == 0) return;
             size_t spaces = depth * opts.indent;
-            for (size_t i = 0; i < spaces; i++) os.put(' ');
+            static constexpr char blanks[] = "                                ";
+            while (spaces > 0) {
+                size_t n = std::min(spaces, sizeof(blanks) - 1);
+                out.write(blanks, n);
+                spaces -= n;
+            }
         }
 
-        void dump_impl(const value& v, std::ostream& os, const WriteOptions& opts, size_t depth) {
-            switch (v.type()) {
-            case kind::null: os << "null"; return;
-            case kind::boolean: os << (v.as_bool() ? "true" : "false"); return;
-            case kind::number: {
-                double d = v.as_number();
+        // Formats a finite double the way ECMAScript's Number::toString does
+        // (RFC 8785 section 3.2.2.3): shortest round-trip digits, plain notation
+        // for decimal exponents in [-6, 21), exponential notation otherwise
+        size_t format_number_es(double d, char* buf) {
+            if (d == 0.0) {
+                buf[0] = '0';
+                return 1;
+            }
+
+            char sci[32];
+            auto [sci_end, ec] = std::to_chars(sci, sci + sizeof(sci), d, std::chars_format::scientific);
+            if (ec != std::errc{}) {
+                buf[0] = '0';
+                return 1;
+            }
+
+            const char* p = sci;
+            size_t len = 0;
+            if (*p == '-') {
+                buf[len++] = '-';
+                p++;
+            }
+
+            char digits[20];
+            int k = 0;
+            for (; p < sci_end && *p != 'e'; p++) 
+                if (*p != '.') digits[k++] = *p;
+            while (k > 1 && digits[k - 1] == '0') k--;
+
+            int exp10 = 0;
+            std::from_chars(*(p + 1) == '+' ? p + 2 : p + 1, sci_end, exp10);
+            int n = exp10 + 1;
+
+            auto put_digits = [&](int from, int to) { for (int i = from; i < to; i++) buf[len++] = digits[i]; };
+
+            if (k <= n && n <= 21) {
+                put_digits(0, k);
+                for (int i = k; i < n; i++) buf[len++] = '0';
+            } else if (0 < n && n <= 21) {
+                put_digits(0, n);
+                buf[len++] = '.';
+                put_digits(n, k);
+            } else if (-6 < n && n <= 0) {
+                buf[len++] = '0';
+                buf[len++] = '.';
+                for (int i = 0; i < -n; i++) buf[len++] = '0';
+                put_digits(0, k);
+            } else {
+                put_digits(0, 1);
+                if (k > 1) {
+                    buf[len++] = '.';
+                    put_digits(1, k);
+                }
+                buf[len++] = 'e';
+                buf[len++] = (n - 1 < 0) ? '-' : '+';
+                auto [e_end, e_ec] = std::to_chars(buf + len, buf + len + 8, n - 1 < 0 ? 1 - n : n - 1);
+                len = static_cast<size_t>(e_end - buf);
+            }
+            return len;
+        }
+
+        // Orders two UTF-8 strings by their UTF-16 code units, as RFC 8785
+        // requires for object keys
+        bool utf16_less(std::string_view a, std::string_view b) {
+            auto next_unit = [](std::string_view s, size_t& i, uint32_t& pending) -> uint32_t {
+                if (pending) {
+                    uint32_t u = pending;
+                    pending = 0;
+                    return u;
+                }
+                auto c = static_cast<unsigned char>(s[i]);
+                uint32_t cp = c;
+                size_t extra = 0;
+                if (c >= 0xF0) { cp = c & 0x07u; extra = 3; }
+                else if (c >= 0xE0) { cp = c & 0x0Fu; extra = 2; }
+                else if (c >= 0xC0) { cp = c & 0x1Fu; extra = 1; }
+                i++;
+                for (size_t j = 0; j < extra && i < s.size(); j++, i++) 
+                    cp = (cp << 6) | (static_cast<unsigned char>(s[i]) & 0x3Fu);
+                if (cp >= 0x10000) {
+                    cp -= 0x10000;
+                    pending = 0xDC00 + (cp & 0x3FF);
+                    return 0xD800 + (cp >> 10);
+                }
+                return cp;
+            };
+
+            size_t i = 0, j = 0;
+            uint32_t pa = 0, pb = 0;
+            while ((i < a.size() || pa) && (j < b.size() || pb)) {
+                uint32_t ua = next_unit(a, i, pa);
+                uint32_t ub = next_unit(b, j, pb);
+                if (ua != ub) return ua < ub;
+            }
+            return !(i < a.size() || pa) && (j < b.size() || pb);
+        }
+
+        template<typename Sink>
+        struct Writer {
+            Sink& out;
+            const WriteOptions& opts;
+            KeyCache* keys = nullptr;
+            TemplateBuilder* holes = nullptr;
+
+            [[nodiscard]] bool pretty() const noexcept { return opts.pretty && !opts.canonical; }
+
+            void write_literal(std::string_view s) { out.write(s.data(), s.size()); }
+
+            void write_key(std::string_view k) {
+                if (keys && !opts.canonical && !opts.ensure_ascii) {
+                    auto esc = keys->lookup(k);
+                    out.write(esc.data(), esc.size());
+                    if (pretty()) out.put(' ');
+                } else {
+                    dump_string(k, out, opts);
+                    if (pretty()) write_literal(": ");
+                    else out.put(':');
+                }
+            }
+
+            void write_number(double d) {
                 if (!std::isfinite(d)) {
-                    os << "null"; 
+                    write_literal("null");
                     return;
                 }
 
                 char buf[64];
+                if (opts.canonical) {
+                    out.write(buf, format_number_es(d, buf));
+                    return;
+                }
                 auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), d, std::chars_format::general);
-                if (ec != std::errc{}) os << "0"; // in case something goes wrong
-                else os.write(buf, ptr - buf);
-                return;
+                if (ec != std::errc{}) out.put('0'); // in case something goes wrong
+                else out.write(buf, static_cast<size_t>(ptr - buf));
             }
-            case kind::string: {
-                dump_string(v.as_string(), os);
-                return;
+
+            void write_member(std::string_view k, const value& val, size_t depth, bool last) {
+                if (pretty()) dump_indent(out, depth + 1, opts);
+                write_key(k);
+                write(val, depth + 1);
+                if (!last) out.put(',');
+                if (pretty()) out.put('\n');
             }
-            case kind::array: {
-                const auto& arr = v.as_array();
-                size_t n = arr.size();
 
-                os.put('[');
-                if (n == 0) {
-                    os.put(']');
+            void write(const value& v, size_t depth) {
+                if constexpr (requires { out.position(); }) {
+                    if (holes && holes->try_mark(v, out.position(), depth)) return;
+                }
+
+                switch (v.type()) {
+                case kind::null: write_literal("null"); return;
+                case kind::boolean: write_literal(v.as_bool() ? "true" : "false"); return;
+                case kind::number: write_number(v.as_number()); return;
+                case kind::string: {
+                    dump_string(v.as_string(), out, opts);
+                    return;
+                }
+                case kind::array: {
+                    size_t n = v.size();
+
+                    out.put('[');
+                    if (n == 0) {
+                        out.put(']');
+                        return;
+                    }
+
+                    if (pretty()) out.put('\n');
+                    for (size_t i = 0; i < n; i++) {
+                        if (pretty()) dump_indent(out, depth + 1, opts);
+                        // A hole can name a packed element, which only
+                        // the element nodes of the array can match
+                        if (v.is_packed() && !holes) write_number(v.numbers()[i]);
+                        else write(v.as_array()[i], depth + 1);
+                        if (i + 1 < n) out.put(',');
+                        if (pretty()) out.put('\n');
+                    }
+                    if (pretty()) dump_indent(out, depth, opts);
+                    out.put(']');
                     return;
                 }
+                case kind::object: {
+                    const auto& obj = v.as_object();
+                    size_t n = obj.size();
+
+                    out.put('{');
+                    if (n == 0) {
+                        out.put('}');
+                        return;
+                    }
+
+                    if (pretty()) out.put('\n');
+
+                    // Note: object is a std::pmr::map so keys are already sorted by
+                    // byte (code point) order; write_options::sort_keys currently
+                    // doesn't change behavior, but it's there for future unordered_map.
+                    // Canonical output orders by UTF-16 code units instead, which only
+                    // differs when keys mix U+E000..U+FFFF with supplementary characters
+                    bool reorder = false;
+                    if (opts.canonical) {
+                        for (const auto& [k, val] : obj) {
+                            for (char c : k) {
+                                if (static_cast<unsigned char>(c) >= 0xEE) { reorder = true; break; }
+                            }
+                            if (reorder) break;
+                        }
+                    }
+
+                    if (reorder) {
+                        std::vector<const object::value_type*> members;
+                        members.reserve(n);
+                        for (const auto& m : obj) members.push_back(&m);
+                        std::sort(members.begin(), members.end(), [](auto* l, auto* r) { return utf16_less(l->first, r->first); });
+                        for (size_t i = 0; i < n; i++) write_member(members[i]->first, members[i]->second, depth, i + 1 == n);
+                    } else {
+                        size_t i = 0;
+                        for (const auto& [k, val] : obj) {
+                            write_member(k, val, depth, i + 1 == n);
+                            i++;
+                        }
+                    }
+
+                    if (pretty()) dump_indent(out, depth, opts);
+                    out.put('}');
+                    return;
+                }
+                }
+                write_literal("null");
+            }
+        };
+
+        template<typename Sink>
+        void dump_impl(const value& v, Sink& out, const WriteOptions& opts, size_t depth, KeyCache* keys, TemplateBuilder* holes) {
+            Writer<Sink>{ out, opts, keys, holes }.write(v, depth);
+        }
+
+        // Incremental serializer behind `dump_to`. All traversal state lives in
+        // the caller's `DumpState`, so output can stop at any byte and resume.
+        // Each step either drains pending bytes (short tokens, escapes and
+        // separators staged in the state), emits indentation, copies part of
+        // a string, or advances the traversal to stage the next token
+        struct ChunkWriter {
+            DumpState& st;
+            char* p;
+            char* end;
+
+            using frame = DumpState::frame;
+            using step = DumpState::step;
+
+            [[nodiscard]] bool pretty() const noexcept { return st.m_Opts.pretty && !st.m_Opts.canonical; }
+
+            void stage(std::string_view s) noexcept {
+                std::memcpy(st.m_Pending.data() + st.m_PendingLen, s.data(), s.size());
+                st.m_PendingLen = static_cast<uint8_t>(st.m_PendingLen + s.size());
+            }
+
+            void stage_indent(size_t depth) noexcept {
+                if (!pretty()) return;
+                stage("\n");
+                st.m_Spaces = depth * st.m_Opts.indent;
+            }
+
+            bool drain_pending() noexcept {
+                size_t left = static_cast<size_t>(st.m_PendingLen - st.m_PendingPos);
+                size_t n = std::min(left, static_cast<size_t>(end - p));
+                std::memcpy(p, st.m_Pending.data() + st.m_PendingPos, n);
+                p += n;
+                st.m_PendingPos = static_cast<uint8_t>(st.m_PendingPos + n);
+                if (st.m_PendingPos < st.m_PendingLen) return false;
+                st.m_PendingLen = st.m_PendingPos = 0;
+                return true;
+            }
+
+            bool drain_spaces() noexcept {
+                size_t n = std::min(st.m_Spaces, static_cast<size_t>(end - p));
+                std::memset(p, ' ', n);
+                p += n;
+                st.m_Spaces -= n;
+                return st.m_Spaces == 0;
+            }
+
+            // Copies string content; returns false when the buffer filled up
+            bool drain_string() noexcept {
+                const bool ascii_only = st.m_Opts.ensure_ascii && !st.m_Opts.canonical;
+                while (st.m_Str < st.m_StrEnd) {
+                    const char* e = find_escape(st.m_Str, st.m_StrEnd, ascii_only);
+                    if (e != st.m_Str) {
+                        size_t n = std::min(static_cast<size_t>(e - st.m_Str), static_cast<size_t>(end - p));
+                        std::memcpy(p, st.m_Str, n);
+                        p += n;
+                        st.m_Str += n;
+                        if (st.m_Str < e) return false;
+                        continue;
+                    }
+                    st.m_PendingLen = static_cast<uint8_t>(escape_one(st.m_Str, st.m_StrEnd, st.m_Opts, st.m_Pending.data()));
+                    if (!drain_pending()) return false;
+                }
 
-                if (opts.pretty) os.put('\n');
-                for (size_t i = 0; i < n; i++) {
-                    if (opts.pretty) dump_indent(os, depth + 1, opts);
-                    dump_impl(arr[i], os, opts, depth + 1);
-                    if (i + 1 < n) os.put(',');
-                    if (opts.pretty) os.put('\n');
+                st.m_InString = false;
+                stage("\"");
+                if (st.m_StrIsKey) stage(pretty() ? ": " : ":");
+                return true;
+            }
+
+            void start_string(std::string_view s, bool is_key) noexcept {
+                stage("\"");
+                st.m_Str = s.data();
+                st.m_StrEnd = s.data() + s.size();
+                st.m_StrIsKey = is_key;
+                st.m_InString = true;
+            }
+
+            bool push(const value& v) noexcept {
+                if (st.m_Depth == DumpState::max_depth) {
+                    st.m_Phase = DumpState::phase::failed;
+                    return false;
+                }
+                frame& f = st.m_Stack[st.m_Depth++];
+                f = frame{};
+                f.node = &v;
+                if (v.is_object()) {
+                    f.it = v.as_object().begin();
+                    if (st.m_Opts.canonical) {
+                        for (const auto& m : v.as_object()) {
+                            for (char c : m.first) 
+                                if (static_cast<unsigned char>(c) >= 0xEE) f.reorder = true;
+                        }
+                    }
+                    if (f.reorder) return sort_members(f);
+                }
+                return true;
+            }
+
+            // Appends the members of the frame's object to `m_Sorted` in
+            // UTF-16 order, so each resume picks the next one by index
+            bool sort_members(frame& f) noexcept {
+                const auto& obj = f.node->as_object();
+                f.sorted = st.m_Sorted.size();
+                try {
+                    st.m_Sorted.reserve(f.sorted + obj.size());
+                } catch (...) {
+                    st.m_Phase = DumpState::phase::failed;
+                    return false;
+                }
+                for (const auto& m : obj) st.m_Sorted.push_back(&m);
+                std::sort(st.m_Sorted.begin() + static_cast<std::ptrdiff_t>(f.sorted), st.m_Sorted.end(),
+                          [](auto* l, auto* r) { return utf16_less(l->first, r->first); });
+                return true;
+            }
+
+            void stage_number(double d) noexcept {
+                if (!std::isfinite(d)) {
+                    stage("null");
+                    return;
+                }
+                char buf[32];
+                if (st.m_Opts.canonical) {
+                    stage({ buf, format_number_es(d, buf) });
+                    return;
                 }
-                if (opts.pretty) dump_indent(os, depth, opts);
-                os.put(']');
-                return;
+                auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), d, std::chars_format::general);
+                if (ec != std::errc{}) stage("0");
+                else stage({ buf, static_cast<size_t>(ptr - buf) });
             }
-            case kind::object: {
-                const auto& obj = v.as_object();
-                size_t n = obj.size();
 
-                os.put('{');
-                if (n == 0) {
-                    os.put('}');
+            void start_value(const value& v) noexcept {
+                switch (v.type()) {
+                case kind::null: stage("null"); return;
+                case kind::boolean: stage(v.as_bool() ? "true" : "false"); return;
+                case kind::number: stage_number(v.as_number()); return;
+                case kind::string: start_string(v.as_string(), false); return;
+                case kind::array: 
+                    if (v.size() == 0) { stage("[]"); return; }
+                    if (push(v)) stage("[");
+                    return;
+                case kind::object: 
+                    if (v.as_object().empty()) { stage("{}"); return; }
+                    if (push(v)) stage("{");
                     return;
                 }
+            }
 
-                // Note: object is a std::pmr::map so keys are already sorted by
-                // lexicographical order; write_options::sort_keys currently
-                // doesn't change behavior, but it's there for future unordered_map.
-                if (opts.pretty) os.put('\n');
+            const object::value_type* next_member(frame& f) noexcept {
+                if (!f.reorder) return &*f.it++;
+                return st.m_Sorted[f.sorted + f.index];
+            }
 
-                size_t i = 0;
-                for (const auto& [k, val] : obj) {
-                    if (opts.pretty) dump_indent(os, depth + 1, opts);
-                    dump_string(k, os);
-                    os << (opts.pretty ? ": " : ":");
-                    dump_impl(val, os, opts, depth + 1);
-                    if (i + 1 < n) os.put(',');
-                    if (opts.pretty) os.put('\n');
-                    i++;
+            void advance() noexcept {
+                frame& f = st.m_Stack[st.m_Depth - 1];
+                const bool is_array = f.node->is_array();
+                const size_t n = f.node->size();
+
+                switch (f.next) {
+                case step::member:
+                    if (f.index == n) {
+                        stage_indent(st.m_Depth - 1);
+                        f.next = step::closing;
+                        return;
+                    }
+                    if (f.index > 0) stage(",");
+                    stage_indent(st.m_Depth);
+                    if (f.node->is_packed()) {
+                        // Staged on the next step, once the indentation
+                        // queued above has been written
+                        f.next = step::number;
+                        return;
+                    }
+                    if (is_array) {
+                        st.m_Next = &f.node->as_array()[f.index++];
+                        return;
+                    }
+                    f.member = next_member(f);
+                    f.next = step::key;
+                    return;
+                case step::key:
+                    start_string(f.member->first, true);
+                    f.next = step::value;
+                    return;
+                case step::value:
+                    st.m_Next = &f.member->second;
+                    f.index++;
+                    f.next = step::member;
+                    return;
+                case step::number:
+                    stage_number(f.node->numbers()[f.index++]);
+                    f.next = step::member;
+                    return;
+                case step::closing:
+                    stage(is_array ? "]" : "}");
+                    if (f.reorder) st.m_Sorted.resize(f.sorted);
+                    st.m_Depth--;
+                    return;
                 }
-                if (opts.pretty) dump_indent(os, depth, opts);
-                os.put('}');
-                return;
             }
+
+            size_t run(const value& v, const WriteOptions& opts) noexcept {
+                char* begin = p;
+                if (st.m_Phase == DumpState::phase::idle) {
+                    st.m_Opts = opts;
+                    st.m_Next = &v;
+                    st.m_Phase = DumpState::phase::running;
+                }
+
+                while (st.m_Phase == DumpState::phase::running) {
+                    if (st.m_PendingLen && !drain_pending()) break;
+                    if (st.m_Spaces && !drain_spaces()) break;
+                    if (st.m_InString) {
+                        if (!drain_string()) break;
+                        continue;
+                    }
+                    if (st.m_Next) {
+                        const value* next = st.m_Next;
+                        st.m_Next = nullptr;
+                        start_value(*next);
+                        continue;
+                    }
+                    if (st.m_Depth == 0) {
+                        st.m_Phase = DumpState::phase::done;
+                        break;
+                    }
+                    if (p == end) break;
+                    advance();
+                }
+
+                size_t written = static_cast<size_t>(p - begin);
+                st.m_Total += written;
+                return written;
             }
-            os << "null";
-        }
+        };
 
 #pragma endregion
 
     } // namespace detail
 
+    size_t dump_to(const value& v, std::span<char> buf, DumpState& state, const WriteOptions& opts) noexcept {
+        detail::ChunkWriter w{ state, buf.data(), buf.data() + buf.size() };
+        return w.run(v, opts);
+    }
+
+    namespace describe::detail {
+        void Emitter::number(double d) {
+            Sonnet::detail::StringSink sink{ m_Out };
+            Sonnet::detail::Writer<Sonnet::detail::StringSink>{ sink, m_Opts, nullptr, nullptr }.write_number(d);
+        }
+
+        void Emitter::string(std::string_view s) {
+            Sonnet::detail::StringSink sink{ m_Out };
+            Sonnet::detail::dump_string(s, sink, m_Opts);
+        }
+
+        void Emitter::dom(const value& v) {
+            Sonnet::detail::StringSink sink{ m_Out };
+            Sonnet::detail::dump_impl(v, sink, m_Opts, m_Depth, nullptr);
+        }
+    } // namespace describe::detail
+
 } // namespace Sonnet
\ No newline at end of file
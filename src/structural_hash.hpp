@@ -0,0 +1,74 @@
+#pragma once
+
+// Internal 64-bit structural hash shared by `Sonnet::hash` and the diff
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "sonnet/value.hpp"
+
+
+namespace Sonnet::detail {
+
+    inline std::uint64_t mix(std::uint64_t h) noexcept {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    }
+
+    inline std::uint64_t combine(std::uint64_t seed, std::uint64_t h) noexcept {
+        return mix(seed ^ (h + 0x9e3779b97f4a7c15ull + (seed << 6)));
+    }
+
+    // Reads bytes as little-endian words so the result does not depend on
+    // the platform
+    inline std::uint64_t hash_bytes(std::string_view s) noexcept {
+        std::uint64_t h = mix(0x5fcb1a3ull ^ s.size());
+        std::size_t i = 0;
+        for (; i + 8 <= s.size(); i += 8) {
+            std::uint64_t w = 0;
+            for (std::size_t b = 0; b < 8; b++) w |= std::uint64_t{ static_cast<unsigned char>(s[i + b]) } << (8 * b);
+            h = mix(h ^ w) * 0x9e3779b97f4a7c15ull;
+        }
+        std::uint64_t w = 0;
+        for (std::size_t b = 0; i + b < s.size(); b++) w |= std::uint64_t{ static_cast<unsigned char>(s[i + b]) } << (8 * b);
+        return mix(h ^ w ^ 3);
+    }
+
+    inline std::uint64_t hash_number(double d) noexcept {
+        // 0.0 and -0.0 compare equal
+        return mix(std::bit_cast<std::uint64_t>(d == 0.0 ? 0.0 : d) ^ 2);
+    }
+
+    // Hash of @p v, taking the hashes of container elements from
+    // @p child. Packed arrays hash like the equivalent array of numbers,
+    // and container hashes are never 0 so 0 can mean "not cached"
+    template<typename Child>
+    std::uint64_t structural_hash(const value& v, Child&& child) {
+        std::uint64_t h = 0;
+        switch (v.type()) {
+        case kind::null: return mix(1);
+        case kind::boolean: return mix(v.as_bool() ? 7 : 5);
+        case kind::number: return hash_number(v.as_number());
+        case kind::string: return hash_bytes(v.as_string());
+        case kind::array:
+            h = mix(4);
+            if (v.is_packed()) {
+                for (double d : v.numbers()) h = combine(h, hash_number(d));
+            } else {
+                for (const auto& e : v.as_array()) h = combine(h, child(e));
+            }
+            break;
+        case kind::object:
+            h = mix(6);
+            for (const auto& [k, e] : v.as_object()) h = combine(h, combine(hash_bytes(k), child(e)));
+            break;
+        }
+        return h ? h : 1;
+    }
+
+} // namespace Sonnet::detail
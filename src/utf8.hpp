@@ -0,0 +1,115 @@
+#pragma once
+
+// Internal UTF-8 helpers shared by the JSON parser and the binary decoders
+
+#include <cstddef>
+#include <string_view>
+
+
+namespace Sonnet::detail {
+
+    inline bool is_valid_utf8(std::string_view s, size_t& error_idx) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(s.data());
+        size_t i = 0; 
+        size_t n = s.size();
+
+        auto fail = [&](size_t idx) { error_idx = idx; return false; };
+
+        while (i < n) {
+            unsigned char c = data[i];
+
+            if (c <= 0x7F) {
+                i++;
+                continue;
+            }
+
+            if (c >= 0xC2 && c <= 0xDF) {
+                if (i + 1 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                if ((c1 & 0xC0) != 0x80) return fail(i);
+                i += 2;
+                continue;
+            }
+
+            if (c >= 0xE1 && c <= 0xEC) {
+                if (i + 2 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                if ((c1 & 0xC0) != 0x80) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                i += 3;
+                continue;
+            }
+
+            if (c == 0xE0) {
+                if (i + 2 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                if (c1 < 0xA0 || c1 > 0xBF) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                i += 3;
+                continue;
+            }
+
+            if (c == 0xED) {
+                if (i + 2 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                if (c1 < 0x80 || c1 > 0x9F) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                i += 3;
+                continue;
+            }
+
+            if (c >= 0xEE && c <= 0xEF) {
+                if (i + 2 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                if ((c1 & 0xC0) != 0x80) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                i += 3;
+                continue;
+            }
+
+            if (c == 0xF0) {
+                if (i + 3 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                unsigned char c3 = data[i + 3];
+                if (c1 < 0x90 || c1 > 0xBF) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                if ((c3 & 0xC0) != 0x80) return fail(i);
+                i += 4;
+                continue;
+            }
+
+            if (c >= 0xF1 && c <= 0xF3) {
+                if (i + 3 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                unsigned char c3 = data[i + 3];
+                if ((c1 & 0xC0) != 0x80) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                if ((c3 & 0xC0) != 0x80) return fail(i);
+                i += 4;
+                continue;
+            }
+
+            if (c == 0xF4) {
+                if (i + 3 >= n) return fail(i);
+                unsigned char c1 = data[i + 1];
+                unsigned char c2 = data[i + 2];
+                unsigned char c3 = data[i + 3];
+                if (c1 < 0x80 || c1 > 0x8F) return fail(i);
+                if ((c2 & 0xC0) != 0x80) return fail(i);
+                if ((c3 & 0xC0) != 0x80) return fail(i);
+                i += 4;
+                continue;
+            }
+
+            return fail(i);
+        }
+        return true;
+    }
+
+} // namespace Sonnet::detail
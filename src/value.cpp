@@ -1,10 +1,57 @@
 #include "sonnet/value.hpp"
 
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 
 namespace Sonnet {
 
+    packed_array::packed_array(number_array n) noexcept
+        : nums{ std::move(n) } {}
+
+    packed_array::packed_array(const packed_array& other)
+        : nums{ other.nums } {}
+
+    packed_array::packed_array(packed_array&& other) noexcept
+        : nums{ std::move(other.nums) }, m_Elements{ other.m_Elements.exchange(nullptr) } {}
+
+    packed_array& packed_array::operator=(const packed_array& other) {
+        if (this == &other) return *this;
+        nums = other.nums;
+        drop_elements();
+        return *this;
+    }
+
+    packed_array& packed_array::operator=(packed_array&& other) noexcept {
+        if (this == &other) return *this;
+        nums = std::move(other.nums);
+        drop_elements();
+        m_Elements.store(other.m_Elements.exchange(nullptr));
+        return *this;
+    }
+
+    packed_array::~packed_array() { drop_elements(); }
+
+    // The first caller to finish publishes its nodes; a caller that lost
+    // the race frees its own and reads the winner's
+    const array& packed_array::elements(std::pmr::memory_resource* res) const {
+        if (auto* e = m_Elements.load(std::memory_order_acquire)) return *e;
+
+        auto fresh = std::make_unique<array>(allocator_type{ res });
+        fresh->reserve(nums.size());
+        for (double d : nums) fresh->emplace_back(d, res);
+
+        array* current = nullptr;
+        if (m_Elements.compare_exchange_strong(current, fresh.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+            return *fresh.release();
+        return *current;
+    }
+
+    void packed_array::drop_elements() noexcept {
+        delete m_Elements.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
     value::value(std::pmr::memory_resource* res) noexcept
         : m_MemRes{ res }, m_Storage{ std::monostate{} } {}
 
@@ -35,6 +82,14 @@ namespace Sonnet {
     value::value(object o, std::pmr::memory_resource* res)
         : m_MemRes{res}, m_Storage{ std::move(o) } {}
 
+    value::value(number_array a, std::pmr::memory_resource* res)
+        : m_MemRes{ res }, m_Storage{ std::in_place_type<packed_array>, std::move(a) } {}
+
+    value::value(shared_value node) noexcept
+        : m_MemRes{ node->m_MemRes } {
+        m_Storage = std::move(node);
+    }
+
     value::value(const value& other)
         : m_MemRes{ other.m_MemRes }, m_Storage{ clone_storage(other.m_Storage, other.m_MemRes) } {}
 
@@ -63,22 +118,72 @@ namespace Sonnet {
         case 3: return kind::string;
         case 4: return kind::array;
         case 5: return kind::object;
+        case 6: return kind::array;
+        case 7: return std::get<shared_value>(m_Storage)->type();
         }
         return kind::null;
     }
 
     bool& value::as_bool() { return std::get<bool>(m_Storage); }
-    const bool& value::as_bool() const { return std::get<bool>(m_Storage); }
+    const bool& value::as_bool() const { return std::get<bool>(target().m_Storage); }
     double& value::as_number() { return std::get<double>(m_Storage); }
-    const double& value::as_number() const { return std::get<double>(m_Storage); }
-    string& value::as_string() { return std::get<string>(m_Storage); }
-    const string& value::as_string() const { return std::get<string>(m_Storage); }
-    array& value::as_array() { if (!is_array()) m_Storage = array{ allocator_type(m_MemRes) }; return std::get<array>(m_Storage); }
-    const array& value::as_array() const { return std::get<array>(m_Storage); }
-    object& value::as_object() { if (!is_object()) m_Storage = object{ allocator_type(m_MemRes) }; return std::get<object>(m_Storage); }
-    const object& value::as_object() const { return std::get<object>(m_Storage); }
+    const double& value::as_number() const { return std::get<double>(target().m_Storage); }
+    string& value::as_string() { unshare(); return std::get<string>(m_Storage); }
+    const string& value::as_string() const { return std::get<string>(target().m_Storage); }
+    array& value::as_array() { unshare(); if (is_packed()) unpack(); else if (!is_array()) m_Storage = array{ allocator_type(m_MemRes) }; return std::get<array>(m_Storage); }
+    const array& value::as_array() const {
+        const value& t = target();
+        if (auto* packed = std::get_if<packed_array>(&t.m_Storage)) return packed->elements(t.m_MemRes);
+        return std::get<array>(t.m_Storage);
+    }
+    object& value::as_object() { unshare(); if (!is_object()) m_Storage = object{ allocator_type(m_MemRes) }; return std::get<object>(m_Storage); }
+    const object& value::as_object() const { return std::get<object>(target().m_Storage); }
+
+    std::span<double> value::numbers() {
+        unshare();
+        if (auto* packed = std::get_if<packed_array>(&m_Storage)) {
+            packed->drop_elements();
+            return packed->nums;
+        }
+        return {};
+    }
+
+    std::span<const double> value::numbers() const noexcept {
+        if (auto* packed = std::get_if<packed_array>(&target().m_Storage)) return packed->nums;
+        return {};
+    }
+
+    bool value::pack() {
+        if (is_packed()) return true;
+        if (!is_array() || as_array().empty()) return false;
+
+        const auto& arr = as_array();
+        if (!std::ranges::all_of(arr, [](const value& e) { return e.is_number(); })) return false;
+
+        number_array nums{ allocator_type(m_MemRes) };
+        nums.reserve(arr.size());
+        for (const auto& e : arr) nums.push_back(e.as_number());
+        m_Storage.emplace<packed_array>(std::move(nums));
+        return true;
+    }
+
+    void value::unpack() {
+        if (!is_packed()) return;
+        unshare();
+
+        const auto& nums = std::get<packed_array>(m_Storage).nums;
+        array arr{ allocator_type(m_MemRes) };
+        arr.reserve(nums.size());
+        for (double d : nums) arr.emplace_back(d, m_MemRes);
+        m_Storage = std::move(arr);
+    }
+
+    void value::unshare() {
+        if (auto* node = std::get_if<shared_value>(&m_Storage)) m_Storage = clone_storage((*node)->m_Storage, m_MemRes);
+    }
 
     size_t value::size() const noexcept {
+        if (is_packed()) return numbers().size();
         if (is_array()) return as_array().size();
         if (is_object()) return as_object().size();
         return 0;
@@ -102,16 +207,15 @@ namespace Sonnet {
 
     value& value::operator[](std::string_view key) {
         auto& obj = as_object();
-        string k{ key.begin(), key.end(), m_MemRes };
-        auto [it, inserted] = obj.emplace(std::move(k), value{ m_MemRes });
+        auto it = obj.find(key);
+        if (it == obj.end()) it = obj.emplace(string{ key.begin(), key.end(), m_MemRes }, value{ m_MemRes }).first;
         return it->second;
     }
 
     const value* value::find(std::string_view key) const {
         if (!is_object()) return nullptr;
         const auto& obj = as_object();
-        string k{ key.begin(), key.end(), m_MemRes };
-        auto it = obj.find(k);
+        auto it = obj.find(key);
         if (it == obj.end()) return nullptr;
         return std::addressof(it->second);
     }
@@ -121,6 +225,47 @@ namespace Sonnet {
         throw std::out_of_range{ "Sonnet::value::at: key not found "};
     }
 
+    namespace {
+        // Element-wise comparison of two arrays of which at least one is
+        // packed. A packed element behaves like a number value that uses
+        // the array's resource
+        std::partial_ordering compare_mixed(const value& lhs, const value& rhs) {
+            auto ln = lhs.numbers();
+            auto rn = rhs.numbers();
+            if (lhs.is_packed() && rhs.is_packed())
+                return std::lexicographical_compare_three_way(ln.begin(), ln.end(), rn.begin(), rn.end());
+
+            auto cmp = [](double d, std::pmr::memory_resource* res, const value& e) -> std::partial_ordering {
+                if (auto c = res <=> e.resource(); c != 0) return c;
+                if (!e.is_number()) return kind::number <=> e.type();
+                return d <=> e.as_number();
+            };
+
+            size_t n = std::min(lhs.size(), rhs.size());
+            for (size_t i = 0; i < n; i++) {
+                auto c = lhs.is_packed() ? cmp(ln[i], lhs.resource(), rhs.as_array()[i])
+                                         : 0 <=> cmp(rn[i], rhs.resource(), lhs.as_array()[i]);
+                if (c != 0) return c;
+            }
+            return lhs.size() <=> rhs.size();
+        }
+    } // namespace
+
+    std::partial_ordering operator<=>(const value& lhs, const value& rhs) {
+        if (auto c = lhs.m_MemRes <=> rhs.m_MemRes; c != 0) return c;
+        if (!lhs.is_packed() && !rhs.is_packed()) return lhs.target().m_Storage <=> rhs.target().m_Storage;
+        if (lhs.type() != rhs.type()) return lhs.type() <=> rhs.type();
+        return compare_mixed(lhs, rhs);
+    }
+
+    bool operator==(const value& lhs, const value& rhs) {
+        if (lhs.m_MemRes != rhs.m_MemRes) return false;
+        if (lhs.is_shared() && &lhs.target() == &rhs.target()) return true;
+        if (!lhs.is_packed() && !rhs.is_packed()) return lhs.target().m_Storage == rhs.target().m_Storage;
+        if (!lhs.is_array() || !rhs.is_array() || lhs.size() != rhs.size()) return false;
+        return compare_mixed(lhs, rhs) == 0;
+    }
+
     storage_t value::clone_storage(const storage_t& s, std::pmr::memory_resource* res) {
         switch (s.index()) {
         case 0: return std::monostate{};
@@ -143,6 +288,13 @@ namespace Sonnet {
             for (const auto& [k, v] : obj) copy.emplace(string{ k, res }, value{ v });
             return copy;
         }
+        case 6: return packed_array{ number_array{ std::get<packed_array>(s).nums, res } };
+        case 7: {
+            // Copies share the node as long as they stay in its resource
+            const auto& node = std::get<shared_value>(s);
+            if (node->m_MemRes == res) return node;
+            return clone_storage(node->m_Storage, res);
+        }
         }
         return std::monostate{};
     }
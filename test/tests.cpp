@@ -5,7 +5,16 @@
 
 #include <random>
 #include <limits>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
 #include <print>
+#include <unordered_set>
+
+#if !SONNET_PLATFORM_WINDOWS
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace Catch;
 
@@ -114,6 +123,23 @@ namespace {
         REQUIRE_FALSE(r);
         REQUIRE(r.error().errc == code);
     }
+
+    static std::vector<std::byte> from_hex(std::string_view hex) {
+        std::vector<std::byte> out;
+        for (size_t i = 0; i + 1 < hex.size(); i += 2) 
+            out.push_back(static_cast<std::byte>(std::stoi(std::string{ hex.substr(i, 2) }, nullptr, 16)));
+        return out;
+    }
+
+    static std::string hex_of(const std::vector<std::byte>& bytes) {
+        static constexpr char digits[] = "0123456789abcdef";
+        std::string out;
+        for (std::byte b : bytes) {
+            out.push_back(digits[std::to_integer<int>(b) >> 4]);
+            out.push_back(digits[std::to_integer<int>(b) & 0xF]);
+        }
+        return out;
+    }
 }
 
 
@@ -625,4 +651,1866 @@ TEST_CASE("Max depth is enforced") {
     expect_fail("[[[[]]]]", Sonnet::ParseError::code::depth_limit_exceeded, opts);
     expect_ok("{ \"1\": { \"2\": {}}}", opts);
     expect_fail("{ \"1\": { \"2\": { \"3\": {}}}}", Sonnet::ParseError::code::depth_limit_exceeded, opts);
-}
\ No newline at end of file
+}
+
+TEST_CASE("KeyCache Output Matches Plain Dump") {
+    auto r = Sonnet::parse(R"({"id":1,"na\"me":"x","nested":{"id":2,"tab\tkey":[1,2]}})");
+    REQUIRE(r);
+
+    Sonnet::KeyCache keys;
+    for (bool pretty : { false, true }) {
+        Sonnet::WriteOptions opts{ .pretty = pretty };
+        REQUIRE(Sonnet::dump(*r, keys, opts) == Sonnet::dump(*r, opts));
+        REQUIRE(Sonnet::dump(*r, keys, opts) == Sonnet::dump(*r, opts));
+    }
+    REQUIRE(keys.size() == 4);
+    REQUIRE(keys.lookup("na\"me") == R"("na\"me":)");
+}
+
+TEST_CASE("KeyCache Stops Growing at max_entries") {
+    Sonnet::KeyCache keys{ 2 };
+    Sonnet::value v;
+    v["a"] = 1.0;
+    v["b"] = 2.0;
+    v["c"] = 3.0;
+
+    REQUIRE(Sonnet::dump(v, keys) == R"({"a":1,"b":2,"c":3})");
+    REQUIRE(keys.size() == 2);
+
+    keys.clear();
+    REQUIRE(keys.size() == 0);
+}
+
+TEST_CASE("Template Render Matches Full Dump") {
+    auto proto = Sonnet::parse(R"({"status":"ok","data":null,"meta":{"id":0,"tags":["a","b"]}})");
+    REQUIRE(proto);
+
+    for (bool pretty : { false, true }) {
+        Sonnet::WriteOptions opts{ .pretty = pretty };
+        auto tmpl = Sonnet::compile_template(*proto, { "/meta/id", "/data" }, opts);
+        REQUIRE(tmpl.hole_count() == 2);
+
+        Sonnet::value id{ 42 };
+        Sonnet::value data;
+        data["x"][1] = true;
+
+        Sonnet::value expected = *proto;
+        expected["meta"]["id"] = id;
+        expected["data"] = data;
+
+        REQUIRE(Sonnet::render(tmpl, id, data) == Sonnet::dump(expected, opts));
+    }
+}
+
+TEST_CASE("Template Rejects Bad Holes and Arguments") {
+    auto proto = Sonnet::parse(R"({"a":{"b":[1,2]},"c~/d":3})");
+    REQUIRE(proto);
+
+    REQUIRE_THROWS_AS(Sonnet::compile_template(*proto, { "/missing" }), std::invalid_argument);
+    REQUIRE_THROWS_AS(Sonnet::compile_template(*proto, { "/a/b/01" }), std::invalid_argument);
+    REQUIRE_THROWS_AS(Sonnet::compile_template(*proto, { "/a", "/a/b" }), std::invalid_argument);
+    REQUIRE_THROWS_AS(Sonnet::compile_template(*proto, { "/a", "/a" }), std::invalid_argument);
+
+    auto tmpl = Sonnet::compile_template(*proto, { "/c~0~1d", "/a/b/1" });
+    REQUIRE(Sonnet::render(tmpl, Sonnet::value{ "x" }, Sonnet::value{ 7 }) == R"({"a":{"b":[1,7]},"c~/d":"x"})");
+    REQUIRE_THROWS_AS(Sonnet::render(tmpl, Sonnet::value{ 1 }), std::invalid_argument);
+}
+
+TEST_CASE("Canonical Output Formats Numbers Like ECMAScript") {
+    auto canon = [](double d) { return Sonnet::dump(Sonnet::value{ d }, { .canonical = true }); };
+
+    REQUIRE(canon(0.0) == "0");
+    REQUIRE(canon(-0.0) == "0");
+    REQUIRE(canon(1.0) == "1");
+    REQUIRE(canon(-1.5) == "-1.5");
+    REQUIRE(canon(1e20) == "100000000000000000000");
+    REQUIRE(canon(1e21) == "1e+21");
+    REQUIRE(canon(0.000001) == "0.000001");
+    REQUIRE(canon(1e-7) == "1e-7");
+    REQUIRE(canon(123456789.125) == "123456789.125");
+    REQUIRE(canon(5e-324) == "5e-324");
+    REQUIRE(canon(1.7976931348623157e308) == "1.7976931348623157e+308");
+    REQUIRE(canon(333333333.3333333) == "333333333.3333333");
+}
+
+TEST_CASE("Canonical Output Sorts Keys by UTF-16 and Escapes Minimally") {
+    auto r = Sonnet::parse(R"({"\u20ac":1,"\r":2,"\ufb33":3,"1":4,"\ud83d\ude00":5,"\u0080":6,"\u00f6":7})");
+    REQUIRE(r);
+
+    std::string out = Sonnet::dump(*r, { .pretty = true, .canonical = true });
+    std::string expected = "{\"\\r\":2,\"1\":4,\"\xC2\x80\":6,\"\xC3\xB6\":7,\"\xE2\x82\xAC\":1,\"\xF0\x9F\x98\x80\":5,\"\xEF\xAC\xB3\":3}";
+    REQUIRE(out == expected);
+
+    Sonnet::value ctl{ std::string_view{ "a\x1f/\"" } };
+    REQUIRE(Sonnet::dump(ctl, { .canonical = true }) == "\"a\\u001f/\\\"\"");
+}
+
+TEST_CASE("Content Hash is SHA-256 of Canonical Form") {
+    Sonnet::Sha256 h;
+    h.update("abc");
+    REQUIRE(Sonnet::to_hex(h.finish()) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    std::string block(1000, 'x');
+    h.update(block.data(), 3);
+    h.update(block.data() + 3, block.size() - 3);
+    auto split = h.finish();
+    h.update(block);
+    REQUIRE(split == h.finish());
+
+    auto a = Sonnet::parse(R"({"b":[1.0,2e0,"x"],"a":{"z":null,"y":true}})");
+    auto b = Sonnet::parse(R"({ "a": { "y": true, "z": null }, "b": [1, 2, "x"] })");
+    REQUIRE(a);
+    REQUIRE(b);
+
+    h.update(Sonnet::dump(*a, { .canonical = true }));
+    REQUIRE(Sonnet::content_hash(*a) == h.finish());
+    REQUIRE(Sonnet::content_hash(*a) == Sonnet::content_hash(*b));
+}
+
+TEST_CASE("ensure_ascii Escapes Non-ASCII Code Points") {
+    Sonnet::value v{ std::string_view{ "caf\xC3\xA9 \xE2\x98\x83 \xF0\x9F\x98\x80" } };
+    REQUIRE(Sonnet::dump(v, { .ensure_ascii = true }) == R"("caf\u00E9 \u2603 \uD83D\uDE00")");
+    REQUIRE(Sonnet::dump(v, { .canonical = true, .ensure_ascii = true }) == Sonnet::dump(v, { .canonical = true }));
+
+    Sonnet::value bad{ std::string_view{ "a\xC0\xAF" } };
+    REQUIRE(Sonnet::dump(bad, { .ensure_ascii = true }) == R"("a\uFFFD\uFFFD")");
+}
+
+TEST_CASE("ensure_ascii Output Round-Trips Long Strings") {
+    std::string s;
+    for (int i = 0; i < 40; i++) {
+        s += "plain ascii run ";
+        s += (i % 3 == 0) ? "\xE2\x82\xAC" : (i % 3 == 1 ? "\"\\\n" : "\xF0\x9F\x98\x80");
+    }
+    Sonnet::value v;
+    v[s] = Sonnet::value{ std::string_view{ s } };
+
+    std::string out = Sonnet::dump(v, { .ensure_ascii = true });
+    for (char c : out) REQUIRE(static_cast<unsigned char>(c) < 0x80);
+
+    auto r = Sonnet::parse(out);
+    REQUIRE(r);
+    REQUIRE(*r == v);
+    REQUIRE(Sonnet::parse(Sonnet::dump(v))->as_object().begin()->second.as_string() == std::string_view{ s });
+}
+
+TEST_CASE("dump_to Reassembles Exact Output in Small Chunks") {
+    auto doc = Sonnet::parse(R"({"name":"café \"q\"\n","list":[1,2.5,[],{},[null,true,false]],"z":{"€":1,"a😀":2,"b":-0.0}})");
+    REQUIRE(doc);
+
+    const Sonnet::WriteOptions modes[] = {
+        {}, { .pretty = true }, { .pretty = true, .indent = 4 }, { .canonical = true }, { .ensure_ascii = true }
+    };
+    for (const auto& opts : modes) {
+        std::string expected = Sonnet::dump(*doc, opts);
+        for (size_t chunk = 1; chunk <= 7; chunk++) {
+            Sonnet::DumpState state;
+            std::string out;
+            char buf[7];
+            while (!state.done()) {
+                size_t n = Sonnet::dump_to(*doc, std::span<char>{ buf, chunk }, state, opts);
+                out.append(buf, n);
+                REQUIRE(!state.failed());
+            }
+            REQUIRE(out == expected);
+            REQUIRE(state.total_written() == expected.size());
+            REQUIRE(Sonnet::dump_to(*doc, std::span<char>{ buf, chunk }, state, opts) == 0);
+        }
+    }
+}
+
+TEST_CASE("dump_to Sorts Nested Canonical Objects in UTF-16 Order") {
+    // U+FF21 sorts before U+1F600 in UTF-16 but after it in UTF-8; the
+    // inner object needs reordering while the outer one is mid-way
+    auto doc = Sonnet::parse(R"({"😀":{"😀":1,"Ａ":{"😀":[2],"Ａ":3},"b":4},"Ａ":[{"😀":5,"Ａ":6}],"a":7})");
+    REQUIRE(doc);
+
+    const Sonnet::WriteOptions opts{ .canonical = true };
+    std::string expected = Sonnet::dump(*doc, opts);
+    Sonnet::DumpState state;
+    for (size_t chunk = 1; chunk <= 5; chunk++) {
+        state.reset();
+        std::string out;
+        char buf[5];
+        while (!state.done()) out.append(buf, Sonnet::dump_to(*doc, std::span<char>{ buf, chunk }, state, opts));
+        REQUIRE(out == expected);
+    }
+}
+
+TEST_CASE("dump_to Matches dump for Pretty Packed Arrays", "[packed]") {
+    Sonnet::ParseOptions packing;
+    packing.pack_numeric_arrays = true;
+    auto doc = Sonnet::parse(R"({"xs":[1,2,3],"m":[[4,5.5],[-6]]})", packing);
+    REQUIRE(doc);
+    REQUIRE(doc->at("xs").is_packed());
+
+    for (Sonnet::WriteOptions opts : { Sonnet::WriteOptions{ .pretty = true }, Sonnet::WriteOptions{ .pretty = true, .indent = 3 } }) {
+        std::string expected = Sonnet::dump(*doc, opts);
+        for (size_t chunk = 1; chunk <= 8; chunk++) {
+            Sonnet::DumpState state;
+            std::string out;
+            char buf[8];
+            while (!state.done()) out.append(buf, Sonnet::dump_to(*doc, std::span<char>{ buf, chunk }, state, opts));
+            REQUIRE(out == expected);
+        }
+    }
+}
+
+TEST_CASE("dump_to Reports Failure and Restarts After Reset") {
+    Sonnet::value deep;
+    Sonnet::value* cur = &deep;
+    for (size_t i = 0; i <= Sonnet::DumpState::max_depth; i++) cur = &(*cur)[0];
+
+    Sonnet::DumpState state;
+    char buf[64];
+    while (!state.done() && !state.failed()) Sonnet::dump_to(deep, buf, state);
+    REQUIRE(state.failed());
+
+    state.reset();
+    Sonnet::value small{ std::string_view{ "ok" } };
+    REQUIRE(Sonnet::dump_to(small, buf, state) == 4);
+    REQUIRE(state.done());
+    REQUIRE(std::string_view{ buf, 4 } == R"("ok")");
+}
+
+TEST_CASE("CBOR Encoding Matches RFC 8949 Examples") {
+    auto hex = [](const Sonnet::value& v) { return hex_of(Sonnet::to_cbor(v)); };
+    REQUIRE(hex(Sonnet::value{ 0.0 }) == "00");
+    REQUIRE(hex(Sonnet::value{ 24.0 }) == "1818");
+    REQUIRE(hex(Sonnet::value{ 1000000.0 }) == "1a000f4240");
+    REQUIRE(hex(Sonnet::value{ 1000000000000.0 }) == "1b000000e8d4a51000");
+    REQUIRE(hex(Sonnet::value{ -1000.0 }) == "3903e7");
+    REQUIRE(hex(Sonnet::value{ -0.0 }) == "f98000");
+    REQUIRE(hex(Sonnet::value{ 1.5 }) == "f93e00");
+    REQUIRE(hex(Sonnet::value{ 5.960464477539063e-8 }) == "f90001");
+    REQUIRE(hex(Sonnet::value{ 3.4028234663852886e+38 }) == "fa7f7fffff");
+    REQUIRE(hex(Sonnet::value{ 1.1 }) == "fb3ff199999999999a");
+    REQUIRE(hex(Sonnet::value{ std::numeric_limits<double>::infinity() }) == "f97c00");
+    REQUIRE(hex(Sonnet::value{ std::numeric_limits<double>::quiet_NaN() }) == "f97e00");
+    REQUIRE(hex(Sonnet::value{ "IETF" }) == "6449455446");
+    REQUIRE(hex(Sonnet::value{ nullptr }) == "f6");
+
+    auto doc = Sonnet::parse(R"({"a":1,"b":[2,3]})");
+    REQUIRE(doc);
+    REQUIRE(hex(*doc) == "a26161016162820203");
+
+    auto keys = Sonnet::parse(R"({"bb":1,"a":2,"c":3})");
+    REQUIRE(keys);
+    REQUIRE(hex(*keys) == "a3616102626262016163" "03");
+    REQUIRE(hex_of(Sonnet::to_cbor(*keys, { .canonical = true })) == "a3616102616303626262" "01");
+
+    std::ostringstream os;
+    Sonnet::to_cbor(*doc, os);
+    REQUIRE(os.str().size() == 9);
+}
+
+TEST_CASE("CBOR Decoding Handles Indefinite Lengths, Tags and Byte Strings") {
+    auto decode = [](std::string_view hex) { return Sonnet::from_cbor(from_hex(hex)); };
+
+    auto nested = decode("9f018202039f0405ffff");
+    REQUIRE(nested);
+    REQUIRE(Sonnet::dump(*nested) == "[1,[2,3],[4,5]]");
+
+    auto obj = decode("bf6346756ef563416d7421ff");
+    REQUIRE(obj);
+    REQUIRE(Sonnet::dump(*obj) == R"({"Amt":-2,"Fun":true})");
+
+    REQUIRE(decode("7f657374726561646d696e67ff")->as_string() == std::string_view{ "streaming" });
+    REQUIRE(decode("4401020304")->as_string() == std::string_view{ "AQIDBA" });
+    REQUIRE(decode("c074323031332d30332d32315432303a30343a30305a")->as_string() == std::string_view{ "2013-03-21T20:04:00Z" });
+    REQUIRE(decode("c249010000000000000000")->as_number() == 18446744073709551616.0);
+    REQUIRE(decode("f90400")->as_number() == 0.00006103515625);
+    REQUIRE(decode("f7")->is_null());
+
+    rng r;
+    for (int i = 0; i < 50; i++) {
+        Sonnet::value original = random_json_value(r);
+        auto back = Sonnet::from_cbor(Sonnet::to_cbor(original, { .canonical = i % 2 == 0 }));
+        REQUIRE(back);
+        REQUIRE(*back == original);
+    }
+}
+
+TEST_CASE("CBOR Decoding Reports Errors") {
+    auto code_of = [](std::string_view hex, const Sonnet::ParseOptions& opts = {}) {
+        auto r = Sonnet::from_cbor(from_hex(hex), std::pmr::get_default_resource(), opts);
+        REQUIRE_FALSE(r);
+        return r.error().errc;
+    };
+    using code = Sonnet::ParseError::code;
+    REQUIRE(code_of("a10101") == code::unsupported_type);
+    REQUIRE(code_of("6261") == code::unexpected_end_of_input);
+    REQUIRE(code_of("9b00000000ffffffff") == code::unexpected_end_of_input);
+    REQUIRE(code_of("0000") == code::trailing_characters);
+    REQUIRE(code_of("ff") == code::unexpected_character);
+    REQUIRE(code_of("1c") == code::unexpected_character);
+    REQUIRE(code_of("62c328") == code::invalid_string);
+    REQUIRE(code_of("818180", { .max_depth = 2 }) == code::depth_limit_exceeded);
+
+    auto err = Sonnet::from_cbor(from_hex("8301026261"));
+    REQUIRE_FALSE(err);
+    REQUIRE(err.error().offset == 3);
+}
+
+TEST_CASE("CBOR SAX Decoding Streams Events") {
+    struct Recorder : Sonnet::SaxHandler {
+        std::string log;
+        size_t stop_after = 100;
+        bool tick(std::string_view ev) { log += ev; return --stop_after > 0; }
+        bool on_null() override { return tick("n"); }
+        bool on_number(double) override { return tick("#"); }
+        bool on_string(std::string_view s) override { return tick(s); }
+        bool on_start_array(size_t n) override { return tick(n == unknown_size ? "[?" : "[" + std::to_string(n)); }
+        bool on_end_array() override { return tick("]"); }
+        bool on_start_object(size_t n) override { return tick("{" + std::to_string(n)); }
+        bool on_key(std::string_view k) override { return tick(std::string{ k } + ":"); }
+        bool on_end_object() override { return tick("}"); }
+    };
+
+    Recorder rec;
+    auto bytes = from_hex("a2616101616282f69f6178ff");
+    REQUIRE(Sonnet::from_cbor(bytes, rec));
+    REQUIRE(rec.log == "{2a:#b:[2n[?x]]}");
+
+    Recorder stopper;
+    stopper.stop_after = 3;
+    auto r = Sonnet::from_cbor(bytes, stopper);
+    REQUIRE_FALSE(r);
+    REQUIRE(r.error().errc == Sonnet::ParseError::code::aborted);
+    REQUIRE(stopper.log == "{2a:#");
+}
+
+TEST_CASE("MessagePack Encoder Picks the Smallest Format") {
+    auto hex = [](const Sonnet::value& v) { return hex_of(Sonnet::to_msgpack(v)); };
+    REQUIRE(hex(Sonnet::value{ 127.0 }) == "7f");
+    REQUIRE(hex(Sonnet::value{ 128.0 }) == "cc80");
+    REQUIRE(hex(Sonnet::value{ 256.0 }) == "cd0100");
+    REQUIRE(hex(Sonnet::value{ 65536.0 }) == "ce00010000");
+    REQUIRE(hex(Sonnet::value{ 4294967296.0 }) == "cf0000000100000000");
+    REQUIRE(hex(Sonnet::value{ -1.0 }) == "ff");
+    REQUIRE(hex(Sonnet::value{ -32.0 }) == "e0");
+    REQUIRE(hex(Sonnet::value{ -33.0 }) == "d0df");
+    REQUIRE(hex(Sonnet::value{ -129.0 }) == "d1ff7f");
+    REQUIRE(hex(Sonnet::value{ -32769.0 }) == "d2ffff7fff");
+    REQUIRE(hex(Sonnet::value{ 1.5 }) == "ca3fc00000");
+    REQUIRE(hex(Sonnet::value{ 1.1 }) == "cb3ff199999999999a");
+    REQUIRE(hex(Sonnet::value{ "a" }) == "a161");
+    REQUIRE(hex(Sonnet::value{ std::string_view{ std::string(32, 'x') } }).substr(0, 4) == "d920");
+
+    Sonnet::value arr;
+    for (int i = 0; i < 16; i++) arr.as_array().emplace_back(nullptr);
+    REQUIRE(hex(arr).substr(0, 6) == "dc0010");
+
+    auto doc = Sonnet::parse(R"({"a":1,"b":[true,null]})");
+    REQUIRE(doc);
+    REQUIRE(hex(*doc) == "82a16101a16292c3c0");
+
+    rng r;
+    for (int i = 0; i < 50; i++) {
+        Sonnet::value original = random_json_value(r);
+        std::ostringstream os;
+        Sonnet::to_msgpack(original, os);
+        REQUIRE(os.str().size() == Sonnet::to_msgpack(original).size());
+        auto back = Sonnet::from_msgpack(Sonnet::to_msgpack(original));
+        REQUIRE(back);
+        REQUIRE(*back == original);
+    }
+}
+
+TEST_CASE("MessagePack Decoder Borrows Strings and Reports Errors") {
+    struct Borrow : Sonnet::SaxHandler {
+        const std::byte* lo;
+        const std::byte* hi;
+        size_t borrowed = 0;
+        bool inside(std::string_view s) {
+            auto* p = reinterpret_cast<const std::byte*>(s.data());
+            if (p >= lo && p + s.size() <= hi) borrowed++;
+            return true;
+        }
+        bool on_key(std::string_view k) override { return inside(k); }
+        bool on_string(std::string_view s) override { return inside(s); }
+    };
+
+    auto bytes = from_hex("82a16101a162a3787978");
+    Borrow b;
+    b.lo = bytes.data();
+    b.hi = bytes.data() + bytes.size();
+    REQUIRE(Sonnet::from_msgpack(bytes, b));
+    REQUIRE(b.borrowed == 3);
+
+    std::pmr::monotonic_buffer_resource arena;
+    auto v = Sonnet::from_msgpack(bytes, &arena);
+    REQUIRE(v);
+    REQUIRE(v->resource() == &arena);
+    REQUIRE(Sonnet::dump(*v) == R"({"a":1,"b":"xyx"})");
+    REQUIRE(Sonnet::from_msgpack(from_hex("c403010203"))->as_string() == std::string_view{ "AQID" });
+
+    auto code_of = [](std::string_view hex) {
+        auto r = Sonnet::from_msgpack(from_hex(hex));
+        REQUIRE_FALSE(r);
+        return r.error().errc;
+    };
+    using code = Sonnet::ParseError::code;
+    REQUIRE(code_of("810101") == code::unsupported_type);
+    REQUIRE(code_of("d40100") == code::unsupported_type);
+    REQUIRE(code_of("c1") == code::unexpected_character);
+    REQUIRE(code_of("cd01") == code::unexpected_end_of_input);
+    REQUIRE(code_of("dd7fffffff") == code::unexpected_end_of_input);
+    REQUIRE(code_of("a2c328") == code::invalid_string);
+    REQUIRE(code_of("c0c0") == code::trailing_characters);
+}
+
+TEST_CASE("Frozen Documents Round-Trip and Support Lookups") {
+    auto doc = Sonnet::parse(R"({"rates":{"EUR":1.1,"GBP":0.8,"JPY":150},"tags":["a","b",null,true],"n":-2.5,"empty":{}})");
+    REQUIRE(doc);
+
+    auto bytes = Sonnet::freeze(*doc);
+    REQUIRE(Sonnet::verify_frozen(bytes));
+    auto root = Sonnet::open_frozen(bytes);
+    REQUIRE(root);
+
+    REQUIRE(root->is_object());
+    REQUIRE(root->size() == 4);
+    REQUIRE(root->at("rates").at("EUR").as_number() == 1.1);
+    REQUIRE(root->at("rates").at("JPY").as_number() == 150);
+    REQUIRE_FALSE(root->at("rates").find("USD"));
+    REQUIRE(root->at("tags")[1].as_string() == "b");
+    REQUIRE(root->at("tags")[2].is_null());
+    REQUIRE(root->at("tags")[3].as_bool());
+    REQUIRE(root->at("tags")[99].is_null());
+    REQUIRE(root->key(0) == "empty");
+    REQUIRE(root->member(0).size() == 0);
+    REQUIRE_THROWS_AS(root->at("missing"), std::out_of_range);
+    REQUIRE_THROWS_AS(root->at("n").as_string(), std::invalid_argument);
+
+    std::pmr::monotonic_buffer_resource arena;
+    auto thawed = root->to_value(&arena);
+    REQUIRE(thawed.resource() == &arena);
+    REQUIRE(Sonnet::dump(thawed) == Sonnet::dump(*doc));
+
+    rng r;
+    for (int i = 0; i < 50; i++) {
+        Sonnet::value original = random_json_value(r);
+        auto frozen = Sonnet::freeze(original);
+        REQUIRE(Sonnet::verify_frozen(frozen));
+        REQUIRE(Sonnet::open_frozen(frozen)->to_value() == original);
+    }
+}
+
+TEST_CASE("Frozen Documents Reject Corruption and Map From Disk") {
+    auto doc = Sonnet::parse(R"({"a":[1,2],"b":"x"})");
+    REQUIRE(doc);
+    auto bytes = Sonnet::freeze(*doc);
+
+    auto bad_magic = bytes;
+    bad_magic[0] = std::byte{ 'X' };
+    REQUIRE_FALSE(Sonnet::open_frozen(bad_magic));
+
+    auto truncated = std::span<const std::byte>{ bytes }.first(bytes.size() - 1);
+    REQUIRE(Sonnet::open_frozen(truncated).error().errc == Sonnet::ParseError::code::unexpected_end_of_input);
+
+    auto unsorted = bytes;
+    auto key = std::find(unsorted.begin() + 16, unsorted.end(), std::byte{ 'a' });
+    *key = std::byte{ 'c' };
+    REQUIRE(Sonnet::open_frozen(unsorted));
+    auto err = Sonnet::verify_frozen(unsorted);
+    REQUIRE_FALSE(err);
+    REQUIRE(err.error().errc == Sonnet::ParseError::code::unexpected_character);
+
+    auto dangling = bytes;
+    dangling[21] = std::byte{ 0x7F };
+    REQUIRE_FALSE(Sonnet::verify_frozen(dangling));
+
+    auto path = std::filesystem::temp_directory_path() / "sonnet_frozen_test.snfz";
+    {
+        std::ofstream out{ path, std::ios::binary };
+        Sonnet::freeze(*doc, out);
+    }
+    {
+        auto file = Sonnet::MappedFile::open(path);
+        REQUIRE(file);
+        REQUIRE(file->bytes().size() == bytes.size());
+        auto root = Sonnet::open_frozen(file->bytes());
+        REQUIRE(root);
+        REQUIRE(root->at("a")[1].as_number() == 2);
+        REQUIRE(root->at("b").as_string() == "x");
+    }
+    std::filesystem::remove(path);
+    REQUIRE_FALSE(Sonnet::MappedFile::open(path));
+}
+
+TEST_CASE("Shared Documents Publish Across Mappings") {
+    std::string name = "/sonnet-test-" + std::to_string(std::random_device{}());
+    auto writer = Sonnet::SharedDocument::create(name, 4096);
+    REQUIRE(writer);
+    auto reader = Sonnet::SharedDocument::open(name);
+    REQUIRE(reader);
+
+    REQUIRE(reader->snapshot().root().is_null());
+    REQUIRE(reader->snapshot().generation() == 0);
+
+    auto v1 = Sonnet::parse(R"({"version":1,"hosts":["a","b"]})");
+    auto v2 = Sonnet::parse(R"({"version":2,"hosts":["c"]})");
+    REQUIRE(v1);
+    REQUIRE(v2);
+
+    writer->publish(*v1);
+    auto old = reader->snapshot();
+    REQUIRE(old.generation() == 1);
+    REQUIRE(old.root().at("hosts")[1].as_string() == "b");
+
+    writer->publish(*v2);
+    REQUIRE(reader->generation() == 2);
+    REQUIRE(old.root().at("version").as_number() == 1);
+    {
+        auto cur = reader->snapshot();
+        REQUIRE(cur.root().at("version").as_number() == 2);
+        REQUIRE(Sonnet::dump(cur.root().to_value()) == Sonnet::dump(*v2));
+    }
+
+    old = Sonnet::SharedSnapshot{};
+    writer->publish(*v1);
+    REQUIRE(reader->snapshot().root().at("version").as_number() == 1);
+
+    Sonnet::value big;
+    big["blob"] = Sonnet::value{ std::string_view{ std::string(8192, 'x') } };
+    REQUIRE_THROWS_AS(writer->publish(big), std::length_error);
+    REQUIRE_THROWS_AS(reader->publish(*v1), std::logic_error);
+
+    REQUIRE_FALSE(Sonnet::SharedDocument::unlink(name));
+    REQUIRE_FALSE(Sonnet::SharedDocument::open(name));
+}
+
+TEST_CASE("Shared Documents Outlive Handles and Dead Readers") {
+    std::string name = "/sonnet-test-" + std::to_string(std::random_device{}());
+    auto writer = Sonnet::SharedDocument::create(name, 4096);
+    REQUIRE(writer);
+    REQUIRE(Sonnet::SharedDocument::create(name, 4096).error() == std::errc::file_exists);
+
+    auto doc = [](int version) {
+        Sonnet::value v;
+        v["version"] = Sonnet::value{ version };
+        return v;
+    };
+    writer->publish(doc(1));
+
+    Sonnet::SharedSnapshot held;
+    {
+        auto reader = Sonnet::SharedDocument::open(name);
+        REQUIRE(reader);
+        held = reader->snapshot();
+    }
+    REQUIRE(held.root().at("version").as_number() == 1);
+
+    // The held snapshot pins the slot the third publication needs
+    writer->publish(doc(2));
+    try {
+        writer->publish(doc(3), std::chrono::milliseconds{ 10 });
+        FAIL("publish did not time out");
+    } catch (const std::system_error& e) {
+        REQUIRE(e.code() == std::errc::timed_out);
+    }
+    REQUIRE(writer->generation() == 2);
+    REQUIRE(held.root().at("version").as_number() == 1);
+
+    held = Sonnet::SharedSnapshot{};
+    writer->publish(doc(3));
+
+#if !SONNET_PLATFORM_WINDOWS
+    // A reader that dies holding a snapshot does not block the writer
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        auto reader = Sonnet::SharedDocument::open(name);
+        auto snap = reader ? std::optional{ reader->snapshot() } : std::nullopt;
+        ::_exit(snap && snap->generation() == 3 ? 0 : 1);
+    }
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    writer->publish(doc(4));
+    writer->publish(doc(5), std::chrono::seconds{ 5 });
+    REQUIRE(writer->snapshot().root().at("version").as_number() == 5);
+#endif
+
+    REQUIRE_FALSE(Sonnet::SharedDocument::unlink(name));
+}
+
+TEST_CASE("parse_sax reports JSON events and stops when asked", "[sax]") {
+    std::string_view text = R"({"a":[1,true,null],"b":"x","a":{}} )";
+    Sonnet::DomBuilder builder;
+    REQUIRE(Sonnet::parse_sax(text, builder));
+    REQUIRE(Sonnet::dump(builder.result()) == Sonnet::dump(*Sonnet::parse(text)));
+
+    struct StopAtString : Sonnet::SaxHandler {
+        bool on_string(std::string_view) override { return false; }
+    } stop;
+    auto r = Sonnet::parse_sax(R"([1, "x", 2])", stop);
+    REQUIRE_FALSE(r);
+    REQUIRE(r.error().errc == Sonnet::ParseError::code::aborted);
+
+    Sonnet::SaxHandler ignore;
+    REQUIRE(Sonnet::parse_sax("[1,]", ignore).error().errc == Sonnet::ParseError::code::trailing_characters);
+    REQUIRE(Sonnet::parse_sax("[1] 2", ignore).error().errc == Sonnet::ParseError::code::trailing_characters);
+}
+
+TEST_CASE("DomBuilder packs numeric arrays like parse", "[sax]") {
+    std::string_view text = R"({"a":[1,2.5,-3],"b":[1,"x",2],"c":[],"d":[[4],[5,6]],"e":[1,[2]]})";
+    Sonnet::DomBuilder builder{ std::pmr::get_default_resource(), true };
+    REQUIRE(Sonnet::parse_sax(text, builder));
+    const auto& built = builder.result();
+    auto parsed = *Sonnet::parse(text, { .pack_numeric_arrays = true });
+
+    REQUIRE(built == parsed);
+    for (const char* key : { "a", "b", "c", "d", "e" }) REQUIRE(built.at(key).is_packed() == parsed.at(key).is_packed());
+    REQUIRE(built.at("a").is_packed());
+    REQUIRE_FALSE(built.at("b").is_packed());
+    REQUIRE_FALSE(built.at("c").is_packed());
+    REQUIRE(built.at("d")[1].is_packed());
+    REQUIRE(built.at("e")[1].is_packed());
+    REQUIRE_FALSE(built.at("e").is_packed());
+}
+
+TEST_CASE("to_columns builds typed Arrow-style columns", "[columns]") {
+    auto doc = Sonnet::parse(R"([
+        {"id": 1, "px": 2, "ok": true, "name": "a"},
+        {"id": 2, "px": 2.5, "name": null, "tags": [1, 2]},
+        {"id": 3, "px": null, "ok": false, "name": "ccc", "mixed": "s"},
+        {"id": 4, "mixed": 7}
+    ])");
+    REQUIRE(doc);
+
+    for (const auto& table : { Sonnet::to_columns(*doc), *Sonnet::parse_columns(Sonnet::dump(*doc)) }) {
+        REQUIRE(table.rows == 4);
+
+        const auto* id = table.find("id");
+        REQUIRE(id->type == Sonnet::column_type::int64);
+        REQUIRE(id->ints == std::vector<std::int64_t>{ 1, 2, 3, 4 });
+        REQUIRE(id->null_count == 0);
+
+        const auto* px = table.find("px");
+        REQUIRE(px->type == Sonnet::column_type::float64);
+        REQUIRE(px->doubles == std::vector<double>{ 2.0, 2.5, 0.0, 0.0 });
+        REQUIRE(px->validity == std::vector<std::uint8_t>{ 0b0011 });
+        REQUIRE(px->null_count == 2);
+
+        const auto* ok = table.find("ok");
+        REQUIRE(ok->type == Sonnet::column_type::boolean);
+        REQUIRE(ok->bool_at(0));
+        REQUIRE_FALSE(ok->bool_at(2));
+        REQUIRE_FALSE(ok->is_valid(1));
+
+        const auto* name = table.find("name");
+        REQUIRE(name->type == Sonnet::column_type::utf8);
+        REQUIRE(name->offsets == std::vector<std::int32_t>{ 0, 1, 1, 4, 4 });
+        REQUIRE(name->string_at(2) == "ccc");
+
+        const auto* tags = table.find("tags");
+        REQUIRE(tags->validity == std::vector<std::uint8_t>{ 0b0010 });
+        REQUIRE(tags->string_at(1) == "[1,2]");
+
+        const auto* mixed = table.find("mixed");
+        REQUIRE(mixed->type == Sonnet::column_type::utf8);
+        REQUIRE(mixed->string_at(2) == "s");
+        REQUIRE(mixed->string_at(3) == "7");
+    }
+}
+
+TEST_CASE("columns reject non-tabular input and keep the last duplicate", "[columns]") {
+    auto table = Sonnet::parse_columns(R"([{"a":1,"a":"x"},{"a":2}])");
+    REQUIRE(table);
+    const auto* a = table->find("a");
+    REQUIRE(a->type == Sonnet::column_type::utf8);
+    REQUIRE(a->string_at(0) == "x");
+    REQUIRE(a->string_at(1) == "2");
+    REQUIRE(a->length == 2);
+
+    REQUIRE(Sonnet::parse_columns(R"({"a":1})").error().errc == Sonnet::ParseError::code::unsupported_type);
+    REQUIRE(Sonnet::parse_columns(R"([{"a":1}, 2])").error().errc == Sonnet::ParseError::code::unsupported_type);
+    REQUIRE(Sonnet::parse_columns(R"([{"a":1},)").error().errc == Sonnet::ParseError::code::unexpected_end_of_input);
+    REQUIRE_THROWS_AS(Sonnet::to_columns(*Sonnet::parse("[[]]")), std::invalid_argument);
+    REQUIRE(Sonnet::parse_columns("[]")->columns.empty());
+}
+
+TEST_CASE("Parser packs all-number arrays on request", "[packed]") {
+    std::string_view text = R"({"xy":[1.5,-2,3e2],"mixed":[1,"a",2],"empty":[],"nested":[[0,1],[2]]})";
+    auto packed = Sonnet::parse(text, { .pack_numeric_arrays = true });
+    auto plain = Sonnet::parse(text);
+    REQUIRE(packed);
+    REQUIRE(plain);
+
+    const auto& xy = packed->at("xy");
+    REQUIRE(xy.is_array());
+    REQUIRE(xy.is_packed());
+    REQUIRE(xy.size() == 3);
+    REQUIRE(std::vector<double>(xy.numbers().begin(), xy.numbers().end()) == std::vector<double>{ 1.5, -2, 300 });
+    REQUIRE_FALSE(packed->at("mixed").is_packed());
+    REQUIRE(packed->at("mixed").as_array()[0].as_number() == 1);
+    REQUIRE_FALSE(packed->at("empty").is_packed());
+    REQUIRE(packed->at("nested").as_array()[0].is_packed());
+    REQUIRE(xy[1].as_number() == -2);
+
+    REQUIRE(*packed == *plain);
+    REQUIRE(Sonnet::dump(*packed) == Sonnet::dump(*plain));
+    REQUIRE(Sonnet::dump(*packed, { .pretty = true }) == Sonnet::dump(*plain, { .pretty = true }));
+    REQUIRE(Sonnet::to_cbor(*packed) == Sonnet::to_cbor(*plain));
+    REQUIRE(Sonnet::to_msgpack(*packed) == Sonnet::to_msgpack(*plain));
+    REQUIRE(Sonnet::freeze(*packed) == Sonnet::freeze(*plain));
+
+    std::string chunked;
+    Sonnet::DumpState state;
+    char buf[3];
+    while (!state.done()) chunked.append(buf, Sonnet::dump_to(*packed, buf, state));
+    REQUIRE(chunked == Sonnet::dump(*plain));
+}
+
+TEST_CASE("value::pack and unpack convert arrays in place", "[packed]") {
+    auto v = *Sonnet::parse("[3, 1, 2]");
+    REQUIRE(v.pack());
+    REQUIRE(v.is_packed());
+    v.numbers()[0] = 0;
+    REQUIRE(Sonnet::dump(v) == "[0,1,2]");
+
+    auto other = *Sonnet::parse("[0, 1, 3]");
+    REQUIRE(v < other);
+    REQUIRE(v != other);
+
+    v[3] = "x";
+    REQUIRE_FALSE(v.is_packed());
+    REQUIRE(Sonnet::dump(v) == R"([0,1,2,"x"])");
+    REQUIRE_FALSE(v.pack());
+
+    Sonnet::value empty{ Sonnet::array{} };
+    REQUIRE_FALSE(empty.pack());
+    REQUIRE(empty.numbers().empty());
+}
+
+TEST_CASE("Const access reads packed elements as values", "[packed]") {
+    auto v = *Sonnet::parse(R"({"a":[1,2,3]})", { .pack_numeric_arrays = true });
+    const auto& a = std::as_const(v).at("a");
+    REQUIRE(a.is_packed());
+    REQUIRE(a[0].as_number() == 1);
+    REQUIRE(a[3].is_null());
+    REQUIRE(&a[2] == &a.as_array()[2]);
+    REQUIRE(a.as_array() == *Sonnet::parse("[1,2,3]"));
+    REQUIRE(a.as_array()[1].resource() == a.resource());
+
+    // Mutable access drops the element nodes, the next read rebuilds them
+    v["a"].numbers()[0] = 9;
+    REQUIRE(a.is_packed());
+    REQUIRE(a[0].as_number() == 9);
+
+    Sonnet::value copy = v;
+    REQUIRE(std::as_const(copy).at("a")[0].as_number() == 9);
+}
+
+TEST_CASE("Pointers and templates reach packed elements", "[packed]") {
+    std::string_view text = R"({"a":[1,2,3],"b":{"c":[4.5]}})";
+    auto packed = *Sonnet::parse(text, { .pack_numeric_arrays = true });
+    auto plain = *Sonnet::parse(text);
+    REQUIRE(packed.at("a").is_packed());
+
+    for (const auto* doc : { &packed, &plain }) {
+        const Sonnet::value* a1 = Sonnet::pointer{ "/a/1" }.resolve(*doc);
+        REQUIRE(a1);
+        REQUIRE(a1->as_number() == 2);
+        REQUIRE(Sonnet::pointer{ "/b/c/0" }.resolve(*doc)->as_number() == 4.5);
+        REQUIRE_FALSE(Sonnet::pointer{ "/a/3" }.resolve(*doc));
+
+        auto tmpl = Sonnet::compile_template(*doc, { "/a/1", "/b/c/0" });
+        REQUIRE(Sonnet::render(tmpl, Sonnet::value{ "x" }, Sonnet::value{ true }) == R"({"a":[1,"x",3],"b":{"c":[true]}})");
+    }
+}
+
+TEST_CASE("reduce aggregates packed and unpacked arrays alike", "[reduce]") {
+    std::string text = "[";
+    for (int i = 1; i <= 37; i++) text += std::to_string(i) + (i < 37 ? "," : "]");
+    auto packed = *Sonnet::parse(text, { .pack_numeric_arrays = true });
+    auto plain = *Sonnet::parse(text);
+    REQUIRE(packed.is_packed());
+
+    for (const auto* v : { &packed, &plain }) {
+        REQUIRE(Sonnet::reduce::sum(*v) == 703);
+        REQUIRE(Sonnet::reduce::count(*v) == 37);
+        REQUIRE(*Sonnet::reduce::mean(*v) == 19);
+        REQUIRE(*Sonnet::reduce::min(*v) == 1);
+        REQUIRE(*Sonnet::reduce::max(*v) == 37);
+        REQUIRE(Sonnet::reduce::count_if(*v, Sonnet::reduce::compare::greater, 30) == 7);
+        REQUIRE(Sonnet::reduce::count_if(*v, Sonnet::reduce::compare::less_equal, 5) == 5);
+        REQUIRE(Sonnet::reduce::histogram(*v, 0, 40, 4) == std::vector<std::size_t>{ 9, 10, 10, 8 });
+    }
+
+    auto mixed = *Sonnet::parse(R"([3, "x", null, -1, [7]])");
+    REQUIRE(Sonnet::reduce::sum(mixed) == 2);
+    REQUIRE(*Sonnet::reduce::min(mixed) == -1);
+
+    Sonnet::value empty{ Sonnet::array{} };
+    REQUIRE_FALSE(Sonnet::reduce::mean(empty));
+    REQUIRE_FALSE(Sonnet::reduce::max(Sonnet::value{ 5.0 }));
+    REQUIRE_THROWS_AS(Sonnet::reduce::histogram(plain, 1, 1, 4), std::invalid_argument);
+
+    // Numbers held through a shared node count like plain ones
+    Sonnet::value shared{ Sonnet::array{} };
+    shared.as_array().push_back(Sonnet::value{ 1.0 });
+    shared.as_array().push_back(Sonnet::value{ std::make_shared<const Sonnet::value>(2.0) });
+    REQUIRE(Sonnet::reduce::sum(shared) == 3);
+    REQUIRE(Sonnet::reduce::count(shared) == 2);
+    REQUIRE(*Sonnet::reduce::max(shared) == 2);
+    REQUIRE(Sonnet::reduce::count_if(shared, Sonnet::reduce::compare::greater, 1.5) == 1);
+}
+
+TEST_CASE("reduce aggregates a field across rows by JSON Pointer", "[reduce]") {
+    auto rows = *Sonnet::parse(R"([
+        {"host":"a","lat":{"p99":12.5}},
+        {"host":"b","lat":{"p99":40}},
+        {"host":"c"},
+        {"host":"d","lat":{"p99":"n/a"}},
+        {"host":"e","lat":{"p99":7.5}}
+    ])");
+
+    const Sonnet::pointer p99{ "/lat/p99" };
+    REQUIRE(Sonnet::reduce::count(rows, p99) == 3);
+    REQUIRE(Sonnet::reduce::sum(rows, p99) == 60);
+    REQUIRE(*Sonnet::reduce::mean(rows, p99) == 20);
+    REQUIRE(*Sonnet::reduce::min(rows, p99) == 7.5);
+    REQUIRE(*Sonnet::reduce::max(rows, p99) == 40);
+    REQUIRE(Sonnet::reduce::count_if(rows, p99, Sonnet::reduce::compare::greater_equal, 12.5) == 2);
+    REQUIRE(Sonnet::reduce::histogram(rows, p99, 0, 40, 2) == std::vector<std::size_t>{ 2, 1 });
+    REQUIRE_FALSE(Sonnet::reduce::max(rows, Sonnet::pointer{ "/missing" }));
+
+    // Packed rows are numbers: only the empty pointer reaches them
+    auto packed = *Sonnet::parse("[4,1,7]", { .pack_numeric_arrays = true });
+    REQUIRE(Sonnet::reduce::sum(packed, Sonnet::pointer{ "" }) == 12);
+    REQUIRE(Sonnet::reduce::count(packed, p99) == 0);
+}
+
+TEST_CASE("pointer compiles and resolves RFC 6901 paths", "[pointer]") {
+    auto doc = *Sonnet::parse(R"({"a":{"b/c":[10,{"~k":true}]},"":1,"n":[1,2]})");
+
+    Sonnet::pointer p{ "/a/b~1c/1/~0k" };
+    REQUIRE(p.size() == 4);
+    REQUIRE(p.token(1) == "b/c");
+    REQUIRE(p.to_string() == "/a/b~1c/1/~0k");
+    REQUIRE(p.resolve(doc)->as_bool());
+
+    REQUIRE(Sonnet::pointer{}.resolve(doc) == &doc);
+    REQUIRE(Sonnet::pointer{ "/" }.resolve(doc)->as_number() == 1);
+    REQUIRE(Sonnet::pointer{ "/a/b~1c/0" }.resolve(doc)->as_number() == 10);
+    REQUIRE_FALSE(Sonnet::pointer{ "/a/b~1c/01" }.resolve(doc));
+    REQUIRE_FALSE(Sonnet::pointer{ "/a/b~1c/2" }.resolve(doc));
+    REQUIRE_FALSE(Sonnet::pointer{ "/a/x" }.resolve(doc));
+
+    REQUIRE_FALSE(Sonnet::pointer::parse("a/b"));
+    REQUIRE_FALSE(Sonnet::pointer::parse("/a~2"));
+    REQUIRE_FALSE(Sonnet::pointer::parse("/a~"));
+    REQUIRE_THROWS_AS(Sonnet::pointer{ "x" }, std::invalid_argument);
+}
+
+TEST_CASE("pointer set and erase edit documents in place", "[pointer]") {
+    auto doc = *Sonnet::parse(R"({"rules":[{"id":1}],"xs":[1,2,3]})", { .pack_numeric_arrays = true });
+
+    Sonnet::pointer{ "/rules/0/limit" }.set(doc, Sonnet::value{ 5 });
+    Sonnet::pointer{ "/rules/-" }.set(doc, Sonnet::value{ "new" });
+    Sonnet::pointer{ "/meta/owner" }.set(doc, Sonnet::value{ "ops" });
+    REQUIRE(Sonnet::dump(doc) == R"({"meta":{"owner":"ops"},"rules":[{"id":1,"limit":5},"new"],"xs":[1,2,3]})");
+    REQUIRE_THROWS_AS(Sonnet::pointer{ "/rules/x" }.set(doc, Sonnet::value{}), std::invalid_argument);
+
+    REQUIRE(Sonnet::pointer{ "/xs/1" }.erase(doc));
+    REQUIRE(doc.at("xs").is_packed());
+    REQUIRE(Sonnet::pointer{ "/rules/0/id" }.erase(doc));
+    REQUIRE(Sonnet::pointer{ "/meta" }.erase(doc));
+    REQUIRE_FALSE(Sonnet::pointer{ "/meta" }.erase(doc));
+    REQUIRE_FALSE(Sonnet::pointer{}.erase(doc));
+    REQUIRE(Sonnet::dump(doc) == R"({"rules":[{"limit":5},"new"],"xs":[1,3]})");
+}
+
+TEST_CASE("jsonpath evaluates names, slices, filters and descendants", "[jsonpath]") {
+    auto doc = *Sonnet::parse(R"({"store":{"book":[
+        {"title":"A","price":8.95,"tags":["x"]},
+        {"title":"B","price":12.99},
+        {"title":"C","price":8.99,"isbn":"0-553"},
+        {"title":"D","price":22.99,"isbn":"0-395"}],
+        "bicycle":{"color":"red","price":19.95}}})");
+
+    auto titles = [&](std::string_view path) {
+        auto q = Sonnet::jsonpath::compile(path);
+        REQUIRE(q);
+        std::string out;
+        q->for_each(doc, [&](const Sonnet::value& v) { out += v.is_string() ? std::string{ v.as_string() } : Sonnet::dump(v); });
+        return out;
+    };
+
+    REQUIRE(titles("$.store.book[?(@.price < 10)].title") == "AC");
+    REQUIRE(titles("$.store.book[?@.isbn && @.price > 20].title") == "D");
+    REQUIRE(titles("$.store.book[?!@.isbn].title") == "AB");
+    REQUIRE(titles("$.store.book[?@.title == 'B' || @.title == \"D\"].title") == "BD");
+    REQUIRE(titles("$.store.book[?@.tags == $.store.book[0].tags].title") == "A");
+    REQUIRE(titles("$.store.book[-1].title") == "D");
+    REQUIRE(titles("$.store.book[1:3].title") == "BC");
+    REQUIRE(titles("$.store.book[::-2].title") == "DB");
+    REQUIRE(titles("$.store.book[0,2]['title']") == "AC");
+    REQUIRE(titles("$..price") == "19.958.9512.998.9922.99");
+    REQUIRE(titles("$.store..color") == "red");
+    REQUIRE(titles("$.store.book[*].nope") == "");
+
+    auto all = Sonnet::jsonpath::compile("$..book[*]");
+    REQUIRE(all->evaluate(doc).size() == 4);
+    REQUIRE(all->first(doc) == &doc.at("store").at("book")[0]);
+    REQUIRE(all->text() == "$..book[*]");
+
+    size_t seen = 0;
+    all->for_each(doc, [&](const Sonnet::value&) { return ++seen < 2; });
+    REQUIRE(seen == 2);
+}
+
+TEST_CASE("jsonpath reports syntax errors with their position", "[jsonpath]") {
+    auto err = [](std::string_view path) {
+        auto q = Sonnet::jsonpath::compile(path);
+        REQUIRE_FALSE(q);
+        return q.error();
+    };
+
+    REQUIRE(err("store").errc == Sonnet::ParseError::code::unexpected_character);
+    REQUIRE(err("$.a[").errc == Sonnet::ParseError::code::unexpected_end_of_input);
+    REQUIRE(err("$.a[01]").errc == Sonnet::ParseError::code::invalid_number);
+    REQUIRE(err("$['a\\q']").errc == Sonnet::ParseError::code::invalid_escape);
+    REQUIRE(err("$.a b").errc == Sonnet::ParseError::code::trailing_characters);
+    REQUIRE(err("$[?@..a == 1]").offset == 3);
+    REQUIRE(err("$[?@.a == 1 &&]").offset == 14);
+    REQUIRE(err("$[?1]").errc == Sonnet::ParseError::code::unexpected_character);
+    REQUIRE(Sonnet::jsonpath::compile("$['\\u00e9\\ud83d\\ude00']"));
+}
+
+TEST_CASE("jsonpath stream matches evaluation on the document", "[jsonpath]") {
+    const std::string_view text = R"({"users":[
+        {"id":1,"name":"ann","roles":["admin","dev"],"meta":{"id":10}},
+        {"id":2,"name":"bob","roles":[]},
+        {"id":3,"name":"cy","roles":["dev"]}],
+        "total":3})";
+    auto doc = *Sonnet::parse(text);
+
+    for (std::string_view path : { "$.users[*].name", "$.users[1:]", "$.users[-1].id", "$..id", "$.users[?@.roles[0] == 'dev'].name",
+                                   "$..roles[*]", "$", "$.total", "$[?@ > 2]", "$.users[?@.id == $.total].name" }) {
+        auto q = Sonnet::jsonpath::compile(path);
+        REQUIRE(q);
+
+        std::vector<std::string> expected;
+        q->for_each(doc, [&](const Sonnet::value& v) { expected.push_back(Sonnet::dump(v)); });
+
+        std::vector<std::string> streamed;
+        REQUIRE(Sonnet::jsonpath::stream(text, *q, [&](const Sonnet::value& v) { streamed.push_back(Sonnet::dump(v)); }));
+        REQUIRE(streamed == expected);
+    }
+
+    size_t calls = 0;
+    auto q = Sonnet::jsonpath::compile("$..id");
+    REQUIRE(Sonnet::jsonpath::stream(text, *q, [&](const Sonnet::value&) { return ++calls < 2; }));
+    REQUIRE(calls == 2);
+    REQUIRE_FALSE(Sonnet::jsonpath::stream(R"({"users":[)", *q, [](const Sonnet::value&) {}));
+}
+
+TEST_CASE("jsonpath selects packed elements like stream mode does", "[jsonpath][packed]") {
+    const std::string_view text = R"({"a":[1,2,3],"b":{"xs":[0.5,4]},"c":[[7],[8,9]]})";
+    auto packed = *Sonnet::parse(text, { .pack_numeric_arrays = true });
+    auto plain = *Sonnet::parse(text);
+    REQUIRE(packed.at("a").is_packed());
+
+    for (std::string_view path : { "$.a[0]", "$.a[-1]", "$.a[?@ > 1]", "$.a[::-1]", "$..xs[*]", "$.c[*][0]", "$..[?@ >= 4]" }) {
+        auto q = Sonnet::jsonpath::compile(path);
+        REQUIRE(q);
+
+        std::vector<std::string> streamed;
+        REQUIRE(Sonnet::jsonpath::stream(text, *q, [&](const Sonnet::value& v) { streamed.push_back(Sonnet::dump(v)); }));
+        REQUIRE_FALSE(streamed.empty());
+
+        for (const auto* doc : { &packed, &plain }) {
+            std::vector<std::string> selected;
+            q->for_each(*doc, [&](const Sonnet::value& v) { selected.push_back(Sonnet::dump(v)); });
+            REQUIRE(selected == streamed);
+        }
+    }
+}
+
+TEST_CASE("apply_patch applies RFC 6902 operations in order", "[patch]") {
+    auto doc = *Sonnet::parse(R"({"v":1,"a":{"b":[1,2,3]},"c":"x"})");
+    auto patch = *Sonnet::parse(R"([
+        {"op":"test","path":"/v","value":1},
+        {"op":"add","path":"/a/b/1","value":9},
+        {"op":"add","path":"/a/b/-","value":{"k":[true]}},
+        {"op":"remove","path":"/a/b/0"},
+        {"op":"replace","path":"/v","value":2},
+        {"op":"move","from":"/c","path":"/a/c"},
+        {"op":"copy","from":"/a/b/3","path":"/d"},
+        {"op":"test","path":"/d/k","value":[true]}])");
+
+    REQUIRE(Sonnet::apply_patch(doc, patch));
+    REQUIRE(Sonnet::dump(doc) == R"({"a":{"b":[9,2,3,{"k":[true]}],"c":"x"},"d":{"k":[true]},"v":2})");
+
+    auto packed = *Sonnet::parse(R"({"xs":[1,2,3]})", { .pack_numeric_arrays = true });
+    REQUIRE(Sonnet::apply_patch(packed, *Sonnet::parse(R"([{"op":"test","path":"/xs","value":[1,2,3]},{"op":"remove","path":"/xs/1"}])")));
+    REQUIRE(Sonnet::dump(packed) == R"({"xs":[1,3]})");
+
+    auto root = *Sonnet::parse("[1]");
+    REQUIRE(Sonnet::apply_patch(root, *Sonnet::parse(R"([{"op":"replace","path":"","value":{"r":1}}])")));
+    REQUIRE(Sonnet::dump(root) == R"({"r":1})");
+}
+
+TEST_CASE("apply_patch rolls back every change when an operation fails", "[patch]") {
+    const std::string original = R"({"a":{"b":[1,2,3]},"c":"x","n":{"m":1}})";
+    auto doc = *Sonnet::parse(original);
+
+    auto fails = [&](std::string_view patch) {
+        auto r = Sonnet::apply_patch(doc, *Sonnet::parse(patch));
+        REQUIRE_FALSE(r);
+        REQUIRE(Sonnet::dump(doc) == original);
+        return r.error();
+    };
+
+    auto e = fails(R"([{"op":"add","path":"/a/b/0","value":0},{"op":"remove","path":"/c"},{"op":"replace","path":"/n","value":5},
+                       {"op":"move","from":"/a/b","path":"/z"},{"op":"add","path":"/a/c","value":1},{"op":"remove","path":"/missing"}])");
+    REQUIRE(e.errc == Sonnet::PatchError::code::path_not_found);
+    REQUIRE(e.op_index == 5);
+
+    e = fails(R"([{"op":"add","path":"/a/b/-","value":4},{"op":"test","path":"/a/b/3","value":5}])");
+    REQUIRE(e.errc == Sonnet::PatchError::code::test_failed);
+    REQUIRE(e.op_index == 1);
+
+    e = fails(R"([{"op":"remove","path":"/c"},{"op":"test","path":"/n/m","value":2}])");
+    REQUIRE(e.errc == Sonnet::PatchError::code::test_failed);
+
+    e = fails(R"([{"op":"move","from":"/a","path":"/c"},{"op":"move","from":"/c/b","path":"/a/x/y"}])");
+    REQUIRE(e.errc == Sonnet::PatchError::code::path_not_found);
+
+    REQUIRE(fails(R"([{"op":"add","path":"/c/x","value":1}])").errc == Sonnet::PatchError::code::path_not_found);
+    REQUIRE(fails(R"([{"op":"remove","path":"/c"},{"op":"jump","path":"/a"}])").errc == Sonnet::PatchError::code::invalid_patch);
+    REQUIRE(fails(R"([{"op":"add","path":"a","value":1}])").errc == Sonnet::PatchError::code::invalid_patch);
+    REQUIRE(fails(R"([{"op":"move","from":"/a","path":"/a/b/0"}])").errc == Sonnet::PatchError::code::invalid_patch);
+    REQUIRE(fails(R"({"op":"add"})").errc == Sonnet::PatchError::code::invalid_patch);
+}
+
+TEST_CASE("apply_patch leaves packed arrays packed when it rolls back", "[patch][packed]") {
+    auto doc = *Sonnet::parse(R"({"xs":[1,2,3],"ys":[4,5]})", { .pack_numeric_arrays = true });
+
+    // Reads go through the packed elements without unpacking
+    REQUIRE(Sonnet::apply_patch(doc, *Sonnet::parse(R"([{"op":"test","path":"/xs/1","value":2},{"op":"copy","from":"/ys/0","path":"/z"}])")));
+    REQUIRE(doc.at("xs").is_packed());
+    REQUIRE(doc.at("ys").is_packed());
+    REQUIRE(doc.at("z").as_number() == 4);
+
+    auto r = Sonnet::apply_patch(doc, *Sonnet::parse(R"([{"op":"replace","path":"/xs/0","value":"a"},{"op":"move","from":"/ys/1","path":"/xs/-"},)"
+                                                     R"({"op":"test","path":"/xs/3","value":6}])"));
+    REQUIRE_FALSE(r);
+    REQUIRE(r.error().errc == Sonnet::PatchError::code::test_failed);
+    REQUIRE(doc.at("xs").is_packed());
+    REQUIRE(doc.at("ys").is_packed());
+    REQUIRE(Sonnet::dump(doc) == R"({"xs":[1,2,3],"ys":[4,5],"z":4})");
+}
+
+TEST_CASE("apply_merge_patch follows RFC 7396", "[patch]") {
+    auto doc = *Sonnet::parse(R"({"title":"Goodbye!","author":{"givenName":"John","familyName":"Doe"},"tags":["example","sample"],"content":"x"})");
+    auto patch = *Sonnet::parse(R"({"title":"Hello!","phoneNumber":"+01-123","author":{"familyName":null},"tags":["example"],"new":{"a":null,"b":1}})");
+
+    Sonnet::apply_merge_patch(doc, patch);
+    REQUIRE(Sonnet::dump(doc) == R"({"author":{"givenName":"John"},"content":"x","new":{"b":1},"phoneNumber":"+01-123","tags":["example"],"title":"Hello!"})");
+
+    auto scalar = *Sonnet::parse(R"({"a":1})");
+    Sonnet::apply_merge_patch(scalar, *Sonnet::parse(R"(["x"])"));
+    REQUIRE(Sonnet::dump(scalar) == R"(["x"])");
+    Sonnet::apply_merge_patch(scalar, *Sonnet::parse(R"({"a":{"b":null}})"));
+    REQUIRE(Sonnet::dump(scalar) == R"({"a":{}})");
+}
+
+TEST_CASE("diff produces a minimal JSON Patch", "[diff]") {
+    auto a = *Sonnet::parse(R"({"a":[1,2,3,4],"b":{"c":1,"d/e":"x"},"gone":null})");
+    auto b = *Sonnet::parse(R"({"a":[1,3,4,5],"b":{"c":2,"d/e":"x"},"new":true})");
+
+    REQUIRE(Sonnet::dump(Sonnet::diff(a, b)) ==
+            R"([{"op":"remove","path":"/a/1"},{"op":"add","path":"/a/3","value":5},{"op":"replace","path":"/b/c","value":2},)"
+            R"({"op":"remove","path":"/gone"},{"op":"add","path":"/new","value":true}])");
+    REQUIRE(Sonnet::diff(a, a).size() == 0);
+    REQUIRE(Sonnet::diff(a, *Sonnet::parse(Sonnet::dump(a))).size() == 0);
+
+    // A changed field inside one row is patched in place
+    auto rows1 = *Sonnet::parse(R"([{"id":1,"v":"a"},{"id":2,"v":"b"},{"id":3,"v":"c"}])");
+    auto rows2 = *Sonnet::parse(R"([{"id":0,"v":"z"},{"id":1,"v":"a"},{"id":2,"v":"B"},{"id":3,"v":"c"}])");
+    auto changes = Sonnet::diff_changes(rows1, rows2);
+    REQUIRE(changes.size() == 2);
+    REQUIRE(changes[0].kind == Sonnet::change_kind::add);
+    REQUIRE(changes[0].path == "/0");
+    REQUIRE(changes[0].target == &rows2[0]);
+    REQUIRE(changes[1].path == "/2/v");
+}
+
+TEST_CASE("diff output applies back to the target document", "[diff]") {
+    const char* docs[] = {
+        R"({"k":[1,2,3,4,5,6,7,8,9]})",
+        R"({"k":[9,8,7,6,5,4,3,2,1],"x":{"y":[{"z":1}]}})",
+        R"({"k":[1,"2",[3],{"4":4},5],"x":{"y":[{"z":2},{"z":1}]}})",
+        R"({"k":[],"x":"y"})",
+        R"([1,2])",
+        R"("root")",
+    };
+
+    for (const char* from : docs) {
+        for (const char* to : docs) {
+            for (std::size_t limit : { std::size_t{ 0 }, std::size_t{ 2 }, std::size_t{ 512 } }) {
+                auto a = *Sonnet::parse(from, { .pack_numeric_arrays = limit == 2 });
+                auto b = *Sonnet::parse(to);
+                REQUIRE(Sonnet::apply_patch(a, Sonnet::diff(a, b, { .array_edit_limit = limit })));
+                REQUIRE(Sonnet::dump(a) == Sonnet::dump(b));
+            }
+        }
+    }
+}
+
+TEST_CASE("structural hash agrees with equality", "[hash]") {
+    auto a = *Sonnet::parse(R"({"a":[1,2,3],"b":{"c":null,"d":"x"},"z":-0.0})");
+    auto b = *Sonnet::parse(R"({"z":0,"b":{"d":"x","c":null},"a":[1,2,3]})");
+    auto packed = *Sonnet::parse(R"({"a":[1,2,3],"b":{"c":null,"d":"x"},"z":0})", { .pack_numeric_arrays = true });
+    REQUIRE(Sonnet::hash(a) == Sonnet::hash(b));
+    REQUIRE(Sonnet::hash(a) == Sonnet::hash(packed));
+    REQUIRE(Sonnet::hash(a) != Sonnet::hash(*Sonnet::parse(R"({"a":[1,3,2],"b":{"c":null,"d":"x"},"z":0})")));
+    REQUIRE(Sonnet::hash(*Sonnet::parse("[[]]")) != Sonnet::hash(*Sonnet::parse("[[],[]]")));
+    REQUIRE(Sonnet::hash(*Sonnet::parse(R"({"ab":"c"})")) != Sonnet::hash(*Sonnet::parse(R"({"a":"bc"})")));
+    Sonnet::hash_cache cache;
+    REQUIRE(cache.hash(a) == Sonnet::hash(b));
+    REQUIRE(cache.hash(packed) == Sonnet::hash(a));
+}
+
+TEST_CASE("hash_cache memoizes container hashes without touching the values", "[hash]") {
+    auto a = *Sonnet::parse(R"({"list":[{"n":1},{"n":2}],"name":"x"})");
+    auto b = a;
+    Sonnet::hash_cache cache;
+    auto before = cache.hash(a);
+    REQUIRE(cache.size() == 4);
+    REQUIRE(cache.hash(a.at("list")) == Sonnet::hash(b.at("list")));
+    REQUIRE(cache.size() == 4);
+    REQUIRE(Sonnet::hashed_equal(cache, a, b));
+
+    // `hash` itself always walks the current contents
+    a["list"][1]["n"] = Sonnet::value{ 3.0 };
+    REQUIRE(Sonnet::hash(a) != before);
+    REQUIRE(a != b);
+
+    // The cache does not see the edit until it is cleared
+    REQUIRE(cache.hash(a) == before);
+    cache.clear();
+    REQUIRE(cache.hash(a) != cache.hash(b));
+    REQUIRE_FALSE(Sonnet::hashed_equal(cache, a, b));
+
+    auto p = *Sonnet::pointer::parse("/list/1/n");
+    *p.resolve(a) = Sonnet::value{ 2.0 };
+    REQUIRE(Sonnet::hash(a) == before);
+    cache.clear();
+    REQUIRE(Sonnet::hashed_equal(cache, a, b));
+}
+
+TEST_CASE("equality ignores hashes", "[hash]") {
+    auto a = *Sonnet::parse(R"({"list":[1]})");
+    auto& list = a["list"];
+    Sonnet::hash_cache cache;
+    auto stale = cache.hash(a);
+
+    // Edited through a reference taken before hashing: the cache keeps
+    // the old hash of `a`, `==` compares the contents
+    list.as_array().push_back(Sonnet::value{ 2.0 });
+    auto b = *Sonnet::parse(R"({"list":[1,2]})");
+    REQUIRE(cache.hash(a) == stale);
+    REQUIRE(a == b);
+    REQUIRE(b == a);
+    REQUIRE(Sonnet::hash(a) == Sonnet::hash(b));
+}
+
+TEST_CASE("std::hash<value> deduplicates documents", "[hash]") {
+    std::unordered_set<Sonnet::value> seen;
+    for (const char* doc : { R"({"x":1,"y":[true]})", R"({"y":[true],"x":1})", "[1,2]", "[1.0,2.0]", R"("s")", "null" })
+        seen.insert(*Sonnet::parse(doc));
+    REQUIRE(seen.size() == 4);
+    REQUIRE(seen.contains(*Sonnet::parse("[1,2]")));
+}
+
+TEST_CASE("intern_subtrees shares repeated subtrees", "[intern]") {
+    const char* text = R"({"a":{"addr":{"city":"Springfield","street":"742 Evergreen Terrace"}},)"
+                       R"("b":{"addr":{"city":"Springfield","street":"742 Evergreen Terrace"}},)"
+                       R"("c":[1,2],"d":[1,2],"e":"a string that is long enough","f":"a string that is long enough","g":{}})";
+    auto doc = *Sonnet::parse(text);
+    const auto original = doc;
+
+    REQUIRE(Sonnet::intern_subtrees(doc) == 3);
+    REQUIRE(doc == original);
+    REQUIRE(Sonnet::dump(doc) == Sonnet::dump(original));
+    REQUIRE(Sonnet::hash(doc) == Sonnet::hash(original));
+    REQUIRE(doc.at("b").is_shared());
+    REQUIRE(&doc.at("a").at("addr") == &doc.at("b").at("addr"));
+    REQUIRE(&doc.at("e").as_string() == &doc.at("f").as_string());
+    REQUIRE(!doc.at("g").is_shared());
+    REQUIRE(Sonnet::intern_subtrees(doc) == 0);
+
+    auto parsed = *Sonnet::parse(text, { .intern_subtrees = true });
+    REQUIRE(parsed == original);
+    REQUIRE(&parsed.at("c").as_array() == &parsed.at("d").as_array());
+}
+
+TEST_CASE("shared subtrees are copied on write", "[intern]") {
+    auto doc = *Sonnet::parse(R"([{"tags":["x","y"],"n":1},{"tags":["x","y"],"n":1},{"tags":["x","y"],"n":2}])");
+    Sonnet::intern_subtrees(doc);
+    auto copy = doc;
+    REQUIRE(&copy[std::size_t{ 0 }].at("tags") == &doc.as_array()[1].at("tags"));
+
+    doc[std::size_t{ 1 }]["n"] = Sonnet::value{ 5.0 };
+    REQUIRE(Sonnet::dump(doc) == R"([{"n":1,"tags":["x","y"]},{"n":5,"tags":["x","y"]},{"n":2,"tags":["x","y"]}])");
+    REQUIRE(Sonnet::dump(copy) == R"([{"n":1,"tags":["x","y"]},{"n":1,"tags":["x","y"]},{"n":2,"tags":["x","y"]}])");
+    REQUIRE(doc.as_array()[0].is_shared());
+
+    REQUIRE(Sonnet::apply_patch(doc, *Sonnet::parse(R"([{"op":"add","path":"/0/tags/-","value":"z"}])")));
+    REQUIRE(Sonnet::dump(doc.as_array()[0].at("tags")) == R"(["x","y","z"])");
+    REQUIRE(Sonnet::dump(doc.as_array()[2].at("tags")) == R"(["x","y"])");
+    REQUIRE(Sonnet::dump(copy) == R"([{"n":1,"tags":["x","y"]},{"n":1,"tags":["x","y"]},{"n":2,"tags":["x","y"]}])");
+}
+
+TEST_CASE("schema validator checks values", "[schema]") {
+    auto schema = *Sonnet::parse(R"({
+        "type": "object",
+        "required": ["id", "name"],
+        "properties": {
+            "id": { "type": "integer", "minimum": 1 },
+            "name": { "type": "string", "minLength": 2, "maxLength": 5, "pattern": "^[a-z]+$" },
+            "tags": { "type": "array", "items": { "enum": ["a", "b", [1]] }, "maxItems": 3 },
+            "ratio": { "type": "number", "exclusiveMaximum": 1 },
+            "tree": { "$ref": "#/$defs/node" }
+        },
+        "additionalProperties": false,
+        "$defs": {
+            "node": { "type": "object", "properties": { "kids": { "type": "array", "items": { "$ref": "#/$defs/node" } } } }
+        }
+    })");
+    auto v = Sonnet::schema::compile(schema);
+    REQUIRE(v);
+
+    REQUIRE(v->is_valid(*Sonnet::parse(R"({"id":3,"name":"ab","tags":["a",[1]],"ratio":0.5,"tree":{"kids":[{"kids":[]}]}})")));
+
+    auto error = [&](const char* doc) {
+        auto r = v->validate(*Sonnet::parse(doc));
+        REQUIRE(!r);
+        return r.error().instance_path + " " + r.error().schema_path;
+    };
+    REQUIRE(error(R"({"id":3})") == " /required");
+    REQUIRE(error(R"({"id":1.5,"name":"ab"})") == "/id /properties/id/type");
+    REQUIRE(error(R"({"id":0,"name":"ab"})") == "/id /properties/id/minimum");
+    REQUIRE(error(R"({"id":1,"name":"Ab"})") == "/name /properties/name/pattern");
+    REQUIRE(error(R"({"id":1,"name":"abcdef"})") == "/name /properties/name/maxLength");
+    REQUIRE(error(R"({"id":1,"name":"ab","tags":["a","c"]})") == "/tags/1 /properties/tags/items/enum");
+    REQUIRE(error(R"({"id":1,"name":"ab","ratio":1})") == "/ratio /properties/ratio/exclusiveMaximum");
+    REQUIRE(error(R"({"id":1,"name":"ab","x":null})") == "/x /additionalProperties");
+    REQUIRE(error(R"({"id":1,"name":"ab","tree":{"kids":[{"kids":1}]}})") == "/tree/kids/0/kids /$defs/node/properties/kids/type");
+    REQUIRE(v->validate(*Sonnet::parse(R"({"id":3})")).error().msg == "Missing required property \"name\"");
+}
+
+TEST_CASE("schema validator checks JSON text while parsing", "[schema]") {
+    auto v = Sonnet::schema::compile(*Sonnet::parse(R"({
+        "type": "array",
+        "minItems": 1,
+        "items": {
+            "type": "object",
+            "required": ["kind"],
+            "properties": { "kind": { "const": "point" }, "at": { "enum": [[0,0],[1,1]] }, "w": { "maximum": 10 } }
+        }
+    })"));
+    REQUIRE(v);
+
+    const char* docs[] = {
+        R"([{"kind":"point","at":[1,1]},{"kind":"point","w":10}])",
+        R"([])",
+        R"([{"at":[0,0]}])",
+        R"([{"kind":"point","at":[0,1]}])",
+        R"([{"kind":"point","w":11}])",
+        R"([{"kind":"line"}])",
+        R"({"kind":"point"})",
+    };
+    for (const char* doc : docs) {
+        auto dom = v->validate(*Sonnet::parse(doc));
+        auto text = v->validate_json(doc);
+        REQUIRE(dom.has_value() == text.has_value());
+        if (!dom) {
+            REQUIRE(dom.error().instance_path == text.error().instance_path);
+            REQUIRE(dom.error().schema_path == text.error().schema_path);
+        }
+    }
+    REQUIRE(v->validate_json(R"([{"kind":"point","at":[0,1]}])").error().instance_path == "/0/at");
+    REQUIRE(v->validate_json("[{").error().errc == Sonnet::schema::ValidationError::code::invalid_json);
+
+    // Validate and build in one pass
+    Sonnet::DomBuilder builder;
+    Sonnet::schema::ValidatingHandler handler{ *v, &builder };
+    REQUIRE(Sonnet::parse_sax(docs[0], handler));
+    REQUIRE(Sonnet::dump(builder.result()) == Sonnet::dump(*Sonnet::parse(docs[0])));
+
+    builder.reset();
+    handler.reset();
+    auto r = Sonnet::parse_sax(R"([{"kind":"point","w":11},{"kind":"point"}])", handler);
+    REQUIRE(!r);
+    REQUIRE(r.error().errc == Sonnet::ParseError::code::aborted);
+    REQUIRE(handler.error()->instance_path == "/0/w");
+}
+
+TEST_CASE("schema compile reports unsupported schemas", "[schema]") {
+    using code = Sonnet::schema::SchemaError::code;
+    auto fails = [](const char* schema) {
+        auto v = Sonnet::schema::compile(*Sonnet::parse(schema));
+        REQUIRE(!v);
+        return std::pair{ v.error().errc, v.error().path };
+    };
+    REQUIRE(fails(R"({"properties":{"a":{"anyOf":[]}}})") == std::pair{ code::unsupported_keyword, std::string{ "/properties/a/anyOf" } });
+    REQUIRE(fails(R"({"$ref":"#/$defs/missing"})") == std::pair{ code::unresolved_ref, std::string{ "/$ref" } });
+    REQUIRE(fails(R"({"$ref":"other.json"})").first == code::unresolved_ref);
+    REQUIRE(fails(R"({"pattern":"(["})").first == code::invalid_pattern);
+    REQUIRE(fails(R"({"type":"int"})").first == code::invalid_schema);
+    REQUIRE(fails(R"({"$defs":{"a":{"$ref":"#/$defs/b"},"b":{"$ref":"#/$defs/a"}},"$ref":"#/$defs/a"})").first == code::invalid_schema);
+
+    auto never = Sonnet::schema::compile(Sonnet::value{ false });
+    REQUIRE(never);
+    REQUIRE(!never->is_valid(Sonnet::value{}));
+    REQUIRE(Sonnet::schema::compile(Sonnet::value{ true })->is_valid(Sonnet::value{ 1.0 }));
+}
+
+TEST_CASE("schema patterns follow ECMAScript", "[schema]") {
+    auto matches = [](const char* pattern, std::string_view s) {
+        Sonnet::value schema{ Sonnet::object{} };
+        schema["pattern"] = Sonnet::value{ pattern };
+        auto v = Sonnet::schema::compile(schema);
+        REQUIRE(v);
+        return v->is_valid(Sonnet::value{ s });
+    };
+    REQUIRE(matches("b+", "abbc"));
+    REQUIRE(!matches("^b+", "abbc"));
+    REQUIRE(matches("^a(b|c){2,3}d$", "abcbd"));
+    REQUIRE(!matches("^a(b|c){2,3}d$", "abd"));
+    REQUIRE(!matches("^a(?:b|c){2,3}d$", "abcbcd"));
+    REQUIRE(matches(R"(^\d{3}-[^\s]+$)", "123-x_y"));
+    REQUIRE(!matches(R"(^\d{3}-[^\s]+$)", "123-x y"));
+    REQUIRE(matches(R"(\bcat\b)", "a cat!"));
+    REQUIRE(!matches(R"(\bcat\b)", "concat"));
+    REQUIRE(matches("^[a-f0-9]*?$", ""));
+    REQUIRE(matches("^.$", "\xC3\xA9"));
+    REQUIRE(matches(R"(^\u00e9$)", "\xC3\xA9"));
+    REQUIRE(matches("^a{,2}$", "a{,2}"));
+
+    using code = Sonnet::schema::SchemaError::code;
+    for (const char* bad : { R"((a)\1)", "(?=a)", "a**", "[b-a]", "(a" }) {
+        Sonnet::value schema{ Sonnet::object{} };
+        schema["pattern"] = Sonnet::value{ bad };
+        REQUIRE(Sonnet::schema::compile(schema).error().errc == code::invalid_pattern);
+    }
+}
+
+TEST_CASE("schema patterns match long strings without recursion", "[schema]") {
+    auto v = Sonnet::schema::compile(*Sonnet::parse(R"({"pattern":"^(a|b)*$"})"));
+    REQUIRE(v);
+
+    std::string s(200'000, 'a');
+    for (std::size_t i = 0; i < s.size(); i += 3) s[i] = 'b';
+    REQUIRE(v->is_valid(Sonnet::value{ std::string_view{ s } }));
+    REQUIRE(v->validate_json('"' + s + '"'));
+
+    s[150'000] = 'c';
+    REQUIRE(!v->is_valid(Sonnet::value{ std::string_view{ s } }));
+    REQUIRE(v->validate_json('"' + s + '"').error().schema_path == "/pattern");
+}
+
+TEST_CASE("index_by finds elements by key", "[index]") {
+    Sonnet::value items{ Sonnet::array{} };
+    for (int i = 0; i < 1000; i++) {
+        Sonnet::value item{ Sonnet::object{} };
+        item["id"] = Sonnet::value{ i };
+        item["sku"] = Sonnet::value{ std::string_view{ "sku-" + std::to_string(i) } };
+        item["group"] = Sonnet::value{ i % 7 };
+        if (i % 100 == 0) item["meta"]["code"] = Sonnet::value{ Sonnet::array{} };
+        items.as_array().push_back(std::move(item));
+    }
+    items.as_array().push_back(Sonnet::value{ "no key" });
+
+    const auto& arr = std::as_const(items).as_array();
+    auto by_id = Sonnet::index_by(items, Sonnet::pointer{ "/id" });
+    REQUIRE(by_id.valid());
+    REQUIRE(by_id.unique());
+    REQUIRE(by_id.size() == 1000);
+    REQUIRE(by_id.find(512) == &arr[512]);
+    REQUIRE(by_id.find(Sonnet::value{ 7.0 }) == &arr[7]);
+    REQUIRE(by_id.find(1000) == nullptr);
+    REQUIRE(by_id.find("512") == nullptr);
+
+    auto by_sku = Sonnet::index_by(items, Sonnet::pointer{ "/sku" });
+    REQUIRE(by_sku.find("sku-999") == &arr[999]);
+
+    auto by_group = Sonnet::index_by(items, Sonnet::pointer{ "/group" });
+    REQUIRE(!by_group.unique());
+    auto threes = by_group.find_all(3);
+    REQUIRE(threes.size() == 143);
+    REQUIRE(std::ranges::all_of(threes, [](const Sonnet::value* v) { return v->at("group").as_number() == 3; }));
+    REQUIRE(std::ranges::is_sorted(threes));
+
+    auto by_meta = Sonnet::index_by(items, Sonnet::pointer{ "/meta" });
+    REQUIRE(by_meta.find_all(*Sonnet::parse(R"({"code":[]})")).size() == 10);
+    REQUIRE_THROWS_AS(Sonnet::index_by(Sonnet::value{ 1.0 }, Sonnet::pointer{ "/id" }), std::invalid_argument);
+}
+
+TEST_CASE("array_index goes stale when the array changes", "[index]") {
+    auto doc = *Sonnet::parse(R"({"users":[{"name":"ann","age":30},{"name":"bob","age":40}]})");
+    const Sonnet::value& users = doc.at("users");
+    auto by_name = Sonnet::index_by(users, Sonnet::pointer{ "/name" });
+    REQUIRE(by_name.find("bob")->at("age").as_number() == 40);
+
+    // Reading through const access keeps the index valid
+    REQUIRE(std::as_const(doc).at("users").size() == 2);
+    REQUIRE(by_name.valid());
+
+    doc["users"][std::size_t{ 2 }]["name"] = Sonnet::value{ "cy" };
+    REQUIRE(!by_name.valid());
+    REQUIRE_THROWS_AS(by_name.find("bob"), std::logic_error);
+
+    by_name.rebuild();
+    REQUIRE(by_name.valid());
+    REQUIRE(by_name.find("cy") == &users.as_array()[2]);
+
+    REQUIRE(Sonnet::apply_patch(doc, *Sonnet::parse(R"([{"op":"remove","path":"/users/0"}])")));
+    REQUIRE(!by_name.valid());
+}
+
+TEST_CASE("array_index goes stale when the array is assigned over", "[index]") {
+    Sonnet::value a = *Sonnet::parse("[1,2,3]");
+    auto idx = Sonnet::index_by(a, Sonnet::pointer{ "" });
+    REQUIRE(idx.find(2.0) == &std::as_const(a).as_array()[1]);
+
+    // The copy has equal contents but storage of its own
+    Sonnet::value b = a;
+    a = b;
+    REQUIRE(!idx.valid());
+    REQUIRE_THROWS_AS(idx.find(2.0), std::logic_error);
+
+    idx.rebuild();
+    a = Sonnet::value{ *Sonnet::parse("[1,2,3]") };
+    REQUIRE(!idx.valid());
+    idx.rebuild();
+    REQUIRE(idx.find(3.0) == &std::as_const(a).as_array()[2]);
+}
+
+TEST_CASE("index_by indexes packed arrays by number", "[index][packed]") {
+    std::string_view text = "[5,3,5,1]";
+    auto packed = *Sonnet::parse(text, { .pack_numeric_arrays = true });
+    auto plain = *Sonnet::parse(text);
+    REQUIRE(packed.is_packed());
+
+    for (auto* doc : { &packed, &plain }) {
+        const auto& arr = std::as_const(*doc);
+        auto idx = Sonnet::index_by(arr, Sonnet::pointer{ "" });
+        REQUIRE(idx.valid());
+        REQUIRE(idx.size() == 3);
+        REQUIRE(idx.find(3.0) == &arr.as_array()[1]);
+        REQUIRE(idx.find_all(5.0).size() == 2);
+        REQUIRE(idx.find(2.0) == nullptr);
+        REQUIRE(Sonnet::index_by(arr, Sonnet::pointer{ "/id" }).size() == 0);
+
+        doc->as_array().push_back(Sonnet::value{ 4.0 });
+        REQUIRE(!idx.valid());
+        idx.rebuild();
+        REQUIRE(idx.find(4.0) == &arr.as_array()[4]);
+    }
+
+    // Editing the numbers in place drops the element nodes the index
+    // points into
+    REQUIRE(packed.pack());
+    auto idx = Sonnet::index_by(packed, Sonnet::pointer{ "" });
+    packed.numbers()[0] = 6;
+    REQUIRE(!idx.valid());
+    idx.rebuild();
+    REQUIRE(idx.find(6.0) == &std::as_const(packed).as_array()[0]);
+}
+
+namespace describe_test {
+    struct item {
+        std::string sku;
+        int qty = 0;
+        double price = 0.0;
+    };
+
+    struct order {
+        std::uint64_t id = 0;
+        bool paid = false;
+        item line;
+        Sonnet::string note;
+        Sonnet::value meta{ nullptr };
+    };
+
+    SONNET_DEFINE_TYPE(item, sku, qty, price);
+    SONNET_DEFINE_TYPE(order, id, paid, line, note, meta);
+}
+
+TEST_CASE("SONNET_DEFINE_TYPE generates to_json and from_json", "[describe]") {
+    static_assert(Sonnet::JsonSerializable<describe_test::order> && Sonnet::JsonDeserializable<describe_test::order>);
+    static_assert(Sonnet::describe::detail::keys<describe_test::order>.find("note", Sonnet::describe::detail::names<describe_test::order>) == 3);
+
+    describe_test::order o{ 7, true, { "A-1", 3, 2.5 }, "fragile", Sonnet::value{ "x" } };
+    Sonnet::value v = Sonnet::serialize(o);
+    REQUIRE(v == *Sonnet::parse(R"({"id":7,"paid":true,"line":{"sku":"A-1","qty":3,"price":2.5},"note":"fragile","meta":"x"})"));
+
+    auto back = Sonnet::deserialize<describe_test::order>(v);
+    REQUIRE(back.id == 7);
+    REQUIRE(back.line.sku == "A-1");
+    REQUIRE(back.line.qty == 3);
+    REQUIRE(back.note == "fragile");
+    REQUIRE(back.meta == o.meta);
+
+    v["line"]["qty"] = 1.5;
+    REQUIRE_THROWS_WITH(Sonnet::deserialize<describe_test::order>(v), "Sonnet::from_json: /line/qty: expected an integer in range");
+    v["line"].as_object().erase("qty");
+    REQUIRE_THROWS_WITH(Sonnet::deserialize<describe_test::order>(v), "Sonnet::from_json: /line/qty: missing member");
+}
+
+TEST_CASE("parse_as fills described types without building a document", "[describe]") {
+    auto o = Sonnet::parse_as<describe_test::order>(R"({
+        "extra": [1, {"id": 9}],
+        "meta": {"tags": ["a", "b"]},
+        "line": {"price": 4, "sku": "B-2", "qty": 12, "unknown": null},
+        "note": "n",
+        "paid": false,
+        "id": 18446744073709549568
+    })");
+    REQUIRE(o);
+    REQUIRE(o->id == 18446744073709549568ull);
+    REQUIRE(o->line.qty == 12);
+    REQUIRE(o->line.price == 4.0);
+    REQUIRE(o->meta == *Sonnet::parse(R"({"tags":["a","b"]})"));
+
+    auto wrong = Sonnet::parse_as<describe_test::order>(R"({"id":1,"paid":true,"line":{"sku":"x","qty":-1e10,"price":0},"note":"","meta":null})");
+    REQUIRE_FALSE(wrong);
+    REQUIRE(wrong.error().errc == Sonnet::ParseError::code::aborted);
+    REQUIRE(wrong.error().msg == "/line/qty: expected an integer in range");
+
+    auto missing = Sonnet::parse_as<describe_test::item>(R"({"sku":"x","qty":1})");
+    REQUIRE_FALSE(missing);
+    REQUIRE(missing.error().msg == "/price: missing member");
+
+    REQUIRE_FALSE(Sonnet::parse_as<describe_test::item>(R"({"sku":"x","qty":1,"price":[]})"));
+    REQUIRE(Sonnet::parse_as<int>("42").value() == 42);
+}
+
+TEST_CASE("dump of a described type matches dump of its value", "[describe]") {
+    describe_test::order o{ 1, false, { "q\"uote", -4, 0.1 }, "", Sonnet::value{ nullptr } };
+    o.meta["k"] = Sonnet::value{ Sonnet::array{} };
+
+    for (Sonnet::WriteOptions opts : { Sonnet::WriteOptions{}, Sonnet::WriteOptions{ .pretty = true, .indent = 3 }, Sonnet::WriteOptions{ .canonical = true } }) {
+        std::string text = Sonnet::dump(o, opts);
+        REQUIRE(text == Sonnet::dump(Sonnet::serialize(o), opts));
+        REQUIRE(Sonnet::parse_as<describe_test::order>(text)->line.sku == "q\"uote");
+    }
+}
+
+namespace describe_test {
+    struct celsius {
+        double deg = 0.0;
+    };
+
+    void to_json(Sonnet::value& v, const celsius& c) { v = c.deg; }
+
+    void from_json(const Sonnet::value& v, celsius& c) {
+        if (!v.is_number() || v.as_number() < -273.15) throw std::invalid_argument{ "not a temperature" };
+        c.deg = v.as_number();
+    }
+
+    struct reading {
+        std::string sensor;
+        celsius temp;
+        std::vector<int>::size_type seq = 0;
+    };
+
+    SONNET_DEFINE_TYPE(reading, sensor, temp, seq);
+}
+
+TEST_CASE("from_json_value reports conversion failures without throwing", "[describe][convert]") {
+    using code = Sonnet::ConvertError::code;
+    static_assert(Sonnet::JsonCheckedDeserializable<describe_test::order>);
+
+    auto ok = Sonnet::from_json_value<describe_test::item>(*Sonnet::parse(R"({"sku":"s","qty":2,"price":1})"));
+    REQUIRE(ok);
+    REQUIRE(ok->qty == 2);
+
+    auto check = [](std::string_view json, code errc, std::string_view path, std::string_view msg) {
+        auto r = Sonnet::from_json_value<describe_test::order>(*Sonnet::parse(json));
+        REQUIRE_FALSE(r);
+        CHECK(r.error().errc == errc);
+        CHECK(r.error().path == path);
+        CHECK(r.error().msg == msg);
+    };
+    check(R"([])", code::type_mismatch, "", "expected an object");
+    check(R"({"id":1,"paid":1,"line":{"sku":"","qty":0,"price":0},"note":"","meta":null})", code::type_mismatch, "/paid", "expected a boolean");
+    check(R"({"id":-1,"paid":true,"line":{"sku":"","qty":0,"price":0},"note":"","meta":null})", code::out_of_range, "/id", "expected an integer in range");
+    check(R"({"id":1,"paid":true,"line":{"sku":"","price":0},"note":"","meta":null})", code::missing_member, "/line/qty", "missing member");
+    check(R"({"id":1,"paid":true,"line":{"sku":"","qty":"2","price":0},"note":"","meta":null})", code::type_mismatch, "/line/qty", "expected an integer");
+}
+
+TEST_CASE("from_json_value wraps throwing converters", "[describe][convert]") {
+    using code = Sonnet::ConvertError::code;
+
+    auto r = Sonnet::from_json_value<describe_test::reading>(*Sonnet::parse(R"({"sensor":"t1","temp":-300,"seq":4})"));
+    REQUIRE_FALSE(r);
+    REQUIRE(r.error().errc == code::invalid_value);
+    REQUIRE(r.error().path == "/temp");
+    REQUIRE(r.error().msg == "not a temperature");
+
+    auto c = Sonnet::from_json_value<describe_test::celsius>(Sonnet::value{ "warm" });
+    REQUIRE_FALSE(c);
+    REQUIRE(c.error().path.empty());
+
+    auto good = Sonnet::parse_as<describe_test::reading>(R"({"sensor":"t1","temp":21.5,"seq":4})");
+    REQUIRE(good);
+    REQUIRE(good->temp.deg == 21.5);
+    auto bad = Sonnet::parse_as<describe_test::reading>(R"({"sensor":"t1","temp":-300,"seq":4})");
+    REQUIRE_FALSE(bad);
+    REQUIRE(bad.error().msg == "/temp: not a temperature");
+    REQUIRE(Sonnet::dump(describe_test::reading{ "t2", { 3.0 }, 1 }) == R"({"sensor":"t2","seq":1,"temp":3})");
+}
+
+TEST_CASE("builtin converters handle STL and vocabulary types", "[convert]") {
+    using code = Sonnet::ConvertError::code;
+    enum class level : std::uint8_t { low = 1, high = 3 };
+
+    std::map<std::string, std::vector<int>> groups{ { "a", { 1, 2 } }, { "b", {} } };
+    Sonnet::value v = Sonnet::serialize(groups);
+    REQUIRE(v == *Sonnet::parse(R"({"a":[1,2],"b":[]})"));
+    REQUIRE(Sonnet::deserialize<std::map<std::string, std::vector<int>>>(v) == groups);
+    REQUIRE(Sonnet::deserialize<std::unordered_map<std::string, std::vector<int>>>(v).at("a") == std::vector<int>{ 1, 2 });
+
+    std::tuple<int, std::string, std::optional<double>> t{ 4, "x", std::nullopt };
+    REQUIRE(Sonnet::serialize(t) == *Sonnet::parse(R"([4,"x",null])"));
+    REQUIRE(Sonnet::deserialize<decltype(t)>(Sonnet::serialize(t)) == t);
+    REQUIRE(Sonnet::deserialize<std::pair<level, std::chrono::milliseconds>>(*Sonnet::parse("[3,250]")) == std::pair{ level::high, std::chrono::milliseconds{ 250 } });
+    REQUIRE(Sonnet::deserialize<std::array<float, 3>>(*Sonnet::parse("[1,2,3]"))[2] == 3.0f);
+    REQUIRE(Sonnet::deserialize<std::vector<bool>>(*Sonnet::parse("[true,false]")) == std::vector<bool>{ true, false });
+
+    using number_or_text = std::variant<std::monostate, int, std::string>;
+    REQUIRE(Sonnet::deserialize<number_or_text>(Sonnet::value{ "s" }).index() == 2);
+    REQUIRE(Sonnet::deserialize<number_or_text>(Sonnet::value{ nullptr }).index() == 0);
+    REQUIRE(Sonnet::serialize(number_or_text{ 5 }) == Sonnet::value{ 5 });
+
+    auto short_array = Sonnet::from_json_value<std::array<int, 3>>(*Sonnet::parse("[1,2]"));
+    REQUIRE_FALSE(short_array);
+    REQUIRE(short_array.error().errc == code::invalid_value);
+    auto bad_element = Sonnet::from_json_value<std::map<std::string, std::vector<int>>>(*Sonnet::parse(R"({"a/b":[1,true]})"));
+    REQUIRE_FALSE(bad_element);
+    REQUIRE(bad_element.error().path == "/a~1b/1");
+    REQUIRE(bad_element.error().msg == "expected an integer");
+    REQUIRE(Sonnet::from_json_value<std::variant<int, bool>>(Sonnet::value{ "s" }).error().errc == code::type_mismatch);
+}
+
+namespace describe_test {
+    enum class tier { basic, gold };
+
+    struct account {
+        std::string name;
+        tier level = tier::basic;
+        std::vector<item> items;
+        std::map<std::string, std::optional<int>> limits;
+        std::optional<std::string> email;
+        std::array<double, 2> position{};
+        std::chrono::seconds ttl{};
+    };
+
+    SONNET_DEFINE_TYPE(account, name, level, items, limits, email, position, ttl);
+}
+
+TEST_CASE("described types nest containers and optionals", "[describe][convert]") {
+    std::string json = R"({
+        "name": "ann",
+        "level": 1,
+        "items": [{"sku": "a", "qty": 1, "price": 0.5}, {"sku": "b", "qty": 2, "price": 1}],
+        "limits": {"daily": 10, "weekly": null, "~x": 3},
+        "position": [1.5, -2],
+        "ttl": 60
+    })";
+    auto a = Sonnet::parse_as<describe_test::account>(json);
+    REQUIRE(a);
+    REQUIRE(a->level == describe_test::tier::gold);
+    REQUIRE(a->items.size() == 2);
+    REQUIRE(a->items[1].sku == "b");
+    REQUIRE(a->limits.at("daily") == 10);
+    REQUIRE_FALSE(a->limits.at("weekly"));
+    REQUIRE_FALSE(a->email);
+    REQUIRE(a->position[1] == -2.0);
+    REQUIRE(a->ttl == std::chrono::seconds{ 60 });
+
+    auto dom = Sonnet::deserialize<describe_test::account>(*Sonnet::parse(json));
+    REQUIRE(Sonnet::serialize(dom) == Sonnet::serialize(*a));
+
+    a->email = "ann@example.com";
+    for (Sonnet::WriteOptions opts : { Sonnet::WriteOptions{}, Sonnet::WriteOptions{ .pretty = true }, Sonnet::WriteOptions{ .canonical = true } }) {
+        REQUIRE(Sonnet::dump(*a, opts) == Sonnet::dump(Sonnet::serialize(*a), opts));
+    }
+
+    auto bad_item = Sonnet::parse_as<describe_test::account>(R"({"name":"","level":0,"items":[{"sku":"a","qty":1,"price":0},{"sku":"b","qty":1}],"limits":{},"position":[0,0],"ttl":0})");
+    REQUIRE(bad_item.error().msg == "/items/1/price: missing member");
+    auto bad_limit = Sonnet::parse_as<describe_test::account>(R"({"name":"","level":0,"items":[],"limits":{"a/b":"x"},"position":[0,0],"ttl":0})");
+    REQUIRE(bad_limit.error().msg == "/limits/a~1b: expected an integer");
+    auto long_position = Sonnet::parse_as<describe_test::account>(R"({"name":"","level":0,"items":[],"limits":{},"position":[0,0,0],"ttl":0})");
+    REQUIRE(long_position.error().msg == "/position: expected an array of 2 elements");
+}
+
+TEST_CASE("parse_as fills containers at the top level", "[describe][convert]") {
+    auto items = Sonnet::parse_as<std::vector<describe_test::item>>(R"([{"sku":"a","qty":1,"price":2},{"sku":"b","qty":3,"price":4}])");
+    REQUIRE(items);
+    REQUIRE(items->size() == 2);
+    REQUIRE(items->capacity() == 2);
+    REQUIRE((*items)[1].qty == 3);
+
+    auto counts = Sonnet::parse_as<std::unordered_map<std::string, std::vector<int>>>(R"({"x":[1,2,3],"y":[]})");
+    REQUIRE(counts);
+    REQUIRE(counts->at("x").size() == 3);
+    REQUIRE(Sonnet::parse_as<std::optional<int>>("null").value() == std::nullopt);
+    REQUIRE(Sonnet::parse_as<std::vector<std::optional<int>>>("[1,null]").value() == std::vector<std::optional<int>>{ 1, std::nullopt });
+    REQUIRE(Sonnet::parse_as<std::vector<int>>(R"([1,"2"])").error().msg == "/1: expected an integer");
+}
+
+namespace describe_test {
+    struct message {
+        Sonnet::string body;
+        std::string subject;
+        Sonnet::array parts{ Sonnet::allocator_type{} };
+        std::vector<Sonnet::string> tags;
+        std::map<std::string, Sonnet::value> headers;
+    };
+
+    SONNET_DEFINE_TYPE(message, body, subject, parts, tags, headers);
+}
+
+TEST_CASE("deserialize from an rvalue moves strings and containers out of the document", "[convert]") {
+    const std::string long_text(200, 'x');
+    auto doc = Sonnet::parse(R"({"body":")" + long_text + R"(","subject":"hi","parts":[1,"two",[3]],"tags":[")" + long_text + R"("],"headers":{"h":")" + long_text + R"("}})");
+    REQUIRE(doc);
+    const char* body = (*doc)["body"].as_string().data();
+    const Sonnet::value* first_part = &(*doc)["parts"].as_array()[0];
+    const char* tag = (*doc)["tags"].as_array()[0].as_string().data();
+    const char* header = (*doc)["headers"]["h"].as_string().data();
+
+    Sonnet::value copy = *doc;
+    auto m = Sonnet::deserialize<describe_test::message>(std::move(*doc));
+    REQUIRE(m.body.data() == body);
+    REQUIRE(m.parts.data() == first_part);
+    REQUIRE(m.tags[0].data() == tag);
+    REQUIRE(m.headers.at("h").as_string().data() == header);
+    REQUIRE(m.subject == "hi");
+    REQUIRE(Sonnet::serialize(m) == copy);
+
+    // The const overload leaves the document alone
+    auto c = Sonnet::deserialize<describe_test::message>(copy);
+    REQUIRE(c.body.data() != copy["body"].as_string().data());
+    REQUIRE(std::string_view{ copy["body"].as_string() } == long_text);
+}
+
+TEST_CASE("rvalue builtin converters adopt storage only from a compatible resource", "[convert]") {
+    const std::string long_text(100, 'y');
+    std::pmr::monotonic_buffer_resource arena;
+    Sonnet::value doc{ Sonnet::array{ Sonnet::allocator_type{ &arena } }, &arena };
+    doc.as_array().emplace_back(&arena) = Sonnet::value{ long_text, &arena };
+    const char* text = doc[0].as_string().data();
+
+    auto strings = Sonnet::from_json_value<std::vector<Sonnet::string>>(std::move(doc));
+    REQUIRE(strings);
+    REQUIRE(std::string_view{ (*strings)[0] } == long_text);
+    REQUIRE((*strings)[0].data() != text);
+
+    Sonnet::value same = Sonnet::serialize(std::vector<std::string>{ long_text });
+    text = same[0].as_string().data();
+    auto adopted = Sonnet::deserialize<std::optional<std::tuple<Sonnet::string>>>(std::move(same));
+    REQUIRE(std::get<0>(adopted.value()).data() == text);
+
+    Sonnet::value obj = *Sonnet::parse(R"({"a":{"b":[1,2]}})");
+    const Sonnet::value* inner = &obj["a"];
+    auto o = Sonnet::deserialize<Sonnet::object>(std::move(obj));
+    REQUIRE(&o.at("a") == inner);
+
+    auto bad = Sonnet::from_json_value<std::vector<Sonnet::string>>(*Sonnet::parse(R"(["a",1])"));
+    REQUIRE(bad.error().path == "/1");
+}
+
+namespace {
+    // Runs the tasks of a batch in reverse order on the calling thread
+    struct reverse_executor {
+        void bulk(std::size_t n, const std::function<void(std::size_t)>& f) const {
+            for (std::size_t i = n; i-- > 0;) f(i);
+        }
+    };
+}
+
+TEST_CASE("deserialize_parallel matches deserialize and reports the first failing element", "[parallel][convert]") {
+    static_assert(Sonnet::Executor<Sonnet::thread_executor> && Sonnet::Executor<reverse_executor>);
+
+    Sonnet::value arr{ Sonnet::array{} };
+    for (int i = 0; i < 5000; i++) {
+        arr.as_array().push_back(Sonnet::serialize(describe_test::item{ "sku-" + std::to_string(i), i, i * 0.5 }));
+    }
+    Sonnet::thread_executor pool{ 4 };
+    auto items = Sonnet::deserialize_parallel<std::vector<describe_test::item>>(arr, pool);
+    REQUIRE(items.size() == 5000);
+    REQUIRE(items[4321].sku == "sku-4321");
+    REQUIRE(Sonnet::serialize(items) == arr);
+    REQUIRE(Sonnet::deserialize_parallel<std::vector<int>>(*Sonnet::parse("[]"), pool).empty());
+
+    arr[1200]["qty"] = "x";
+    arr[4000].as_object().erase("price");
+    for (int run = 0; run < 3; run++) {
+        REQUIRE_THROWS_WITH(Sonnet::deserialize_parallel<std::vector<describe_test::item>>(arr, pool), "Sonnet::deserialize: /1200/qty: expected an integer");
+    }
+    REQUIRE_THROWS_WITH(Sonnet::deserialize_parallel<std::vector<describe_test::item>>(arr, reverse_executor{}), "Sonnet::deserialize: /1200/qty: expected an integer");
+    REQUIRE_THROWS_WITH(Sonnet::deserialize<std::vector<describe_test::item>>(arr), "Sonnet::deserialize: /1200/qty: expected an integer");
+    REQUIRE_THROWS_WITH(Sonnet::deserialize_parallel<std::vector<int>>(Sonnet::value{ 1 }, pool), "Sonnet::deserialize: expected an array");
+
+    Sonnet::ParseOptions packed;
+    packed.pack_numeric_arrays = true;
+    auto nums = Sonnet::parse("[1,2,3.5]", packed);
+    REQUIRE(nums->is_packed());
+    REQUIRE(Sonnet::deserialize_parallel<std::vector<double>>(*nums, pool) == std::vector<double>{ 1, 2, 3.5 });
+    REQUIRE_THROWS_WITH(Sonnet::deserialize_parallel<std::vector<int>>(*nums, pool), "Sonnet::deserialize: /2: expected an integer in range");
+}
+
+TEST_CASE("parse_as_parallel parses top-level arrays like parse_as", "[parallel][describe]") {
+    std::string json = " [\n";
+    for (int i = 0; i < 3000; i++) {
+        if (i > 0) json += ",\n";
+        json += R"({"sku": "a,]\"[)" + std::to_string(i) + R"(", "qty": )" + std::to_string(i) + R"(, "price": 1.5, "tags": [{}, []]})";
+    }
+    json += "\n] ";
+
+    Sonnet::thread_executor pool{ 3 };
+    auto items = Sonnet::parse_as_parallel<std::vector<describe_test::item>>(json, pool);
+    REQUIRE(items);
+    REQUIRE(items->size() == 3000);
+    REQUIRE((*items)[2999].qty == 2999);
+    REQUIRE((*items)[17].sku == "a,]\"[17");
+    REQUIRE(Sonnet::serialize(*items) == Sonnet::serialize(*Sonnet::parse_as<std::vector<describe_test::item>>(json)));
+    REQUIRE(Sonnet::parse_as_parallel<std::vector<int>>("[]", pool).value().empty());
+
+    auto errors_match = [&](std::string_view text, Sonnet::ParseOptions opts = {}) {
+        auto parallel = Sonnet::parse_as_parallel<std::vector<describe_test::item>>(text, reverse_executor{}, opts);
+        auto sequential = Sonnet::parse_as<std::vector<describe_test::item>>(text, opts);
+        REQUIRE_FALSE(parallel);
+        REQUIRE_FALSE(sequential);
+        CHECK(parallel.error().errc == sequential.error().errc);
+        CHECK(parallel.error().offset == sequential.error().offset);
+        CHECK(parallel.error().line == sequential.error().line);
+        CHECK(parallel.error().msg == sequential.error().msg);
+        return parallel.error();
+    };
+    std::string bad = json;
+    bad.replace(bad.find(R"("qty": 2500)"), 11, R"("qty": "2")");
+    bad.replace(bad.find(R"("qty": 700)"), 10, R"("qty": -.5)");
+    REQUIRE(errors_match(bad).errc != Sonnet::ParseError::code::aborted);
+    REQUIRE(errors_match(json.substr(0, json.size() - 3)).errc == Sonnet::ParseError::code::unexpected_end_of_input);
+    REQUIRE(errors_match(R"([{"sku":"a","qty":1,"price":0} {"sku":"b","qty":2,"price":0}])").errc == Sonnet::ParseError::code::unexpected_character);
+    REQUIRE(errors_match(R"([{"sku":"a","qty":1,"price":0},{"sku":"b","qty":2.5,"price":0}])").msg == "/1/qty: expected an integer in range");
+    REQUIRE(errors_match(R"([[]])", { .max_depth = 1 }).errc == Sonnet::ParseError::code::depth_limit_exceeded);
+
+    Sonnet::ParseOptions lenient;
+    lenient.allow_trailing_commas = true;
+    REQUIRE(Sonnet::parse_as_parallel<std::vector<int>>("[1,2,]", pool, lenient).value().size() == 2);
+}